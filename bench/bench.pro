@@ -0,0 +1,20 @@
+#-------------------------------------------------
+#
+# qtverilog-bench - times the parser on generated designs.
+#
+#-------------------------------------------------
+
+CONFIG  += console
+CONFIG  -= app_bundle qt
+
+TARGET = qtverilog-bench
+TEMPLATE = app
+
+include(../qtverilog.pri)
+
+SOURCES += \
+	main.cpp \
+	netlistgen.cpp
+
+HEADERS += \
+	netlistgen.h
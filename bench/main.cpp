@@ -0,0 +1,325 @@
+/*!
+@file main.cpp
+@brief Benchmarks the parser on generated designs.
+@details Each scenario writes a synthetic design to disk, lexes it once
+on its own to time the scanner, then parses, resolves and releases it,
+reading the time spent in every phase from VerilogCode::stats. The lists
+scenario times the ast_list operations the grammar actions rely on.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include "verilogcode.h"
+#include "netlistgen.h"
+
+//! Which scenarios to run, as bits.
+enum bench_scenario {
+	SCENARIO_GATES     = 1, //!< Flat gate level netlists.
+	SCENARIO_HIERARCHY = 2, //!< Deep module hierarchies.
+	SCENARIO_MACROS    = 4, //!< Macro heavy headers.
+	SCENARIO_RTL       = 8, //!< Many always blocks.
+	SCENARIO_LISTS     = 16, //!< ast_list operations on their own.
+	SCENARIO_ALL       = 0x1F
+};
+
+//! Number of calls to operator new, so heap use per token can be reported.
+static unsigned long heap_allocations = 0;
+
+void *operator new(std::size_t size)
+{
+	void *p = malloc(size > 0 ? size : 1);
+	if(p == NULL)
+		throw std::bad_alloc();
+	heap_allocations++;
+	return p;
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+	free(p);
+}
+
+static void usage(const char *argv0)
+{
+	std::cerr << "Usage: " << argv0 << " [-o <dir>] [-n <scale>] [-r <runs>] [gates|hierarchy|macros|rtl|lists]..." << std::endl;
+	std::cerr << "  -o <dir>    Write the generated designs here, default /tmp." << std::endl;
+	std::cerr << "  -n <scale>  Multiply every design size by this, default 1." << std::endl;
+	std::cerr << "  -r <runs>   Keep the fastest of this many runs, default 3." << std::endl;
+	std::cerr << "  -h          Show this message." << std::endl;
+	std::cerr << "With no scenario named, all of them are run." << std::endl;
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//! Times of one run through every stage, in seconds.
+typedef struct bench_result_t {
+	double lex;
+	double preprocess;
+	double parse;
+	double resolve;
+	double release;
+	double total;
+	size_t bytes;
+	unsigned long tokens;
+	unsigned long heap;     //!< Heap allocations made while lexing.
+	unsigned long instances;
+	bool   ok;
+} bench_result;
+
+static bench_result run_once(const std::string &dir, const std::string &file)
+{
+	bench_result r = bench_result();
+
+	// Lexing alone, so it can be told apart from the parse below.
+	{
+		yy::VerilogCode code;
+		code.verilog_preprocessor_add_search_dir(dir);
+		unsigned long heap = heap_allocations;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		r.tokens = code.scan_file(file);
+		r.lex = seconds_since(start);
+		r.heap = heap_allocations - heap;
+	}
+
+	yy::VerilogCode code;
+	code.verilog_preprocessor_add_search_dir(dir);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	r.ok = code.parse_file(file);
+	code.verilog_resolve_modules(code.yy_verilog_source_tree);
+	r.instances = code.stats_node_count(yy::NODE_KIND_MODULE_INSTANCE);
+	code.ast_free_all();
+	r.total = seconds_since(start);
+
+	r.preprocess = code.stats_phase_seconds(yy::PHASE_PREPROCESS);
+	r.parse      = code.stats_phase_seconds(yy::PHASE_PARSE);
+	r.resolve    = code.stats_phase_seconds(yy::PHASE_RESOLVE);
+	r.release    = code.stats_phase_seconds(yy::PHASE_RELEASE);
+	r.bytes      = code.stats.input_bytes;
+	return r;
+}
+
+static void report(const char *name, const std::string &dir, const std::string &file, int runs)
+{
+	bench_result best = bench_result();
+
+	for(int i = 0; i < runs; i++) {
+		bench_result r = run_once(dir, file);
+		if(i == 0 || r.total < best.total)
+			best = r;
+	}
+
+	double mb = best.bytes / (1024.0 * 1024.0);
+	double parsed = best.preprocess + best.parse;
+
+	printf("%-22s %9.2f %9lu %9.4f %9lu %8.4f %8.4f %8.4f %8.4f %8.4f %8.1f %11.0f%s\n",
+		name, mb * 1024, best.tokens,
+		best.tokens > 0 ? (double)best.heap / best.tokens : 0, best.instances,
+		best.preprocess, best.lex, best.parse, best.resolve, best.release,
+		parsed > 0 ? mb / parsed : 0,
+		parsed > 0 ? best.instances / parsed : 0,
+		best.ok ? "" : "  (parse failed)");
+	fflush(stdout);
+}
+
+//! Times of the list operations, in nanoseconds per item.
+typedef struct bench_list_result_t {
+	double append;
+	double preappend;
+	double get_forward;
+	double get_reverse;  //!< Reading from the last item back to the first.
+	double concat;       //!< Two lists of half the items each.
+	bool   ok;
+} bench_list_result;
+
+static bench_list_result run_lists_once(unsigned long n)
+{
+	bench_list_result r = bench_list_result();
+	yy::VerilogCode code;
+	unsigned long sum = 0;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	yy::ast_list *list = code.ast_list_new();
+	for(unsigned long i = 0; i < n; i++)
+		code.ast_list_append(list, (void *)(i + 1));
+	r.append = seconds_since(start) * 1e9 / n;
+
+	start = std::chrono::steady_clock::now();
+	for(unsigned long i = 0; i < n; i++)
+		sum += (unsigned long)code.ast_list_get(list, i);
+	r.get_forward = seconds_since(start) * 1e9 / n;
+
+	start = std::chrono::steady_clock::now();
+	for(unsigned long i = n; i > 0; i--)
+		sum += (unsigned long)code.ast_list_get(list, i - 1);
+	r.get_reverse = seconds_since(start) * 1e9 / n;
+
+	// As the right recursive grammar rules build their lists.
+	start = std::chrono::steady_clock::now();
+	yy::ast_list *front = code.ast_list_new();
+	for(unsigned long i = n; i > 0; i--)
+		code.ast_list_preappend(front, (void *)i);
+	r.preappend = seconds_since(start) * 1e9 / n;
+
+	yy::ast_list *head = code.ast_list_new();
+	yy::ast_list *tail = code.ast_list_new();
+	for(unsigned long i = 0; i < n; i++)
+		code.ast_list_append(i < n / 2 ? head : tail, (void *)(i + 1));
+	start = std::chrono::steady_clock::now();
+	code.ast_list_concat(head, tail);
+	r.concat = seconds_since(start) * 1e9 / n;
+
+	r.ok = sum == n * (n + 1) && head->items == n &&
+		code.ast_list_get(front, n - 1) == (void *)n &&
+		code.ast_list_get(head, n - 1) == (void *)n;
+	code.ast_free_all();
+	return r;
+}
+
+static void report_lists(unsigned long n, int runs)
+{
+	bench_list_result best = bench_list_result();
+
+	for(int i = 0; i < runs; i++) {
+		bench_list_result r = run_lists_once(n);
+		if(i == 0 || r.append + r.preappend + r.get_forward + r.get_reverse + r.concat <
+		   best.append + best.preappend + best.get_forward + best.get_reverse + best.concat)
+			best = r;
+	}
+
+	printf("%-22lu %9.2f %9.2f %9.2f %9.2f %9.3f%s\n", n,
+		best.append, best.preappend, best.get_forward, best.get_reverse, best.concat,
+		best.ok ? "" : "  (wrong items)");
+	fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+	std::string dir = "/tmp";
+	unsigned int scale = 1;
+	int runs = 3;
+	unsigned int scenarios = 0;
+
+	for(int i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+			usage(argv[0]);
+			return 0;
+		} else if(strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "-n") == 0 ||
+		          strcmp(argv[i], "-r") == 0) {
+			if(i + 1 == argc) {
+				usage(argv[0]);
+				return 2;
+			}
+			if(argv[i][1] == 'o')
+				dir = argv[i + 1];
+			else if(argv[i][1] == 'n')
+				scale = strtoul(argv[i + 1], NULL, 10);
+			else
+				runs = atoi(argv[i + 1]);
+			i++;
+		} else if(strcmp(argv[i], "gates") == 0) {
+			scenarios |= SCENARIO_GATES;
+		} else if(strcmp(argv[i], "hierarchy") == 0) {
+			scenarios |= SCENARIO_HIERARCHY;
+		} else if(strcmp(argv[i], "macros") == 0) {
+			scenarios |= SCENARIO_MACROS;
+		} else if(strcmp(argv[i], "rtl") == 0) {
+			scenarios |= SCENARIO_RTL;
+		} else if(strcmp(argv[i], "lists") == 0) {
+			scenarios |= SCENARIO_LISTS;
+		} else {
+			std::cerr << "Unknown option " << argv[i] << std::endl;
+			usage(argv[0]);
+			return 2;
+		}
+	}
+
+	if(scenarios == 0)
+		scenarios = SCENARIO_ALL;
+	if(scale == 0)
+		scale = 1;
+	if(runs < 1)
+		runs = 1;
+	if(dir.empty() || dir[dir.size()-1] != '/')
+		dir += '/';
+
+	// The parse column covers AST construction too, the grammar actions
+	// build the tree as they reduce.
+	// heap/token counts calls to operator new during the lexing pass,
+	// opening the files included.
+	if(scenarios & ~SCENARIO_LISTS)
+		printf("%-22s %9s %9s %9s %9s %8s %8s %8s %8s %8s %8s %11s\n",
+			"design", "KiB", "tokens", "heap/tok", "instances",
+			"preproc", "lex", "parse", "resolve", "release", "MB/s", "instances/s");
+
+	char name[64];
+
+	if(scenarios & SCENARIO_GATES) {
+		static const unsigned long sizes[] = {1000, 10000, 100000};
+		for(unsigned int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+			std::string file = dir + "bench_gates.v";
+			unsigned long n = sizes[s] * scale;
+			bench::write_gate_netlist(file, n, 1 + s);
+			snprintf(name, sizeof(name), "gates %lu", n);
+			report(name, dir, file, runs);
+		}
+	}
+
+	if(scenarios & SCENARIO_HIERARCHY) {
+		static const unsigned int depths[] = {8, 64, 512};
+		for(unsigned int s = 0; s < sizeof(depths) / sizeof(depths[0]); s++) {
+			std::string file = dir + "bench_hierarchy.v";
+			unsigned int depth = depths[s] * scale;
+			bench::write_hierarchy(file, depth, 16);
+			snprintf(name, sizeof(name), "hierarchy %u x 16", depth);
+			report(name, dir, file, runs);
+		}
+	}
+
+	if(scenarios & SCENARIO_MACROS) {
+		static const unsigned int counts[] = {100, 1000, 10000};
+		for(unsigned int s = 0; s < sizeof(counts) / sizeof(counts[0]); s++) {
+			std::string file = dir + "bench_macros.v";
+			unsigned int macros = counts[s] * scale;
+			bench::write_macro_design(file, macros);
+			snprintf(name, sizeof(name), "macros %u", macros);
+			report(name, dir, file, runs);
+		}
+	}
+
+	if(scenarios & SCENARIO_RTL) {
+		static const unsigned int counts[] = {100, 1000, 10000};
+		for(unsigned int s = 0; s < sizeof(counts) / sizeof(counts[0]); s++) {
+			std::string file = dir + "bench_rtl.v";
+			unsigned int blocks = counts[s] * scale;
+			bench::write_rtl(file, blocks);
+			snprintf(name, sizeof(name), "rtl %u", blocks);
+			report(name, dir, file, runs);
+		}
+	}
+
+	if(scenarios & SCENARIO_LISTS) {
+		// Nanoseconds per item, concat over the items of both lists.
+		printf("\n%-22s %9s %9s %9s %9s %9s\n", "list items",
+			"append", "preappend", "get", "get back", "concat");
+		static const unsigned long sizes[] = {1000, 10000, 100000};
+		for(unsigned int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+			report_lists(sizes[s] * scale, runs);
+	}
+
+	return 0;
+}
@@ -0,0 +1,247 @@
+/*!
+@file netlistgen.cpp
+@brief Contains the synthetic design generators declared in netlistgen.h
+*/
+
+#include <stdio.h>
+
+#include "netlistgen.h"
+
+namespace bench {
+
+	//! A standard cell the generators can instance.
+	typedef struct cell_t {
+		const char *name;       //!< Module name.
+		int         inputs;     //!< Number of data inputs, named A, B, C.
+		const char *function;   //!< Expression for Y, in terms of A, B, C.
+	} cell;
+
+	//! Combinational cells, in the style of the OSU library counter.rtl.v uses.
+	static const cell cells[] = {
+		{"INVX1",   1, "~A"},
+		{"BUFX2",   1, "A"},
+		{"NAND2X1", 2, "~(A & B)"},
+		{"NOR2X1",  2, "~(A | B)"},
+		{"AND2X2",  2, "A & B"},
+		{"OR2X2",   2, "A | B"},
+		{"XOR2X1",  2, "A ^ B"},
+		{"NAND3X1", 3, "~(A & B & C)"},
+		{"NOR3X1",  3, "~(A | B | C)"},
+		{"OAI21X1", 3, "~((A | B) & C)"},
+		{"AOI21X1", 3, "~((A & B) | C)"},
+	};
+
+	static const int cell_count = sizeof(cells) / sizeof(cells[0]);
+
+	//! Small, fast and above all portable random numbers.
+	static unsigned int next_random(unsigned int *state)
+	{
+		unsigned int x = *state;
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		*state = x;
+		return x;
+	}
+
+	//! Writes a module for every cell in cells[], plus DFFPOSX1.
+	static void write_cell_models(FILE *out)
+	{
+		static const char *pins[] = {"A", "B", "C"};
+
+		for(int c = 0; c < cell_count; c++) {
+			fprintf(out, "module %s ( gnd, vdd, ", cells[c].name);
+			for(int i = 0; i < cells[c].inputs; i++)
+				fprintf(out, "%s, ", pins[i]);
+			fprintf(out, "Y );\n\ninput gnd, vdd;\ninput ");
+			for(int i = 0; i < cells[c].inputs; i++)
+				fprintf(out, "%s%s", i ? ", " : "", pins[i]);
+			fprintf(out, ";\noutput Y;\n\n\tassign Y = %s;\nendmodule\n\n", cells[c].function);
+		}
+
+		fprintf(out,
+			"module DFFPOSX1 ( gnd, vdd, CLK, D, Q );\n\n"
+			"input gnd, vdd;\ninput CLK;\ninput D;\noutput Q;\nreg Q;\n\n"
+			"\talways @(posedge CLK)\n\t\tQ <= D;\nendmodule\n\n");
+	}
+
+	//! Writes one cell instance reading nets chosen from the first driven.
+	static void write_cell_instance(FILE *out, const cell &c, unsigned long index,
+		unsigned long driven, unsigned int *seed, const char *output)
+	{
+		static const char *pins[] = {"A", "B", "C"};
+
+		fprintf(out, "\t%s %s_%lu ( .gnd(gnd), .vdd(vdd)", c.name, c.name, index);
+		for(int i = 0; i < c.inputs; i++) {
+			unsigned int r = next_random(seed);
+			// Mostly read recent nets, as synthesised logic tends to.
+			unsigned long window = driven < 64 || r % 4 == 0 ? driven : 64;
+			unsigned long net = driven - 1 - (next_random(seed) % window);
+			if(net < 16)
+				fprintf(out, ", .%s(in[%lu])", pins[i], net);
+			else
+				fprintf(out, ", .%s(_%lu_)", pins[i], net);
+		}
+		fprintf(out, ", .Y(%s) );\n", output);
+	}
+
+	unsigned long write_gate_netlist(const std::string &path, unsigned long instances, unsigned int seed)
+	{
+		FILE *out = fopen(path.c_str(), "w");
+		if(out == NULL)
+			return 0;
+
+		if(seed == 0)
+			seed = 1;
+
+		write_cell_models(out);
+
+		fprintf(out,
+			"module gates ( gnd, vdd, clk, reset, in, out);\n\n"
+			"input gnd, vdd;\ninput clk;\ninput reset;\ninput [15:0] in;\n"
+			"output [15:0] out;\n\n");
+
+		// Nets 0 to 15 are the inputs, net n > 15 is _n_.
+		unsigned long driven = 16;
+		unsigned long written = 0;
+		unsigned long dffs = 0;
+		char name[32];
+
+		while(written + 16 < instances) {
+			snprintf(name, sizeof(name), "_%lu_", driven);
+			if(written % 8 == 7) {
+				// Flip flops may read nets not driven yet, closing loops.
+				unsigned long d = 16 + next_random(&seed) % (instances - 16);
+				fprintf(out, "\tDFFPOSX1 DFFPOSX1_%lu ( .gnd(gnd), .vdd(vdd), .CLK(clk), .D(_%lu_), .Q(%s) );\n",
+					++dffs, d, name);
+			} else {
+				const cell &c = cells[next_random(&seed) % cell_count];
+				write_cell_instance(out, c, written + 1, driven, &seed, name);
+			}
+			driven++;
+			written++;
+		}
+
+		for(int b = 0; b < 16 && written < instances; b++) {
+			snprintf(name, sizeof(name), "out[%d]", b);
+			write_cell_instance(out, cells[1], written + 1, driven, &seed, name);
+			written++;
+		}
+
+		fprintf(out, "endmodule\n");
+		fclose(out);
+		return written;
+	}
+
+	unsigned long write_hierarchy(const std::string &path, unsigned int depth, unsigned int fanout)
+	{
+		FILE *out = fopen(path.c_str(), "w");
+		if(out == NULL)
+			return 0;
+
+		unsigned long written = 0;
+
+		for(unsigned int level = 0; level + 1 < depth; level++) {
+			fprintf(out, "module level_%u ( gnd, vdd, clk, a, y );\n\n", level);
+			fprintf(out, "input gnd, vdd;\ninput clk;\ninput a;\noutput y;\n\n");
+			// The children form a chain from a to y.
+			for(unsigned int f = 0; f < fanout; f++) {
+				char a[32] = "a", y[32] = "y";
+				if(f != 0)
+					snprintf(a, sizeof(a), "_%u_", f);
+				if(f + 1 != fanout)
+					snprintf(y, sizeof(y), "_%u_", f + 1);
+				fprintf(out, "\tlevel_%u u_%u ( .gnd(gnd), .vdd(vdd), .clk(clk), .a(%s), .y(%s) );\n",
+					level + 1, f, a, y);
+				written++;
+			}
+			fprintf(out, "endmodule\n\n");
+		}
+
+		// The leaf is a short chain of gates and a flip flop.
+		fprintf(out, "module level_%u ( gnd, vdd, clk, a, y );\n\n", depth ? depth - 1 : 0);
+		fprintf(out, "input gnd, vdd;\ninput clk;\ninput a;\noutput y;\n\n");
+		fprintf(out, "\tINVX1 INVX1_1 ( .gnd(gnd), .vdd(vdd), .A(a), .Y(_1_) );\n");
+		fprintf(out, "\tNAND2X1 NAND2X1_1 ( .gnd(gnd), .vdd(vdd), .A(a), .B(_1_), .Y(_2_) );\n");
+		fprintf(out, "\tNOR2X1 NOR2X1_1 ( .gnd(gnd), .vdd(vdd), .A(_1_), .B(_2_), .Y(_3_) );\n");
+		fprintf(out, "\tDFFPOSX1 DFFPOSX1_1 ( .gnd(gnd), .vdd(vdd), .CLK(clk), .D(_3_), .Q(y) );\n");
+		fprintf(out, "endmodule\n\n");
+		written += 4;
+
+		write_cell_models(out);
+
+		fclose(out);
+		return written;
+	}
+
+	unsigned long write_macro_design(const std::string &path, unsigned int macros)
+	{
+		std::string dir = path.substr(0, path.find_last_of('/') + 1);
+		FILE *header = fopen((dir + "macros.vh").c_str(), "w");
+		if(header == NULL)
+			return 0;
+
+		fprintf(header, "`ifndef MACROS_VH\n`define MACROS_VH\n\n");
+		for(unsigned int m = 0; m < macros; m++) {
+			fprintf(header, "`define WIDTH_%u %u\n", m, 1 + m % 32);
+			if(m % 4 == 0) {
+				fprintf(header, "`ifdef FEATURE_%u\n`define MODE_%u 1\n`else\n`define MODE_%u 0\n`endif\n",
+					m % 16, m, m);
+			}
+		}
+		fprintf(header, "\n`endif\n");
+		fclose(header);
+
+		FILE *out = fopen(path.c_str(), "w");
+		if(out == NULL)
+			return 0;
+
+		// Include the header twice, the second time it should be skipped.
+		fprintf(out, "`include \"macros.vh\"\n`include \"macros.vh\"\n\n");
+		fprintf(out, "`define FEATURE_0\n\n");
+		fprintf(out, "module macros ( clk, a, y );\n\ninput clk;\ninput [31:0] a;\noutput [31:0] y;\n\n");
+		for(unsigned int m = 0; m < macros; m++) {
+			fprintf(out, "\twire [`WIDTH_%u-1:0] w_%u;\n", m, m);
+			fprintf(out, "\tassign w_%u = a[`WIDTH_%u-1:0];\n", m, m);
+		}
+		fprintf(out, "\tassign y = a;\nendmodule\n");
+		fclose(out);
+
+		return 0;
+	}
+
+	unsigned long write_rtl(const std::string &path, unsigned int always_blocks)
+	{
+		FILE *out = fopen(path.c_str(), "w");
+		if(out == NULL)
+			return 0;
+
+		unsigned int regs = always_blocks / 2 + 1;
+
+		fprintf(out, "module rtl ( clk, reset, in, out );\n\n");
+		fprintf(out, "input clk;\ninput reset;\ninput [31:0] in;\noutput [31:0] out;\n\n");
+		for(unsigned int r = 0; r < regs; r++)
+			fprintf(out, "reg [31:0] r_%u;\nreg [31:0] c_%u;\n", r, r);
+		fprintf(out, "\n");
+
+		for(unsigned int b = 0; b < always_blocks; b++) {
+			unsigned int r = b / 2;
+			unsigned int p = r == 0 ? 0 : r - 1;
+			if(b % 2 == 0) {
+				fprintf(out, "\talways @(posedge clk)\n");
+				fprintf(out, "\t\tif (reset) begin\n\t\t\tr_%u <= 32'b0 ;\n", r);
+				fprintf(out, "\t\tend else begin\n\t\t\tr_%u <= c_%u + in;\n\t\tend\n", r, p);
+			} else {
+				fprintf(out, "\talways @(r_%u or r_%u)\n", r, p);
+				fprintf(out, "\t\tif (r_%u[0]) c_%u = r_%u ^ r_%u;\n", r, r, r, p);
+				fprintf(out, "\t\telse c_%u = r_%u + 1;\n", r, r);
+			}
+		}
+
+		fprintf(out, "\n\tassign out = r_%u;\nendmodule\n", regs - 1);
+		fclose(out);
+
+		return 0;
+	}
+
+}
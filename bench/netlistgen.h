@@ -0,0 +1,49 @@
+#ifndef NETLISTGEN_H
+#define NETLISTGEN_H
+
+/*!
+@file netlistgen.h
+@brief Writes synthetic Verilog designs of a chosen size, for benchmarking.
+@details Every generator is deterministic for a given size and seed, so runs
+on different machines or different days parse the same text. Each returns
+the number of module instances in what it wrote, which is the unit the
+benchmark reports throughput in.
+*/
+
+#include <string>
+
+namespace bench {
+
+	/*!
+	@brief Writes a flat gate-level netlist in the style of counter.rtl.v.
+	@details The cell models (NAND2X1, NOR2X1, INVX1, OAI21X1, AOI21X1,
+	DFFPOSX1 and friends) are written into the same file, so every instance
+	resolves. Combinational cells only read nets driven earlier, and flip
+	flops may read any net, so the design is acyclic once flip flops are cut.
+	*/
+	unsigned long write_gate_netlist(const std::string &path, unsigned long instances, unsigned int seed);
+
+	/*!
+	@brief Writes a hierarchy depth modules deep, each instantiating the next
+	one fanout times, with a small gate netlist in the leaf.
+	@details Every module is declared once, so the file grows linearly with
+	depth, while the elaborated design grows as fanout to the power depth.
+	*/
+	unsigned long write_hierarchy(const std::string &path, unsigned int depth, unsigned int fanout);
+
+	/*!
+	@brief Writes a header of macros, guarded with `ifndef, and a design
+	which includes it and uses the macros.
+	@details The header is written next to path, as macros.vh.
+	*/
+	unsigned long write_macro_design(const std::string &path, unsigned int macros);
+
+	/*!
+	@brief Writes a register transfer level module with many always blocks,
+	alternating clocked and combinational ones.
+	*/
+	unsigned long write_rtl(const std::string &path, unsigned int always_blocks);
+
+}
+
+#endif // NETLISTGEN_H
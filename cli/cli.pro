@@ -0,0 +1,16 @@
+#-------------------------------------------------
+#
+# qtverilog-cli - parses Verilog files without any user interface.
+#
+#-------------------------------------------------
+
+CONFIG  += console
+CONFIG  -= app_bundle qt
+
+TARGET = qtverilog-cli
+TEMPLATE = app
+
+include(../qtverilog.pri)
+
+SOURCES += \
+	main.cpp
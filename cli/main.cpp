@@ -0,0 +1,299 @@
+/*!
+@file main.cpp
+@brief Headless command line front end to the Verilog parser.
+@details Parses each file named on the command line, or in a filelist, into
+one source tree, resolves module instantiations, and prints statistics. No QApplication is
+created, so this starts as quickly as the parser itself.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "verilogcode.h"
+
+/*!
+@brief Simulates a module with random patterns on its inputs.
+@details Each cycle gives every input 64 new patterns, settles the logic
+and clocks the flip flops. The outputs of every cycle are folded into a
+signature, which only changes when the behaviour of the netlist does.
+*/
+static void simulate(yy::VerilogCode &code, yy::ast_module_declaration *module, unsigned long cycles)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	yy::verilog_netlist *netlist = code.verilog_netlist_build(module);
+	yy::verilog_sim *sim = code.verilog_sim_new(netlist);
+	uint64_t random = 0x9E3779B97F4A7C15ULL;
+	uint64_t signature = 0;
+
+	for(unsigned long c = 0; c < cycles; c++) {
+		for(unsigned int n = 0; n < netlist->nets; n++) {
+			if(netlist->net_port[n] != yy::PORT_INPUT || netlist->net_symbol[n] == AST_SYMBOL_NONE)
+				continue;
+			random ^= random << 13;
+			random ^= random >> 7;
+			random ^= random << 17;
+			sim->values[n] = random;
+		}
+		code.verilog_sim_eval(sim);
+		for(unsigned int n = 0; n < netlist->nets; n++) {
+			if(netlist->net_port[n] == yy::PORT_OUTPUT)
+				signature = (signature ^ sim->values[n]) * 0x100000001B3ULL;
+		}
+		code.verilog_sim_clock(sim);
+	}
+
+	printf("Simulated:          %s, %u cells and %u flip flops (%u unknown), %lu cycles x 64 in %.6f s, signature %016llx\n",
+	       module->identifier->identifier.get(), sim->gates, sim->flops, sim->unknown, cycles,
+	       std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(),
+	       (unsigned long long)signature);
+	if(sim->looped > 0)
+		printf("ERROR: %u cells of module %s are on or behind combinational loops, and weren't simulated.\n",
+		       sim->looped, module->identifier->identifier.get());
+}
+
+/*!
+@brief Prints the depth of a module's logic and its combinational loops.
+@details The deepest instance is printed with the path leading up to it,
+and each loop with the instances on it.
+*/
+static void levelize(yy::VerilogCode &code, yy::ast_module_declaration *module)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	yy::verilog_netlist *netlist = code.verilog_netlist_build(module);
+	yy::verilog_levels *levels = code.verilog_netlist_levelize(netlist);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("Levelized:          %s, depth %u, %u of %u instances ordered, %u loops in %.6f s\n",
+	       module->identifier->identifier.get(), levels->depth, levels->ordered, netlist->instances,
+	       levels->loops, seconds);
+
+	if(levels->critical != VERILOG_NETLIST_NONE && levels->depth > 0) {
+		std::vector<unsigned int> path(levels->depth);
+		unsigned int length = code.verilog_levels_path(levels, levels->critical, path.data());
+		printf("Critical path:     ");
+		for(unsigned int p = 0; p < length; p++)
+			printf(" %s", netlist->instance[path[p]]->instance_identifier->identifier.get());
+		printf("\n");
+	}
+
+	for(unsigned int l = 0; l < levels->loops; l++) {
+		printf("Loop:              ");
+		for(unsigned int i = levels->loop_start[l]; i < levels->loop_start[l + 1]; i++)
+			printf(" %s", netlist->instance[levels->loop_instances[i]]->instance_identifier->identifier.get());
+		printf("\n");
+	}
+}
+
+/*!
+@brief Prints the fan in and fan out cones of a net or an instance.
+@details The name is looked up as a net first, with a constant index such
+as out[3] selecting one bit, and then as an instance. Both cones stop at
+flip flops.
+*/
+static void query(yy::VerilogCode &code, yy::ast_module_declaration *module, const char *name)
+{
+	yy::verilog_netlist *netlist = code.verilog_netlist_build(module);
+	std::string net_name(name);
+	int bit = VERILOG_NETLIST_WHOLE;
+	size_t bracket = net_name.find('[');
+	if(bracket != std::string::npos) {
+		bit = atoi(net_name.c_str() + bracket + 1);
+		net_name.erase(bracket);
+	}
+
+	unsigned int net = code.verilog_netlist_find_net(netlist, net_name.c_str(), bit);
+	unsigned int instance = code.verilog_netlist_find_instance(netlist, name);
+	if(net == VERILOG_NETLIST_NONE && instance == VERILOG_NETLIST_NONE)
+		return;
+
+	yy::verilog_cone *cone = code.verilog_cone_new(code.verilog_netlist_levelize(netlist));
+	const yy::verilog_cone_direction directions[] = {yy::CONE_FANIN, yy::CONE_FANOUT};
+	for(unsigned int d = 0; d < 2; d++) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if(net != VERILOG_NETLIST_NONE)
+			code.verilog_cone_of_net(cone, net, directions[d], 0, true);
+		else
+			code.verilog_cone_of_instance(cone, instance, directions[d], 0, true);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		printf("%s %s, %u instances, %u nets, depth %u in %.6f s\n",
+		       directions[d] == yy::CONE_FANIN ? "Fan in:            " : "Fan out:           ",
+		       name, cone->instances, cone->nets, cone->depth, seconds);
+	}
+}
+
+static void usage(const char *argv0)
+{
+	std::cerr << "Usage: " << argv0 << " [-I <dir>]... [-t <categories>] [-s <file>] [-j <jobs>] [-c <dir>] [-r <cycles>] [-l] [-q <name>] {-f <list.f> | <file.v>...}" << std::endl;
+	std::cerr << "  -I <dir>   Add a directory to search for `include files." << std::endl;
+	std::cerr << "  -t <list>  Trace lexer,parser,preprocessor,memory or all." << std::endl;
+	std::cerr << "             Only available in debug builds." << std::endl;
+	std::cerr << "  -s <file>  Write per-phase statistics as JSON, - for stdout." << std::endl;
+	std::cerr << "  -f <file>  Parse the files in a filelist, in parallel." << std::endl;
+	std::cerr << "  -j <jobs>  Threads to parse a filelist with, default one per core." << std::endl;
+	std::cerr << "  -c <dir>   Keep parsed trees here, and reuse them for unchanged files." << std::endl;
+	std::cerr << "  -r <n>     Simulate each module of cells for n cycles of random inputs." << std::endl;
+	std::cerr << "  -l         Print the logic depth and combinational loops of each module." << std::endl;
+	std::cerr << "  -q <name>  Print the fan in and fan out cones of a net or instance." << std::endl;
+	std::cerr << "  -h         Show this message." << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+	yy::VerilogCode code;
+	int files = 0;
+	int failed = 0;
+	double parse_seconds = 0;
+	const char *stats_json = NULL;
+	const char *filelist = NULL;
+	unsigned int jobs = 0;
+	unsigned long cycles = 0;
+	bool levels = false;
+	const char *cone = NULL;
+
+	for(int i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+			usage(argv[0]);
+			return 0;
+		} else if(strcmp(argv[i], "-I") == 0) {
+			if(++i == argc) {
+				usage(argv[0]);
+				return 2;
+			}
+			code.verilog_preprocessor_add_search_dir(argv[i]);
+		} else if(strcmp(argv[i], "-s") == 0) {
+			if(++i == argc) {
+				usage(argv[0]);
+				return 2;
+			}
+			stats_json = argv[i];
+		} else if(strcmp(argv[i], "-f") == 0) {
+			if(++i == argc) {
+				usage(argv[0]);
+				return 2;
+			}
+			filelist = argv[i];
+		} else if(strcmp(argv[i], "-j") == 0) {
+			if(++i == argc) {
+				usage(argv[0]);
+				return 2;
+			}
+			jobs = strtoul(argv[i], NULL, 10);
+		} else if(strcmp(argv[i], "-c") == 0) {
+			if(++i == argc) {
+				usage(argv[0]);
+				return 2;
+			}
+			code.set_cache_directory(argv[i]);
+		} else if(strcmp(argv[i], "-r") == 0) {
+			if(++i == argc) {
+				usage(argv[0]);
+				return 2;
+			}
+			cycles = strtoul(argv[i], NULL, 10);
+		} else if(strcmp(argv[i], "-q") == 0) {
+			if(++i == argc) {
+				usage(argv[0]);
+				return 2;
+			}
+			cone = argv[i];
+		} else if(strcmp(argv[i], "-l") == 0) {
+			levels = true;
+		} else if(strcmp(argv[i], "-t") == 0) {
+			if(++i == argc) {
+				usage(argv[0]);
+				return 2;
+			}
+			code.set_trace_categories(yy::VerilogCode::verilog_trace_parse_categories(argv[i]));
+		} else if(strncmp(argv[i], "-I", 2) == 0) {
+			code.verilog_preprocessor_add_search_dir(argv[i] + 2);
+		} else if(argv[i][0] == '-') {
+			std::cerr << "Unknown option " << argv[i] << std::endl;
+			usage(argv[0]);
+			return 2;
+		}
+	}
+
+	for(int i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "-I") == 0 || strcmp(argv[i], "-t") == 0 ||
+		   strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "-f") == 0 ||
+		   strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "-c") == 0 ||
+		   strcmp(argv[i], "-r") == 0 || strcmp(argv[i], "-q") == 0) {
+			i++;
+			continue;
+		} else if(argv[i][0] == '-') {
+			continue;
+		}
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if(!code.parse_file(argv[i])) {
+			std::cerr << argv[i] << ": parse failed" << std::endl;
+			failed++;
+		}
+		parse_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		files++;
+	}
+
+	if(filelist != NULL) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if(!code.parse_filelist(filelist, jobs)) {
+			std::cerr << filelist << ": parse failed" << std::endl;
+			failed++;
+		}
+		parse_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if(code.yy_units != NULL)
+			files += code.yy_units->items;
+	}
+
+	if(files == 0) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	yy::verilog_source_tree *st = code.yy_verilog_source_tree;
+	yy::verilog_resolution_stats stats = code.verilog_resolve_modules(st);
+
+	printf("Files:              %d (%d failed)\n", files, failed);
+	printf("Modules:            %u\n", st->modules->items);
+	printf("Primitives:         %u\n", st->primitives->items);
+	printf("Configs:            %u\n", st->configs->items);
+	printf("Libraries:          %u\n", st->libraries->items);
+	printf("Parse time:         %.6f s\n", parse_seconds);
+	printf("Resolved:           %u\n", stats.resolved);
+	printf("Unresolved:         %u\n", stats.unresolved);
+	printf("Resolve time:       %.6f s\n", stats.seconds);
+	printf("AST memory:         %lu bytes (high water)\n", (unsigned long)code.ast_arena_high_water());
+
+	printf("Tokens:             %lu\n", code.stats.tokens);
+	printf("Reductions:         %lu\n", code.stats_phase_count(yy::PHASE_PARSE));
+
+	for(unsigned int m = 0; levels && m < st->modules->items; m++) {
+		yy::ast_module_declaration *module = (yy::ast_module_declaration *)yy::ast_list_at(st->modules, m);
+		if(module->module_instantiations != NULL && module->module_instantiations->items > 0)
+			levelize(code, module);
+	}
+
+	for(unsigned int m = 0; cone != NULL && m < st->modules->items; m++) {
+		yy::ast_module_declaration *module = (yy::ast_module_declaration *)yy::ast_list_at(st->modules, m);
+		if(module->module_instantiations != NULL && module->module_instantiations->items > 0)
+			query(code, module, cone);
+	}
+
+	for(unsigned int m = 0; cycles > 0 && m < st->modules->items; m++) {
+		yy::ast_module_declaration *module = (yy::ast_module_declaration *)yy::ast_list_at(st->modules, m);
+		if(module->module_instantiations != NULL && module->module_instantiations->items > 0)
+			simulate(code, module, cycles);
+	}
+
+	// Written after resolution, so the resolve phase is included.
+	if(stats_json != NULL && !code.stats_write_json(stats_json)) {
+		std::cerr << "Could not write " << stats_json << std::endl;
+	}
+
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,35 @@
+#include <QApplication>
+#include <QComboBox>
+#include "mainwindow.h"
+#include "verilogschematics.h"
+#include "ui_mainwindow.h"
+
+MainWindow::MainWindow(QWidget *parent) :
+	QMainWindow(parent),
+	ui(new Ui::MainWindow)
+{
+	ui->setupUi(this);
+
+	VerilogSchematics *schematics = new VerilogSchematics();
+	ui->workbench->addWidget(schematics);
+	connect(schematics, &VerilogSchematics::itemHovered, this, [this](const QString &description) {
+		ui->statusBar->showMessage(description);
+	});
+
+	QStringList arguments = QApplication::arguments();
+	for(int i = 1; i < arguments.size(); i++)
+		schematics->openFile(arguments.at(i));
+
+	// Switching modules lays each out once, on a worker thread.
+	QComboBox *modules = new QComboBox();
+	modules->addItems(schematics->moduleNames());
+	ui->mainToolBar->addWidget(modules);
+	connect(modules, &QComboBox::currentTextChanged, schematics, &VerilogSchematics::showModule);
+	if(modules->count() > 0)
+		schematics->showModule(modules->currentText());
+}
+
+MainWindow::~MainWindow()
+{
+	delete ui;
+}
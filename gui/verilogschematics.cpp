@@ -0,0 +1,317 @@
+#include <QMouseEvent>
+#include <QPaintEvent>
+#include <QPainter>
+#include <QPolygon>
+#include <QWheelEvent>
+#include <QtConcurrent/QtConcurrentRun>
+#include <cmath>
+#include "verilogschematics.h"
+
+VerilogSchematics::VerilogSchematics(QWidget *parent) : QWidget(parent),
+	module(nullptr), pending(nullptr), layingOut(nullptr), scale(1), offset(0, 0),
+	hovered(VERILOG_NETLIST_NONE), selected(VERILOG_NETLIST_NONE)
+{
+	code = new yy::VerilogCode();
+	setMouseTracking(true);
+	connect(&watcher, &QFutureWatcher<yy::verilog_layout_index*>::finished,
+		this, &VerilogSchematics::layoutFinished);
+}
+
+VerilogSchematics::~VerilogSchematics()
+{
+	// The worker may still be using the arena.
+	watcher.waitForFinished();
+	delete code;
+}
+
+bool VerilogSchematics::openFile(const QString &path)
+{
+	watcher.waitForFinished();
+	if(!code->parse_file(path.toStdString()))
+		return false;
+	code->verilog_resolve_modules(code->yy_verilog_source_tree);
+	return true;
+}
+
+QStringList VerilogSchematics::moduleNames() const
+{
+	QStringList names;
+	yy::verilog_source_tree *st = code->yy_verilog_source_tree;
+	for(unsigned int m = 0; st != nullptr && m < st->modules->items; m++) {
+		yy::ast_module_declaration *declaration = (yy::ast_module_declaration *)yy::ast_list_at(st->modules, m);
+		names.append(QString::fromUtf8(declaration->identifier->identifier));
+	}
+	return names;
+}
+
+yy::verilog_layout_index *VerilogSchematics::layOut(yy::VerilogCode *code, yy::ast_module_declaration *module)
+{
+	yy::verilog_netlist *netlist = code->verilog_netlist_build(module);
+	yy::verilog_layout *layout = code->verilog_layout_build(code->verilog_netlist_levelize(netlist));
+	return code->verilog_layout_index_build(layout);
+}
+
+void VerilogSchematics::startLayout(yy::ast_module_declaration *module)
+{
+	layingOut = module;
+	watcher.setFuture(QtConcurrent::run(&VerilogSchematics::layOut, code, module));
+}
+
+void VerilogSchematics::showModule(const QString &name)
+{
+	module = nullptr;
+	QStringList names = moduleNames();
+	int index = names.indexOf(name);
+	if(index >= 0)
+		module = (yy::ast_module_declaration *)yy::ast_list_at(code->yy_verilog_source_tree->modules, index);
+
+	if(module != nullptr && !layouts.contains(module)) {
+		// Only one layout runs at a time; the latest request waits for it.
+		if(watcher.isRunning())
+			pending = module;
+		else
+			startLayout(module);
+	}
+
+	hovered = selected = VERILOG_NETLIST_NONE;
+	fit();
+	update();
+}
+
+void VerilogSchematics::layoutFinished()
+{
+	layouts.insert(layingOut, watcher.result());
+	if(layingOut == module)
+		fit();
+	layingOut = nullptr;
+
+	if(pending != nullptr && !layouts.contains(pending))
+		startLayout(pending);
+	pending = nullptr;
+	update();
+}
+
+void VerilogSchematics::fit()
+{
+	yy::verilog_layout_index *index = layouts.value(module);
+	if(index == nullptr || index->layout->width == 0 || index->layout->height == 0)
+		return;
+
+	scale = qMin((width() - 20) / (double)index->layout->width, (height() - 20) / (double)index->layout->height);
+	scale = qBound(0.001, scale, 4.0);
+	offset = QPointF(10, 10);
+}
+
+QTransform VerilogSchematics::transform() const
+{
+	return QTransform(scale, 0, 0, scale, offset.x(), offset.y());
+}
+
+unsigned int VerilogSchematics::itemAt(const QPoint &at) const
+{
+	yy::verilog_layout_index *index = layouts.value(module);
+	if(index == nullptr)
+		return VERILOG_NETLIST_NONE;
+
+	// Anything within a few pixels counts.
+	QPointF point = transform().inverted().map(QPointF(at));
+	int radius = qMax(1, (int)std::ceil(4 / scale));
+	return code->verilog_layout_index_hit(index, (int)std::floor(point.x() + 0.5),
+		(int)std::floor(point.y() + 0.5), radius);
+}
+
+unsigned int VerilogSchematics::itemNet(yy::verilog_layout_index *index, unsigned int item) const
+{
+	if(index == nullptr || item == VERILOG_NETLIST_NONE)
+		return VERILOG_NETLIST_NONE;
+
+	yy::verilog_layout *layout = index->layout;
+	switch(index->item_kind[item]) {
+	case yy::LAYOUT_ITEM_PIN:     return layout->levels->netlist->pin_net[index->item_index[item]];
+	case yy::LAYOUT_ITEM_SEGMENT: return layout->segment[index->item_index[item]].net;
+	case yy::LAYOUT_ITEM_PORT:    return layout->port_net[index->item_index[item]];
+	default:                      return VERILOG_NETLIST_NONE;
+	}
+}
+
+QRect VerilogSchematics::itemBounds(yy::verilog_layout_index *index, unsigned int item) const
+{
+	if(index == nullptr || item == VERILOG_NETLIST_NONE)
+		return QRect();
+
+	const yy::verilog_layout_box &b = index->item_box[item];
+	QRectF box(b.x1, b.y1, b.x2 - b.x1, b.y2 - b.y1);
+	return transform().mapRect(box).toAlignedRect().adjusted(-4, -4, 4, 4);
+}
+
+QString VerilogSchematics::describe(yy::verilog_layout_index *index, unsigned int item) const
+{
+	if(index == nullptr || item == VERILOG_NETLIST_NONE)
+		return QString();
+
+	yy::verilog_netlist *netlist = index->layout->levels->netlist;
+	unsigned int what = index->item_index[item];
+	unsigned int net = itemNet(index, item);
+	QString netName = net == VERILOG_NETLIST_NONE ? tr("nothing") :
+		QString::fromStdString(code->verilog_netlist_net_name(netlist, net));
+
+	switch(index->item_kind[item]) {
+	case yy::LAYOUT_ITEM_INSTANCE:
+		return tr("%1 %2").arg(QString::fromUtf8(code->verilog_netlist_cell_name(netlist, what)))
+			.arg(QString::fromUtf8(netlist->instance[what]->instance_identifier->identifier));
+	case yy::LAYOUT_ITEM_PIN: {
+		yy::ast_symbol_entry *port = code->ast_symbol_lookup(code->yy_symbols, netlist->pin_port[what]);
+		unsigned int instance = netlist->pin_instance[what];
+		return tr("%1.%2 on %3")
+			.arg(QString::fromUtf8(netlist->instance[instance]->instance_identifier->identifier))
+			.arg(port != nullptr ? QString::fromUtf8(port->text) :
+				QString::number(what - netlist->instance_pins_start[instance]))
+			.arg(netName);
+	}
+	case yy::LAYOUT_ITEM_PORT:
+		return tr("Port %1").arg(netName);
+	default:
+		return tr("Net %1").arg(netName);
+	}
+}
+
+void VerilogSchematics::paintEvent(QPaintEvent *event)
+{
+	QPainter painter(this);
+	yy::verilog_layout_index *index = layouts.value(module);
+	if(index == nullptr) {
+		painter.drawText(rect(), Qt::AlignCenter, module == nullptr ? tr("No module") :
+			tr("Laying out %1...").arg(QString::fromUtf8(module->identifier->identifier)));
+		return;
+	}
+
+	yy::verilog_layout *layout = index->layout;
+	yy::verilog_netlist *netlist = layout->levels->netlist;
+	QTransform view = transform();
+	painter.setTransform(view);
+
+	// Only what meets the exposed area is drawn, with a pitch to spare for text.
+	QRectF exposed = view.inverted().mapRect(QRectF(event->rect()));
+	yy::verilog_layout_box area = {
+		(int)std::floor(exposed.left()) - VERILOG_LAYOUT_PITCH,
+		(int)std::floor(exposed.top()) - VERILOG_LAYOUT_PITCH,
+		(int)std::ceil(exposed.right()) + VERILOG_LAYOUT_PITCH,
+		(int)std::ceil(exposed.bottom()) + VERILOG_LAYOUT_PITCH
+	};
+	found.clear();
+	code->verilog_layout_index_query(index, area, found);
+
+	// Text is sized in layout units, to fit between pins, and left out when too small to read.
+	QFont font = painter.font();
+	font.setPixelSize(VERILOG_LAYOUT_PITCH - 2);
+	painter.setFont(font);
+	bool labels = scale * VERILOG_LAYOUT_PITCH >= 6;
+	unsigned int selectedNet = itemNet(index, selected);
+
+	for(size_t f = 0; f < found.size(); f++) {
+		if(index->item_kind[found[f]] != yy::LAYOUT_ITEM_INSTANCE)
+			continue;
+		unsigned int i = index->item_index[found[f]];
+		const yy::verilog_layout_rect &r = layout->instance_rect[i];
+		QRect box(r.x, r.y, r.width, r.height);
+		painter.setPen(found[f] == selected ? QPen(Qt::red, 2 / scale) : QPen(Qt::darkBlue, 0));
+		painter.setBrush(layout->levels->sequential[i] ? QColor(220, 220, 255) : QColor(Qt::white));
+		painter.drawRect(box);
+		if(labels)
+			painter.drawText(box, Qt::AlignCenter, QString("%1\n%2")
+				.arg(QString::fromUtf8(code->verilog_netlist_cell_name(netlist, i)))
+				.arg(QString::fromUtf8(netlist->instance[i]->instance_identifier->identifier)));
+	}
+
+	painter.setBrush(QColor(200, 240, 200));
+	for(size_t f = 0; f < found.size(); f++) {
+		if(index->item_kind[found[f]] != yy::LAYOUT_ITEM_PORT)
+			continue;
+		unsigned int p = index->item_index[found[f]];
+		const yy::verilog_layout_rect &r = layout->port_rect[p];
+		QPolygon arrow;
+		arrow << QPoint(r.x, r.y) << QPoint(r.x + r.width - r.height / 2, r.y)
+		      << QPoint(r.x + r.width, r.y + r.height / 2)
+		      << QPoint(r.x + r.width - r.height / 2, r.y + r.height) << QPoint(r.x, r.y + r.height);
+		painter.setPen(layout->port_net[p] == selectedNet ? QPen(Qt::red, 2 / scale) : QPen(Qt::darkGreen, 0));
+		painter.drawPolygon(arrow);
+		if(labels)
+			painter.drawText(QRect(r.x, r.y, r.width, r.height), Qt::AlignCenter,
+				QString::fromStdString(code->verilog_netlist_net_name(netlist, layout->port_net[p])));
+	}
+
+	for(size_t f = 0; f < found.size(); f++) {
+		if(index->item_kind[found[f]] != yy::LAYOUT_ITEM_SEGMENT)
+			continue;
+		const yy::verilog_layout_segment &w = layout->segment[index->item_index[found[f]]];
+		if(w.net == selectedNet)
+			painter.setPen(QPen(Qt::red, 2 / scale));
+		else
+			painter.setPen(QPen(layout->net_routed[w.net] ? Qt::darkRed : Qt::darkMagenta, 0));
+		painter.drawLine(w.x1, w.y1, w.x2, w.y2);
+
+		// Nets drawn as stubs are named at the end of each stub.
+		if(labels && !layout->net_routed[w.net])
+			painter.drawText(QPoint(w.x1, w.y1 - 2),
+				QString::fromStdString(code->verilog_netlist_net_name(netlist, w.net)));
+	}
+
+	// What is under the mouse is outlined on top of everything.
+	if(hovered != VERILOG_NETLIST_NONE) {
+		const yy::verilog_layout_box &b = index->item_box[hovered];
+		painter.setPen(QPen(QColor(255, 140, 0), 2 / scale));
+		painter.setBrush(Qt::NoBrush);
+		if(index->item_kind[hovered] == yy::LAYOUT_ITEM_PIN)
+			painter.drawEllipse(QPointF(b.x1, b.y1), 2, 2);
+		else if(index->item_kind[hovered] == yy::LAYOUT_ITEM_SEGMENT)
+			painter.drawLine(b.x1, b.y1, b.x2, b.y2);
+		else
+			painter.drawRect(QRect(b.x1, b.y1, b.x2 - b.x1, b.y2 - b.y1));
+	}
+}
+
+void VerilogSchematics::wheelEvent(QWheelEvent *event)
+{
+	// Zoom about the cursor.
+	double factor = std::pow(1.0015, event->angleDelta().y());
+	QPointF at = event->pos();
+	offset = at - (at - offset) * factor;
+	scale *= factor;
+	update();
+}
+
+void VerilogSchematics::mousePressEvent(QMouseEvent *event)
+{
+	dragged = pressed = event->pos();
+}
+
+void VerilogSchematics::mouseMoveEvent(QMouseEvent *event)
+{
+	if(event->buttons() & Qt::LeftButton) {
+		offset += event->pos() - dragged;
+		dragged = event->pos();
+		update();
+		return;
+	}
+
+	// Only the old and new outlines need redrawing.
+	unsigned int item = itemAt(event->pos());
+	if(item == hovered)
+		return;
+
+	yy::verilog_layout_index *index = layouts.value(module);
+	update(itemBounds(index, hovered));
+	update(itemBounds(index, item));
+	hovered = item;
+	emit itemHovered(describe(index, item));
+}
+
+void VerilogSchematics::mouseReleaseEvent(QMouseEvent *event)
+{
+	// A click rather than the end of a drag selects.
+	if((event->pos() - pressed).manhattanLength() > 3)
+		return;
+
+	selected = itemAt(event->pos());
+	update();
+}
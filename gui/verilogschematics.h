@@ -0,0 +1,70 @@
+#ifndef VERILOGSCHEMATICS_H
+#define VERILOGSCHEMATICS_H
+
+#include <QFutureWatcher>
+#include <QHash>
+#include <QPoint>
+#include <QPointF>
+#include <QRect>
+#include <QStringList>
+#include <QTransform>
+#include <QWidget>
+#include <vector>
+#include "verilogcode.h"
+
+/*
+ * Draws the schematic of one module at a time. Layouts are worked out on a
+ * worker thread, one at a time since they allocate from the parser's
+ * arena, and are kept per module, so showing a module again is instant.
+ * Painting and picking only look at what the spatial index of the layout
+ * finds in the area concerned, so they cost what is on screen.
+ */
+class VerilogSchematics : public QWidget
+{
+	Q_OBJECT
+private:
+	yy::VerilogCode *code;
+	yy::ast_module_declaration *module;
+	yy::ast_module_declaration *pending;
+	yy::ast_module_declaration *layingOut;
+	QHash<yy::ast_module_declaration*, yy::verilog_layout_index*> layouts;
+	QFutureWatcher<yy::verilog_layout_index*> watcher;
+	double scale;
+	QPointF offset;
+	QPoint dragged;
+	QPoint pressed;
+	unsigned int hovered;
+	unsigned int selected;
+	std::vector<unsigned int> found;
+
+	static yy::verilog_layout_index *layOut(yy::VerilogCode *code, yy::ast_module_declaration *module);
+	void startLayout(yy::ast_module_declaration *module);
+	void fit();
+	QTransform transform() const;
+	unsigned int itemAt(const QPoint &at) const;
+	unsigned int itemNet(yy::verilog_layout_index *index, unsigned int item) const;
+	QRect itemBounds(yy::verilog_layout_index *index, unsigned int item) const;
+	QString describe(yy::verilog_layout_index *index, unsigned int item) const;
+public:
+	explicit VerilogSchematics(QWidget *parent = nullptr);
+	~VerilogSchematics();
+	bool openFile(const QString &path);
+	QStringList moduleNames() const;
+signals:
+	void itemHovered(const QString &description);
+
+public slots:
+	void showModule(const QString &name);
+
+private slots:
+	void layoutFinished();
+
+protected:
+	void paintEvent(QPaintEvent *event);
+	void wheelEvent(QWheelEvent *event);
+	void mousePressEvent(QMouseEvent *event);
+	void mouseMoveEvent(QMouseEvent *event);
+	void mouseReleaseEvent(QMouseEvent *event);
+};
+
+#endif // VERILOGSCHEMATICS_H
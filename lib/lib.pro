@@ -0,0 +1,94 @@
+#-------------------------------------------------
+#
+# libqtverilog - the Verilog parser core as a static library.
+# It has no Qt dependency, so the GUI, the command line tool and the
+# benchmarks can all link it, and the hot parsing code is built once with
+# full optimisation.
+#
+#-------------------------------------------------
+
+CONFIG  -= qt
+CONFIG  += staticlib optimize_full thread
+
+TARGET = qtverilog
+TEMPLATE = lib
+
+INCLUDEPATH += ..
+
+#QMAKE_CXXFLAGS += -Werror=missing-prototypes
+#QMAKE_CXXFLAGS += -Werror=missing-declarations
+QMAKE_CXXFLAGS += -g
+#QMAKE_CXXFLAGS += -std=c++11
+QMAKE_CXXFLAGS += -std=c++0x
+
+# Trace output is only compiled into debug builds, see verilog_trace.hh
+CONFIG(debug, debug|release): DEFINES += VERILOG_TRACE_ENABLED
+
+SOURCES += \
+	../verilogcode.cpp \
+	../verilog_ast_common.cc \
+	../verilog_ast_mem.cc \
+	../verilog_ast_util.cc \
+	../verilog_preprocessor.cc \
+	../verilogscanner.cpp \
+	../verilog_ast.cc \
+	../verilog_parser_wrapper.cc \
+	../verilog_input.cc \
+	../verilog_stats.cc \
+	../verilog_trace.cc \
+	../verilog_project.cc \
+	../verilog_cache.cc \
+	../verilog_netlist.cc \
+	../verilog_sim.cc \
+	../verilog_layout.cc
+
+HEADERS += \
+	../verilog_ast_common.hh \
+	../verilog_ast.hh \
+	../verilog_ast_mem.hh \
+	../verilog_ast_util.hh \
+	../verilog_preprocessor.hh \
+	../verilogcode.h \
+	../verilogscanner.hh \
+	../verilog_input.hh \
+	../verilog_stats.hh \
+	../verilog_trace.hh \
+	../verilog_project.hh \
+	../verilog_cache.hh \
+	../verilog_netlist.hh \
+	../verilog_sim.hh \
+	../verilog_layout.hh
+
+FLEXSOURCES += ../verilog_scanner.ll
+BISONSOURCES += ../verilog_parser.yy
+
+flex.commands = flex++ --c++ --header-file=verilog.ll.hh -o verilog.ll.cc ${QMAKE_FILE_IN}
+flex.input = FLEXSOURCES
+flex.output = verilog.ll.cc
+flex.variable_out = SOURCES
+flex.depends = verilog.yy.hh
+flex.name = flex
+QMAKE_EXTRA_COMPILERS += flex
+
+flexheader.commands = @true
+flexheader.input = FLEXSOURCES
+flexheader.output = verilog.ll.hh
+flexheader.variable_out = HEADERS
+flexheader.name = flex header
+flexheader.depends = verilog.ll.cc
+QMAKE_EXTRA_COMPILERS += flexheader
+
+bison.commands = bison -Lc++ --defines=verilog.yy.hh --output=verilog.yy.cc -t ${QMAKE_FILE_IN}
+bison.input = BISONSOURCES
+bison.output = verilog.yy.cc
+bison.variable_out = SOURCES
+bison.name = bison
+QMAKE_EXTRA_COMPILERS += bison
+
+bisonheader.commands = @true
+bisonheader.input = BISONSOURCES
+bisonheader.output = verilog.yy.hh
+bisonheader.variable_out = HEADERS
+bisonheader.name = bison header
+bisonheader.depends = verilog.yy.cc
+QMAKE_EXTRA_COMPILERS += bisonheader
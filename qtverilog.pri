@@ -0,0 +1,25 @@
+#-------------------------------------------------
+#
+# Links a target against libqtverilog. Include this from any project which
+# lives one directory below this file, next to lib/.
+#
+#-------------------------------------------------
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+QMAKE_CXXFLAGS += -std=c++0x
+
+# parse_files runs a pool of std::thread workers.
+CONFIG += thread
+unix: LIBS += -pthread
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../lib/release/ -lqtverilog
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../lib/debug/ -lqtverilog
+else:unix: LIBS += -L$$OUT_PWD/../lib/ -lqtverilog
+
+win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../lib/release/libqtverilog.a
+else:win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../lib/debug/libqtverilog.a
+else:win32:!win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../lib/release/qtverilog.lib
+else:win32:!win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../lib/debug/qtverilog.lib
+else:unix: PRE_TARGETDEPS += $$OUT_PWD/../lib/libqtverilog.a
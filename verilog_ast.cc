@@ -27,7 +27,8 @@ meta data member.
 */
   void VerilogCode::ast_set_meta_info(ast_metadata * meta)
   {
-	meta->line = yylineno;
+	// Macros may be defined before any file is opened.
+	meta->line = lexer != NULL ? yylineno : 0;
 	meta->file = verilog_preprocessor_current_file(yy_preproc);
   }
 
@@ -36,7 +37,8 @@ meta data member.
 */
   ast_node_attributes * VerilogCode::ast_new_attributes(ast_identifier name, ast_expression * value)
   {
-    ast_node_attributes * tr = (ast_node_attributes *)ast_calloc(1, sizeof(ast_node_attributes));
+    ast_node_attributes * tr = ast_new<ast_node_attributes>();
+    stats.nodes[NODE_KIND_ATTRIBUTE] ++;
     tr->attr_name   = name;
     tr->attr_value  = value;
     return tr;
@@ -72,7 +74,8 @@ meta data member.
                    || type == GENVAR_IDENTIFIER
            || type == SPECPARAM_ID
            || type == PARAM_ID);
-    ast_lvalue * tr = (ast_lvalue *)ast_calloc(1, sizeof(ast_lvalue));
+    ast_lvalue * tr = ast_new<ast_lvalue>();
+    stats.nodes[NODE_KIND_LVALUE] ++;
         ast_set_meta_info(&(tr->meta_info));
     tr->type = type;
     tr->data.identifier = id;
@@ -88,7 +91,8 @@ meta data member.
   {
     assert(type == NET_CONCATENATION
            || type == VAR_CONCATENATION);
-    ast_lvalue * tr = (ast_lvalue *)ast_calloc(1, sizeof(ast_lvalue));
+    ast_lvalue * tr = ast_new<ast_lvalue>();
+    stats.nodes[NODE_KIND_LVALUE] ++;
         ast_set_meta_info(&(tr->meta_info));
     tr->type = type;
     tr->data.concatenation = concat;
@@ -134,7 +138,8 @@ a string representation.
 */
   ast_primary * VerilogCode::ast_new_constant_primary(ast_primary_value_type type)
   {
-	ast_primary * tr = (ast_primary *)ast_calloc(1, sizeof(ast_primary));
+	ast_primary * tr = ast_new<ast_primary>();
+	stats.nodes[NODE_KIND_PRIMARY] ++;
 		ast_set_meta_info(&(tr->meta_info));
 
 	tr->primary_type  = CONSTANT_PRIMARY;
@@ -149,7 +154,8 @@ a string representation.
 */
   ast_primary * VerilogCode::ast_new_primary_function_call(ast_function_call * call)
   {
-    ast_primary * tr = (ast_primary *)ast_calloc(1, sizeof(ast_primary));
+    ast_primary * tr = ast_new<ast_primary>();
+    stats.nodes[NODE_KIND_PRIMARY] ++;
         ast_set_meta_info(&(tr->meta_info));
     assert(tr!=NULL);
 
@@ -167,7 +173,8 @@ a string representation.
 */
   ast_primary * VerilogCode::ast_new_primary(ast_primary_value_type type)
   {
-    ast_primary * tr = (ast_primary *)ast_calloc(1, sizeof(ast_primary));
+    ast_primary * tr = ast_new<ast_primary>();
+    stats.nodes[NODE_KIND_PRIMARY] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->primary_type  = PRIMARY;
@@ -183,7 +190,8 @@ a string representation.
   ast_primary * VerilogCode::ast_new_module_path_primary(ast_primary_value_type type)
 
   {
-    ast_primary * tr = (ast_primary *)ast_calloc(1, sizeof(ast_primary));
+    ast_primary * tr = ast_new<ast_primary>();
+    stats.nodes[NODE_KIND_PRIMARY] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->primary_type  = MODULE_PATH_PRIMARY;
@@ -202,7 +210,8 @@ of the passed primary.
   ast_expression * VerilogCode::ast_new_expression_primary(ast_primary * p)
   {
     assert(sizeof(ast_expression) != 0);
-    ast_expression * tr = (ast_expression *)ast_calloc(1, sizeof(ast_expression));
+    ast_expression * tr = ast_new<ast_expression>();
+    stats.nodes[NODE_KIND_PRIMARY] ++;
         ast_set_meta_info(&(tr->meta_info));
     assert(tr != NULL);
 
@@ -352,7 +361,8 @@ if exp is NULL.
 */
   ast_expression * VerilogCode::ast_new_unary_expression(ast_primary * operand, ast_operator operation, ast_node_attributes * attr, bool constant)
   {
-    ast_expression * tr = (ast_expression *)ast_calloc(1, sizeof(ast_expression));
+    ast_expression * tr = ast_new<ast_expression>();
+    stats.nodes[NODE_KIND_EXPRESSION] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->operation     = operation;
@@ -376,7 +386,8 @@ if exp is NULL.
 */
   ast_expression * VerilogCode::ast_new_range_expression(ast_expression * left, ast_expression * right)
   {
-    ast_expression * tr = (ast_expression *)ast_calloc(1, sizeof(ast_expression));
+    ast_expression * tr = ast_new<ast_expression>();
+    stats.nodes[NODE_KIND_EXPRESSION] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->attributes    = NULL;
@@ -393,7 +404,8 @@ if exp is NULL.
 */
   ast_expression * VerilogCode::ast_new_index_expression(ast_expression * left)
   {
-    ast_expression * tr = (ast_expression *)ast_calloc(1, sizeof(ast_expression));
+    ast_expression * tr = ast_new<ast_expression>();
+    stats.nodes[NODE_KIND_EXPRESSION] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->attributes    = NULL;
@@ -412,7 +424,8 @@ and operands.
 */
   ast_expression * VerilogCode::ast_new_binary_expression(ast_expression * left, ast_expression * right, ast_operator operation, ast_node_attributes * attr, bool constant)
   {
-    ast_expression * tr = (ast_expression *)ast_calloc(1, sizeof(ast_expression));
+    ast_expression * tr = ast_new<ast_expression>();
+    stats.nodes[NODE_KIND_EXPRESSION] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->operation     = operation;
@@ -434,9 +447,10 @@ and operands.
   /*!
 @brief Creates a new string expression.
 */
-  ast_expression * VerilogCode::ast_new_string_expression(std::string string)
+  ast_expression * VerilogCode::ast_new_string_expression(const char * string)
   {
-    ast_expression * tr = (ast_expression *)ast_calloc(1, sizeof(ast_expression));
+    ast_expression * tr = ast_new<ast_expression>();
+    stats.nodes[NODE_KIND_EXPRESSION] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->attributes    = NULL;
@@ -462,7 +476,8 @@ on the right.
 */
   ast_expression * VerilogCode::ast_new_conditional_expression(ast_expression * condition, ast_expression * if_true, ast_expression * if_false, ast_node_attributes * attr)
   {
-    ast_expression * tr = (ast_expression *)ast_calloc(1, sizeof(ast_expression));
+    ast_expression * tr = ast_new<ast_expression>();
+    stats.nodes[NODE_KIND_EXPRESSION] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->attributes    = attr;
@@ -481,7 +496,8 @@ then the min and max arguments should be NULL, and only typ set.
 */
   ast_expression * VerilogCode::ast_new_mintypmax_expression(ast_expression * min, ast_expression * typ, ast_expression * max)
   {
-    ast_expression * tr = (ast_expression *)ast_calloc(1, sizeof(ast_expression));
+    ast_expression * tr = ast_new<ast_expression>();
+    stats.nodes[NODE_KIND_EXPRESSION] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->attributes    = NULL;
@@ -507,7 +523,8 @@ NULL, then an empty list is added automatically by the function.
 */
   ast_function_call * VerilogCode::ast_new_function_call(ast_identifier id, bool constant, bool system, ast_node_attributes * attr, ast_list * arguments)
   {
-    ast_function_call * tr = (ast_function_call *)ast_calloc(1, sizeof(ast_function_call));
+    ast_function_call * tr = ast_new<ast_function_call>();
+    stats.nodes[NODE_KIND_EXPRESSION] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->function  = id;
@@ -542,7 +559,8 @@ should be:
 */
   ast_concatenation * VerilogCode::ast_new_concatenation(ast_concatenation_type type, ast_expression * repeat, void * first_value)
   {
-    ast_concatenation * tr = (ast_concatenation *)ast_calloc(1,sizeof(ast_concatenation));
+    ast_concatenation * tr = ast_new<ast_concatenation>();
+    stats.nodes[NODE_KIND_CONCATENATION] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->repeat = repeat;
@@ -558,7 +576,8 @@ should be:
 */
   ast_concatenation * VerilogCode::ast_new_empty_concatenation(ast_concatenation_type type)
   {
-    ast_concatenation * tr = (ast_concatenation *)ast_calloc(1,sizeof(ast_concatenation));
+    ast_concatenation * tr = ast_new<ast_concatenation>();
+    stats.nodes[NODE_KIND_CONCATENATION] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->repeat = NULL;
@@ -590,7 +609,8 @@ be filled in manually;
 */
   ast_path_declaration * VerilogCode::ast_new_path_declaration(ast_path_declaration_type type)
   {
-    ast_path_declaration * tr = (ast_path_declaration *)ast_calloc(1,sizeof(ast_path_declaration));
+    ast_path_declaration * tr = ast_new<ast_path_declaration>();
+    stats.nodes[NODE_KIND_PATH] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type = type;
@@ -609,7 +629,8 @@ be filled in manually;
                   ast_list * delay_value
                   )
   {
-    ast_simple_parallel_path_declaration * tr = (ast_simple_parallel_path_declaration *)ast_calloc(1, sizeof(ast_simple_parallel_path_declaration));
+    ast_simple_parallel_path_declaration * tr = ast_new<ast_simple_parallel_path_declaration>();
+    stats.nodes[NODE_KIND_PATH] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->input_terminal = input_terminal;
@@ -632,7 +653,8 @@ be filled in manually;
       ast_list        *   delay_value
       )
   {
-    ast_simple_full_path_declaration * tr = (ast_simple_full_path_declaration *)ast_calloc(1,sizeof(ast_simple_full_path_declaration));
+    ast_simple_full_path_declaration * tr = ast_new<ast_simple_full_path_declaration>();
+    stats.nodes[NODE_KIND_PATH] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->input_terminals= input_terminals;
@@ -656,7 +678,8 @@ be filled in manually;
       ast_list        *   delay_value         //!< path_delay_value
       )
   {
-    ast_edge_sensitive_parallel_path_declaration * tr = (ast_edge_sensitive_parallel_path_declaration *)ast_calloc(1,sizeof(ast_edge_sensitive_parallel_path_declaration));
+    ast_edge_sensitive_parallel_path_declaration * tr = ast_new<ast_edge_sensitive_parallel_path_declaration>();
+    stats.nodes[NODE_KIND_PATH] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->edge            = edge           ;
@@ -682,7 +705,8 @@ be filled in manually;
       ast_list        *   delay_value         //!< path_delay_value
       )
   {
-    ast_edge_sensitive_full_path_declaration * tr = (ast_edge_sensitive_full_path_declaration *)ast_calloc(1,sizeof(ast_edge_sensitive_full_path_declaration));
+    ast_edge_sensitive_full_path_declaration * tr = ast_new<ast_edge_sensitive_full_path_declaration>();
+    stats.nodes[NODE_KIND_PATH] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->edge            = edge           ;
@@ -705,7 +729,8 @@ be filled in manually;
       bool       is_system
       )
   {
-    ast_task_enable_statement * tr = (ast_task_enable_statement *)ast_calloc(1,sizeof(ast_task_enable_statement));
+    ast_task_enable_statement * tr = ast_new<ast_task_enable_statement>();
+    stats.nodes[NODE_KIND_STATEMENT] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->expressions = expressions;
@@ -725,7 +750,8 @@ make upt the loop body.
       ast_statement * inner_statement
       )
   {
-    ast_loop_statement * tr = (ast_loop_statement *)ast_calloc(1,sizeof(ast_loop_statement));
+    ast_loop_statement * tr = ast_new<ast_loop_statement>();
+    stats.nodes[NODE_KIND_STATEMENT] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type              = LOOP_FOREVER;
@@ -755,7 +781,8 @@ continue or break.
       ast_expression * continue_condition
       )
   {
-    ast_loop_statement * tr = (ast_loop_statement *)ast_calloc(1,sizeof(ast_loop_statement));
+    ast_loop_statement * tr = ast_new<ast_loop_statement>();
+    stats.nodes[NODE_KIND_STATEMENT] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type              = LOOP_FOR;
@@ -808,7 +835,8 @@ continue or break.
       ast_expression * continue_condition
       )
   {
-    ast_loop_statement * tr = (ast_loop_statement *)ast_calloc(1,sizeof(ast_loop_statement));
+    ast_loop_statement * tr = ast_new<ast_loop_statement>();
+    stats.nodes[NODE_KIND_STATEMENT] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type              = LOOP_WHILE;
@@ -832,7 +860,8 @@ continue or break.
       ast_expression * continue_condition
       )
   {
-    ast_loop_statement * tr = (ast_loop_statement *)ast_calloc(1,sizeof(ast_loop_statement));
+    ast_loop_statement * tr = ast_new<ast_loop_statement>();
+    stats.nodes[NODE_KIND_STATEMENT] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type              = LOOP_REPEAT;
@@ -852,7 +881,8 @@ continue or break.
 */
   ast_case_item * VerilogCode::ast_new_case_item(ast_list * conditions, ast_statement * body)
   {
-    ast_case_item * tr = (ast_case_item *)ast_calloc(1,sizeof(ast_case_item));
+    ast_case_item * tr = ast_new<ast_case_item>();
+    stats.nodes[NODE_KIND_STATEMENT] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->conditions = conditions;
@@ -872,7 +902,8 @@ continue or break.
                                               ast_list       * cases,
                                               ast_case_statement_type type)
   {
-    ast_case_statement * tr = (ast_case_statement *)ast_calloc(1,sizeof(ast_case_statement));
+    ast_case_statement * tr = ast_new<ast_case_statement>();
+    stats.nodes[NODE_KIND_STATEMENT] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->expression = expression;
@@ -914,7 +945,8 @@ continue or break.
       ast_expression * condition
       )
   {
-    ast_conditional_statement * tr = (ast_conditional_statement *)ast_calloc(1,sizeof(ast_conditional_statement));
+    ast_conditional_statement * tr = ast_new<ast_conditional_statement>();
+    stats.nodes[NODE_KIND_STATEMENT] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->statement = statement;
@@ -939,7 +971,8 @@ Priority of exectuion is given to items added first.
       ast_statement             * else_condition
       )
   {
-    ast_if_else * tr = (ast_if_else *)ast_calloc(1, sizeof(ast_if_else));
+    ast_if_else * tr = ast_new<ast_if_else>();
+    stats.nodes[NODE_KIND_STATEMENT] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->else_condition         = else_condition;
@@ -979,7 +1012,8 @@ if-then conditions, but before any else_condtion.
       ast_statement  * statement
       )
   {
-    ast_wait_statement * tr = (ast_wait_statement *)ast_calloc(1, sizeof(ast_wait_statement));
+    ast_wait_statement * tr = ast_new<ast_wait_statement>();
+    stats.nodes[NODE_KIND_STATEMENT] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->expression = wait_for;
@@ -999,7 +1033,8 @@ if-then conditions, but before any else_condtion.
       ast_expression * expression
       )
   {
-    ast_event_expression * tr = (ast_event_expression *)ast_calloc(1,sizeof(ast_event_expression));
+    ast_event_expression * tr = ast_new<ast_event_expression>();
+    stats.nodes[NODE_KIND_TIMING] ++;
 
     //assert(trigger_edge != EDGE_NONE);
 
@@ -1031,7 +1066,8 @@ sub-expressions.
       ast_event_expression * right
       )
   {
-    ast_event_expression * tr = (ast_event_expression *)ast_calloc(1,sizeof(ast_event_expression));
+    ast_event_expression * tr = ast_new<ast_event_expression>();
+    stats.nodes[NODE_KIND_TIMING] ++;
 
     tr->type = EVENT_SEQUENCE;
     tr->sequence = ast_list_new();
@@ -1050,7 +1086,8 @@ sub-expressions.
       ast_event_expression * expression
       )
   {
-    ast_event_control * tr = (ast_event_control *)ast_calloc(1,sizeof(ast_event_control));
+    ast_event_control * tr = ast_new<ast_event_control>();
+    stats.nodes[NODE_KIND_TIMING] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     if(type == EVENT_CTRL_ANY)
@@ -1067,7 +1104,8 @@ sub-expressions.
 */
   ast_delay_ctrl * VerilogCode::ast_new_delay_ctrl_value(ast_delay_value * value)
   {
-    ast_delay_ctrl * tr = (ast_delay_ctrl *)ast_calloc(1,sizeof(ast_event_control));
+    ast_delay_ctrl * tr = ast_new<ast_delay_ctrl>();
+    stats.nodes[NODE_KIND_TIMING] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type = DELAY_CTRL_VALUE;
@@ -1083,7 +1121,8 @@ sub-expressions.
       ast_expression * mintypmax
       )
   {
-    ast_delay_ctrl * tr = (ast_delay_ctrl *)ast_calloc(1,sizeof(ast_event_control));
+    ast_delay_ctrl * tr = ast_new<ast_delay_ctrl>();
+    stats.nodes[NODE_KIND_TIMING] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type = DELAY_CTRL_MINTYPMAX;
@@ -1101,7 +1140,8 @@ sub-expressions.
       ast_delay_ctrl                    * delay_ctrl
       )
   {
-    ast_timing_control_statement * tr = (ast_timing_control_statement *)ast_calloc(1,sizeof(ast_timing_control_statement));
+    ast_timing_control_statement * tr = ast_new<ast_timing_control_statement>();
+    stats.nodes[NODE_KIND_STATEMENT] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     assert(type == TIMING_CTRL_DELAY_CONTROL);
@@ -1125,7 +1165,8 @@ sub-expressions.
       ast_event_control                 * event_ctrl
       )
   {
-    ast_timing_control_statement * tr = (ast_timing_control_statement *)ast_calloc(1,sizeof(ast_timing_control_statement));
+    ast_timing_control_statement * tr = ast_new<ast_timing_control_statement>();
+    stats.nodes[NODE_KIND_STATEMENT] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     assert(type == TIMING_CTRL_EVENT_CONTROL ||
@@ -1147,7 +1188,8 @@ sub-expressions.
       ast_expression * expression
       )
   {
-    ast_single_assignment * tr = (ast_single_assignment *)ast_calloc(1,sizeof(ast_single_assignment));
+    ast_single_assignment * tr = ast_new<ast_single_assignment>();
+    stats.nodes[NODE_KIND_STATEMENT] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->lval = lval;
@@ -1164,11 +1206,12 @@ sub-expressions.
       ast_single_assignment * assignment
       )
   {
-    ast_assignment * tr = (ast_assignment *)ast_calloc(1,sizeof(ast_assignment));
+    ast_assignment * tr = ast_new<ast_assignment>();
+    stats.nodes[NODE_KIND_STATEMENT] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type = ASSIGNMENT_HYBRID;
-    tr->hybrid = (ast_hybrid_assignment *)ast_calloc(1,sizeof(ast_hybrid_assignment));
+    tr->hybrid = ast_new<ast_hybrid_assignment>();
     tr->hybrid->type = type;
     tr->hybrid->assignment = assignment;
 
@@ -1184,11 +1227,12 @@ sub-expressions.
       ast_lvalue *lval
       )
   {
-    ast_assignment * tr = (ast_assignment *)ast_calloc(1,sizeof(ast_assignment));
+    ast_assignment * tr = ast_new<ast_assignment>();
+    stats.nodes[NODE_KIND_STATEMENT] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type = ASSIGNMENT_HYBRID;
-    tr->hybrid = (ast_hybrid_assignment *)ast_calloc(1,sizeof(ast_hybrid_assignment));
+    tr->hybrid = ast_new<ast_hybrid_assignment>();
     tr->hybrid->type = type;
     tr->hybrid->lval = lval;
 
@@ -1204,11 +1248,12 @@ sub-expressions.
       ast_timing_control_statement* delay_or_event
       )
   {
-    ast_assignment * tr = (ast_assignment *)ast_calloc(1,sizeof(ast_assignment));
+    ast_assignment * tr = ast_new<ast_assignment>();
+    stats.nodes[NODE_KIND_STATEMENT] ++;
         ast_set_meta_info(&(tr->meta_info));
     tr->type          = ASSIGNMENT_BLOCKING;
 
-    tr->procedural = (ast_procedural_assignment *)ast_calloc(1,sizeof(ast_procedural_assignment));
+    tr->procedural = ast_new<ast_procedural_assignment>();
     tr->procedural->lval = lval;
     tr->procedural->expression = expression;
     tr->procedural->delay_or_event = delay_or_event;
@@ -1225,11 +1270,12 @@ sub-expressions.
       ast_timing_control_statement * delay_or_event
       )
   {
-    ast_assignment * tr = (ast_assignment *)ast_calloc(1,sizeof(ast_assignment));
+    ast_assignment * tr = ast_new<ast_assignment>();
+    stats.nodes[NODE_KIND_STATEMENT] ++;
         ast_set_meta_info(&(tr->meta_info));
     tr->type          = ASSIGNMENT_NONBLOCKING;
 
-    tr->procedural = (ast_procedural_assignment *)ast_calloc(1,sizeof(ast_procedural_assignment));
+    tr->procedural = ast_new<ast_procedural_assignment>();
     tr->procedural->lval = lval;
     tr->procedural->expression = expression;
     tr->procedural->delay_or_event = delay_or_event;
@@ -1247,7 +1293,8 @@ sub-expressions.
       ast_delay3 * delay
       )
   {
-    ast_continuous_assignment * trc = (ast_continuous_assignment *)ast_calloc(1, sizeof(ast_continuous_assignment));
+    ast_continuous_assignment * trc = ast_new<ast_continuous_assignment>();
+    stats.nodes[NODE_KIND_STATEMENT] ++;
     trc->assignments = assignments;
 
     unsigned int i;
@@ -1258,7 +1305,7 @@ sub-expressions.
         item->delay = delay;
       }
 
-    ast_assignment * tr = (ast_assignment *)ast_calloc(1, sizeof(ast_assignment));
+    ast_assignment * tr = ast_new<ast_assignment>();
 
         ast_set_meta_info(&(tr->meta_info));
 
@@ -1279,7 +1326,8 @@ sub-expressions.
       ast_list       * statements
       )
   {
-    ast_statement_block * tr = (ast_statement_block *)ast_calloc(1,sizeof(ast_statement_block));
+    ast_statement_block * tr = ast_new<ast_statement_block>();
+    stats.nodes[NODE_KIND_STATEMENT] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type = type;
@@ -1293,7 +1341,8 @@ sub-expressions.
   //! Creates and returns a pointer to a new disable statement.
   ast_disable_statement * VerilogCode::ast_new_disable_statement(ast_identifier id)
   {
-    ast_disable_statement * tr = (ast_disable_statement *)ast_calloc(1, sizeof(ast_disable_statement));
+    ast_disable_statement * tr = ast_new<ast_disable_statement>();
+    stats.nodes[NODE_KIND_STATEMENT] ++;
         ast_set_meta_info(&(tr->meta_info));
     tr->id = id;
     return tr;
@@ -1311,7 +1360,8 @@ sub-expressions.
       ast_statement_type  type
       )
   {
-    ast_statement * tr = (ast_statement *)ast_calloc(1,sizeof(ast_statement));
+    ast_statement * tr = ast_new<ast_statement>();
+    stats.nodes[NODE_KIND_STATEMENT] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type = type;
@@ -1337,7 +1387,8 @@ sub-expressions.
       ast_expression      * default_value
       )
   {
-    ast_udp_port * tr = (ast_udp_port *)ast_calloc(1,sizeof(ast_udp_port));
+    ast_udp_port * tr = ast_new<ast_udp_port>();
+    stats.nodes[NODE_KIND_UDP] ++;
         ast_set_meta_info(&(tr->meta_info));
     tr->direction     = direction;
     assert(direction != PORT_INPUT);
@@ -1359,7 +1410,8 @@ sub-expressions.
       ast_node_attributes * attributes
       )
   {
-    ast_udp_port * tr = (ast_udp_port *)ast_calloc(1,sizeof(ast_udp_port));
+    ast_udp_port * tr = ast_new<ast_udp_port>();
+    stats.nodes[NODE_KIND_UDP] ++;
         ast_set_meta_info(&(tr->meta_info));
     tr->direction     = PORT_INPUT;
     tr->identifiers   = identifiers;
@@ -1381,7 +1433,8 @@ sub-expressions.
       ast_udp_body        * body
       )
   {
-    ast_udp_declaration * tr = (ast_udp_declaration *)ast_calloc(1,sizeof(ast_udp_declaration));
+    ast_udp_declaration * tr = ast_new<ast_udp_declaration>();
+    stats.nodes[NODE_KIND_UDP] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->attributes    = attributes;
@@ -1405,7 +1458,8 @@ sub-expressions.
       ast_lvalue          * output,
       ast_list            * inputs
       ){
-    ast_udp_instance * tr = (ast_udp_instance *)ast_calloc(1,sizeof(ast_udp_instance));
+    ast_udp_instance * tr = ast_new<ast_udp_instance>();
+    stats.nodes[NODE_KIND_UDP] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->identifier    = identifier;
@@ -1427,7 +1481,8 @@ sub-expressions.
       ast_drive_strength  * drive_strength,
       ast_delay2          * delay
       ){
-    ast_udp_instantiation * tr = (ast_udp_instantiation *)ast_calloc(1,sizeof(ast_udp_instantiation));
+    ast_udp_instantiation * tr = ast_new<ast_udp_instantiation>();
+    stats.nodes[NODE_KIND_UDP] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->instances     = instances;
@@ -1444,7 +1499,8 @@ sub-expressions.
       ast_identifier   output_port,
       ast_number     * initial_value
       ){
-    ast_udp_initial_statement *tr = (ast_udp_initial_statement *)ast_calloc(1,sizeof(ast_udp_initial_statement));
+    ast_udp_initial_statement *tr = ast_new<ast_udp_initial_statement>();
+    stats.nodes[NODE_KIND_UDP] ++;
 
     tr->output_port   = output_port;
     tr->initial_value = initial_value;
@@ -1458,7 +1514,8 @@ sub-expressions.
       ast_udp_initial_statement * initial_statement,
       ast_list                  * sequential_entries
       ){
-    ast_udp_body * tr = (ast_udp_body *)ast_calloc(1,sizeof(ast_udp_body));
+    ast_udp_body * tr = ast_new<ast_udp_body>();
+    stats.nodes[NODE_KIND_UDP] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->body_type = UDP_BODY_SEQUENTIAL;
@@ -1472,7 +1529,8 @@ sub-expressions.
   ast_udp_body * VerilogCode::ast_new_udp_combinatoral_body(
       ast_list                  * combinatorial_entries
       ){
-    ast_udp_body * tr = (ast_udp_body *)ast_calloc(1,sizeof(ast_udp_body));
+    ast_udp_body * tr = ast_new<ast_udp_body>();
+    stats.nodes[NODE_KIND_UDP] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->body_type = UDP_BODY_COMBINATORIAL;
@@ -1486,7 +1544,8 @@ sub-expressions.
       ast_list * input_levels,
       ast_udp_next_state output_symbol
       ){
-    ast_udp_combinatorial_entry * tr = (ast_udp_combinatorial_entry *)ast_calloc(1,sizeof(ast_udp_combinatorial_entry));
+    ast_udp_combinatorial_entry * tr = ast_new<ast_udp_combinatorial_entry>();
+    stats.nodes[NODE_KIND_UDP] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->input_levels = input_levels;
@@ -1502,7 +1561,8 @@ sub-expressions.
       ast_level_symbol               current_state,
       ast_udp_next_state             output
       ){
-    ast_udp_sequential_entry * tr = (ast_udp_sequential_entry *)ast_calloc(1, sizeof(ast_udp_sequential_entry));
+    ast_udp_sequential_entry * tr = ast_new<ast_udp_sequential_entry>();
+    stats.nodes[NODE_KIND_UDP] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->entry_prefix = prefix_type;
@@ -1545,7 +1605,8 @@ ast_generate_item structure.
       ast_identifier   identifier,
       ast_list       * generate_items
       ){
-    ast_generate_block * tr = (ast_generate_block *)ast_calloc(1,sizeof(ast_generate_block));
+    ast_generate_block * tr = ast_new<ast_generate_block>();
+    stats.nodes[NODE_KIND_GENERATE] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->generate_items = generate_items;
@@ -1564,7 +1625,8 @@ parameters.
       ast_list              * module_parameters,
       ast_list              * module_instances
       ){
-    ast_module_instantiation * tr = (ast_module_instantiation *)ast_calloc(1,sizeof(ast_module_instantiation));
+    ast_module_instantiation * tr = ast_new<ast_module_instantiation>();
+    stats.nodes[NODE_KIND_MODULE_INSTANTIATION] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->resolved = false;
@@ -1583,7 +1645,8 @@ and set of port connections.
       ast_identifier          instance_identifier,
       ast_list              * port_connections
       ){
-    ast_module_instance * tr = (ast_module_instance *)ast_calloc(1,sizeof(ast_module_instance));
+    ast_module_instance * tr = ast_new<ast_module_instance>();
+    stats.nodes[NODE_KIND_MODULE_INSTANCE] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->instance_identifier = instance_identifier;
@@ -1601,7 +1664,8 @@ and set of port connections.
       ast_identifier   port_name,
       ast_expression * expression
       ){
-    ast_port_connection * tr = (ast_port_connection *)ast_calloc(1,sizeof(ast_port_connection));
+    ast_port_connection * tr = ast_new<ast_port_connection>();
+    stats.nodes[NODE_KIND_PORT_CONNECTION] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->port_name = port_name;
@@ -1617,7 +1681,8 @@ and set of port connections.
       ast_delay3    * delay
       ){
     assert(type != SWITCH_TRAN && type != SWITCH_RTRAN);
-    ast_switch_gate * tr = (ast_switch_gate *)ast_calloc(1,sizeof(ast_switch_gate));
+    ast_switch_gate * tr = ast_new<ast_switch_gate>();
+    stats.nodes[NODE_KIND_GATE] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type   = type;
@@ -1632,7 +1697,8 @@ and set of port connections.
       ast_delay2    * delay
       ){
     assert(type == SWITCH_TRAN || type == SWITCH_RTRAN);
-    ast_switch_gate * tr = (ast_switch_gate *)ast_calloc(1,sizeof(ast_switch_gate));
+    ast_switch_gate * tr = ast_new<ast_switch_gate>();
+    stats.nodes[NODE_KIND_GATE] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type   = type;
@@ -1647,7 +1713,8 @@ and set of port connections.
       ast_primitive_strength   strength_1,
       ast_primitive_strength   strength_0
       ){
-    ast_primitive_pull_strength * tr = (ast_primitive_pull_strength *)ast_calloc(1,sizeof(ast_primitive_pull_strength));
+    ast_primitive_pull_strength * tr = ast_new<ast_primitive_pull_strength>();
+    stats.nodes[NODE_KIND_GATE] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->direction  = direction;
@@ -1662,7 +1729,8 @@ and set of port connections.
       ast_identifier      name,
       ast_lvalue        * output_terminal
       ){
-    ast_pull_gate_instance * tr = (ast_pull_gate_instance *)ast_calloc(1,sizeof(ast_pull_gate_instance));
+    ast_pull_gate_instance * tr = ast_new<ast_pull_gate_instance>();
+    stats.nodes[NODE_KIND_GATE] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->name = name;
@@ -1677,7 +1745,8 @@ and set of port connections.
       ast_lvalue        * terminal_1,
       ast_lvalue        * terminal_2
       ){
-    ast_pass_switch_instance * tr = (ast_pass_switch_instance *)ast_calloc(1,sizeof(ast_pass_switch_instance));
+    ast_pass_switch_instance * tr = ast_new<ast_pass_switch_instance>();
+    stats.nodes[NODE_KIND_GATE] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->name = name;
@@ -1693,7 +1762,8 @@ and set of port connections.
       ast_list          * input_terminals,
       ast_lvalue        * output_terminal
       ){
-    ast_n_input_gate_instance * tr = (ast_n_input_gate_instance *)ast_calloc(1,sizeof(ast_n_input_gate_instance));
+    ast_n_input_gate_instance * tr = ast_new<ast_n_input_gate_instance>();
+    stats.nodes[NODE_KIND_GATE] ++;
 
     tr->name = name;
     tr->input_terminals = input_terminals;
@@ -1709,7 +1779,8 @@ and set of port connections.
       ast_expression    * enable_terminal,
       ast_expression    * input_terminal
       ){
-    ast_enable_gate_instance * tr = (ast_enable_gate_instance *)ast_calloc(1,sizeof(ast_enable_gate_instance));
+    ast_enable_gate_instance * tr = ast_new<ast_enable_gate_instance>();
+    stats.nodes[NODE_KIND_GATE] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->name = name;
@@ -1727,7 +1798,8 @@ and set of port connections.
       ast_expression    * enable_terminal,
       ast_expression    * input_terminal
       ){
-    ast_mos_switch_instance * tr = (ast_mos_switch_instance *)ast_calloc(1,sizeof(ast_mos_switch_instance));
+    ast_mos_switch_instance * tr = ast_new<ast_mos_switch_instance>();
+    stats.nodes[NODE_KIND_GATE] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->name = name;
@@ -1746,7 +1818,8 @@ and set of port connections.
       ast_expression    * pcontrol_terminal,
       ast_expression    * input_terminal
       ){
-    ast_cmos_switch_instance * tr = (ast_cmos_switch_instance *)ast_calloc(1,sizeof(ast_cmos_switch_instance));
+    ast_cmos_switch_instance * tr = ast_new<ast_cmos_switch_instance>();
+    stats.nodes[NODE_KIND_GATE] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->name = name;
@@ -1767,7 +1840,8 @@ and set of port connections.
       ast_lvalue        * terminal_2,
       ast_expression    * enable
       ){
-    ast_pass_enable_switch * tr = (ast_pass_enable_switch *)ast_calloc(1,sizeof(ast_pass_enable_switch));
+    ast_pass_enable_switch * tr = ast_new<ast_pass_enable_switch>();
+    stats.nodes[NODE_KIND_GATE] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->name = name;
@@ -1787,7 +1861,8 @@ and set of port connections.
       ast_delay2                  * delay,
       ast_list                    * switches
       ){
-    ast_pass_enable_switches * tr = (ast_pass_enable_switches *)ast_calloc(1,sizeof(ast_pass_enable_switches));
+    ast_pass_enable_switches * tr = ast_new<ast_pass_enable_switches>();
+    stats.nodes[NODE_KIND_GATE] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type = type;
@@ -1807,7 +1882,8 @@ and set of port connections.
       ast_drive_strength    * drive_strength,
       ast_list              * instances
       ){
-    ast_n_input_gate_instances * tr = (ast_n_input_gate_instances *)ast_calloc(1,sizeof(ast_n_input_gate_instances));
+    ast_n_input_gate_instances * tr = ast_new<ast_n_input_gate_instances>();
+    stats.nodes[NODE_KIND_GATE] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type = type;
@@ -1825,7 +1901,8 @@ and set of port connections.
       ast_drive_strength    * drive_strength,
       ast_list              * instances
       ){
-    ast_enable_gate_instances * tr = (ast_enable_gate_instances *)ast_calloc(1,sizeof(ast_enable_gate_instances));
+    ast_enable_gate_instances * tr = ast_new<ast_enable_gate_instances>();
+    stats.nodes[NODE_KIND_GATE] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type = (ast_enable_gatetype)type_e;
@@ -1846,7 +1923,8 @@ and set of port connections.
       ast_list                    * outputs,
       ast_expression              * input
       ){
-    ast_n_output_gate_instance * tr = (ast_n_output_gate_instance *)ast_calloc(1,sizeof(ast_n_output_gate_instance));
+    ast_n_output_gate_instance * tr = ast_new<ast_n_output_gate_instance>();
+    stats.nodes[NODE_KIND_GATE] ++;
 
     tr->name = name;
     tr->outputs = outputs;
@@ -1864,7 +1942,8 @@ and set of port connections.
       ast_drive_strength          * drive_strength,
       ast_list                    * instances
       ){
-    ast_n_output_gate_instances * tr = (ast_n_output_gate_instances *)ast_calloc(1,sizeof(ast_n_output_gate_instances));
+    ast_n_output_gate_instances * tr = ast_new<ast_n_output_gate_instances>();
+    stats.nodes[NODE_KIND_GATE] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type = type;
@@ -1880,7 +1959,8 @@ and set of port connections.
 */
   ast_switches * VerilogCode::ast_new_switches(ast_switch_gate * type, ast_list * switches)
   {
-    ast_switches * tr = (ast_switches *)ast_calloc(1,sizeof(ast_switches));
+    ast_switches * tr = ast_new<ast_switches>();
+    stats.nodes[NODE_KIND_GATE] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type = type;
@@ -1894,7 +1974,8 @@ and set of port connections.
       ast_primitive_strength strength_1,
       ast_primitive_strength strength_2
       ){
-    ast_pull_strength * tr = (ast_pull_strength *)ast_calloc(1,sizeof(ast_pull_strength));
+    ast_pull_strength * tr = ast_new<ast_pull_strength>();
+    stats.nodes[NODE_KIND_GATE] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->strength_1 = strength_1;
@@ -1910,7 +1991,8 @@ is returned.
 */
   ast_gate_instantiation * VerilogCode::ast_new_gate_instantiation(ast_gate_type type)
   {
-    ast_gate_instantiation * tr = (ast_gate_instantiation *)ast_calloc(1,sizeof(ast_gate_instantiation));
+    ast_gate_instantiation * tr = ast_new<ast_gate_instantiation>();
+    stats.nodes[NODE_KIND_GATE] ++;
         ast_set_meta_info(&(tr->meta_info));
     tr->type = type;
     return tr;
@@ -1930,7 +2012,8 @@ is returned.
       ast_range       * range,
       ast_parameter_type  type
       ){
-    ast_parameter_declarations * tr = (ast_parameter_declarations *)ast_calloc(1,sizeof(ast_parameter_declarations));
+    ast_parameter_declarations * tr = ast_new<ast_parameter_declarations>();
+    stats.nodes[NODE_KIND_DECLARATION] ++;
         ast_set_meta_info(&(tr->meta_info));
 
 
@@ -1960,7 +2043,8 @@ is returned.
       ast_range         * range,          //!< [in] Bus width.
       ast_list          * port_names      //!< [in] The names of the ports.
       ){
-    ast_port_declaration * tr = (ast_port_declaration *)ast_calloc(1,sizeof(ast_port_declaration));
+    ast_port_declaration * tr = ast_new<ast_port_declaration>();
+    stats.nodes[NODE_KIND_DECLARATION] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->direction   =  direction  ;
@@ -1986,7 +2070,8 @@ initially be false.
 */
   ast_type_declaration * VerilogCode::ast_new_type_declaration(ast_declaration_type type)
   {
-    ast_type_declaration * tr = (ast_type_declaration *)ast_calloc(1,sizeof(ast_type_declaration));
+    ast_type_declaration * tr = ast_new<ast_type_declaration>();
+    stats.nodes[NODE_KIND_DECLARATION] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type = type;
@@ -2021,7 +2106,8 @@ in the original type declaration object.
     unsigned int i = 0;
     for (i = 0; i < type_dec->identifiers->items; i ++)
       {
-        ast_net_declaration * toadd = (ast_net_declaration *)ast_calloc(1,sizeof(ast_net_declaration));
+        ast_net_declaration * toadd = ast_new<ast_net_declaration>();
+        stats.nodes[NODE_KIND_DECLARATION] ++;
                 toadd->meta_info       = type_dec->meta_info;
 
         toadd->identifier = (ast_identifier)ast_list_get(type_dec->identifiers, i);
@@ -2055,7 +2141,8 @@ in the original type declaration object.
     unsigned int i = 0;
     for (i = 0; i < type_dec->identifiers->items; i ++)
       {
-        ast_reg_declaration * toadd = (ast_reg_declaration *)ast_calloc(1,sizeof(ast_reg_declaration));
+        ast_reg_declaration * toadd = ast_new<ast_reg_declaration>();
+        stats.nodes[NODE_KIND_DECLARATION] ++;
                 toadd->meta_info       = type_dec->meta_info;
 
         toadd->identifier = (ast_identifier)ast_list_get(type_dec->identifiers, i);
@@ -2084,7 +2171,8 @@ in the original type declaration object.
     unsigned int i = 0;
     for (i = 0; i < type_dec->identifiers->items; i ++)
       {
-        ast_var_declaration * toadd = (ast_var_declaration *)ast_calloc(1,sizeof(ast_var_declaration));
+        ast_var_declaration * toadd = ast_new<ast_var_declaration>();
+        stats.nodes[NODE_KIND_DECLARATION] ++;
                 toadd->meta_info       = type_dec->meta_info;
 
         toadd->identifier = (ast_identifier)ast_list_get(type_dec->identifiers,i);
@@ -2103,7 +2191,8 @@ in the original type declaration object.
       ast_delay_value_type type,
       void * data
       ){
-    ast_delay_value * tr = (ast_delay_value *)ast_calloc(1,sizeof(ast_delay_value));
+    ast_delay_value * tr = ast_new<ast_delay_value>();
+    stats.nodes[NODE_KIND_TIMING] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type = type;
@@ -2120,7 +2209,8 @@ in the original type declaration object.
       ast_delay_value * avg,
       ast_delay_value * max
       ){
-    ast_delay3 * tr = (ast_delay3 *)ast_calloc(1,sizeof(ast_delay3));
+    ast_delay3 * tr = ast_new<ast_delay3>();
+    stats.nodes[NODE_KIND_TIMING] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->min = min;
@@ -2137,7 +2227,8 @@ in the original type declaration object.
       ast_delay_value * min,
       ast_delay_value * max
       ){
-    ast_delay2 * tr = (ast_delay2 *)ast_calloc(1,sizeof(ast_delay2));
+    ast_delay2 * tr = ast_new<ast_delay2>();
+    stats.nodes[NODE_KIND_TIMING] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->min = min;
@@ -2154,7 +2245,8 @@ in the original type declaration object.
       ast_expression * reject_limit,
       ast_expression * error_limit
       ){
-    ast_pulse_control_specparam * tr = (ast_pulse_control_specparam *)ast_calloc(1,sizeof(ast_pulse_control_specparam));
+    ast_pulse_control_specparam * tr = ast_new<ast_pulse_control_specparam>();
+    stats.nodes[NODE_KIND_PATH] ++;
 
     tr->reject_limit = reject_limit;
     tr->error_limit  = error_limit;
@@ -2170,7 +2262,8 @@ in the original type declaration object.
       ast_expression * upper,
       ast_expression * lower
       ){
-    ast_range * tr = (ast_range *)ast_calloc(1,sizeof(ast_range));
+    ast_range * tr = ast_new<ast_range>();
+    stats.nodes[NODE_KIND_RANGE] ++;
 
     tr->upper = upper;
     tr->lower = lower;
@@ -2186,7 +2279,8 @@ else false.
 */
   ast_range_or_type * VerilogCode::ast_new_range_or_type(bool is_range)
   {
-    ast_range_or_type * tr = (ast_range_or_type *)ast_calloc(1,sizeof(ast_range_or_type));
+    ast_range_or_type * tr = ast_new<ast_range_or_type>();
+    stats.nodes[NODE_KIND_RANGE] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->is_range = is_range;
@@ -2206,7 +2300,8 @@ else false.
       ast_list           *item_declarations,
       ast_statement      *statements
       ){
-    ast_function_declaration * tr = (ast_function_declaration *)ast_calloc(1,sizeof(ast_function_declaration));
+    ast_function_declaration * tr = ast_new<ast_function_declaration>();
+    stats.nodes[NODE_KIND_DECLARATION] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->automatic         = automatic;
@@ -2226,7 +2321,8 @@ else false.
 ensures the memory is allocated properly.
 */
   ast_function_item_declaration * VerilogCode::ast_new_function_item_declaration(){
-    return (ast_function_item_declaration *)ast_calloc(1,sizeof(ast_function_item_declaration));
+    return ast_new<ast_function_item_declaration>();
+    stats.nodes[NODE_KIND_DECLARATION] ++;
   }
 
   /*
@@ -2241,7 +2337,8 @@ argument.
       ast_task_port_type type,
       ast_list         * identifiers //!< The list of port names.
       ){
-    ast_task_port * tr = (ast_task_port *)ast_calloc(1,sizeof(ast_task_port));
+    ast_task_port * tr = ast_new<ast_task_port>();
+    stats.nodes[NODE_KIND_DECLARATION] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->direction   = direction;
@@ -2264,7 +2361,8 @@ argument.
       ast_list        *   declarations,
       ast_statement   *   statements
       ){
-    ast_task_declaration * tr = (ast_task_declaration *)ast_calloc(1,sizeof(ast_task_declaration));
+    ast_task_declaration * tr = ast_new<ast_task_declaration>();
+    stats.nodes[NODE_KIND_DECLARATION] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->automatic  = automatic;
@@ -2284,7 +2382,8 @@ argument.
       ast_range   * range,
       ast_list    * identifiers
       ){
-    ast_block_reg_declaration * tr = (ast_block_reg_declaration *)ast_calloc(1,sizeof(ast_block_reg_declaration));
+    ast_block_reg_declaration * tr = ast_new<ast_block_reg_declaration>();
+    stats.nodes[NODE_KIND_DECLARATION] ++;
 
     tr->is_signed = is_signed;
     tr->range     = range;
@@ -2302,7 +2401,8 @@ argument.
       ast_block_item_declaration_type type,
       ast_node_attributes             * attributes
       ){
-    ast_block_item_declaration * tr = (ast_block_item_declaration *)ast_calloc(1,sizeof(ast_block_item_declaration));
+    ast_block_item_declaration * tr = ast_new<ast_block_item_declaration>();
+    stats.nodes[NODE_KIND_DECLARATION] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type = type;
@@ -2319,7 +2419,8 @@ argument.
       ast_node_attributes * attributes,
       ast_module_item_type  type
       ){
-    ast_module_item * tr = (ast_module_item *)ast_calloc(1,sizeof(ast_module_item));
+    ast_module_item * tr = ast_new<ast_module_item>();
+    stats.nodes[NODE_KIND_MODULE_ITEM] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type       = type;
@@ -2423,7 +2524,8 @@ contained within the module items list.
       ast_list            * ports,
       ast_list            * constructs
       ){
-    ast_module_declaration * tr = (ast_module_declaration *)ast_calloc(1,sizeof(ast_module_declaration));
+    ast_module_declaration * tr = ast_new<ast_module_declaration>();
+    stats.nodes[NODE_KIND_MODULE] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->attributes = attributes;
@@ -2581,7 +2683,8 @@ contained within the module items list.
 
   //! Creates and returns a new source item representation.
   ast_source_item * VerilogCode::ast_new_source_item(ast_source_item_type type){
-    ast_source_item * tr = (ast_source_item *)ast_calloc(1,sizeof(ast_source_item));
+    ast_source_item * tr = ast_new<ast_source_item>();
+    stats.nodes[NODE_KIND_SOURCE_ITEM] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type = type;
@@ -2603,7 +2706,7 @@ array.
 */
   std::string VerilogCode::ast_identifier_tostring(ast_identifier id)
   {
-	std::string tr = id->identifier;
+	std::string tr = id->identifier.get();
     ast_identifier walker = id;
 
     while(walker->next != NULL)
@@ -2615,42 +2718,88 @@ array.
   }
 
   /*!
-@brief Acts like strcmp but works on ast identifiers.
+@brief Compares two identifiers, returning zero when they are equal.
+@details Walks both hierarchies in step, comparing symbol ids, so the cost
+is one integer compare per level rather than two string copies.
 */
   int VerilogCode::ast_identifier_cmp(
       ast_identifier a,
       ast_identifier b
       ){
-	std::string s1 = ast_identifier_tostring(a);
-	std::string s2 = ast_identifier_tostring(b);
+    while(a != NULL && b != NULL)
+      {
+        if(a->symbol != b->symbol)
+          return a->symbol < b->symbol ? -1 : 1;
+
+        a = a->next;
+        b = b->next;
+      }
 
-	int result = (s1==s2);
+    if(a == b)
+      return 0;
 
-    return result;
+    // One is a prefix of the other, the shorter one sorts first.
+    return a == NULL ? -1 : 1;
+  }
+
+  /*!
+@brief Returns a hash of an identifier, taken from its interned symbols.
+*/
+  unsigned int VerilogCode::ast_identifier_hash(ast_identifier id)
+  {
+    unsigned int tr = 0;
+
+    for(ast_identifier walker = id; walker != NULL; walker = walker->next)
+      {
+        ast_symbol_entry * entry = ast_symbol_lookup(yy_symbols, walker->symbol);
+        tr = (tr * 31) ^ entry->hash;
+      }
+
+    return tr;
   }
 
   ast_identifier VerilogCode::ast_new_identifier(
-	   std::string   identifier,
+      const char   * identifier,
+      size_t         length,
       unsigned int   from_line
       ){
-    ast_identifier tr = (ast_identifier)ast_calloc(1,sizeof(struct ast_identifier_t));
+    ast_identifier tr = ast_new<ast_identifier_t>();
+    stats.nodes[NODE_KIND_IDENTIFIER] ++;
 	ast_set_meta_info(&(tr->meta_info));
 
-	tr->identifier = identifier;
+    if(yy_symbols == NULL)
+      {
+        ast_arena_keep keep(this);
+        yy_symbols = ast_symbol_table_new();
+      }
+
+    ast_symbol_entry * entry = ast_symbol_intern(yy_symbols, identifier, length);
+
+    tr->identifier = entry->text;
+    tr->symbol = entry->id;
     tr->from_line = from_line;
     tr->type = ID_UNKNOWN;
     tr->next = NULL;
     tr->range_or_idx = ID_HAS_NONE;
 
+    if(yy_identifiers != NULL)
+      ast_list_append(yy_identifiers, tr);
+
     return tr;
   }
 
+  ast_identifier VerilogCode::ast_new_identifier(
+	   std::string   identifier,
+      unsigned int   from_line
+      ){
+    return ast_new_identifier(identifier.data(), identifier.size(), from_line);
+  }
+
   ast_identifier VerilogCode::ast_new_system_identifier(
       char         * identifier,  //!< String text of the identifier.
       unsigned int   from_line    //!< THe line the idenifier came from.
       ){
-    ast_identifier tr = ast_new_identifier(identifier,from_line);
-        ast_set_meta_info(&(tr->meta_info));
+    ast_identifier tr = ast_new_identifier(identifier,strlen(identifier),from_line);
 
     tr->is_system = true;
 
@@ -2691,7 +2840,8 @@ array.
       ast_identifier clause_1,    //!< The first grammar clause.
       ast_identifier clause_2     //!< The second grammar clause.
       ){
-    ast_config_rule_statement * tr = (ast_config_rule_statement *)ast_calloc(1,sizeof(ast_config_rule_statement));
+    ast_config_rule_statement * tr = ast_new<ast_config_rule_statement>();
+    stats.nodes[NODE_KIND_CONFIG] ++;
 
     tr->is_default = is_default;
     tr->clause_1 = clause_1;
@@ -2705,7 +2855,8 @@ array.
       ast_identifier  design_statement,
       ast_list      * rule_statements
       ){
-    ast_config_declaration * tr = (ast_config_declaration *)ast_calloc(1,sizeof(ast_config_declaration));
+    ast_config_declaration * tr = ast_new<ast_config_declaration>();
+    stats.nodes[NODE_KIND_CONFIG] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->identifier = identifier;
@@ -2723,7 +2874,8 @@ array.
       ast_list      * file_paths,
       ast_list      * incdirs
       ){
-    ast_library_declaration * tr = (ast_library_declaration *)ast_calloc(1,sizeof(ast_library_declaration));
+    ast_library_declaration * tr = ast_new<ast_library_declaration>();
+    stats.nodes[NODE_KIND_CONFIG] ++;
 
     tr->identifier = identifier;
     tr->file_paths = file_paths;
@@ -2736,7 +2888,8 @@ array.
   ast_library_descriptions * VerilogCode::ast_new_library_description(
       ast_library_item_type type
       ){
-    ast_library_descriptions * tr = (ast_library_descriptions *)ast_calloc(1,sizeof(ast_library_descriptions));
+    ast_library_descriptions * tr = ast_new<ast_library_descriptions>();
+    stats.nodes[NODE_KIND_CONFIG] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->type = type;
@@ -2751,9 +2904,10 @@ array.
 */
   ast_number * VerilogCode::ast_new_number(ast_number_base base,   //!< What is the base of the number.
 	  ast_number_representation representation,   //!< How to interepret digits.
-	  std::string digits  //!< The string token representing the number.
+	  const char * digits  //!< The string token representing the number.
 	  ){
-    ast_number * tr = (ast_number *)ast_calloc(1,sizeof(ast_number));
+    ast_number * tr = ast_new<ast_number>();
+    stats.nodes[NODE_KIND_NUMBER] ++;
         ast_set_meta_info(&(tr->meta_info));
 
     tr->base = base;
@@ -2810,6 +2964,7 @@ have an object to put parsed constructs into.
     tr->primitives    =   ast_list_new();
     tr->configs       =   ast_list_new();
     tr->libraries     =   ast_list_new();
+    tr->module_index  =   ast_hashtable_new();
 
     return tr;
   }
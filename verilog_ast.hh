@@ -4,7 +4,7 @@
        and operate on the Verilog Abstract Syntax Tree (AST)
 */
 
-#include <QString>
+#include <string>
 
 #include "verilog_ast_common.hh"
 
@@ -112,14 +112,14 @@ namespace yy {
   //! Refers to a source code file line number.
   typedef int ast_line;
   //! Refers to a source code file name.
-  typedef std::string *ast_file;
+  typedef const char *ast_file;
 
   /*!
 @brief Stores "meta" information and other tagging stuff about nodes.
 */
   typedef struct ast_metadata_t{
-    ast_line line;  //!< The line number the construct came from.
-    ast_file file;  //!< The file the construct came from.
+    ast_line            line; //!< The line number the construct came from.
+    ast_ref<const char> file; //!< The file the construct came from.
   } ast_metadata;
 
   /*! @} */
@@ -157,9 +157,9 @@ namespace yy {
     ast_number_base base; //!< Hex, octal, binary, decimal.
     ast_number_representation   representation; //!< How is it expressed?
     union{
-	  std::string as_bits;
-      float  as_float;
-      int    as_int;
+      ast_ref<const char> as_bits;
+      float               as_float;
+      int                 as_int;
     };
   };
 
@@ -181,11 +181,11 @@ assignments.
   typedef struct ast_node_attributes_t ast_node_attributes;
   struct ast_node_attributes_t
   {
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_identifier        attr_name;    //!< Name of the attribute
-    ast_expression      * attr_value;   //!< Value of the attribute.
+    ast_metadata              meta_info;  //!< Node metadata.
+    ast_ref<ast_identifier_t> attr_name;  //!< Name of the attribute
+    ast_ref<ast_expression>   attr_value; //!< Value of the attribute.
 
-    ast_node_attributes * next;         //!< Next one in a linked list.
+    ast_ref<ast_node_attributes> next; //!< Next one in a linked list.
   };
 
   // -------------------------------- Concatenations ---------------------------
@@ -210,10 +210,10 @@ module paths.
 
   //! Fully describes a concatenation in terms of type and data.
   struct ast_concatenation_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_concatenation_type   type;  //!< The type of concatenation
-    ast_expression         * repeat;//!< The number of repetitions. Normally 1.
-    ast_list               * items; //!< sequence of items.
+    ast_metadata             meta_info; //!< Node metadata.
+    ast_concatenation_type   type;      //!< The type of concatenation
+    ast_ref<ast_expression>  repeat;    //!< The number of repetitions. Normally 1.
+    ast_ref<ast_list>        items;     //!< sequence of items.
   };
 
   // -------------------------------- L Value ------------------------
@@ -245,8 +245,8 @@ of an assignment.
 */
   typedef union ast_lvalue_data_u
   {
-    ast_identifier      identifier;     //!< Identifier value.
-    ast_concatenation * concatenation;  //!< Concatenation list.
+    ast_ref<ast_identifier_t>  identifier;    //!< Identifier value.
+    ast_ref<ast_concatenation> concatenation; //!< Concatenation list.
   } ast_lvalue_data ;
 
   /*!
@@ -274,12 +274,12 @@ destinct from a function declaration.
 system fucntion.
 */
   struct ast_function_call_t {
-    ast_metadata    meta_info;   //!< Node metadata.
-    bool         constant;   //!< Constant function call?
-    bool         system;     //!< System function call?
-    ast_identifier      function;   //!< Function identifier
-    ast_list        *   arguments;  //!< Linked list of arguments.
-    ast_node_attributes * attributes;
+    ast_metadata                 meta_info; //!< Node metadata.
+    bool                         constant;  //!< Constant function call?
+    bool                         system;    //!< System function call?
+    ast_ref<ast_identifier_t>    function;  //!< Function identifier
+    ast_ref<ast_list>            arguments; //!< Linked list of arguments.
+    ast_ref<ast_node_attributes> attributes;
   };
 
   // -------------------------------- Primaries ----------------------
@@ -318,13 +318,13 @@ the sort of expression we are dealing with.
   //! The expression primary can produce several different sub-expressions:
   typedef union ast_primary_value_e
   {
-    ast_number        * number;         //!< A single constant number
-    ast_identifier      identifier;     //!< Net or variable identifier.
-    ast_concatenation * concatenation;  //!< Concatenation of expressions.
-    ast_function_call * function_call;  //!< Call to a function.
-    ast_expression    * minmax;
-    ast_macro_use       macro;          //!< A MACRO expansion.
-	std::string       * str;
+    ast_ref<ast_number>        number;        //!< A single constant number
+    ast_ref<ast_identifier_t>  identifier;    //!< Net or variable identifier.
+    ast_ref<ast_concatenation> concatenation; //!< Concatenation of expressions.
+    ast_ref<ast_function_call> function_call; //!< Call to a function.
+    ast_ref<ast_expression>    minmax;
+    ast_ref<void>              macro;         //!< A MACRO expansion.
+	ast_ref<std::string>   str;
   } ast_primary_value;
 
   /*!
@@ -391,16 +391,16 @@ re-writing it. That will be post the first "release" though.
 */
   struct ast_expression_t
   {
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_expression_type type;           //!< What sort of expression is this?
-    ast_node_attributes * attributes;   //!< Additional expression attributes.
-    ast_expression * left;              //!< LHS of operation
-    ast_expression * right;             //!< RHS of operation
-    ast_expression * aux;               //!< Optional auxiliary/predicate.
-    ast_primary    * primary;           //!< Valid IFF type == PRIMARY_EXPRESSION.
-    ast_operator     operation;         //!< What are we doing?
-    bool      constant;          //!< True iff constant_expression.
-	std::string       string;            //!< The string constant. Valid IFF type == STRING_EXPRESSION.
+    ast_metadata                 meta_info;  //!< Node metadata.
+    ast_expression_type          type;       //!< What sort of expression is this?
+    ast_ref<ast_node_attributes> attributes; //!< Additional expression attributes.
+    ast_ref<ast_expression>      left;       //!< LHS of operation
+    ast_ref<ast_expression>      right;      //!< RHS of operation
+    ast_ref<ast_expression>      aux;        //!< Optional auxiliary/predicate.
+    ast_ref<ast_primary>         primary;    //!< Valid IFF type == PRIMARY_EXPRESSION.
+    ast_operator                 operation;  //!< What are we doing?
+    bool                         constant;   //!< True iff constant_expression.
+    ast_ref<const char>          string;     //!< The string constant. Valid IFF type == STRING_EXPRESSION.
   };
 
   // -------------------------------- Specify Blocks ---------------------------
@@ -427,56 +427,56 @@ re-writing it. That will be post the first "release" though.
 
   //! Describes the declaration of a path.
   typedef struct ast_simple_parallel_path_declaration_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_identifier      input_terminal;
-    ast_operator        polarity;
-    ast_identifier      output_terminal;
-    ast_list        *   delay_value;
+    ast_metadata              meta_info; //!< Node metadata.
+    ast_ref<ast_identifier_t> input_terminal;
+    ast_operator              polarity;
+    ast_ref<ast_identifier_t> output_terminal;
+    ast_ref<ast_list>         delay_value;
   } ast_simple_parallel_path_declaration;
 
 
   //! Describes the declaration of a path.
   typedef struct ast_simple_full_path_declaration_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_list        *   input_terminals;
+    ast_metadata        meta_info; //!< Node metadata.
+    ast_ref<ast_list>   input_terminals;
     ast_operator        polarity;
-    ast_list        *   output_terminals;
-    ast_list        *   delay_value;
+    ast_ref<ast_list>   output_terminals;
+    ast_ref<ast_list>   delay_value;
   } ast_simple_full_path_declaration;
 
 
   //! Describes a single edge sensitive path declaration
   typedef struct ast_edge_sensitive_parallel_path_declaration_t {
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_edge            edge;               //!< edge_identifier
-    ast_identifier      input_terminal;     //!< specify_input_terminal_descriptor
-    ast_operator        polarity;           //!< polarity_operator
-    ast_identifier      output_terminal;    //!< specify_output_terminal_descriptor
-    ast_expression  *   data_source;        //!< data_source_expression
-    ast_list        *   delay_value;        //!< path_delay_value
+    ast_metadata              meta_info;       //!< Node metadata.
+    ast_edge                  edge;            //!< edge_identifier
+    ast_ref<ast_identifier_t> input_terminal;  //!< specify_input_terminal_descriptor
+    ast_operator              polarity;        //!< polarity_operator
+    ast_ref<ast_identifier_t> output_terminal; //!< specify_output_terminal_descriptor
+    ast_ref<ast_expression>   data_source;     //!< data_source_expression
+    ast_ref<ast_list>         delay_value;     //!< path_delay_value
   } ast_edge_sensitive_parallel_path_declaration;
 
   //! Describes a parallel edge sensitive path declaration
   typedef struct ast_edge_sensitive_full_path_declaration_t {
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_edge            edge;               //!< edge_identifier
-    ast_list        *   input_terminal;     //!< list_of_path_inputs
-    ast_operator        polarity;           //!< polarity_operator
-    ast_list        *   output_terminal;    //!< list_of_path_outputs
-    ast_expression  *   data_source;        //!< data_source_expression
-    ast_list        *   delay_value;        //!< path_delay_value
+    ast_metadata            meta_info;       //!< Node metadata.
+    ast_edge                edge;            //!< edge_identifier
+    ast_ref<ast_list>       input_terminal;  //!< list_of_path_inputs
+    ast_operator            polarity;        //!< polarity_operator
+    ast_ref<ast_list>       output_terminal; //!< list_of_path_outputs
+    ast_ref<ast_expression> data_source;     //!< data_source_expression
+    ast_ref<ast_list>       delay_value;     //!< path_delay_value
   } ast_edge_sensitive_full_path_declaration;
 
   //! Struct which holds the type and data of a path declaration.
   typedef struct ast_path_declaration_t{
-    ast_metadata    meta_info;   //!< Node metadata.
+    ast_metadata                meta_info;        //!< Node metadata.
     ast_path_declaration_type   type;
-    ast_expression        * state_expression; //!< Used iff type == state_dependent_*
+    ast_ref<ast_expression>     state_expression; //!< Used iff type == state_dependent_*
     union {
-      ast_simple_parallel_path_declaration         * parallel;
-      ast_simple_full_path_declaration             * full;
-      ast_edge_sensitive_parallel_path_declaration * es_parallel;
-      ast_edge_sensitive_full_path_declaration     * es_full;
+      ast_ref<ast_simple_parallel_path_declaration>         parallel;
+      ast_ref<ast_simple_full_path_declaration>             full;
+      ast_ref<ast_edge_sensitive_parallel_path_declaration> es_parallel;
+      ast_ref<ast_edge_sensitive_full_path_declaration>     es_full;
     };
   } ast_path_declaration;
 
@@ -491,10 +491,10 @@ re-writing it. That will be post the first "release" though.
 
   //! Fully describes a task enable statement.
   typedef struct ast_task_enable_statement_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_list        * expressions;  //!< Arguments to the task
-    ast_identifier    identifier;   //!< Task identifier.
-    bool       is_system;    //!< Is this a system task?
+    ast_metadata              meta_info;   //!< Node metadata.
+    ast_ref<ast_list>         expressions; //!< Arguments to the task
+    ast_ref<ast_identifier_t> identifier;  //!< Task identifier.
+    bool                      is_system;   //!< Is this a system task?
   } ast_task_enable_statement;
 
   // -------------------------------- Loop Statements --------------------------
@@ -520,12 +520,12 @@ re-writing it. That will be post the first "release" though.
     ast_metadata    meta_info;   //!< Node metadata.
     ast_loop_type   type;            //!< The type of loop
     union{
-      ast_statement * inner_statement; //!< Loop body.
-      ast_list      * generate_items; //!< IFF type == LOOP_GENERATE;
+      ast_ref<ast_statement> inner_statement; //!< Loop body.
+      ast_ref<ast_list>      generate_items;  //!< IFF type == LOOP_GENERATE;
     };
-    ast_expression * condition;      //!< Condition on which the loop runs.
-    ast_single_assignment * initial;       //!< Initial condition for for loops.
-    ast_single_assignment * modify;        //!< Modification assignment for for loop.
+    ast_ref<ast_expression>        condition; //!< Condition on which the loop runs.
+    ast_ref<ast_single_assignment> initial;   //!< Initial condition for for loops.
+    ast_ref<ast_single_assignment> modify;    //!< Modification assignment for for loop.
   } ast_loop_statement;
 
 
@@ -549,20 +549,20 @@ re-writing it. That will be post the first "release" though.
 
   //! Describes a single exeuctable item in a case statement.
   typedef struct ast_case_item_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_list    * conditions; //!< A list of condtions, one must be met.
-    ast_statement * body;     //!< What to execute if the condition is met.
-    bool     is_default; //!< This is the default item.
+    ast_metadata           meta_info;  //!< Node metadata.
+    ast_ref<ast_list>      conditions; //!< A list of condtions, one must be met.
+    ast_ref<ast_statement> body;       //!< What to execute if the condition is met.
+    bool                   is_default; //!< This is the default item.
   } ast_case_item;
 
   //! Describes the top level of a case statement in terms of its items.
   typedef struct ast_case_statement_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_expression  * expression;   //!< The thing to be evaluated.
-    ast_list        * cases;        //!< Statements, conditionally run.
-    ast_statement   * default_item; //!< Default IFF no item matches.
-    ast_case_statement_type type;   //!< CASE, CASEX or CASEZ.
-    bool       is_function;  //!< Is this a function_case_statement?
+    ast_metadata            meta_info;    //!< Node metadata.
+    ast_ref<ast_expression> expression;   //!< The thing to be evaluated.
+    ast_ref<ast_list>       cases;        //!< Statements, conditionally run.
+    ast_ref<ast_statement>  default_item; //!< Default IFF no item matches.
+    ast_case_statement_type type;         //!< CASE, CASEX or CASEZ.
+    bool                    is_function;  //!< Is this a function_case_statement?
   } ast_case_statement;
 
   // -------------------------------- IF Else Statements -----------------------
@@ -576,16 +576,16 @@ re-writing it. That will be post the first "release" though.
 
   //! Describes a single if-then-do statement.
   typedef struct ast_conditional_statement_t {
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_statement   * statement; //!< What should be executed.
-    ast_expression  * condition; //!< Execute iff true.
+    ast_metadata            meta_info; //!< Node metadata.
+    ast_ref<ast_statement>  statement; //!< What should be executed.
+    ast_ref<ast_expression> condition; //!< Execute iff true.
   } ast_conditional_statement;
 
   //! Describes a complete set of if-elseif-else statements
   typedef struct ast_if_else_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_list * conditional_statements; //!< Ordered list of if-elseifs
-    ast_statement * else_condition;    //!< Execute iff no conditonals are met.
+    ast_metadata           meta_info;              //!< Node metadata.
+    ast_ref<ast_list>      conditional_statements; //!< Ordered list of if-elseifs
+    ast_ref<ast_statement> else_condition;         //!< Execute iff no conditonals are met.
   } ast_if_else;
 
   // -------------------------------- Timing Control Statements ----------------
@@ -599,9 +599,9 @@ re-writing it. That will be post the first "release" though.
 
   //! Describes a single wait statement.
   typedef struct ast_wait_statement_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_expression * expression; //!< How long to wait for.
-    ast_statement  * statement;  //!< What to execute after waiting.
+    ast_metadata            meta_info;  //!< Node metadata.
+    ast_ref<ast_expression> expression; //!< How long to wait for.
+    ast_ref<ast_statement>  statement;  //!< What to execute after waiting.
   } ast_wait_statement;
 
   typedef enum ast_event_expression_type_e{
@@ -616,8 +616,8 @@ re-writing it. That will be post the first "release" though.
   struct ast_event_expression_t {
     ast_event_expression_type type;
     union{
-      ast_expression * expression; //!< Single event expressions.
-      ast_list       * sequence;   //!< Used for CSV lists of events
+      ast_ref<ast_expression> expression; //!< Single event expressions.
+      ast_ref<ast_list>       sequence;   //!< Used for CSV lists of events
     };
   };
 
@@ -632,9 +632,9 @@ re-writing it. That will be post the first "release" though.
 
   //! Describes the type of event triggers.
   typedef struct ast_event_control_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_event_control_type type;
-    ast_event_expression * expression;
+    ast_metadata                  meta_info; //!< Node metadata.
+    ast_event_control_type        type;
+    ast_ref<ast_event_expression> expression;
   } ast_event_control;
 
   //! What sort of procedural timing control statement is this?
@@ -655,8 +655,8 @@ re-writing it. That will be post the first "release" though.
     ast_metadata    meta_info;   //!< Node metadata.
     ast_delay_ctrl_type type;
     union{
-      ast_delay_value * value;
-      ast_expression  * mintypmax;
+      ast_ref<ast_delay_value> value;
+      ast_ref<ast_expression>  mintypmax;
     };
   } ast_delay_ctrl;
 
@@ -665,11 +665,11 @@ re-writing it. That will be post the first "release" though.
     ast_metadata    meta_info;   //!< Node metadata.
     ast_timing_control_statement_type type;
     union{
-      ast_delay_ctrl    * delay;
-      ast_event_control * event_ctrl;
+      ast_ref<ast_delay_ctrl>    delay;
+      ast_ref<ast_event_control> event_ctrl;
     };
-    ast_expression    * repeat;     //!< NULL unless part of repeat statement.
-    ast_statement     * statement;  //!< What to execute after the control.
+    ast_ref<ast_expression> repeat;    //!< NULL unless part of repeat statement.
+    ast_ref<ast_statement>  statement; //!< What to execute after the control.
   } ast_timing_control_statement;
 
   // -------------------------------- Fork Join Sequential ---------------------
@@ -683,8 +683,8 @@ re-writing it. That will be post the first "release" though.
 
   //! Contains the identifier from a disable statement.
   typedef struct ast_disable_statement_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_identifier   id;
+    ast_metadata              meta_info; //!< Node metadata.
+    ast_ref<ast_identifier_t> id;
   } ast_disable_statement;
 
   //! Describes the type of a block of statements.
@@ -702,12 +702,12 @@ re-writing it. That will be post the first "release" though.
 blocks, and collections of statements in the body of a function or task.
 */
   typedef struct ast_statement_block_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_block_type   type;
-    ast_identifier   block_identifier;
-    ast_list       * declarations;
-    ast_list       * statements;
-    ast_timing_control_statement * trigger; //<! Use if this is an always block
+    ast_metadata                          meta_info; //!< Node metadata.
+    ast_block_type                        type;
+    ast_ref<ast_identifier_t>             block_identifier;
+    ast_ref<ast_list>                     declarations;
+    ast_ref<ast_list>                     statements;
+    ast_ref<ast_timing_control_statement> trigger;   //<! Use if this is an always block
   } ast_statement_block;
 
   // -------------------------------- Procedural Blocks and Assignments --------
@@ -732,28 +732,28 @@ blocks, and collections of statements in the body of a function or task.
 @brief encodes a single assignment.
 */
   struct ast_single_assignment_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_lvalue      * lval;         //!< The thing being assigned to.
-    ast_expression  * expression;   //!< The value it takes on.
-    ast_drive_strength * drive_strength; //!< Drive strength of the assignment.
-    ast_delay3         * delay; //!< Signal propagation delay.
+    ast_metadata                meta_info;      //!< Node metadata.
+    ast_ref<ast_lvalue>         lval;           //!< The thing being assigned to.
+    ast_ref<ast_expression>     expression;     //!< The value it takes on.
+    ast_ref<ast_drive_strength> drive_strength; //!< Drive strength of the assignment.
+    ast_ref<ast_delay3>         delay;          //!< Signal propagation delay.
   };
   /*!
 @brief Describes a set of assignments with the same drive strength and delay.
 */
   typedef struct ast_continuous_assignment_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_list          * assignments; //!< A list of @ref ast_single_assignment.
+    ast_metadata      meta_info;   //!< Node metadata.
+    ast_ref<ast_list> assignments; //!< A list of @ref ast_single_assignment.
   } ast_continuous_assignment;
 
   /*!
 @brief Describes a procedural assignment, can be blocking or nonblocking.
 */
   typedef struct ast_procedural_assignment_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_lvalue      * lval;
-    ast_expression  * expression;
-    ast_timing_control_statement * delay_or_event;
+    ast_metadata                          meta_info; //!< Node metadata.
+    ast_ref<ast_lvalue>                   lval;
+    ast_ref<ast_expression>               expression;
+    ast_ref<ast_timing_control_statement> delay_or_event;
   } ast_procedural_assignment;
 
   //! Describes the different types of procedural continuous assignments.
@@ -777,8 +777,8 @@ simulation.
     ast_metadata    meta_info;   //!< Node metadata.
     union
     {
-      ast_single_assignment * assignment; //!< The assignment being made.
-      ast_lvalue            * lval; //!< lvalue being assigned / deassigned.
+      ast_ref<ast_single_assignment> assignment; //!< The assignment being made.
+      ast_ref<ast_lvalue>            lval;       //!< lvalue being assigned / deassigned.
     };
     ast_hybrid_assignment_type type; //!< Type of hybrid assignment.
   } ast_hybrid_assignment;
@@ -788,9 +788,9 @@ simulation.
     ast_metadata    meta_info;   //!< Node metadata.
     ast_assignment_type type;  //!< Which element of the internal union to use.
     union{
-      ast_continuous_assignment * continuous; //!< The continuous assignment.
-      ast_procedural_assignment * procedural; //!< The procedural assignment.
-      ast_hybrid_assignment     * hybrid; //!< The hybrid special assignment.
+      ast_ref<ast_continuous_assignment> continuous; //!< The continuous assignment.
+      ast_ref<ast_procedural_assignment> procedural; //!< The procedural assignment.
+      ast_ref<ast_hybrid_assignment>     hybrid;     //!< The hybrid special assignment.
     };
   };
 
@@ -823,26 +823,26 @@ and nothing more. This is *very* bad practice and knowing this code is here
 pains me dearly.
 */
   struct ast_statement_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_statement_type      type;
-    bool             is_function_statement;
-    ast_node_attributes   * attributes;
-    bool             is_generate_statement;
+    ast_metadata                 meta_info; //!< Node metadata.
+    ast_statement_type           type;
+    bool                         is_function_statement;
+    ast_ref<ast_node_attributes> attributes;
+    bool                         is_generate_statement;
     union{
-      ast_wait_statement              * wait;
-      ast_task_enable_statement       * task_enable;
-      ast_function_call               * function_call;
-      ast_timing_control_statement    * timing_control;
-      ast_statement_block             * block;
-      ast_loop_statement              * loop;
-      ast_event_expression            * event;
-      ast_disable_statement           * disable;
-      ast_conditional_statement       * conditional;
-      ast_case_statement              * case_statement;
-      ast_assignment                  * assignment;
-      ast_generate_block              * generate_block;
-      ast_module_item                 * module_item;
-      void                            * data;
+      ast_ref<ast_wait_statement>           wait;
+      ast_ref<ast_task_enable_statement>    task_enable;
+      ast_ref<ast_function_call>            function_call;
+      ast_ref<ast_timing_control_statement> timing_control;
+      ast_ref<ast_statement_block>          block;
+      ast_ref<ast_loop_statement>           loop;
+      ast_ref<ast_event_expression>         event;
+      ast_ref<ast_disable_statement>        disable;
+      ast_ref<ast_conditional_statement>    conditional;
+      ast_ref<ast_case_statement>           case_statement;
+      ast_ref<ast_assignment>               assignment;
+      ast_ref<ast_generate_block>           generate_block;
+      ast_ref<ast_module_item>              module_item;
+      ast_ref<void>                         data;
     };
   };
 
@@ -852,11 +852,11 @@ pains me dearly.
 @brief Describes the pulse characteristics in signal transmission?
 */
   typedef struct ast_pulse_control_specparam_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_expression * reject_limit;
-    ast_expression * error_limit;
-    ast_identifier   input_terminal;
-    ast_identifier   output_terminal;
+    ast_metadata              meta_info; //!< Node metadata.
+    ast_ref<ast_expression>   reject_limit;
+    ast_ref<ast_expression>   error_limit;
+    ast_ref<ast_identifier_t> input_terminal;
+    ast_ref<ast_identifier_t> output_terminal;
   } ast_pulse_control_specparam;
 
 
@@ -916,33 +916,33 @@ instantiations
     ast_metadata    meta_info;   //!< Node metadata.
     ast_port_direction    direction;
     union{
-      ast_identifier        identifier;  //! IFF direction != input
-      ast_list            * identifiers; //! IFF direction = input
+      ast_ref<ast_identifier_t> identifier;  //! IFF direction != input
+      ast_ref<ast_list>         identifiers; //! IFF direction = input
     };
-    ast_node_attributes * attributes;
-    bool           reg;  //!< Is a register or wire?
-    ast_expression      * default_value;
+    ast_ref<ast_node_attributes> attributes;
+    bool                         reg; //!< Is a register or wire?
+    ast_ref<ast_expression>      default_value;
   } ast_udp_port;
 
   //! Describes the initial statement of a sequential udp body.
   typedef struct ast_udp_initial_statement_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_identifier    output_port;
-    ast_number      * initial_value;
+    ast_metadata              meta_info; //!< Node metadata.
+    ast_ref<ast_identifier_t> output_port;
+    ast_ref<ast_number>       initial_value;
   } ast_udp_initial_statement;
 
   //! Describes a single UDP body sequentially or combinatorially.
   typedef struct ast_udp_body_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_list *        entries;
-    ast_udp_initial_statement * initial; //!< IFF body_type = sequential
-    ast_udp_body_type body_type;
+    ast_metadata                       meta_info; //!< Node metadata.
+    ast_ref<ast_list>                  entries;
+    ast_ref<ast_udp_initial_statement> initial;   //!< IFF body_type = sequential
+    ast_udp_body_type                  body_type;
   } ast_udp_body;
 
   //! Describes a single combinatorial entry in the UDP ast tree.
   typedef struct ast_udp_combinatorial_entry_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_list * input_levels;
+    ast_metadata        meta_info; //!< Node metadata.
+    ast_ref<ast_list>   input_levels;
     ast_udp_next_state  output_symbol;
   } ast_udp_combinatorial_entry;
 
@@ -951,8 +951,8 @@ instantiations
     ast_metadata    meta_info;   //!< Node metadata.
     ast_udp_seqential_entry_prefix entry_prefix;
     union {
-      ast_list * edges; //!< iff entry_prefix == PREFIX_EDGES
-      ast_list * levels;  //!< iff entry_prefix == PREFIX_LEVELS
+      ast_ref<ast_list> edges;  //!< iff entry_prefix == PREFIX_EDGES
+      ast_ref<ast_list> levels; //!< iff entry_prefix == PREFIX_LEVELS
     };
     ast_level_symbol   current_state;
     ast_udp_next_state output;
@@ -965,31 +965,31 @@ in the grammar. This means that the first element is the output terminal,
 while the subsequent elements are input terminals.
 */
   typedef struct ast_udp_declaration_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_identifier        identifier;
-    ast_node_attributes * attributes;
-    ast_list            * ports;
-    ast_list            * body_entries;
-    ast_udp_initial_statement * initial; //!< IFF body_type = sequential
-    ast_udp_body_type     body_type;
+    ast_metadata                       meta_info; //!< Node metadata.
+    ast_ref<ast_identifier_t>          identifier;
+    ast_ref<ast_node_attributes>       attributes;
+    ast_ref<ast_list>                  ports;
+    ast_ref<ast_list>                  body_entries;
+    ast_ref<ast_udp_initial_statement> initial;   //!< IFF body_type = sequential
+    ast_udp_body_type                  body_type;
   } ast_udp_declaration;
 
   //! Describes a single instance of a UDP
   typedef struct ast_udp_instance_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_identifier        identifier;
-    ast_range           * range;
-    ast_lvalue          * output;
-    ast_list            * inputs;
+    ast_metadata              meta_info; //!< Node metadata.
+    ast_ref<ast_identifier_t> identifier;
+    ast_ref<ast_range>        range;
+    ast_ref<ast_lvalue>       output;
+    ast_ref<ast_list>         inputs;
   } ast_udp_instance;
 
   //! Describes an a list of instances of a particular kind of UDP.
   typedef struct ast_udp_instantiation_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_list            * instances; //!< list of ast_udp_instance
-    ast_identifier        identifier;
-    ast_drive_strength  * drive_strength;
-    ast_delay2          * delay;
+    ast_metadata                meta_info; //!< Node metadata.
+    ast_ref<ast_list>           instances; //!< list of ast_udp_instance
+    ast_ref<ast_identifier_t>   identifier;
+    ast_ref<ast_drive_strength> drive_strength;
+    ast_ref<ast_delay2>         delay;
   } ast_udp_instantiation;
 
 
@@ -997,8 +997,8 @@ while the subsequent elements are input terminals.
 @brief Describes a range or dimension.
 */
   struct ast_range_t{
-	ast_expression * upper;
-	ast_expression * lower;
+	ast_ref<ast_expression> upper;
+	ast_ref<ast_expression> lower;
   };
 
   // -------------------------------- Generate Statements ----------------------
@@ -1012,9 +1012,9 @@ while the subsequent elements are input terminals.
 
   //! Simple wrapper and placeholder for generate associated meta-data.
   struct ast_generate_block_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_identifier   identifier;
-    ast_list       * generate_items;
+    ast_metadata              meta_info; //!< Node metadata.
+    ast_ref<ast_identifier_t> identifier;
+    ast_ref<ast_list>         generate_items;
   };
 
   // -------------------------------- Module Instantiation ---------------------
@@ -1038,11 +1038,11 @@ module is called.
     ast_metadata    meta_info;   //!< Node metadata.
     bool     resolved; //!< Is the name resolved to a declaration?
     union{
-      ast_identifier  module_identifer; //!< The module being instanced.
-      ast_module_declaration * declaration; //!< The module instanced.
+      ast_ref<ast_identifier_t>       module_identifer; //!< The module being instanced.
+      ast_ref<ast_module_declaration> declaration;      //!< The module instanced.
     };
-    ast_list              * module_parameters;
-    ast_list              * module_instances;
+    ast_ref<ast_list> module_parameters;
+    ast_ref<ast_list> module_instances;
   } ast_module_instantiation;
 
 
@@ -1052,19 +1052,21 @@ module is called.
 collection of ast_module_instance with the same parameters.
 */
   typedef struct ast_module_instance_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_identifier          instance_identifier;
-    ast_list              * port_connections;
+    ast_metadata              meta_info;        //!< Node metadata.
+    ast_ref<ast_identifier_t> instance_identifier;
+    ast_ref<ast_list>         port_connections; //!< ast_port_connection
   } ast_module_instance;
 
   /*!
 @brief Decribes a single port connection in a module instance.
+@details Connections made by position have no port_name, and a connection
+left empty has no expression.
 @note This is also used to represent parameter assignments.
 */
   typedef struct ast_port_connection_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_identifier   port_name;
-    ast_expression * expression;
+    ast_metadata              meta_info; //!< Node metadata.
+    ast_ref<ast_identifier_t> port_name;
+    ast_ref<ast_expression>   expression;
   } ast_port_connection;
 
   // -------------------------------- Primitives -------------------------------
@@ -1094,8 +1096,8 @@ gates, etc.
     ast_metadata    meta_info;   //!< Node metadata.
     ast_switchtype type;
     union {
-      ast_delay3 * delay3;
-      ast_delay2 * delay2; //!< IFF type == TRAN or RTRAN
+      ast_ref<ast_delay3> delay3;
+      ast_ref<ast_delay2> delay2; //!< IFF type == TRAN or RTRAN
     };
   } ast_switch_gate;
 
@@ -1138,17 +1140,17 @@ gates, etc.
 
   //! Describes a single pull gate instance.
   typedef struct ast_pull_gate_instance_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_identifier      name;
-    ast_lvalue        * output_terminal;
+    ast_metadata              meta_info; //!< Node metadata.
+    ast_ref<ast_identifier_t> name;
+    ast_ref<ast_lvalue>       output_terminal;
   } ast_pull_gate_instance;
 
   //! A single pass transistor instance.
   typedef struct ast_pass_switch_instance_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_identifier      name;
-    ast_lvalue        * terminal_1;
-    ast_lvalue        * terminal_2;
+    ast_metadata              meta_info; //!< Node metadata.
+    ast_ref<ast_identifier_t> name;
+    ast_ref<ast_lvalue>       terminal_1;
+    ast_ref<ast_lvalue>       terminal_2;
   } ast_pass_switch_instance;
 
   //! Describes the logical function performed by a builtin n-input gate.
@@ -1163,19 +1165,19 @@ gates, etc.
 
   //! A collection of n-input gates with the same type and delay properties.
   typedef struct ast_n_input_gate_instances_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_gatetype_n_input    type;
-    ast_delay3            * delay;
-    ast_drive_strength    * drive_strength;
-    ast_list              * instances;
+    ast_metadata                meta_info; //!< Node metadata.
+    ast_gatetype_n_input        type;
+    ast_ref<ast_delay3>         delay;
+    ast_ref<ast_drive_strength> drive_strength;
+    ast_ref<ast_list>           instances;
   } ast_n_input_gate_instances;
 
   //! An N-input gate instance. e.g. 3-to-1 NAND.
   typedef struct ast_n_input_gate_instance_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_identifier      name;
-    ast_list          * input_terminals;
-    ast_lvalue        * output_terminal;
+    ast_metadata              meta_info; //!< Node metadata.
+    ast_ref<ast_identifier_t> name;
+    ast_ref<ast_list>         input_terminals;
+    ast_ref<ast_lvalue>       output_terminal;
   } ast_n_input_gate_instance;
 
   //! Describes a variety of enable gate type.
@@ -1188,48 +1190,48 @@ gates, etc.
 
   //! A collection of enable gates with the same type and delay properties.
   typedef struct ast_enable_gate_instances{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_enable_gatetype     type;
-    ast_delay3            * delay;
-    ast_drive_strength    * drive_strength;
-    ast_list              * instances;
+    ast_metadata                meta_info; //!< Node metadata.
+    ast_enable_gatetype         type;
+    ast_ref<ast_delay3>         delay;
+    ast_ref<ast_drive_strength> drive_strength;
+    ast_ref<ast_list>           instances;
   } ast_enable_gate_instances;
 
   //! A single enable gate
   typedef struct ast_enable_gate_instance_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_identifier      name;
-    ast_lvalue        * output_terminal;
-    ast_expression    * enable_terminal;
-    ast_expression    * input_terminal;
+    ast_metadata              meta_info; //!< Node metadata.
+    ast_ref<ast_identifier_t> name;
+    ast_ref<ast_lvalue>       output_terminal;
+    ast_ref<ast_expression>   enable_terminal;
+    ast_ref<ast_expression>   input_terminal;
   } ast_enable_gate_instance;
 
   //! A single MOS switch (transistor) instance.
   typedef struct ast_mos_switch_instance_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_identifier      name;
-    ast_lvalue        * output_terminal;
-    ast_expression    * enable_terminal;
-    ast_expression    * input_terminal;
+    ast_metadata              meta_info; //!< Node metadata.
+    ast_ref<ast_identifier_t> name;
+    ast_ref<ast_lvalue>       output_terminal;
+    ast_ref<ast_expression>   enable_terminal;
+    ast_ref<ast_expression>   input_terminal;
   } ast_mos_switch_instance;
 
   //! A single CMOS switch (transistor) instance.
   typedef struct ast_cmos_switch_instance_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_identifier      name;
-    ast_lvalue        * output_terminal;
-    ast_expression    * ncontrol_terminal;
-    ast_expression    * pcontrol_terminal;
-    ast_expression    * input_terminal;
+    ast_metadata              meta_info; //!< Node metadata.
+    ast_ref<ast_identifier_t> name;
+    ast_ref<ast_lvalue>       output_terminal;
+    ast_ref<ast_expression>   ncontrol_terminal;
+    ast_ref<ast_expression>   pcontrol_terminal;
+    ast_ref<ast_expression>   input_terminal;
   } ast_cmos_switch_instance;
 
   //! A single pass enable switch with pass and enable terminals.
   typedef struct ast_pass_enable_switch_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_identifier      name;
-    ast_lvalue        * terminal_1;
-    ast_lvalue        * terminal_2;
-    ast_expression    * enable;
+    ast_metadata              meta_info; //!< Node metadata.
+    ast_ref<ast_identifier_t> name;
+    ast_ref<ast_lvalue>       terminal_1;
+    ast_ref<ast_lvalue>       terminal_2;
+    ast_ref<ast_expression>   enable;
   } ast_pass_enable_switch;
 
   //! Describes a particular type of pass enable switch.
@@ -1245,10 +1247,10 @@ gates, etc.
 delay characteristics.
 */
   typedef struct ast_pass_enable_switches_t{
-    ast_metadata    meta_info;   //!< Node metadata.
+    ast_metadata                  meta_info; //!< Node metadata.
     ast_pass_enable_switchtype    type;
-    ast_delay2                  * delay;
-    ast_list                    * switches;
+    ast_ref<ast_delay2>           delay;
+    ast_ref<ast_list>             switches;
   } ast_pass_enable_switches;
 
   //! Describes the type of an n_output gate.
@@ -1259,26 +1261,26 @@ delay characteristics.
 
   //! Describes a single gate with one input and several outputs.
   typedef struct ast_n_output_gate_instance_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_identifier                name;
-    ast_list                    * outputs;
-    ast_expression              * input;
+    ast_metadata              meta_info; //!< Node metadata.
+    ast_ref<ast_identifier_t> name;
+    ast_ref<ast_list>         outputs;
+    ast_ref<ast_expression>   input;
   } ast_n_output_gate_instance;
 
   typedef struct ast_n_output_gate_instances_t{
-    ast_metadata    meta_info;   //!< Node metadata.
+    ast_metadata                  meta_info; //!< Node metadata.
     ast_n_output_gatetype         type;
-    ast_delay2                  * delay;
-    ast_drive_strength          * drive_strength;
-    ast_list                    * instances;
+    ast_ref<ast_delay2>           delay;
+    ast_ref<ast_drive_strength>   drive_strength;
+    ast_ref<ast_list>             instances;
   } ast_n_output_gate_instances;
 
 
   //! A collection of CMOS, MOS or PASS switches of the same type.
   typedef struct ast_switches_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_switch_gate * type;
-    ast_list        * switches;
+    ast_metadata             meta_info; //!< Node metadata.
+    ast_ref<ast_switch_gate> type;
+    ast_ref<ast_list>        switches;
   } ast_switches;
 
   //! Describes a kind of gate primitive.
@@ -1302,16 +1304,14 @@ delay characteristics.
     ast_metadata    meta_info;   //!< Node metadata.
     ast_gate_type type;
     union{
-      ast_switches * switches;
-      ast_pass_enable_switches * pass_en;
-      ast_enable_gate_instances * enable;
-      ast_n_input_gate_instances * n_in;
-      ast_n_output_gate_instances * n_out;
-      struct{
-        ast_primitive_pull_strength   * pull_strength;
-        ast_list                      * pull_gates;
-      };
+      ast_ref<ast_switches>                switches;
+      ast_ref<ast_pass_enable_switches>    pass_en;
+      ast_ref<ast_enable_gate_instances>   enable;
+      ast_ref<ast_n_input_gate_instances>  n_in;
+      ast_ref<ast_n_output_gate_instances> n_out;
+      ast_ref<ast_primitive_pull_strength> pull_strength;
     };
+    ast_ref<ast_list>                      pull_gates; //!< Of pull gates only.
   } ast_gate_instantiation;
 
   // -------------------------------- Delays -----------------------------------
@@ -1336,20 +1336,20 @@ delay characteristics.
     ast_metadata    meta_info;   //!< Node metadata.
     ast_delay_value_type type;
     union{
-      ast_identifier parameter_id;
-      ast_identifier specparam_id;
-      ast_number  *  unsigned_number;
-      ast_minmax_exp mintypmax;
-      void        *  data;
+      ast_ref<ast_identifier_t> parameter_id;
+      ast_ref<ast_identifier_t> specparam_id;
+      ast_ref<ast_number>       unsigned_number;
+      ast_ref<void>             mintypmax;
+      ast_ref<void>             data;
     };
   } ast_delay_value;
 
   //! Describes a 3 point delay distribution.
   struct ast_delay3_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_delay_value * min;
-    ast_delay_value * max;
-    ast_delay_value * avg;
+    ast_metadata             meta_info; //!< Node metadata.
+    ast_ref<ast_delay_value> min;
+    ast_ref<ast_delay_value> max;
+    ast_ref<ast_delay_value> avg;
   };
 
   // -------------------------------- Strengths --------------------------------
@@ -1414,14 +1414,14 @@ delay characteristics.
 
   //! Fully describes a single port declaration
   typedef struct ast_port_declaration_t{
-    ast_metadata    meta_info;   //!< Node metadata.
+    ast_metadata        meta_info;      //!< Node metadata.
     ast_port_direction  direction;      //!< Input / output / inout etc.
     ast_net_type        net_type;       //!< Wire/reg etc
-    bool         net_signed;     //!< Signed value?
-    bool         is_reg;         //!< Is explicitly a "reg"
-    bool         is_variable;    //!< Variable or net?
-    ast_range         * range;          //!< Bus width.
-    ast_list          * port_names;     //!< The names of the ports.
+    bool                net_signed;     //!< Signed value?
+    bool                is_reg;         //!< Is explicitly a "reg"
+    bool                is_variable;    //!< Variable or net?
+    ast_ref<ast_range>  range;          //!< Bus width.
+    ast_ref<ast_list>   port_names;     //!< The names of the ports.
   } ast_port_declaration;
 
   // -------------------------------- Type Declarations ------------------------
@@ -1452,48 +1452,48 @@ module.
 @todo Clean this up to avoid accessing members which are mutually exclusive
 */
   typedef struct ast_type_declaration_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_declaration_type  type;
-    ast_net_type          net_type;
-    ast_list            * identifiers;
-    ast_delay3          * delay;
-    ast_drive_strength  * drive_strength;
-    ast_charge_strength   charge_strength;
-    bool           vectored;
-    bool           scalared;
-    bool           is_signed;
-    ast_range           * range;
+    ast_metadata                meta_info; //!< Node metadata.
+    ast_declaration_type        type;
+    ast_net_type                net_type;
+    ast_ref<ast_list>           identifiers;
+    ast_ref<ast_delay3>         delay;
+    ast_ref<ast_drive_strength> drive_strength;
+    ast_charge_strength         charge_strength;
+    bool                        vectored;
+    bool                        scalared;
+    bool                        is_signed;
+    ast_ref<ast_range>          range;
   } ast_type_declaration;
 
   //! Describes a single net declaration.
   typedef struct ast_net_declaration_t{
-    ast_metadata         meta_info;       //!< Node metadata.
-    ast_net_type         type;       //!< What sort of net is this?
-    ast_identifier       identifier; //!< What is the net called?
-    ast_delay3         * delay;      //!< Delay characteristics.
-    ast_drive_strength * drive;      //!< Drive strength.
-    ast_range          * range;      //!< Width of the net.
-    bool          vectored;
-    bool          scalared;
-    bool          is_signed;
-    ast_expression     * value;      //!< Default assigned value.
+    ast_metadata                meta_info;  //!< Node metadata.
+    ast_net_type                type;       //!< What sort of net is this?
+    ast_ref<ast_identifier_t>   identifier; //!< What is the net called?
+    ast_ref<ast_delay3>         delay;      //!< Delay characteristics.
+    ast_ref<ast_drive_strength> drive;      //!< Drive strength.
+    ast_ref<ast_range>          range;      //!< Width of the net.
+    bool                        vectored;
+    bool                        scalared;
+    bool                        is_signed;
+    ast_ref<ast_expression>     value;      //!< Default assigned value.
   } ast_net_declaration;
 
 
   //! Describes a single reg declaration.
   typedef struct ast_reg_declaration_t{
-    ast_metadata         meta_info;       //!< Node metadata.
-    ast_identifier       identifier; //!< What is the reg called?
-    ast_range          * range;      //!< Width of the reg.
-    bool          is_signed;
-    ast_expression     * value;      //!< Default assigned value.
+    ast_metadata              meta_info;  //!< Node metadata.
+    ast_ref<ast_identifier_t> identifier; //!< What is the reg called?
+    ast_ref<ast_range>        range;      //!< Width of the reg.
+    bool                      is_signed;
+    ast_ref<ast_expression>   value;      //!< Default assigned value.
   } ast_reg_declaration;
 
   //! Describes a simple set of declarations of a particular type.
   typedef struct ast_var_declaration_t{
-    ast_metadata        meta_info;       //!< Metadata
-    ast_identifier      identifier; //!< The variable identifier.
-    ast_declaration_type type;      //!< What sort of variable is this?
+    ast_metadata              meta_info;  //!< Metadata
+    ast_ref<ast_identifier_t> identifier; //!< The variable identifier.
+    ast_declaration_type      type;       //!< What sort of variable is this?
   } ast_var_declaration;
 
 
@@ -1519,11 +1519,11 @@ module.
 
   //! Stores the type and characteristics of one or more parameter declarations.
   typedef struct ast_parameter_declarations_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_list        * assignments;
-    bool       signed_values; //!< Valid IFF type==PARAM_GENERIC
-    bool       local;        //!< Local parameter or global.
-    ast_range       * range; //!< Valid IFF type==PARAM_GENERIC
+    ast_metadata        meta_info;     //!< Node metadata.
+    ast_ref<ast_list>   assignments;
+    bool                signed_values; //!< Valid IFF type==PARAM_GENERIC
+    bool                local;         //!< Local parameter or global.
+    ast_ref<ast_range>  range;         //!< Valid IFF type==PARAM_GENERIC
     ast_parameter_type  type;
   } ast_parameter_declarations;
 
@@ -1539,10 +1539,10 @@ module.
 
   //! Describes the declaration of a set of registers within a block.
   typedef struct ast_block_reg_declaration_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    bool   is_signed;     //!< Do they represent signed values?
-    ast_range   * range;         //!< Are these vectors of registers?
-    ast_list    * identifiers;   //!< list of reg names with same properties.
+    ast_metadata       meta_info;   //!< Node metadata.
+    bool               is_signed;   //!< Do they represent signed values?
+    ast_ref<ast_range> range;       //!< Are these vectors of registers?
+    ast_ref<ast_list>  identifiers; //!< list of reg names with same properties.
   } ast_block_reg_declaration;
 
 
@@ -1555,13 +1555,13 @@ module.
 
   //! Describes the declaration of a block item.
   struct ast_block_item_declaration_t{
-    ast_metadata    meta_info;   //!< Node metadata.
+    ast_metadata                    meta_info; //!< Node metadata.
     ast_block_item_declaration_type type;
-    ast_node_attributes             * attributes;
+    ast_ref<ast_node_attributes>    attributes;
     union{
-      ast_block_reg_declaration * reg; //!< When type == BLOCK_ITEM_REG
-      ast_type_declaration * event_or_var;//!< When type == BLOCK_ITEM_TYPE.
-      ast_parameter_declarations *  parameters; //!< When type==BLOCK_ITEM_PARAM.
+      ast_ref<ast_block_reg_declaration>  reg;          //!< When type == BLOCK_ITEM_REG
+      ast_ref<ast_type_declaration>       event_or_var; //!< When type == BLOCK_ITEM_TYPE.
+      ast_ref<ast_parameter_declarations> parameters;   //!< When type==BLOCK_ITEM_PARAM.
     };
   };
 
@@ -1591,8 +1591,8 @@ module.
     ast_metadata    meta_info;   //!< Node metadata.
     bool is_range;   //!< iff true use range, else type.
     union{
-      ast_range * range;  //!< The range strucure.
-      ast_task_port_type type; //!< The type structure (an enum)
+      ast_ref<ast_range> range; //!< The range strucure.
+      ast_task_port_type type;  //!< The type structure (an enum)
     };
   } ast_range_or_type;
 
@@ -1600,27 +1600,27 @@ module.
 @brief Fully describes the declaration of a verilog function.
 */
   typedef struct ast_function_declaration_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    bool         automatic;         //!< Is automatic?
-    bool         is_signed;         //!< Is the returned value signed?
-    bool         function_or_block; //!< IFF true statements is list of function_item_declaration else list of block_item_declaration.
-    ast_range_or_type  *rot;               //!< Range or type.
-    ast_identifier      identifier;        //!< Function name.
-    ast_list           *item_declarations; //!< Internal variable declarations.
-    ast_statement      *statements;        //!< Executable statements.
+    ast_metadata               meta_info;         //!< Node metadata.
+    bool                       automatic;         //!< Is automatic?
+    bool                       is_signed;         //!< Is the returned value signed?
+    bool                       function_or_block; //!< IFF true statements is list of function_item_declaration else list of block_item_declaration.
+    ast_ref<ast_range_or_type> rot;               //!< Range or type.
+    ast_ref<ast_identifier_t>  identifier;        //!< Function name.
+    ast_ref<ast_list>          item_declarations; //!< Internal variable declarations.
+    ast_ref<ast_statement>     statements;        //!< Executable statements.
   } ast_function_declaration;
 
   /*
 @brief Fully describes a set of task arguments with the same properties.
 */
   typedef struct ast_task_port_t{
-    ast_metadata    meta_info;   //!< Node metadata.
+    ast_metadata       meta_info;   //!< Node metadata.
     ast_port_direction direction;   //!< Input or output to the port.
-    bool        reg;         //!< Is is a registered value?
-    bool        is_signed;   //!< Does it represent a signed value?
-    ast_range        * range;       //!< Bit or item range for arrays.
+    bool               reg;         //!< Is is a registered value?
+    bool               is_signed;   //!< Does it represent a signed value?
+    ast_ref<ast_range> range;       //!< Bit or item range for arrays.
     ast_task_port_type type;        //!< Data type (if any)
-    ast_list         * identifiers; //!< The list of port names.
+    ast_ref<ast_list>  identifiers; //!< The list of port names.
   } ast_task_port;
 
 
@@ -1632,8 +1632,8 @@ item or port declaration.
     ast_metadata    meta_info;   //!< Node metadata.
     bool is_port_declaration; //!< True IFF an argument to the function.
     union{
-      ast_block_item_declaration  * block_item; //!< Standard body statements.
-      ast_task_port               * port_declaration; //!< IFF is_port_declaration == AST_TRUE
+      ast_ref<ast_block_item_declaration> block_item;       //!< Standard body statements.
+      ast_ref<ast_task_port>              port_declaration; //!< IFF is_port_declaration == AST_TRUE
     };
   } ast_function_item_declaration;
 
@@ -1650,12 +1650,12 @@ item or port declaration.
 @brief Creates and returns a new task declaration statement.
 */
   typedef struct ast_task_declaration_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    bool         automatic;      //!< Automatic iff TRUE
-    ast_identifier      identifier;     //!< The task name.
-    ast_list        *   ports;          //!< Arguments to the task.
-    ast_list        *   declarations;   //!< Internal variable declarations.
-    ast_statement   *   statements;     //!< The body of the task.
+    ast_metadata              meta_info;    //!< Node metadata.
+    bool                      automatic;    //!< Automatic iff TRUE
+    ast_ref<ast_identifier_t> identifier;   //!< The task name.
+    ast_ref<ast_list>         ports;        //!< Arguments to the task.
+    ast_ref<ast_list>         declarations; //!< Internal variable declarations.
+    ast_ref<ast_statement>    statements;   //!< The body of the task.
   } ast_task_declaration;
 
 
@@ -1699,32 +1699,32 @@ module instantiations.
 
   //! Describes a single module item, its type and data structure.
   struct ast_module_item_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_module_item_type type;
-    ast_node_attributes *attributes;
+    ast_metadata                 meta_info; //!< Node metadata.
+    ast_module_item_type         type;
+    ast_ref<ast_node_attributes> attributes;
     union{
-      ast_port_declaration        * port_declaration;
-      ast_generate_block          * generated_instantiation;
-      ast_parameter_declarations  * parameter_declaration;
-      ast_list                    * specify_block;
-      ast_parameter_declarations  * specparam_declaration;
-      ast_list                    * parameter_override;
-      ast_continuous_assignment   * continuous_assignment;
-      ast_gate_instantiation      * gate_instantiation;
-      ast_udp_instantiation       * udp_instantiation;
-      ast_module_instantiation    * module_instantiation;
-      ast_statement               * always_construct;
-      ast_statement               * initial_construct;
-      ast_type_declaration        * net_declaration;
-      ast_type_declaration        * reg_declaration;
-      ast_type_declaration        * integer_declaration;
-      ast_type_declaration        * real_declaration;
-      ast_type_declaration        * time_declaration;
-      ast_type_declaration        * realtime_declaration;
-      ast_type_declaration        * event_declaration;
-      ast_type_declaration        * genvar_declaration;
-      ast_task_declaration        * task_declaration;
-      ast_function_declaration    * function_declaration;
+      ast_ref<ast_port_declaration>       port_declaration;
+      ast_ref<ast_generate_block>         generated_instantiation;
+      ast_ref<ast_parameter_declarations> parameter_declaration;
+      ast_ref<ast_list>                   specify_block;
+      ast_ref<ast_parameter_declarations> specparam_declaration;
+      ast_ref<ast_list>                   parameter_override;
+      ast_ref<ast_continuous_assignment>  continuous_assignment;
+      ast_ref<ast_gate_instantiation>     gate_instantiation;
+      ast_ref<ast_udp_instantiation>      udp_instantiation;
+      ast_ref<ast_module_instantiation>   module_instantiation;
+      ast_ref<ast_statement>              always_construct;
+      ast_ref<ast_statement>              initial_construct;
+      ast_ref<ast_type_declaration>       net_declaration;
+      ast_ref<ast_type_declaration>       reg_declaration;
+      ast_ref<ast_type_declaration>       integer_declaration;
+      ast_ref<ast_type_declaration>       real_declaration;
+      ast_ref<ast_type_declaration>       time_declaration;
+      ast_ref<ast_type_declaration>       realtime_declaration;
+      ast_ref<ast_type_declaration>       event_declaration;
+      ast_ref<ast_type_declaration>       genvar_declaration;
+      ast_ref<ast_task_declaration>       task_declaration;
+      ast_ref<ast_function_declaration>   function_declaration;
     };
   };
 
@@ -1743,32 +1743,32 @@ ports and internal constructs.
 @details
 */
   struct ast_module_declaration_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_node_attributes * attributes; //!< Tool specific attributes.
-    ast_identifier        identifier; //!< The name of the module.
-    ast_list * always_blocks; //!< ast_statement_block
-    ast_list * continuous_assignments; //!< ast_single_assignment
-    ast_list * event_declarations; //!< ast_var_declaration
-    ast_list * function_declarations; //!< ast_task_declaration
-    ast_list * gate_instantiations; //!< ast_gate_instantiation
-    ast_list * genvar_declarations; //!< ast_var_declaration
-    ast_list * generate_blocks; //!< ast_generate_block
-    ast_list * initial_blocks; //!< ast_statement_block
-    ast_list * integer_declarations; //!< ast_var_declaration
-    ast_list * local_parameters; //!< ast_parameter_declaration
-    ast_list * module_instantiations; //!< ast_module_instantiation
-    ast_list * module_parameters; //!< ast_parameter_declaration
-    ast_list * module_ports; //!< ast_port_declaration
-    ast_list * net_declarations; //!< ast_net_declaration
-    ast_list * parameter_overrides; //!< ast_single_assignment
-    ast_list * real_declarations; //!< ast_var_declaration
-    ast_list * realtime_declarations; //!< ast_var_declaration
-    ast_list * reg_declarations; //!< ast_reg_declaration
-    ast_list * specify_blocks; //!< Not Supported
-    ast_list * specparams; //!< ast_parameter_declaration
-    ast_list * task_declarations; //!< ast_task_declaration
-    ast_list * time_declarations; //!< ast_var_declaration
-    ast_list * udp_instantiations; //!< ast_udp_instantiation
+    ast_metadata                 meta_info;              //!< Node metadata.
+    ast_ref<ast_node_attributes> attributes;             //!< Tool specific attributes.
+    ast_ref<ast_identifier_t>    identifier;             //!< The name of the module.
+    ast_ref<ast_list>            always_blocks;          //!< ast_statement_block
+    ast_ref<ast_list>            continuous_assignments; //!< ast_single_assignment
+    ast_ref<ast_list>            event_declarations;     //!< ast_var_declaration
+    ast_ref<ast_list>            function_declarations;  //!< ast_task_declaration
+    ast_ref<ast_list>            gate_instantiations;    //!< ast_gate_instantiation
+    ast_ref<ast_list>            genvar_declarations;    //!< ast_var_declaration
+    ast_ref<ast_list>            generate_blocks;        //!< ast_generate_block
+    ast_ref<ast_list>            initial_blocks;         //!< ast_statement_block
+    ast_ref<ast_list>            integer_declarations;   //!< ast_var_declaration
+    ast_ref<ast_list>            local_parameters;       //!< ast_parameter_declaration
+    ast_ref<ast_list>            module_instantiations;  //!< ast_module_instantiation
+    ast_ref<ast_list>            module_parameters;      //!< ast_parameter_declaration
+    ast_ref<ast_list>            module_ports;           //!< ast_port_declaration
+    ast_ref<ast_list>            net_declarations;       //!< ast_net_declaration
+    ast_ref<ast_list>            parameter_overrides;    //!< ast_single_assignment
+    ast_ref<ast_list>            real_declarations;      //!< ast_var_declaration
+    ast_ref<ast_list>            realtime_declarations;  //!< ast_var_declaration
+    ast_ref<ast_list>            reg_declarations;       //!< ast_reg_declaration
+    ast_ref<ast_list>            specify_blocks;         //!< Not Supported
+    ast_ref<ast_list>            specparams;             //!< ast_parameter_declaration
+    ast_ref<ast_list>            task_declarations;      //!< ast_task_declaration
+    ast_ref<ast_list>            time_declarations;      //!< ast_var_declaration
+    ast_ref<ast_list>            udp_instantiations;     //!< ast_udp_instantiation
 
   } ;
 
@@ -1854,17 +1854,18 @@ Verilog Constructs.
 @brief Structure containing all information on an identifier.
 */
   struct ast_identifier_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_identifier_type   type;         //!< What construct does it identify?
-	std::string identifier;   //!< The identifier value.
-    unsigned int          from_line;    //!< The line number of the file.
-    bool           is_system;    //!< Is this a system identifier?
-    ast_identifier        next;         //!< Represents a hierarchical id.
-    ast_id_range_or_index range_or_idx; //!< Is it indexed or ranged?
+    ast_metadata              meta_info;    //!< Node metadata.
+    ast_identifier_type       type;         //!< What construct does it identify?
+    ast_symbol                symbol;       //!< Symbol id of identifier.
+    ast_ref<const char>       identifier;   //!< The interned identifier text.
+    ast_ref<ast_identifier_t> next;         //!< Represents a hierarchical id.
+    unsigned int              from_line;    //!< The line number of the file.
+    ast_id_range_or_index     range_or_idx; //!< Is it indexed or ranged?
+    bool                      is_system;    //!< Is this a system identifier?
     union{
-      ast_list        * ranges; //!< For multi-dimensional arrays.
-      ast_range       * range; //!< Iff range_or_idx == ID_HAS_RANGE
-      ast_expression  * index; //!< Iff range_or_idx == ID_HAS_INDEX
+      ast_ref<ast_list>       ranges; //!< For multi-dimensional arrays.
+      ast_ref<ast_range>      range;  //!< Iff range_or_idx == ID_HAS_RANGE
+      ast_ref<ast_expression> index;  //!< Iff range_or_idx == ID_HAS_INDEX
     };
   };
 
@@ -1881,23 +1882,23 @@ Verilog Constructs.
 
   //! Fully describes a config rule statemnet. See Annex 1.2
   typedef struct ast_config_rule_statement_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    bool    is_default;
-    bool    multiple_clauses; //<! IFF TRUE use clauses, else clause_2
-    ast_identifier clause_1;    //!< The first grammar clause.
+    ast_metadata              meta_info;        //!< Node metadata.
+    bool                      is_default;
+    bool                      multiple_clauses; //<! IFF TRUE use clauses, else clause_2
+    ast_ref<ast_identifier_t> clause_1;         //!< The first grammar clause.
     union{
-      ast_identifier clause_2;    //!< The second grammar clause.
-      ast_list     * clauses;     //!< List of ast_identifier.
+      ast_ref<ast_identifier_t> clause_2; //!< The second grammar clause.
+      ast_ref<ast_list>         clauses;  //!< List of ast_identifier.
     };
   } ast_config_rule_statement;
 
 
   //! Describes a single config declaration in it's entirety.
   typedef struct ast_config_declaration_t{
-	ast_metadata    meta_info;   //!< Node metadata.
-	ast_identifier  identifier;
-	ast_identifier  design_statement;
-	ast_list      * rule_statements;
+	ast_metadata              meta_info; //!< Node metadata.
+	ast_ref<ast_identifier_t> identifier;
+	ast_ref<ast_identifier_t> design_statement;
+	ast_ref<ast_list>         rule_statements;
   } ast_config_declaration;
 
   // -------------------------------- Library Source Text ----------------------
@@ -1913,10 +1914,10 @@ Verilog Constructs.
 @brief Describes a library declaration of file and include paths.
 */
   typedef struct ast_library_declaration_t{
-    ast_metadata    meta_info;   //!< Node metadata.
-    ast_identifier  identifier;
-    ast_list      * file_paths;
-    ast_list      * incdirs;
+    ast_metadata              meta_info; //!< Node metadata.
+    ast_ref<ast_identifier_t> identifier;
+    ast_ref<ast_list>         file_paths;
+    ast_ref<ast_list>         incdirs;
   } ast_library_declaration;
 
   //! Describes a library item.
@@ -1931,9 +1932,9 @@ Verilog Constructs.
     ast_metadata    meta_info;   //!< Node metadata.
     ast_library_item_type type;
     union{
-      ast_library_declaration * library;
-      ast_config_declaration  * config;
-	  std::string             * include;
+      ast_ref<ast_library_declaration> library;
+      ast_ref<ast_config_declaration>  config;
+      ast_ref<const char>              include;
     };
   } ast_library_descriptions;
 
@@ -1974,8 +1975,8 @@ used to represent a collection of other nodes.
     ast_metadata    meta_info;   //!< Node metadata.
     ast_source_item_type type;  //!< Which member of the union to access.
     union{
-      ast_module_declaration * module; //!< IFF type == SOURCE_MODULE
-      ast_udp_declaration    * udp;   //!< IFF type == SOURCE_UDP
+      ast_ref<ast_module_declaration> module; //!< IFF type == SOURCE_MODULE
+      ast_ref<ast_udp_declaration>    udp;    //!< IFF type == SOURCE_UDP
     };
   } ast_source_item;
 
@@ -1990,6 +1991,7 @@ a verilog source file can contain.
     ast_list    *   primitives;
     ast_list    *   configs;
     ast_list    *   libraries;
+    ast_hashtable * module_index; //!< Module name to ast_module_declaration.
   } verilog_source_tree;
 
   // --------------------------------------------------------------
@@ -2028,10 +2030,18 @@ a verilog source file can contain.
   //! Describes a 2 point delay distribution.
   struct ast_delay2_t{
 	ast_metadata    meta_info;   //!< Node metadata.
-	ast_delay_value * min;
-	ast_delay_value * max;
+	ast_ref<ast_delay_value> min;
+	ast_ref<ast_delay_value> max;
   };
 
+  //! The kind of each tree node, see ast_arena_kind.
+  #define X(node_kind, node_type) \
+    template <> struct ast_arena_kind_of<node_type>{ \
+      static const ast_arena_kind kind = ARENA_KIND_##node_kind; \
+    };
+  AST_ARENA_NODE_KINDS(X)
+  #undef X
+
   /*! @} */
 }
 
@@ -19,12 +19,11 @@ namespace yy {
 */
   ast_list * VerilogCode::ast_list_new ()
   {
-    ast_list * tr = (ast_list *)ast_calloc(1, sizeof(ast_list));
-    tr->head          = NULL;
-    tr->tail          = NULL;
-    tr->walker        = NULL;
+    ast_list * tr = ast_new<ast_list>();
+    tr->data          = NULL;
+    tr->first         = 0;
     tr->items         = 0;
-    tr->current_item  = 0;
+    tr->capacity      = 0;
     return tr;
   }
 
@@ -32,27 +31,56 @@ namespace yy {
 @brief Frees the memory of the supplied linked list.
 @note Does not free the memory of the data elements in the list, only
 the list construct itself.
+@note The list and its storage live in the AST arena, so they are only
+handed back to the system by @ref ast_free_all. This just empties the list.
 */
   void       VerilogCode::ast_list_free(ast_list * list)
   {
-    if(list->items > 0)
-      {
-        list->walker = list->head;
+    list->data     = NULL;
+    list->first    = 0;
+    list->items    = 0;
+    list->capacity = 0;
+  }
 
-        // Walk along the list, freeing elements as we go.
-        while(list->walker != NULL)
-          {
-            ast_list_element * tmp = list->walker;
-            list->walker = list->walker->next;
+  /*!
+@brief Moves the items of a list into a larger block of storage.
+@param [inout] list - The list to grow.
+@param [in] at_front - True if the extra room is needed before the first
+item (for a pre-append), false if it is needed after the last one.
+@details The capacity is doubled, which keeps appends and pre-appends
+amortised O(1). The old block stays in the arena until
+@ref ast_free_all.
+*/
+  void      VerilogCode::ast_list_grow(ast_list * list, bool at_front)
+  {
+    unsigned int capacity = list->capacity < 4 ? 8 : list->capacity * 2;
+    ast_list_item * data = (ast_list_item *)ast_calloc(capacity, sizeof(ast_list_item));
 
-            if(tmp != NULL)
-              {
-                free(tmp);
-              }
-          }
+    // Give the new room to the side being grown, but keep up to half of it
+    // on the other side if that side was already in use. This stops lists
+    // which are both appended and pre-appended to from growing every time.
+    unsigned int room       = capacity - list->items;
+    unsigned int back_room  = list->capacity - list->first - list->items;
+    unsigned int first;
+
+    if(at_front)
+      {
+        first = room - (back_room < room / 2 ? back_room : room / 2);
+      }
+    else
+      {
+        first = list->first < room / 2 ? list->first : room / 2;
       }
 
-    free(list);
+    // Items are relative to where they are kept, so each is copied over.
+    for(unsigned int i = 0; i < list->items; i ++)
+      {
+        data[first + i] = list->data[list->first + i];
+      }
+
+    list->data     = data;
+    list->first    = first;
+    list->capacity = capacity;
   }
 
   /*!
@@ -60,25 +88,13 @@ the list construct itself.
 */
   void       VerilogCode::ast_list_append(ast_list * list, const void * data)
   {
-    if(list->items == 0)
+    if(list->first + list->items == list->capacity)
       {
-        list->head         = (ast_list_element *)ast_calloc(1,sizeof(ast_list_element));
-        list->head->next = NULL;
-        list->head->data = data;
-
-        list->tail         = list->head;
-        list->walker       = list->tail;
-        list->items       += 1;
-        list->current_item = list->items-1;
+        ast_list_grow(list, false);
       }
-    else
-      {
-        list->tail->next = (ast_list_element *)ast_calloc(1, sizeof(ast_list_element));
-        list->tail = list->tail->next;
-        list->tail->data = data;
 
-        list->items += 1;
-      }
+    list->data[list->first + list->items] = data;
+    list->items += 1;
   }
 
 
@@ -87,35 +103,23 @@ the list construct itself.
 */
   void      VerilogCode::ast_list_remove_at(ast_list * list, unsigned int i)
   {
-    if(i > list->items - 1)
+    if(i >= list->items)
       {
         return;
       }
+    else if(i == 0)
+      {
+        list->first += 1;
+        list->items -= 1;
+      }
     else
       {
-        if(i <= list->current_item)
-          {
-            list->current_item = 0;
-            list->walker = list->head;
-          }
-
-        while(list->current_item != i-1 && list->walker != NULL)
+        ast_list_item * at = list->data + list->first + i;
+        for(unsigned int j = i + 1; j < list->items; j ++, at ++)
           {
-            list->walker = list->walker->next;
-            list->current_item += 1;
-          }
-        if(i > 0){
-            assert(i-1 == list->current_item);
-            list->walker->next = list->walker->next->next;
-            list->items -= 1;
-            //ast_list_element * toremove =  list->walker->next;
-            //free(toremove);
-          } else {
-            list->head = list->head->next;
-            //ast_list_element * toremove =  list->head;
-            //free(toremove);
-            list->items -= 1;
+            at[0] = at[1];
           }
+        list->items -= 1;
       }
   }
 
@@ -125,28 +129,14 @@ the list construct itself.
 */
   void       VerilogCode::ast_list_preappend(ast_list * list, void * data)
   {
-    if(list->items == 0)
+    if(list->first == 0)
       {
-        list->head         = (ast_list_element*)ast_calloc(1,sizeof(ast_list_element));
-        list->head->next = NULL;
-        list->head->data = data;
-
-        list->tail         = list->head;
-        list->walker       = list->tail;
-        list->items       += 1;
-        list->current_item = list->items-1;
+        ast_list_grow(list, true);
       }
-    else
-      {
-        ast_list_element * to_add = (ast_list_element *)ast_calloc(1, sizeof(ast_list_element));
-        to_add->data = data;
 
-        to_add->next = list->head;
-        list  ->head = to_add;
-
-        list->items += 1;
-        list->current_item += 1;
-      }
+    list->first -= 1;
+    list->data[list->first] = data;
+    list->items += 1;
   }
 
   /*!
@@ -157,64 +147,26 @@ as the correct type.
   const void * VerilogCode::ast_list_get(ast_list * list, unsigned int item)
   {
     assert(list != NULL);
-    if(item > list->items - 1)
+    if(item >= list->items)
       {
         return NULL;
       }
     else
       {
-        if(item < list->current_item)
-          {
-            list->current_item = 0;
-            list->walker = list->head;
-          }
-
-        while(list->current_item != item && list->walker != NULL)
-          {
-            list->walker = list->walker->next;
-            list->current_item += 1;
-          }
-
-        if(list->walker == NULL)
-          {
-            return NULL;
-          }
-        else
-          {
-            return list->walker->data;
-          }
+        return list->data[list->first + item].get();
       }
   }
 
   std::string VerilogCode::ast_list_get_str(ast_list * list, unsigned int item)
   {
 	assert(list != NULL);
-	if(item > list->items - 1)
+	if(item >= list->items)
 	  {
 		return  std::string("");
 	  }
 	else
 	  {
-		if(item < list->current_item)
-		  {
-			list->current_item = 0;
-			list->walker = list->head;
-		  }
-
-		while(list->current_item != item && list->walker != NULL)
-		  {
-			list->walker = list->walker->next;
-			list->current_item += 1;
-		  }
-
-		if(list->walker == NULL)
-		  {
-			return  std::string("");
-		  }
-		else
-		  {
-			return  std::string((char*)list->walker->data);
-		  }
+		return  std::string((const char*)list->data[list->first + item].get());
 	  }
   }
 
@@ -230,30 +182,19 @@ considered to be found.
       void * data
       ){
     assert(list != NULL);
-    if(list->items  <= 0)
-      {
-        return 0;
-      }
-    else
-      {
-        list->current_item = 0;
-        list->walker = list->head;
 
-        while(list->walker != NULL)
+    const ast_list_item * walker = ast_list_begin(list);
+    const ast_list_item * end    = ast_list_end(list);
+
+    for(; walker != end; walker ++)
+      {
+        if(walker->get() == data)
           {
-            if(list->walker->data == data)
-              {
-                return 1;
-              }
-            else
-              {
-                list->walker = list->walker->next;
-                list->current_item += 1;
-              }
+            return 1;
           }
-
-        return 0;
       }
+
+    return 0;
   }
 
 
@@ -262,8 +203,10 @@ considered to be found.
 @param head - This will form the "front" of the new list.
 @param tail - This will form the "end" of the new list.
 @details This function takes all the elements in tail and appends them
-to those in head. The tail argument is then released from memory, and the
+to those in head. The tail argument is then left empty, and the
 original head pointer is returned, with all data items still in tact.
+If head is empty it simply takes over the storage of tail, otherwise the
+cost is that of appending each item of tail.
 */
   ast_list *    VerilogCode::ast_list_concat(ast_list * head, ast_list * tail)
   {
@@ -272,32 +215,29 @@ original head pointer is returned, with all data items still in tact.
 
     // Perform the concatenation.
 
-    if(head->tail == NULL)
-      {
-        head->tail = tail->head;
-        head->head = tail->head;
-      }
-    else if(head->tail->next == NULL)
+    if(head->items == 0)
       {
-        head->tail->next = tail->head;
-        head->tail = tail->tail;
+        head->data     = tail->data;
+        head->first    = tail->first;
+        head->items    = tail->items;
+        head->capacity = tail->capacity;
       }
-    else
+    else if(tail->items > 0)
       {
-        while(head->tail->next != NULL)
+        while(head->first + head->items + tail->items > head->capacity)
           {
-            head->tail = head->tail->next;
+            ast_list_grow(head, false);
           }
-        head->tail->next = tail->head;
-        head->tail = tail->tail;
-      }
 
-    head->items += tail->items;
-    head->walker = head->head;
-    head->current_item = 0;
+        for(unsigned int i = 0; i < tail->items; i ++)
+          {
+            head->data[head->first + head->items + i] = tail->data[tail->first + i];
+          }
+        head->items += tail->items;
+      }
 
-    // Free only the tail data-structure, not it's elements.
-    //free(tail);
+    // Empty only the tail data-structure, not it's elements.
+    ast_list_free(tail);
 
     // return the new list.
     return head;
@@ -318,13 +258,9 @@ original head pointer is returned, with all data items still in tact.
   void VerilogCode::ast_stack_free(ast_stack * stack){
     assert(stack != NULL);
 
-    while(stack->items != NULL){
-        ast_stack_element * tmp = stack->items->next;
-        free(stack->items);
-        stack->items = tmp;
-      }
-
-    free(stack);
+    // Elements live in the AST arena and are released by ast_free_all.
+    stack->items = NULL;
+    stack->depth = 0;
   }
 
   /*!
@@ -355,29 +291,6 @@ original head pointer is returned, with all data items still in tact.
 
   }
 
-  void VerilogCode::ast_stack_push(
-	  ast_stack * stack,
-	  std::string item
-	  ){
-	assert(stack != NULL);
-
-	if(stack->items == NULL)
-	  {
-		stack->items = (ast_stack_element *)ast_calloc(1,sizeof(ast_stack_element));
-		stack->items->data = (void*)item.c_str();
-	  }
-	else
-	  {
-		ast_stack_element * toadd = (ast_stack_element *)ast_calloc(1,sizeof(ast_stack_element));
-		toadd->data = (void*)item.c_str();
-		toadd->next = stack->items;
-		stack->items = toadd;
-	  }
-
-	stack->depth ++;
-
-  }
-
   /*!
 @brief Pop the top item from the top of the stack.
 @param [inout] stack - The stack to pop from.
@@ -423,21 +336,6 @@ original head pointer is returned, with all data items still in tact.
       }
   }
 
-  std::string* VerilogCode::ast_stack_peek_str(
-	  ast_stack * stack
-	  ){
-	assert(stack != NULL);
-
-	if(stack->items != NULL){
-		char * tr = (char*)stack->items->data;
-		return new std::string(tr);
-	  }
-	else
-	  {
-		return new std::string();
-	  }
-  }
-
   /*!
 @brief Peek at the item *below* the top item on the top of the stack.
 @param [inout] stack - The stack to peek into
@@ -465,12 +363,122 @@ original head pointer is returned, with all data items still in tact.
       }
   }
 
+  //! Marks the key of a slot whose element has been deleted.
+  static const char ast_hashtable_tombstone[1] = {0};
+
+  /*!
+@brief Hashes a string key using 32-bit FNV-1a.
+@param [in] key - The key text. Need not be null terminated.
+@param [in] len - Length of the key in bytes.
+*/
+  unsigned int VerilogCode::ast_hashtable_hash(const char * key, size_t len)
+  {
+    unsigned int h = 2166136261u;
+    for(size_t i = 0; i < len; i ++)
+      {
+        h ^= (unsigned char)key[i];
+        h *= 16777619u;
+      }
+    return h;
+  }
+
+  /*!
+@brief Finds the slot for a key.
+@returns The slot holding the key if it is present, otherwise the slot it
+should be inserted into: the first deleted slot on its probe chain, or the
+empty slot which ends the chain.
+*/
+  ast_hashtable_element * VerilogCode::ast_hashtable_find(
+      ast_hashtable * table, //!< The table to search.
+      const char    * key,   //!< The key to look for.
+      size_t          len,   //!< Length of the key.
+      unsigned int    hash   //!< Hash of the key.
+      ){
+    unsigned int mask = table->capacity - 1;
+    unsigned int i    = hash & mask;
+    ast_hashtable_element * reuse = NULL;
+
+    while(true)
+      {
+        ast_hashtable_element * e = &table->elements[i];
+
+        if(e->key == NULL)
+          {
+            return reuse != NULL ? reuse : e;
+          }
+        else if(e->key == ast_hashtable_tombstone)
+          {
+            if(reuse == NULL)
+              reuse = e;
+          }
+        else if(e->hash == hash && e->key_len == len &&
+                memcmp(e->key, key, len) == 0)
+          {
+            return e;
+          }
+
+        i = (i + 1) & mask;
+      }
+  }
+
+  /*!
+@brief Re-inserts every live element into a fresh set of slots.
+@details Deleted slots are dropped. The old slots stay in the arena until
+@ref ast_free_all.
+*/
+  void VerilogCode::ast_hashtable_resize(
+      ast_hashtable * table,    //!< The table to resize.
+      unsigned int    capacity  //!< New number of slots, a power of two.
+      ){
+    ast_hashtable_element * old      = table->elements;
+    unsigned int            old_size = table->capacity;
+
+    table->elements   = (ast_hashtable_element *)ast_calloc(capacity, sizeof(ast_hashtable_element));
+    table->capacity   = capacity;
+    table->tombstones = 0;
+
+    unsigned int mask = capacity - 1;
+    for(unsigned int o = 0; o < old_size; o ++)
+      {
+        if(old[o].key == NULL || old[o].key == ast_hashtable_tombstone)
+          continue;
+
+        unsigned int i = old[o].hash & mask;
+        while(table->elements[i].key != NULL)
+          i = (i + 1) & mask;
+        table->elements[i] = old[o];
+      }
+  }
+
+  /*!
+@brief Inserts every item of one hashtable into another.
+@details Keys already in the destination keep their item. Only the keys are
+copied, the items are shared between the two tables.
+*/
+  void VerilogCode::ast_hashtable_insert_all(
+      ast_hashtable * table,  //!< The table to insert into.
+      ast_hashtable * from    //!< The table to read from. Not modified.
+      ){
+    assert(table != NULL && from != NULL);
+
+    for(unsigned int i = 0; i < from->capacity; i ++)
+      {
+        ast_hashtable_element * e = &from->elements[i];
+        if(e->key == NULL || e->key == ast_hashtable_tombstone)
+          continue;
+
+        ast_hashtable_insert(table, e->key, e->key_len, e->data);
+      }
+  }
+
   //! Creates and returns a new hashtable.
   ast_hashtable * VerilogCode::ast_hashtable_new(){
     ast_hashtable * tr = (ast_hashtable *)ast_calloc(1,sizeof(ast_hashtable));
 
-    tr->size = 0;
-    tr->elements = ast_list_new();
+    tr->size       = 0;
+    tr->tombstones = 0;
+    tr->capacity   = AST_HASHTABLE_INITIAL_CAPACITY;
+    tr->elements   = (ast_hashtable_element *)ast_calloc(tr->capacity, sizeof(ast_hashtable_element));
 
     return tr;
   }
@@ -479,94 +487,250 @@ original head pointer is returned, with all data items still in tact.
   void  VerilogCode::ast_hashtable_free(
       ast_hashtable * table  //!< The table to free.
       ){
-    ast_list_free(table->elements);
-    free(table);
+    // The slots live in the AST arena and are released by ast_free_all.
+    memset(table->elements, 0, table->capacity * sizeof(ast_hashtable_element));
+    table->size       = 0;
+    table->tombstones = 0;
     return;
   }
 
   //! Inserts a new item into the hashtable.
   ast_hashtable_result VerilogCode::ast_hashtable_insert(
       ast_hashtable * table, //!< The table to insert into.
-	  std::string key,   //!< The key to insert with.
+      const char    * key,   //!< The key to insert with.
+      size_t          len,   //!< Length of the key.
       void          * value  //!< The data being added.
       ){
-	assert(table != NULL);
+    assert(table != NULL);
 
-    unsigned int i;
-    for(i = 0; i < table->elements->items; i ++)
+    if((table->size + table->tombstones + 1) * 4 > table->capacity * 3)
       {
-        ast_hashtable_element * e = (ast_hashtable_element *)ast_list_get(table->elements, i);
-        if(e != NULL)
-          {
-			if(e->key==key){
-                return HASH_KEY_COLLISION;
-              }
-          }
+        // Only grow if live elements need it, else just sweep tombstones.
+        unsigned int capacity = table->capacity;
+        if((table->size + 1) * 2 > capacity)
+          capacity *= 2;
+        ast_hashtable_resize(table, capacity);
       }
-    ast_hashtable_element * toinsert = (ast_hashtable_element *)ast_calloc(1,sizeof(ast_hashtable_element));
-    toinsert->key = key;
-    toinsert->data = value;
-    ast_list_append(table->elements, toinsert);;
+
+    unsigned int hash = ast_hashtable_hash(key, len);
+    ast_hashtable_element * e = ast_hashtable_find(table, key, len, hash);
+
+    if(e->key != NULL && e->key != ast_hashtable_tombstone)
+      {
+        return HASH_KEY_COLLISION;
+      }
+
+    if(e->key == ast_hashtable_tombstone)
+      table->tombstones --;
+
+    // Keep a private copy of the key, the caller's buffer may not live long.
+    char * copy = (char *)ast_calloc(len + 1, sizeof(char));
+    memcpy(copy, key, len);
+
+    e->key     = copy;
+    e->key_len = len;
+    e->hash    = hash;
+    e->data    = value;
+    table->size ++;
 
     return HASH_SUCCESS;
   }
 
+  ast_hashtable_result VerilogCode::ast_hashtable_insert(
+      ast_hashtable * table,
+      std::string key,
+      void          * value
+      ){
+    return ast_hashtable_insert(table, key.data(), key.size(), value);
+  }
+
   //! Returns an item from the hashtable.
   ast_hashtable_result VerilogCode::ast_hashtable_get(
       ast_hashtable * table, //!< The table to fetch from.
-	  std::string key,   //!< The key of the data to fetch.
+      const char    * key,   //!< The key of the data to fetch.
+      size_t          len,   //!< Length of the key.
       void         ** value  //!< [out] The data being returned.
       ){
-    unsigned int i;
-    for(i = 0; i < table->elements->items; i ++)
+    assert(table != NULL);
+
+    unsigned int hash = ast_hashtable_hash(key, len);
+    ast_hashtable_element * e = ast_hashtable_find(table, key, len, hash);
+
+    if(e->key == NULL || e->key == ast_hashtable_tombstone)
       {
-        ast_hashtable_element * e = (ast_hashtable_element *)ast_list_get(table->elements, i);
-        if(e != NULL)
-          {
-			if(e->key==key){
-                *value = (e->data);
-                return HASH_SUCCESS;
-              }
-          }
+        return HASH_KEY_NOT_FOUND;
       }
-    return HASH_KEY_NOT_FOUND;
+
+    *value = e->data;
+    return HASH_SUCCESS;
+  }
+
+  ast_hashtable_result VerilogCode::ast_hashtable_get(
+      ast_hashtable * table,
+      std::string key,
+      void         ** value
+      ){
+    return ast_hashtable_get(table, key.data(), key.size(), value);
   }
 
   //! Removes a key value pair from the hashtable.
   ast_hashtable_result VerilogCode::ast_hashtable_delete(
       ast_hashtable * table, //!< The table to delete from.
-	  std::string key    //!< The key to delete.
+      std::string key    //!< The key to delete.
       ){
-    unsigned int i;
-    for(i = 0; i < table->elements->items; i ++)
+    assert(table != NULL);
+
+    unsigned int hash = ast_hashtable_hash(key.data(), key.size());
+    ast_hashtable_element * e = ast_hashtable_find(table, key.data(), key.size(), hash);
+
+    if(e->key == NULL || e->key == ast_hashtable_tombstone)
       {
-        ast_hashtable_element * e = (ast_hashtable_element *)ast_list_get(table->elements, i);
-        if(e != NULL)
-          {
-			if(e->key==key){
-                ast_list_remove_at(table->elements, i);
-                return HASH_SUCCESS;
-              }
-          }
+        return HASH_KEY_NOT_FOUND;
       }
-    return HASH_KEY_NOT_FOUND;
+
+    // Leave a tombstone so probe chains running through this slot survive.
+    e->key  = ast_hashtable_tombstone;
+    e->data = NULL;
+    table->size --;
+    table->tombstones ++;
+
+    return HASH_SUCCESS;
   }
 
   //! Updates an existing item in the hashtable.
   ast_hashtable_result VerilogCode::ast_hashtable_update(
       ast_hashtable * table, //!< The table to update.
-	  std::string key,   //!< The key to update with.
+      std::string key,   //!< The key to update with.
       void          * value  //!< The new data item to update.
       ){
-    unsigned int i;
-    for(i = 0; i < table->elements->items; i ++)
+    assert(table != NULL);
+
+    unsigned int hash = ast_hashtable_hash(key.data(), key.size());
+    ast_hashtable_element * e = ast_hashtable_find(table, key.data(), key.size(), hash);
+
+    if(e->key == NULL || e->key == ast_hashtable_tombstone)
       {
-        ast_hashtable_element * e = (ast_hashtable_element *)ast_list_get(table->elements, i);
-		if(e->key==key){
-            e->data = value;
-            return HASH_SUCCESS;
-          }
+        return HASH_KEY_NOT_FOUND;
+      }
+
+    e->data = value;
+    return HASH_SUCCESS;
+  }
+
+  // ----------------------- Symbol Table -------------------------------
+
+  //! Creates and returns a new, empty symbol table.
+  ast_symbol_table * VerilogCode::ast_symbol_table_new()
+  {
+    ast_symbol_table * tr = (ast_symbol_table *)ast_calloc(1, sizeof(ast_symbol_table));
+    tr->index   = ast_hashtable_new();
+    tr->entries = ast_list_new();
+    return tr;
+  }
+
+  /*!
+@brief Builds a symbol table around entries interned by another one.
+@details The entries keep their ids, and their texts stay where they are.
+The index is only built once something is interned, see
+ast_symbol_table_index, so a tree loaded from the cache and only read
+costs nothing per symbol.
+*/
+  ast_symbol_table * VerilogCode::ast_symbol_table_adopt(
+      ast_list * entries  //!< Entry for symbol N at position N-1.
+      ){
+    ast_symbol_table * tr = (ast_symbol_table *)ast_calloc(1, sizeof(ast_symbol_table));
+    tr->index   = NULL;
+    tr->entries = entries;
+    return tr;
+  }
+
+  /*!
+@brief Builds the index of a table made by ast_symbol_table_adopt.
+@details The index is sized once, and each entry is placed by the hash it
+carries, so no text is hashed or copied. Does nothing if the table has an
+index already.
+*/
+  void VerilogCode::ast_symbol_table_index(ast_symbol_table * table)
+  {
+    if(table->index != NULL)
+      return;
+
+    // Symbols stay when a streamed module is released.
+    ast_arena_keep keep(this);
+    table->index = ast_hashtable_new();
+
+    // Stay below the load at which ast_hashtable_insert would grow it.
+    unsigned int capacity = table->index->capacity;
+    while((table->entries->items + 1) * 4 > capacity * 3)
+      capacity *= 2;
+    ast_hashtable_resize(table->index, capacity);
+
+    for(unsigned int s = 0; s < table->entries->items; s ++)
+      {
+        ast_symbol_entry * entry = (ast_symbol_entry *)ast_list_at(table->entries, s);
+        ast_hashtable_element * e = ast_hashtable_find(table->index, entry->text,
+                                                       entry->length, entry->hash);
+        if(e->key != NULL)
+          continue;
+
+        e->key     = entry->text;
+        e->key_len = entry->length;
+        e->hash    = entry->hash;
+        e->data    = entry;
+        table->index->size ++;
+      }
+  }
+
+  /*!
+@brief Returns the entry for a string, interning it if it is new.
+@details A string which has been seen before costs one hash and one probe.
+The text of a new string is stored once, as the key of the index, and the
+entry points at that copy.
+*/
+  ast_symbol_entry * VerilogCode::ast_symbol_intern(
+      ast_symbol_table * table, //!< The table to intern into.
+      const char       * text,  //!< The text to intern.
+      size_t             len    //!< Length of the text.
+      ){
+    assert(table != NULL);
+    ast_symbol_table_index(table);
+
+    unsigned int hash = ast_hashtable_hash(text, len);
+    ast_hashtable_element * e = ast_hashtable_find(table->index, text, len, hash);
+
+    if(e->key != NULL && e->key != ast_hashtable_tombstone)
+      {
+        return (ast_symbol_entry *)e->data;
       }
-    return HASH_KEY_NOT_FOUND;
+
+    // Symbols stay when a streamed module is released.
+    ast_arena_keep keep(this);
+
+    ast_symbol_entry * entry = (ast_symbol_entry *)ast_calloc(1, sizeof(ast_symbol_entry));
+    entry->id     = table->entries->items + 1;
+    entry->hash   = hash;
+    entry->length = len;
+
+    ast_hashtable_insert(table->index, text, len, entry);
+
+    // The insert may have resized the index, so look the slot up again.
+    e = ast_hashtable_find(table->index, text, len, hash);
+    entry->text = e->key;
+
+    ast_list_append(table->entries, entry);
+    return entry;
+  }
+
+  //! Returns the entry for a symbol id, or NULL if the id is not known.
+  ast_symbol_entry * VerilogCode::ast_symbol_lookup(
+      ast_symbol_table * table, //!< The table the symbol came from.
+      ast_symbol         symbol //!< The symbol to look up.
+      ){
+    assert(table != NULL);
+
+    if(symbol == AST_SYMBOL_NONE || symbol > table->entries->items)
+      return NULL;
+
+    return (ast_symbol_entry *)ast_list_get(table->entries, symbol - 1);
   }
 }
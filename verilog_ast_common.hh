@@ -5,6 +5,7 @@
 */
 
 #include "stdarg.h"
+#include "stdint.h"
 #include "stdlib.h"
 #include "string.h"
 
@@ -14,38 +15,177 @@
 #define VERILOG_AST_COMMON_H
 
 namespace yy {
-  // --------------- Linked List ------------------------
+  // --------------- Relative pointers ------------------
 
   /*!
-@defgroup ast-linked-lists Linked List
+@defgroup ast-relative-pointers Relative Pointers
 @{
 @ingroup ast-utility
+@brief Pointers kept as the distance from themselves to what they point at.
+@details Every pointer in a tree node, list or symbol entry is kept this
+way, so a tree means the same wherever its memory is mapped, and a cache
+entry can be read where it lies, see verilog_cache.hh. Zero is NULL.
+Copying one aims the copy at the same place, so they may be assigned and
+passed around like the pointers they stand for, but not memcpy'd.
 */
 
+  //! A T * kept as a self-relative offset.
+  template <class T>
+  class ast_ref
+  {
+  public:
+    ast_ref() = default;
+    ast_ref(T * p) { set(p); }
+    ast_ref(const ast_ref & other) { set(other.get()); }
 
-  //! Typedef for the ast_list_element_t
-  typedef struct ast_list_element_t ast_list_element;
+    ast_ref & operator=(const ast_ref & other)
+    {
+      set(other.get());
+      return *this;
+    }
+
+    ast_ref & operator=(T * p)
+    {
+      set(p);
+      return *this;
+    }
+
+    //! Returns what is pointed at, or NULL.
+    T * get() const
+    {
+      return offset == 0 ? NULL : (T *)((uintptr_t)this + (uintptr_t)offset);
+    }
+
+    operator T *() const
+    {
+      return get();
+    }
+
+    T * operator->() const
+    {
+      return get();
+    }
+
+    intptr_t offset;  //!< Bytes from this to what it points at, or 0.
+
+  private:
+    void set(const volatile void * p)
+    {
+      offset = p == NULL ? 0 : (intptr_t)((uintptr_t)p - (uintptr_t)this);
+    }
+  };
+
+  //! List items below this are numbers some rules keep in place of pointers.
+  #define AST_LIST_SCALARS 4096
 
   /*!
-@brief Storage container for a single element in the linked list.
+@brief One item of an ast_list.
+@details As an ast_ref, except that a number below AST_LIST_SCALARS is kept
+as itself offset by INT64_MIN, so it too means the same wherever the list
+is. It converts to a pointer of any type, as the void * it replaces did.
 */
-  struct ast_list_element_t{
-    ast_list_element * next;
-	const void             * data;
+  class ast_list_item
+  {
+  public:
+    ast_list_item() = default;
+    ast_list_item(const ast_list_item & other) { set(other.get()); }
+
+    ast_list_item & operator=(const ast_list_item & other)
+    {
+      set(other.get());
+      return *this;
+    }
+
+    ast_list_item & operator=(const void * p)
+    {
+      set(p);
+      return *this;
+    }
+
+    //! Returns the item, or NULL.
+    const void * get() const
+    {
+      if(offset == 0)
+        return NULL;
+      if((uint64_t)offset - (uint64_t)INT64_MIN < AST_LIST_SCALARS)
+        return (const void *)(uintptr_t)((uint64_t)offset - (uint64_t)INT64_MIN);
+      return (const void *)((uintptr_t)this + (uintptr_t)offset);
+    }
+
+    template <class U>
+    operator U *() const
+    {
+      return (U *)get();
+    }
+
+    intptr_t offset;  //!< As ast_ref::offset, or a number from INT64_MIN.
+
+  private:
+    void set(const void * p)
+    {
+      if(p == NULL)
+        offset = 0;
+      else if((uintptr_t)p < AST_LIST_SCALARS)
+        offset = (intptr_t)((uint64_t)INT64_MIN + (uintptr_t)p);
+      else
+        offset = (intptr_t)((uintptr_t)p - (uintptr_t)this);
+    }
   };
 
+  /*! @} */
+
+  // --------------- List -------------------------------
 
   /*!
-@brief Container struct for the linked list data structure.
+@defgroup ast-linked-lists List
+@{
+@ingroup ast-utility
+@brief A growable array of pointers.
+@details Items are stored contiguously in data[first .. first+items). Space
+is kept free at both ends, so appending and pre-appending are amortised O(1)
+and indexed access is O(1).
+*/
+
+  /*!
+@brief Container struct for the list data structure.
 */
   typedef struct ast_list_t {
-    ast_list_element *  head;         //!< The "front" of the list.
-    ast_list_element *  tail;         //!< The "end" of the list.
-    ast_list_element *  walker;       //!< Used to "walk" along the list.
-    unsigned int        items;        //!< Number of items in the list.
-    unsigned int        current_item; //! Current position of walker in list.
+    ast_ref<ast_list_item> data;      //!< Item storage, owned by the arena.
+    unsigned int           first;     //!< Index in data of the first item.
+    unsigned int           items;     //!< Number of items in the list.
+    unsigned int           capacity;  //!< Number of slots in data.
   } ast_list;
 
+  //! Lists are kept apart from nodes, see ast_arena_kind.
+  template <> struct ast_arena_kind_of<ast_list>{
+    static const ast_arena_kind kind = ARENA_KIND_LIST;
+  };
+
+  /*!
+@brief Returns a pointer to the first item of a list.
+@details With ast_list_end this walks a list without a VerilogCode and
+without writing to anything, so a finished tree may be read by any number
+of threads at once:
+@code
+for(const ast_list_item * i = ast_list_begin(l); i != ast_list_end(l); i ++)
+@endcode
+*/
+  inline const ast_list_item * ast_list_begin(const ast_list * list)
+  {
+    return list->data + list->first;
+  }
+
+  //! Returns a pointer one past the last item of a list.
+  inline const ast_list_item * ast_list_end(const ast_list * list)
+  {
+    return list->data + list->first + list->items;
+  }
+
+  //! Returns the item at an index, which must be less than list->items.
+  inline const void * ast_list_at(const ast_list * list, unsigned int item)
+  {
+    return list->data[list->first + item].get();
+  }
 
   /*! @} */
 
@@ -84,28 +224,33 @@ namespace yy {
 @defgroup ast-hashtable Hash Table
 @{
 @ingroup ast-utility
-@brief A *very* simple hash table implemented (for now) over a linked list.
-@details This can be used for simple key-value pair storage. Current
-access time is O(n) for a table with N elements in it.
-@warning This is a *terrible* way to implement a hash table. It doesn't
-even do any hashing!
-@todo Re-implement over a proper hash table structure.
+@brief A string keyed hash table using open addressing.
+@details Keys are hashed with 32-bit FNV-1a and collisions are resolved by
+linear probing over a power of two number of slots. The table doubles in
+size whenever live and deleted slots together would exceed three quarters
+of it, so lookups stay O(1) on average however many keys are stored.
 */
 
   /*! @} */
 
+  //! Number of slots a hashtable starts out with. Must be a power of two.
+  #define AST_HASHTABLE_INITIAL_CAPACITY 16
 
-  //! A single element in the hash table.
+  //! A single slot in the hash table.
   typedef struct ast_hashtable_element_t{
-	std::string key; //!< The key for the element.
-    void * data;    //!< The data associated with they key.
+    const char  * key;      //!< The key, or NULL if the slot is empty.
+    size_t        key_len;  //!< Length of the key in bytes.
+    unsigned int  hash;     //!< Hash of the key, to skip most key compares.
+    void        * data;     //!< The data associated with they key.
   } ast_hashtable_element;
 
 
   //! A hash table object.
   typedef struct ast_hashtable_t{
-    ast_list * elements; //!< The items.
-    unsigned int size;   //!< The number of elements in the table.
+    ast_hashtable_element * elements;   //!< The slots.
+    unsigned int            size;       //!< The number of elements in the table.
+    unsigned int            capacity;   //!< Number of slots. A power of two.
+    unsigned int            tombstones; //!< Slots of deleted elements.
   } ast_hashtable;
 
   typedef enum ast_hashtable_result_e{
@@ -115,5 +260,40 @@ even do any hashing!
     HASH_KEY_NOT_FOUND  = 3
   } ast_hashtable_result;
 
+  // ----------------------- Symbol Table -------------------------------
+
+  /*!
+@defgroup ast-symbols Symbol Table
+@{
+@ingroup ast-utility
+@brief Interns identifier text so each distinct name is stored only once.
+@details Every distinct string is given a dense, non-zero ast_symbol id and
+a single NUL terminated copy of its text in the arena. Two interned strings
+from the same table are equal exactly when their ids, or equivalently their
+text pointers, are equal.
+*/
+
+  //! Dense id of an interned string. Zero is never a valid symbol.
+  typedef unsigned int ast_symbol;
+
+  //! The ast_symbol value which no interned string ever has.
+  #define AST_SYMBOL_NONE 0
+
+  //! One interned string.
+  typedef struct ast_symbol_entry_t{
+    ast_symbol          id;       //!< The id of the string.
+    unsigned int        hash;     //!< Hash of the text, as ast_hashtable_hash.
+    size_t              length;   //!< Length of the text in bytes.
+    ast_ref<const char> text;     //!< The interned, NUL terminated text.
+  } ast_symbol_entry;
+
+  //! Maps strings to symbols and back.
+  typedef struct ast_symbol_table_t{
+    ast_hashtable * index;    //!< Text to ast_symbol_entry, or NULL until needed.
+    ast_list      * entries;  //!< Entry for symbol N is at position N-1.
+  } ast_symbol_table;
+
+  /*! @} */
+
 }
 #endif
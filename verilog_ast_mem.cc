@@ -4,6 +4,8 @@
 manage dynamic memory allocation within the library.
 */
 
+#include <assert.h>
+
 #include "verilog_ast_mem.hh"
 #include "verilogcode.h"
 
@@ -16,82 +18,264 @@ namespace yy {
 */
 
   /*!
-@brief A simple wrapper around calloc.
+@brief A replacement for calloc which bump allocates from an arena.
 @details Makes it very easy to clean up afterward using the @ref ast_free_all
-function.
+function. See ast_arena_alloc.
 @param [in] num - Number of elements to allocate space for.
 @param [in] size - The size of each element being allocated.
 @returns A pointer to the start of the block of memory allocated.
 */
   void * VerilogCode::ast_calloc(size_t num, size_t size)
   {
-    // This is the memory the user asked for.
-    void * data = calloc(num,size);
+    assert(size == 0 || num <= ((size_t)-1) / size);
+    return ast_arena_alloc(num * size, ARENA_KIND_DATA);
+  }
+
+  /*!
+@brief Hands out zeroed bytes from the arena.
+@details Requests which do not fit in the current chunk start a new one.
+Requests larger than a chunk get a dedicated chunk of their own, which is
+linked in behind the current one so the space left in it is not wasted.
+While a module is being streamed, requests made under an ast_arena_keep come
+from the chunks at memory_keep instead, which ast_arena_release leaves alone.
+Chunks only get a kind map while arena_kind_maps is set, and only then is
+the kind of the block noted. Setting it starts a new chunk, one with a map.
+@param [in] bytes - Number of bytes to allocate.
+@param [in] kind - What the block will hold.
+@returns A pointer to the start of the block of memory allocated.
+*/
+  void * VerilogCode::ast_arena_alloc(size_t bytes, ast_arena_kind kind)
+  {
+    size_t header = AST_ARENA_ALIGN(sizeof(ast_arena_chunk));
 
     memory_allocations += 1;
+    total_allocated    += bytes;
+    bytes               = AST_ARENA_ALIGN(bytes);
+
+    ast_arena_chunk ** head = arena_keep > 0 && modules_open > 0 ?
+                              &memory_keep : &memory_head;
 
-    // Add the allocated memory to tracking data structure.
-    if(walker == NULL)
+    if(*head == NULL || (*head)->used + bytes > (*head)->size ||
+       (arena_kind_maps && (*head)->kinds == NULL))
       {
-        memory_head = (ast_memory *)calloc(1,sizeof(ast_memory));
-        memory_head->size = num * size;
-        total_allocated += memory_head->size;
-        memory_head->data = data;
-        memory_head->next = NULL;
-        walker      = memory_head;
+        size_t chunk_size = bytes > AST_ARENA_CHUNK_SIZE ? bytes :
+                                                           AST_ARENA_CHUNK_SIZE;
+        size_t map_size   = arena_kind_maps ? chunk_size / AST_ARENA_ALIGNMENT : 0;
+
+        // Fresh chunks come from calloc, so every block is already zeroed.
+        ast_arena_chunk * chunk = (ast_arena_chunk *)calloc(1, header + chunk_size + map_size);
+        assert(chunk != NULL);
+
+        chunk->size   = chunk_size;
+        chunk->used   = 0;
+        chunk->serial = arena_chunks ++;
+        chunk->kinds  = map_size > 0 ? (unsigned char *)chunk + header + chunk_size : NULL;
+        arena_reserved += header + chunk_size + map_size;
+        VERILOG_TRACE(this, TRACE_MEMORY, "New arena chunk of %lu bytes.",
+                      (unsigned long)chunk_size);
+
+        if(*head != NULL && bytes > AST_ARENA_CHUNK_SIZE)
+          {
+            // Oversized request, keep bump allocating from the current head.
+            chunk->next    = (*head)->next;
+            (*head)->next  = chunk;
+          }
+        else
+          {
+            chunk->next = *head;
+            *head       = chunk;
+          }
+
+        chunk->used     = bytes;
+        if(chunk->kinds != NULL)
+          chunk->kinds[0] = (unsigned char)kind;
+        arena_in_use   += bytes;
+        if(arena_in_use > arena_high_water)
+          arena_high_water = arena_in_use;
+
+        return (char *)chunk + header;
       }
-    else
+
+    void * data = (char *)*head + header + (*head)->used;
+    if((*head)->kinds != NULL)
+      (*head)->kinds[(*head)->used / AST_ARENA_ALIGNMENT] = (unsigned char)kind;
+    (*head)->used += bytes;
+
+    arena_in_use += bytes;
+    if(arena_in_use > arena_high_water)
+      arena_high_water = arena_in_use;
+
+    return data;
+  }
+
+  //! Returns the current position of the arena.
+  ast_arena_mark VerilogCode::ast_arena_get_mark()
+  {
+    ast_arena_mark tr;
+    tr.chunk  = memory_head;
+    tr.used   = memory_head != NULL ? memory_head->used : 0;
+    tr.serial = arena_chunks;
+    return tr;
+  }
+
+  /*!
+@brief Frees everything allocated from the arena since a mark was taken.
+@details Chunks made since the mark are freed whole. They all sit in front
+of the marked chunk, oversized ones included, since those are linked in just
+behind whichever chunk was the head. The marked chunk is cut back, and the
+part given back zeroed again, as ast_calloc promises zeroed memory.
+*/
+  void VerilogCode::ast_arena_release(const ast_arena_mark * mark)
+  {
+    size_t header = AST_ARENA_ALIGN(sizeof(ast_arena_chunk));
+    ast_arena_chunk ** link = &memory_head;
+
+    while(*link != NULL && *link != mark->chunk)
       {
-        walker->next = (ast_memory *)calloc(1,sizeof(ast_memory));
-        walker->next->size = num * size;
-        total_allocated += walker->size;
-        walker->next->data = data;
-        walker->next->next = NULL;
-        walker         = walker->next;
+        ast_arena_chunk * chunk = *link;
+        if(chunk->serial < mark->serial)
+          {
+            link = &chunk->next;
+            continue;
+          }
+
+        *link           = chunk->next;
+        arena_in_use   -= chunk->used;
+        arena_reserved -= header + chunk->size +
+                          (chunk->kinds != NULL ? chunk->size / AST_ARENA_ALIGNMENT : 0);
+        free(chunk);
       }
 
+    if(mark->chunk != NULL)
+      {
+        // Oversized chunks made since the mark may follow it directly.
+        while(mark->chunk->next != NULL && mark->chunk->next->serial >= mark->serial)
+          {
+            ast_arena_chunk * chunk = mark->chunk->next;
+            mark->chunk->next = chunk->next;
+            arena_in_use   -= chunk->used;
+            arena_reserved -= header + chunk->size +
+                          (chunk->kinds != NULL ? chunk->size / AST_ARENA_ALIGNMENT : 0);
+            free(chunk);
+          }
+
+        memset((char *)mark->chunk + header + mark->used, 0,
+               mark->chunk->used - mark->used);
 
-    return data;
+        if(mark->chunk->kinds != NULL)
+          memset(mark->chunk->kinds + mark->used / AST_ARENA_ALIGNMENT, ARENA_KIND_NONE,
+                 (mark->chunk->used - mark->used) / AST_ARENA_ALIGNMENT);
+
+        arena_in_use     -= mark->chunk->used - mark->used;
+        mark->chunk->used = mark->used;
+      }
+
+    VERILOG_TRACE(this, TRACE_MEMORY, "Released the arena back to %lu bytes in use.",
+                  (unsigned long)arena_in_use);
+  }
+
+  ast_arena_keep::ast_arena_keep(VerilogCode * code) : code(code)
+  {
+    code->arena_keep ++;
+  }
+
+  ast_arena_keep::~ast_arena_keep()
+  {
+    code->arena_keep --;
+  }
+
+  /*!
+@brief Copies length bytes of text into the arena.
+@details The arena hands out zeroed memory, so the copy is NUL terminated.
+*/
+  char * VerilogCode::ast_strndup(const char * text, size_t length)
+  {
+    char * tr = (char *)ast_arena_alloc(length + 1, ARENA_KIND_TEXT);
+    memcpy(tr, text, length);
+    return tr;
+  }
+
+  /*!
+@brief Returns the largest number of bytes the arena has ever had in use.
+@details Includes alignment padding, but not the unused tail of each chunk.
+See arena_reserved for the memory actually requested from the system.
+*/
+  size_t VerilogCode::ast_arena_high_water()
+  {
+    return arena_high_water;
   }
 
   /*!
 @brief Frees all memory allocated using @ref ast_calloc.
-@details Free's all data stored in the linked list pointed to by the
-@ref head variable.
-@post @ref walker and @ref head are NULL. All memory allocated by ast_calloc
-has been freed.
+@details Hands every arena chunk back to the system. The cost depends only on
+the number of chunks, not on the number of nodes allocated.
+@post @ref memory_head and @ref yy_symbols are NULL. All memory allocated by
+ast_calloc has been freed.
 */
   void VerilogCode::ast_free_all()
   {
-    printf("Freeing data for %u memory allocations.\n", memory_allocations);
+    verilog_phase_timer timer(&stats.phases[PHASE_RELEASE]);
+    stats.phases[PHASE_RELEASE].count += arena_reserved;
+
+    VERILOG_TRACE(this, TRACE_MEMORY, "Freeing data for %u memory allocations.",
+                  memory_allocations);
     size_t total_freed = 0;
 
+    // The files of a project were parsed into arenas of their own.
+    verilog_project_release();
+
+    // Trees loaded from the cache point into its mappings.
+    verilog_cache_release();
+
+    // Cached include files live outside the arena, only their entries in it.
+    if(yy_preproc != NULL)
+      {
+        for(unsigned int i = 0; i < yy_preproc->include_files->items; i ++)
+          {
+            verilog_include_file * file = (verilog_include_file *)ast_list_get(yy_preproc->include_files, i);
+            file->input->cached = false;
+            verilog_input_release(file->input);
+          }
+      }
+
     while(memory_head != NULL)
       {
-        walker = memory_head->next;
-        total_freed += memory_head->size;
+        ast_arena_chunk * next = memory_head->next;
+        total_freed += memory_head->used;
 
-        free(memory_head->data);
         free(memory_head);
 
-        memory_head = walker;
+        memory_head = next;
       }
 
-    printf("\tFree'd %lu bytes of %lu bytes allocated.\n",
-           total_freed, total_allocated);
-    printf("\tBytes remaining: %lu\n", total_allocated - total_freed);
-  }
+    while(memory_keep != NULL)
+      {
+        ast_arena_chunk * next = memory_keep->next;
+        total_freed += memory_keep->used;
 
+        free(memory_keep);
 
-  /*std::string VerilogCode::ast_strdup(QString in)
-  {
-		return in.toStdString();
-  }
+        memory_keep = next;
+      }
 
-  std::string VerilogCode::ast_strdup(std::string in)
-  {
-		return in;
-  }*/
+    VERILOG_TRACE(this, TRACE_MEMORY,
+                  "Free'd %lu bytes of %lu bytes in use (high water %lu).",
+                  (unsigned long)total_freed, (unsigned long)arena_in_use,
+                  (unsigned long)arena_high_water);
+
+    arena_in_use   = 0;
+    arena_reserved = 0;
+    modules_open   = 0;
+
+    // The symbol table, preprocessor and source tree lived in the arena too.
+    yy_symbols             = NULL;
+    yy_identifiers         = NULL;
+    yy_units               = NULL;
+    cache_images           = NULL;
+    yy_preproc             = NULL;
+    yy_verilog_source_tree = NULL;
+    input_stack            = NULL;
+  }
 
 
   /*!@}*/
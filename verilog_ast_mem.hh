@@ -13,16 +13,182 @@ manage dynamic memory allocation within the library.
 #define VERILOG_AST_MEM_H
 
 namespace yy {
-  //! Typedef over ast_memory_T
-  typedef struct ast_memory_t ast_memory;
-
-  //! Stores information on some allocated memory as a linked list.
-  struct ast_memory_t{
-    size_t          size;   //!< Amount of memory allocated.
-    void        *   data;   //!< Pointer to the allocated memory.
-    ast_memory  *   next;   //!< Next element to be allocated.
+  //! Default number of usable bytes in a single arena chunk.
+  #define AST_ARENA_CHUNK_SIZE  (256 * 1024)
+
+  //! Every block handed out by the arena is aligned to this many bytes.
+  #define AST_ARENA_ALIGNMENT   16
+
+  //! Rounds n up to the next multiple of AST_ARENA_ALIGNMENT.
+  #define AST_ARENA_ALIGN(n) \
+    (((n) + (AST_ARENA_ALIGNMENT - 1)) & ~((size_t)AST_ARENA_ALIGNMENT - 1))
+
+  /*!
+@brief Lists every kind of tree node with its type, as X(kind, type).
+@details Gives the node kinds of ast_arena_kind, ast_arena_kind_of and the
+layout signature of verilog_cache.cc, so none of them can miss a node.
+*/
+  #define AST_ARENA_NODE_KINDS(X) \
+    X(IDENTIFIER,                               ast_identifier_t) \
+    X(NUMBER,                                   ast_number) \
+    X(NODE_ATTRIBUTES,                          ast_node_attributes) \
+    X(CONCATENATION,                            ast_concatenation) \
+    X(LVALUE,                                   ast_lvalue) \
+    X(FUNCTION_CALL,                            ast_function_call) \
+    X(PRIMARY,                                  ast_primary) \
+    X(EXPRESSION,                               ast_expression) \
+    X(SIMPLE_PARALLEL_PATH_DECLARATION,         ast_simple_parallel_path_declaration) \
+    X(SIMPLE_FULL_PATH_DECLARATION,             ast_simple_full_path_declaration) \
+    X(EDGE_SENSITIVE_PARALLEL_PATH_DECLARATION, ast_edge_sensitive_parallel_path_declaration) \
+    X(EDGE_SENSITIVE_FULL_PATH_DECLARATION,     ast_edge_sensitive_full_path_declaration) \
+    X(PATH_DECLARATION,                         ast_path_declaration) \
+    X(TASK_ENABLE_STATEMENT,                    ast_task_enable_statement) \
+    X(LOOP_STATEMENT,                           ast_loop_statement) \
+    X(CASE_ITEM,                                ast_case_item) \
+    X(CASE_STATEMENT,                           ast_case_statement) \
+    X(CONDITIONAL_STATEMENT,                    ast_conditional_statement) \
+    X(IF_ELSE,                                  ast_if_else) \
+    X(WAIT_STATEMENT,                           ast_wait_statement) \
+    X(EVENT_EXPRESSION,                         ast_event_expression) \
+    X(EVENT_CONTROL,                            ast_event_control) \
+    X(DELAY_CTRL,                               ast_delay_ctrl) \
+    X(TIMING_CONTROL_STATEMENT,                 ast_timing_control_statement) \
+    X(DISABLE_STATEMENT,                        ast_disable_statement) \
+    X(STATEMENT_BLOCK,                          ast_statement_block) \
+    X(SINGLE_ASSIGNMENT,                        ast_single_assignment) \
+    X(CONTINUOUS_ASSIGNMENT,                    ast_continuous_assignment) \
+    X(PROCEDURAL_ASSIGNMENT,                    ast_procedural_assignment) \
+    X(HYBRID_ASSIGNMENT,                        ast_hybrid_assignment) \
+    X(ASSIGNMENT,                               ast_assignment) \
+    X(STATEMENT,                                ast_statement) \
+    X(PULSE_CONTROL_SPECPARAM,                  ast_pulse_control_specparam) \
+    X(UDP_PORT,                                 ast_udp_port) \
+    X(UDP_INITIAL_STATEMENT,                    ast_udp_initial_statement) \
+    X(UDP_BODY,                                 ast_udp_body) \
+    X(UDP_COMBINATORIAL_ENTRY,                  ast_udp_combinatorial_entry) \
+    X(UDP_SEQUENTIAL_ENTRY,                     ast_udp_sequential_entry) \
+    X(UDP_DECLARATION,                          ast_udp_declaration) \
+    X(UDP_INSTANCE,                             ast_udp_instance) \
+    X(UDP_INSTANTIATION,                        ast_udp_instantiation) \
+    X(RANGE,                                    ast_range) \
+    X(GENERATE_BLOCK,                           ast_generate_block) \
+    X(MODULE_INSTANTIATION,                     ast_module_instantiation) \
+    X(MODULE_INSTANCE,                          ast_module_instance) \
+    X(PORT_CONNECTION,                          ast_port_connection) \
+    X(SWITCH_GATE,                              ast_switch_gate) \
+    X(PULL_STRENGTH,                            ast_pull_strength) \
+    X(PRIMITIVE_PULL_STRENGTH,                  ast_primitive_pull_strength) \
+    X(PULL_GATE_INSTANCE,                       ast_pull_gate_instance) \
+    X(PASS_SWITCH_INSTANCE,                     ast_pass_switch_instance) \
+    X(N_INPUT_GATE_INSTANCES,                   ast_n_input_gate_instances) \
+    X(N_INPUT_GATE_INSTANCE,                    ast_n_input_gate_instance) \
+    X(ENABLE_GATE_INSTANCES,                    ast_enable_gate_instances) \
+    X(ENABLE_GATE_INSTANCE,                     ast_enable_gate_instance) \
+    X(MOS_SWITCH_INSTANCE,                      ast_mos_switch_instance) \
+    X(CMOS_SWITCH_INSTANCE,                     ast_cmos_switch_instance) \
+    X(PASS_ENABLE_SWITCH,                       ast_pass_enable_switch) \
+    X(PASS_ENABLE_SWITCHES,                     ast_pass_enable_switches) \
+    X(N_OUTPUT_GATE_INSTANCE,                   ast_n_output_gate_instance) \
+    X(N_OUTPUT_GATE_INSTANCES,                  ast_n_output_gate_instances) \
+    X(SWITCHES,                                 ast_switches) \
+    X(GATE_INSTANTIATION,                       ast_gate_instantiation) \
+    X(DELAY_VALUE,                              ast_delay_value) \
+    X(DELAY3,                                   ast_delay3) \
+    X(DELAY2,                                   ast_delay2) \
+    X(PORT_DECLARATION,                         ast_port_declaration) \
+    X(TYPE_DECLARATION,                         ast_type_declaration) \
+    X(NET_DECLARATION,                          ast_net_declaration) \
+    X(REG_DECLARATION,                          ast_reg_declaration) \
+    X(VAR_DECLARATION,                          ast_var_declaration) \
+    X(PARAMETER_DECLARATIONS,                   ast_parameter_declarations) \
+    X(BLOCK_REG_DECLARATION,                    ast_block_reg_declaration) \
+    X(BLOCK_ITEM_DECLARATION,                   ast_block_item_declaration) \
+    X(RANGE_OR_TYPE,                            ast_range_or_type) \
+    X(FUNCTION_DECLARATION,                     ast_function_declaration) \
+    X(TASK_PORT,                                ast_task_port) \
+    X(FUNCTION_ITEM_DECLARATION,                ast_function_item_declaration) \
+    X(TASK_DECLARATION,                         ast_task_declaration) \
+    X(MODULE_ITEM,                              ast_module_item) \
+    X(MODULE_DECLARATION,                       ast_module_declaration) \
+    X(CONFIG_RULE_STATEMENT,                    ast_config_rule_statement) \
+    X(CONFIG_DECLARATION,                       ast_config_declaration) \
+    X(LIBRARY_DECLARATION,                      ast_library_declaration) \
+    X(LIBRARY_DESCRIPTIONS,                     ast_library_descriptions) \
+    X(SOURCE_ITEM,                              ast_source_item)
+
+  /*!
+@brief What a block handed out by the arena holds.
+@details Kept in the kind map of its chunk while a cache directory is set,
+so the type of the node at any address is known without trusting the type
+of the pointer which led there. This is what lets verilog_cache.cc walk a
+tree field by field.
+*/
+  typedef enum ast_arena_kind_e{
+    ARENA_KIND_NONE = 0,    //!< No block starts here.
+    ARENA_KIND_DATA,        //!< Anything which is not a tree node.
+    ARENA_KIND_TEXT,        //!< NUL terminated text, see ast_strndup.
+    ARENA_KIND_LIST,        //!< An ast_list. Its storage is DATA.
+    #define X(kind, type) ARENA_KIND_##kind,
+    AST_ARENA_NODE_KINDS(X)
+    #undef X
+    ARENA_KIND_COUNT        //!< Number of kinds, not a kind.
+  } ast_arena_kind;
+
+  //! Gives the kind of a block holding a T, see VerilogCode::ast_new.
+  template <class T>
+  struct ast_arena_kind_of{
+    static const ast_arena_kind kind = ARENA_KIND_DATA;
+  };
+
+  //! Typedef over ast_arena_chunk_t
+  typedef struct ast_arena_chunk_t ast_arena_chunk;
+
+  /*!
+@brief Header of one large block of memory which AST nodes are bump
+allocated from.
+@details The usable memory starts AST_ARENA_ALIGN(sizeof(ast_arena_chunk))
+bytes after the header. Chunks form a singly linked list, with the chunk
+currently being allocated from at the head. A chunk made while a cache
+directory is set has a kind map after the usable memory, with one byte for
+every AST_ARENA_ALIGNMENT bytes. It holds the ast_arena_kind of the block
+starting there, or ARENA_KIND_NONE.
+*/
+  struct ast_arena_chunk_t{
+    ast_arena_chunk * next;   //!< Next (older) chunk in the arena.
+    size_t            size;   //!< Number of usable bytes in the chunk.
+    size_t            used;   //!< Number of bytes handed out so far.
+    unsigned long     serial; //!< Chunks are numbered in the order made.
+    unsigned char   * kinds;  //!< The kind map, or NULL if it has none.
+  };
+
+  /*!
+@brief A point in the arena which it can later be cut back to.
+@details Everything allocated after the mark is released at once, which is
+how a streamed module is freed. See VerilogCode::ast_arena_release.
+*/
+  typedef struct ast_arena_mark_t{
+    ast_arena_chunk * chunk;  //!< The head chunk when marked, or NULL.
+    size_t            used;   //!< Bytes used in chunk when marked.
+    unsigned long     serial; //!< Serial the next new chunk would get.
+  } ast_arena_mark;
+
+  class VerilogCode;
+
+  /*!
+@brief Makes ast_calloc allocate memory which outlives a streamed module.
+@details Declare one at the top of anything which allocates preprocessor,
+scanner or symbol state, which may be used after the module being parsed
+is released. Has no effect unless a module is being streamed.
+*/
+  class ast_arena_keep
+  {
+  public:
+    explicit ast_arena_keep(VerilogCode * code);
+    ~ast_arena_keep();
+
+  private:
+    VerilogCode * code;
   };
 }
 
 #endif
-
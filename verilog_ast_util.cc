@@ -6,14 +6,44 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
+
+#include <chrono>
 
 #include "verilog_ast_util.hh"
 #include "verilogcode.h"
 
 namespace yy {
   /*!
-@brief Searches the list of modules in the parsed source tree, returning the
-one that matches the passed identifer.
+@brief Adds a module to a source tree, and to its module name index.
+@details Where two modules share a name, the first one added stays in the
+index, which matches the order the old linear search found them in.
+*/
+  void VerilogCode::verilog_source_tree_add_module(
+      verilog_source_tree    * source,
+      ast_module_declaration * module
+      ){
+    ast_list_append(source->modules, module);
+
+    if(module->identifier == NULL)
+      return;
+
+    if(module->identifier->next == NULL)
+      {
+        const char * name = module->identifier->identifier;
+        ast_hashtable_insert(source->module_index, name, strlen(name), module);
+      }
+    else
+      {
+        ast_hashtable_insert(source->module_index,
+                             ast_identifier_tostring(module->identifier),
+                             module);
+      }
+  }
+
+  /*!
+@brief Looks up the module in the parsed source tree that matches the
+passed identifer.
 @returns The matching module declaration, or NULL if no such declaration
 exists.
 */
@@ -21,33 +51,48 @@ exists.
       verilog_source_tree * source,
       ast_identifier module_name
       ){
-    unsigned int m;
-    for(m = 0; m < source->modules->items; m++)
+    void * found = NULL;
+    ast_hashtable_result result;
+
+    if(module_name->next == NULL)
+      {
+        const char * name = module_name->identifier;
+        result = ast_hashtable_get(source->module_index, name, strlen(name),
+                                   &found);
+      }
+    else
       {
-        ast_module_declaration * candidate = (ast_module_declaration *)ast_list_get(source->modules,m);
+        result = ast_hashtable_get(source->module_index,
+                                   ast_identifier_tostring(module_name),
+                                   &found);
+      }
 
-        if(ast_identifier_cmp(module_name, candidate->identifier) == 0)
-          {
-            return candidate;
-          }
+    if(result != HASH_SUCCESS)
+      {
+        return NULL;
       }
 
-    return NULL;
+    return (ast_module_declaration *)found;
   }
 
 
   /*!
 @brief searches across an entire verilog source tree, resolving module
 identifiers to their declarations.
+@returns Counts of resolved, unresolved and previously resolved
+instantiations, and the wall time taken.
 */
-  void VerilogCode::verilog_resolve_modules(
+  verilog_resolution_stats VerilogCode::verilog_resolve_modules(
       verilog_source_tree * source
       ){
     assert(source != NULL);
     assert(source->modules != NULL);
 
-    int resolved = 0;
-    int unresolved = 0;
+    verilog_resolution_stats stats;
+    memset(&stats, 0, sizeof(stats));
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
 
 	for(unsigned int m = 0; m < source->modules->items; m++)
       {
@@ -60,12 +105,6 @@ identifiers to their declarations.
             continue;
           }
 
-        assert(module->identifier != NULL);
-        assert(module->module_instantiations != NULL);
-
-        //printf("%s\n", ast_identifier_tostring(module->identifier));
-
-
         unsigned int sm;
         for(sm = 0; sm < module->module_instantiations->items; sm ++)
           {
@@ -73,7 +112,7 @@ identifiers to their declarations.
 
             if(submod->resolved)
               {
-                // Do Nothing
+                stats.skipped ++;
               }
             else
               {
@@ -83,21 +122,25 @@ identifiers to their declarations.
                                                     submod->module_identifer);
                 if(foundmod == NULL)
                   {
-                    //printf("Could not resolve module name '%s'\n",
-                    //ast_identifier_tostring(submod->module_identifer));
-                    unresolved ++;
+                    stats.unresolved ++;
                   }
                 else
                   {
                     submod->resolved = true;
                     submod->declaration = foundmod;
-                    resolved ++;
+                    stats.resolved ++;
                   }
               }
           }
       }
-    //printf("Resolved Modules: %d\t Unresolved Modules: %d\n",
-    //    resolved,unresolved);
+
+    stats.seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    this->stats.phases[PHASE_RESOLVE].seconds += stats.seconds;
+    this->stats.phases[PHASE_RESOLVE].count   += stats.resolved + stats.unresolved;
+
+    return stats;
   }
 
 
@@ -14,6 +14,17 @@
 
 namespace yy {
 
+  /*!
+@brief Summary of one call to verilog_resolve_modules.
+@ingroup ast-utility-modules
+*/
+  typedef struct verilog_resolution_stats_t{
+    unsigned int  resolved;     //!< Instantiations resolved by this call.
+    unsigned int  unresolved;   //!< Instantiations with no known module.
+    unsigned int  skipped;      //!< Instantiations already resolved before.
+    double        seconds;      //!< Wall time spent resolving.
+  } verilog_resolution_stats;
+
 }
 
 #endif
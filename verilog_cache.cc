@@ -0,0 +1,2073 @@
+/*!
+@file verilog_cache.cc
+@brief Contains implementations of the AST cache functions declared in
+       verilogcode.h
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "verilogcode.h"
+
+namespace yy {
+
+  //! Rounds n up to the alignment of every block in an image.
+  #define VERILOG_CACHE_ALIGN(n) (((n) + 7) & ~(uint64_t)7)
+
+  /*!
+@brief Lists the fields of a node, for an archive to write or check.
+@details A is verilog_cache_writer or verilog_cache_checker. place gives the
+node, read from the arena or lying in the image, then each pointer is
+passed to meta, ref or symbol in turn. Anything not passed is a value, and
+is copied with the node.
+A union of pointers is passed as any one of its members, since ref goes by
+the kind of the block pointed at. A union which may hold a value is passed
+only when its node says a pointer is in use.
+*/
+  template <class A>
+  static void verilog_cache_fields(A & a, ast_arena_kind kind, void * node)
+  {
+    switch(kind)
+      {
+      case ARENA_KIND_IDENTIFIER:
+        {
+          ast_identifier n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.symbol(n);
+          a.ref(n->next);
+          a.ref(n->ranges);
+        }
+        break;
+      case ARENA_KIND_NUMBER:
+        {
+          ast_number * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          if(n->representation == REP_BITS)
+            a.ref(n->as_bits);
+        }
+        break;
+      case ARENA_KIND_NODE_ATTRIBUTES:
+        {
+          ast_node_attributes * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->attr_name);
+          a.ref(n->attr_value);
+          a.ref(n->next);
+        }
+        break;
+      case ARENA_KIND_CONCATENATION:
+        {
+          ast_concatenation * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->repeat);
+          a.ref(n->items);
+        }
+        break;
+      case ARENA_KIND_LVALUE:
+        {
+          ast_lvalue * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->data.identifier);
+        }
+        break;
+      case ARENA_KIND_FUNCTION_CALL:
+        {
+          ast_function_call * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->function);
+          a.ref(n->arguments);
+          a.ref(n->attributes);
+        }
+        break;
+      case ARENA_KIND_PRIMARY:
+        {
+          ast_primary * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->value.number);
+        }
+        break;
+      case ARENA_KIND_EXPRESSION:
+        {
+          ast_expression * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->attributes);
+          a.ref(n->left);
+          a.ref(n->right);
+          a.ref(n->aux);
+          a.ref(n->primary);
+          a.ref(n->string);
+        }
+        break;
+      case ARENA_KIND_SIMPLE_PARALLEL_PATH_DECLARATION:
+        {
+          ast_simple_parallel_path_declaration * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->input_terminal);
+          a.ref(n->output_terminal);
+          a.ref(n->delay_value);
+        }
+        break;
+      case ARENA_KIND_SIMPLE_FULL_PATH_DECLARATION:
+        {
+          ast_simple_full_path_declaration * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->input_terminals);
+          a.ref(n->output_terminals);
+          a.ref(n->delay_value);
+        }
+        break;
+      case ARENA_KIND_EDGE_SENSITIVE_PARALLEL_PATH_DECLARATION:
+        {
+          ast_edge_sensitive_parallel_path_declaration * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->input_terminal);
+          a.ref(n->output_terminal);
+          a.ref(n->data_source);
+          a.ref(n->delay_value);
+        }
+        break;
+      case ARENA_KIND_EDGE_SENSITIVE_FULL_PATH_DECLARATION:
+        {
+          ast_edge_sensitive_full_path_declaration * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->input_terminal);
+          a.ref(n->output_terminal);
+          a.ref(n->data_source);
+          a.ref(n->delay_value);
+        }
+        break;
+      case ARENA_KIND_PATH_DECLARATION:
+        {
+          ast_path_declaration * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->state_expression);
+          a.ref(n->parallel);
+        }
+        break;
+      case ARENA_KIND_TASK_ENABLE_STATEMENT:
+        {
+          ast_task_enable_statement * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->expressions);
+          a.ref(n->identifier);
+        }
+        break;
+      case ARENA_KIND_LOOP_STATEMENT:
+        {
+          ast_loop_statement * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->inner_statement);
+          a.ref(n->condition);
+          a.ref(n->initial);
+          a.ref(n->modify);
+        }
+        break;
+      case ARENA_KIND_CASE_ITEM:
+        {
+          ast_case_item * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->conditions);
+          a.ref(n->body);
+        }
+        break;
+      case ARENA_KIND_CASE_STATEMENT:
+        {
+          ast_case_statement * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->expression);
+          a.ref(n->cases);
+          a.ref(n->default_item);
+        }
+        break;
+      case ARENA_KIND_CONDITIONAL_STATEMENT:
+        {
+          ast_conditional_statement * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->statement);
+          a.ref(n->condition);
+        }
+        break;
+      case ARENA_KIND_IF_ELSE:
+        {
+          ast_if_else * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->conditional_statements);
+          a.ref(n->else_condition);
+        }
+        break;
+      case ARENA_KIND_WAIT_STATEMENT:
+        {
+          ast_wait_statement * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->expression);
+          a.ref(n->statement);
+        }
+        break;
+      case ARENA_KIND_EVENT_EXPRESSION:
+        {
+          ast_event_expression * n;
+          a.place(node, n);
+          a.ref(n->expression);
+        }
+        break;
+      case ARENA_KIND_EVENT_CONTROL:
+        {
+          ast_event_control * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->expression);
+        }
+        break;
+      case ARENA_KIND_DELAY_CTRL:
+        {
+          ast_delay_ctrl * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->value);
+        }
+        break;
+      case ARENA_KIND_TIMING_CONTROL_STATEMENT:
+        {
+          ast_timing_control_statement * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->delay);
+          a.ref(n->repeat);
+          a.ref(n->statement);
+        }
+        break;
+      case ARENA_KIND_DISABLE_STATEMENT:
+        {
+          ast_disable_statement * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->id);
+        }
+        break;
+      case ARENA_KIND_STATEMENT_BLOCK:
+        {
+          ast_statement_block * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->block_identifier);
+          a.ref(n->declarations);
+          a.ref(n->statements);
+          a.ref(n->trigger);
+        }
+        break;
+      case ARENA_KIND_SINGLE_ASSIGNMENT:
+        {
+          ast_single_assignment * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->lval);
+          a.ref(n->expression);
+          a.ref(n->drive_strength);
+          a.ref(n->delay);
+        }
+        break;
+      case ARENA_KIND_CONTINUOUS_ASSIGNMENT:
+        {
+          ast_continuous_assignment * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->assignments);
+        }
+        break;
+      case ARENA_KIND_PROCEDURAL_ASSIGNMENT:
+        {
+          ast_procedural_assignment * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->lval);
+          a.ref(n->expression);
+          a.ref(n->delay_or_event);
+        }
+        break;
+      case ARENA_KIND_HYBRID_ASSIGNMENT:
+        {
+          ast_hybrid_assignment * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->assignment);
+        }
+        break;
+      case ARENA_KIND_ASSIGNMENT:
+        {
+          ast_assignment * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->continuous);
+        }
+        break;
+      case ARENA_KIND_STATEMENT:
+        {
+          ast_statement * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->attributes);
+          a.ref(n->data);
+        }
+        break;
+      case ARENA_KIND_PULSE_CONTROL_SPECPARAM:
+        {
+          ast_pulse_control_specparam * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->reject_limit);
+          a.ref(n->error_limit);
+          a.ref(n->input_terminal);
+          a.ref(n->output_terminal);
+        }
+        break;
+      case ARENA_KIND_UDP_PORT:
+        {
+          ast_udp_port * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->identifier);
+          a.ref(n->attributes);
+          a.ref(n->default_value);
+        }
+        break;
+      case ARENA_KIND_UDP_INITIAL_STATEMENT:
+        {
+          ast_udp_initial_statement * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->output_port);
+          a.ref(n->initial_value);
+        }
+        break;
+      case ARENA_KIND_UDP_BODY:
+        {
+          ast_udp_body * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->entries);
+          a.ref(n->initial);
+        }
+        break;
+      case ARENA_KIND_UDP_COMBINATORIAL_ENTRY:
+        {
+          ast_udp_combinatorial_entry * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->input_levels);
+        }
+        break;
+      case ARENA_KIND_UDP_SEQUENTIAL_ENTRY:
+        {
+          ast_udp_sequential_entry * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->edges);
+        }
+        break;
+      case ARENA_KIND_UDP_DECLARATION:
+        {
+          ast_udp_declaration * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->identifier);
+          a.ref(n->attributes);
+          a.ref(n->ports);
+          a.ref(n->body_entries);
+          a.ref(n->initial);
+        }
+        break;
+      case ARENA_KIND_UDP_INSTANCE:
+        {
+          ast_udp_instance * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->identifier);
+          a.ref(n->range);
+          a.ref(n->output);
+          a.ref(n->inputs);
+        }
+        break;
+      case ARENA_KIND_UDP_INSTANTIATION:
+        {
+          ast_udp_instantiation * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->instances);
+          a.ref(n->identifier);
+          a.ref(n->drive_strength);
+          a.ref(n->delay);
+        }
+        break;
+      case ARENA_KIND_RANGE:
+        {
+          ast_range * n;
+          a.place(node, n);
+          a.ref(n->upper);
+          a.ref(n->lower);
+        }
+        break;
+      case ARENA_KIND_GENERATE_BLOCK:
+        {
+          ast_generate_block * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->identifier);
+          a.ref(n->generate_items);
+        }
+        break;
+      case ARENA_KIND_MODULE_INSTANTIATION:
+        {
+          ast_module_instantiation * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->module_identifer);
+          a.ref(n->module_parameters);
+          a.ref(n->module_instances);
+        }
+        break;
+      case ARENA_KIND_MODULE_INSTANCE:
+        {
+          ast_module_instance * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->instance_identifier);
+          a.ref(n->port_connections);
+        }
+        break;
+      case ARENA_KIND_PORT_CONNECTION:
+        {
+          ast_port_connection * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->port_name);
+          a.ref(n->expression);
+        }
+        break;
+      case ARENA_KIND_SWITCH_GATE:
+        {
+          ast_switch_gate * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->delay3);
+        }
+        break;
+      case ARENA_KIND_PULL_STRENGTH:
+        {
+          ast_pull_strength * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+        }
+        break;
+      case ARENA_KIND_PRIMITIVE_PULL_STRENGTH:
+        {
+          ast_primitive_pull_strength * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+        }
+        break;
+      case ARENA_KIND_PULL_GATE_INSTANCE:
+        {
+          ast_pull_gate_instance * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->name);
+          a.ref(n->output_terminal);
+        }
+        break;
+      case ARENA_KIND_PASS_SWITCH_INSTANCE:
+        {
+          ast_pass_switch_instance * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->name);
+          a.ref(n->terminal_1);
+          a.ref(n->terminal_2);
+        }
+        break;
+      case ARENA_KIND_N_INPUT_GATE_INSTANCES:
+        {
+          ast_n_input_gate_instances * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->delay);
+          a.ref(n->drive_strength);
+          a.ref(n->instances);
+        }
+        break;
+      case ARENA_KIND_N_INPUT_GATE_INSTANCE:
+        {
+          ast_n_input_gate_instance * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->name);
+          a.ref(n->input_terminals);
+          a.ref(n->output_terminal);
+        }
+        break;
+      case ARENA_KIND_ENABLE_GATE_INSTANCES:
+        {
+          ast_enable_gate_instances * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->delay);
+          a.ref(n->drive_strength);
+          a.ref(n->instances);
+        }
+        break;
+      case ARENA_KIND_ENABLE_GATE_INSTANCE:
+        {
+          ast_enable_gate_instance * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->name);
+          a.ref(n->output_terminal);
+          a.ref(n->enable_terminal);
+          a.ref(n->input_terminal);
+        }
+        break;
+      case ARENA_KIND_MOS_SWITCH_INSTANCE:
+        {
+          ast_mos_switch_instance * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->name);
+          a.ref(n->output_terminal);
+          a.ref(n->enable_terminal);
+          a.ref(n->input_terminal);
+        }
+        break;
+      case ARENA_KIND_CMOS_SWITCH_INSTANCE:
+        {
+          ast_cmos_switch_instance * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->name);
+          a.ref(n->output_terminal);
+          a.ref(n->ncontrol_terminal);
+          a.ref(n->pcontrol_terminal);
+          a.ref(n->input_terminal);
+        }
+        break;
+      case ARENA_KIND_PASS_ENABLE_SWITCH:
+        {
+          ast_pass_enable_switch * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->name);
+          a.ref(n->terminal_1);
+          a.ref(n->terminal_2);
+          a.ref(n->enable);
+        }
+        break;
+      case ARENA_KIND_PASS_ENABLE_SWITCHES:
+        {
+          ast_pass_enable_switches * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->delay);
+          a.ref(n->switches);
+        }
+        break;
+      case ARENA_KIND_N_OUTPUT_GATE_INSTANCE:
+        {
+          ast_n_output_gate_instance * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->name);
+          a.ref(n->outputs);
+          a.ref(n->input);
+        }
+        break;
+      case ARENA_KIND_N_OUTPUT_GATE_INSTANCES:
+        {
+          ast_n_output_gate_instances * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->delay);
+          a.ref(n->drive_strength);
+          a.ref(n->instances);
+        }
+        break;
+      case ARENA_KIND_SWITCHES:
+        {
+          ast_switches * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->type);
+          a.ref(n->switches);
+        }
+        break;
+      case ARENA_KIND_GATE_INSTANTIATION:
+        {
+          ast_gate_instantiation * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->switches);
+          a.ref(n->pull_gates);
+        }
+        break;
+      case ARENA_KIND_DELAY_VALUE:
+        {
+          ast_delay_value * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->data);
+        }
+        break;
+      case ARENA_KIND_DELAY3:
+        {
+          ast_delay3 * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->min);
+          a.ref(n->max);
+          a.ref(n->avg);
+        }
+        break;
+      case ARENA_KIND_DELAY2:
+        {
+          ast_delay2 * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->min);
+          a.ref(n->max);
+        }
+        break;
+      case ARENA_KIND_PORT_DECLARATION:
+        {
+          ast_port_declaration * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->range);
+          a.ref(n->port_names);
+        }
+        break;
+      case ARENA_KIND_TYPE_DECLARATION:
+        {
+          ast_type_declaration * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->identifiers);
+          a.ref(n->delay);
+          a.ref(n->drive_strength);
+          a.ref(n->range);
+        }
+        break;
+      case ARENA_KIND_NET_DECLARATION:
+        {
+          ast_net_declaration * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->identifier);
+          a.ref(n->delay);
+          a.ref(n->drive);
+          a.ref(n->range);
+          a.ref(n->value);
+        }
+        break;
+      case ARENA_KIND_REG_DECLARATION:
+        {
+          ast_reg_declaration * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->identifier);
+          a.ref(n->range);
+          a.ref(n->value);
+        }
+        break;
+      case ARENA_KIND_VAR_DECLARATION:
+        {
+          ast_var_declaration * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->identifier);
+        }
+        break;
+      case ARENA_KIND_PARAMETER_DECLARATIONS:
+        {
+          ast_parameter_declarations * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->assignments);
+          a.ref(n->range);
+        }
+        break;
+      case ARENA_KIND_BLOCK_REG_DECLARATION:
+        {
+          ast_block_reg_declaration * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->range);
+          a.ref(n->identifiers);
+        }
+        break;
+      case ARENA_KIND_BLOCK_ITEM_DECLARATION:
+        {
+          ast_block_item_declaration * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->attributes);
+          a.ref(n->reg);
+        }
+        break;
+      case ARENA_KIND_RANGE_OR_TYPE:
+        {
+          ast_range_or_type * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          if(n->is_range)
+            a.ref(n->range);
+        }
+        break;
+      case ARENA_KIND_FUNCTION_DECLARATION:
+        {
+          ast_function_declaration * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->rot);
+          a.ref(n->identifier);
+          a.ref(n->item_declarations);
+          a.ref(n->statements);
+        }
+        break;
+      case ARENA_KIND_TASK_PORT:
+        {
+          ast_task_port * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->range);
+          a.ref(n->identifiers);
+        }
+        break;
+      case ARENA_KIND_FUNCTION_ITEM_DECLARATION:
+        {
+          ast_function_item_declaration * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->block_item);
+        }
+        break;
+      case ARENA_KIND_TASK_DECLARATION:
+        {
+          ast_task_declaration * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->identifier);
+          a.ref(n->ports);
+          a.ref(n->declarations);
+          a.ref(n->statements);
+        }
+        break;
+      case ARENA_KIND_MODULE_ITEM:
+        {
+          ast_module_item * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->attributes);
+          a.ref(n->port_declaration);
+        }
+        break;
+      case ARENA_KIND_MODULE_DECLARATION:
+        {
+          ast_module_declaration * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->attributes);
+          a.ref(n->identifier);
+          a.ref(n->always_blocks);
+          a.ref(n->continuous_assignments);
+          a.ref(n->event_declarations);
+          a.ref(n->function_declarations);
+          a.ref(n->gate_instantiations);
+          a.ref(n->genvar_declarations);
+          a.ref(n->generate_blocks);
+          a.ref(n->initial_blocks);
+          a.ref(n->integer_declarations);
+          a.ref(n->local_parameters);
+          a.ref(n->module_instantiations);
+          a.ref(n->module_parameters);
+          a.ref(n->module_ports);
+          a.ref(n->net_declarations);
+          a.ref(n->parameter_overrides);
+          a.ref(n->real_declarations);
+          a.ref(n->realtime_declarations);
+          a.ref(n->reg_declarations);
+          a.ref(n->specify_blocks);
+          a.ref(n->specparams);
+          a.ref(n->task_declarations);
+          a.ref(n->time_declarations);
+          a.ref(n->udp_instantiations);
+        }
+        break;
+      case ARENA_KIND_CONFIG_RULE_STATEMENT:
+        {
+          ast_config_rule_statement * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->clause_1);
+          a.ref(n->clause_2);
+        }
+        break;
+      case ARENA_KIND_CONFIG_DECLARATION:
+        {
+          ast_config_declaration * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->identifier);
+          a.ref(n->design_statement);
+          a.ref(n->rule_statements);
+        }
+        break;
+      case ARENA_KIND_LIBRARY_DECLARATION:
+        {
+          ast_library_declaration * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->identifier);
+          a.ref(n->file_paths);
+          a.ref(n->incdirs);
+        }
+        break;
+      case ARENA_KIND_LIBRARY_DESCRIPTIONS:
+        {
+          ast_library_descriptions * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->library);
+        }
+        break;
+      case ARENA_KIND_SOURCE_ITEM:
+        {
+          ast_source_item * n;
+          a.place(node, n);
+          a.meta(n->meta_info);
+          a.ref(n->module);
+        }
+        break;
+      default:
+        a.fail("node kind");
+        break;
+      }
+  }
+
+  //! The used part of one arena chunk.
+  typedef struct verilog_cache_chunk_t{
+    const char            * begin;  //!< First usable byte.
+    const char            * end;    //!< One past the last byte handed out.
+    const unsigned char   * kinds;  //!< The kind map of the chunk, or NULL.
+    std::vector<uint32_t>   placed; //!< Offset / 8 + 1 of each block written.
+  } verilog_cache_chunk;
+
+  /*!
+@brief Writes a tree as an image, see verilog_cache_fields.
+@details Each block is copied to the end of the image the first time it is
+reached, and its kind noted, then every pointer in it is rewritten as the
+distance to where its target lies in the image. A block reached again is
+only pointed at, and noted as shared.
+*/
+  struct verilog_cache_writer{
+    std::vector<verilog_cache_chunk> chunks;  //!< By address.
+    std::string                      image;   //!< The blocks so far.
+    std::string                      kinds;   //!< Kind of each block placed.
+    std::vector<uint64_t>            shared;  //!< Blocks reached again.
+    std::vector<uint64_t>            texts;   //!< Where each symbol's text is.
+    std::unordered_map<const char *, uint64_t> files; //!< Where each file name is.
+    const char                     * src;     //!< The node being written.
+    uint64_t                         at;      //!< Where it is in the image.
+    const char                     * problem; //!< Why it can't be written.
+
+    void fail(const char * what)
+    {
+      if(problem == NULL)
+        problem = what;
+    }
+
+    //! Sets the pointer at pos in the image to aim at target, or NULL.
+    void set(uint64_t pos, uint64_t target, bool null)
+    {
+      intptr_t offset = null ? 0 : (intptr_t)(target - pos);
+      memcpy(&image[pos], &offset, sizeof(offset));
+    }
+
+    //! Returns where a field of the node being written is in the image.
+    uint64_t field(const void * f) const
+    {
+      return at + (uint64_t)((const char *)f - src);
+    }
+
+    //! Appends bytes as a block, padded to the alignment of the image.
+    uint64_t append(const void * bytes, size_t length)
+    {
+      uint64_t tr = image.size();
+      image.append((const char *)bytes, length);
+      image.resize(VERILOG_CACHE_ALIGN(image.size()), '\0');
+      return tr;
+    }
+
+    template <class T>
+    void place(void * node, T *& n)
+    {
+      n   = (T *)node;
+      src = (const char *)node;
+      at  = append(node, sizeof(T));
+    }
+
+    //! Points at the file name, placing it the first time it is seen.
+    void meta(ast_metadata & m)
+    {
+      const char * file = m.file.get();
+      if(file == NULL)
+        {
+          set(field(&m.file), 0, true);
+          return;
+        }
+
+      std::unordered_map<const char *, uint64_t>::iterator known = files.find(file);
+      uint64_t pos;
+      if(known != files.end())
+        {
+          pos = known->second;
+        }
+      else
+        {
+          kinds += (char)ARENA_KIND_TEXT;
+          pos = append(file, strlen(file) + 1);
+          files[file] = pos;
+        }
+      set(field(&m.file), pos, false);
+    }
+
+    //! Points an identifier at the text of its symbol, at the image's start.
+    void symbol(ast_identifier id)
+    {
+      if(id->symbol == AST_SYMBOL_NONE || id->symbol > texts.size())
+        {
+          fail("symbol");
+          set(field(&id->identifier), 0, true);
+          return;
+        }
+      set(field(&id->identifier), texts[id->symbol - 1], false);
+    }
+
+    template <class T>
+    void ref(ast_ref<T> & f)
+    {
+      uint64_t pos = field(&f);
+      uint64_t target = 0;
+      bool null = f.get() == NULL || !write((const void *)f.get(), &target);
+      set(pos, target, null);
+    }
+
+    //! Returns the chunk holding an address, or NULL.
+    verilog_cache_chunk * find(const char * address)
+    {
+      size_t lo = 0;
+      size_t hi = chunks.size();
+
+      // The last chunk beginning at or before the address.
+      while(lo < hi)
+        {
+          size_t mid = (lo + hi) / 2;
+          if(chunks[mid].begin <= address)
+            lo = mid + 1;
+          else
+            hi = mid;
+        }
+
+      if(lo == 0 || address >= chunks[lo - 1].end)
+        return NULL;
+      return &chunks[lo - 1];
+    }
+
+    //! Notes that a block was placed at pos, so it is only placed once.
+    bool mark(const void * p, uint64_t pos)
+    {
+      const char * address = (const char *)p;
+      verilog_cache_chunk * c = find(address);
+      if(c == NULL || (size_t)(address - c->begin) % AST_ARENA_ALIGNMENT != 0)
+        return false;
+
+      if(c->placed.empty())
+        c->placed.resize((size_t)(c->end - c->begin) / AST_ARENA_ALIGNMENT);
+      c->placed[(size_t)(address - c->begin) / AST_ARENA_ALIGNMENT] = (uint32_t)(pos / 8 + 1);
+      return true;
+    }
+
+    /*!
+@brief Places a block, if not placed already, and gives where it is.
+@details A list is placed as its header followed by its items, and each
+item as a pointer, a small number some rules keep there, or NULL.
+@returns false if it is not a node, list or text in the arena.
+*/
+    bool write(const void * p, uint64_t * pos)
+    {
+      const char * address = (const char *)p;
+      verilog_cache_chunk * c = find(address);
+      if(c == NULL || (size_t)(address - c->begin) % AST_ARENA_ALIGNMENT != 0)
+        {
+          fail("pointer");
+          return false;
+        }
+
+      size_t g = (size_t)(address - c->begin) / AST_ARENA_ALIGNMENT;
+      if(!c->placed.empty() && c->placed[g] != 0)
+        {
+          *pos = (uint64_t)(c->placed[g] - 1) * 8;
+          shared.push_back(*pos);
+          return true;
+        }
+
+      ast_arena_kind kind = c->kinds != NULL ? (ast_arena_kind)c->kinds[g] : ARENA_KIND_NONE;
+      if(kind < ARENA_KIND_TEXT || kind >= ARENA_KIND_COUNT)
+        {
+          fail("pointer");
+          return false;
+        }
+
+      *pos = image.size();
+      mark(p, *pos);
+      kinds += (char)kind;
+
+      if(kind == ARENA_KIND_TEXT)
+        {
+          append(address, strlen(address) + 1);
+        }
+      else if(kind == ARENA_KIND_LIST)
+        {
+          const ast_list * list = (const ast_list *)p;
+          ast_list header = ast_list();
+          header.data.offset = list->items > 0 ? (intptr_t)sizeof(ast_list) : 0;
+          header.items       = list->items;
+          header.capacity    = list->items;
+          append(&header, sizeof(header));
+
+          uint64_t items = image.size();
+          image.resize(items + list->items * sizeof(ast_list_item), '\0');
+          for(unsigned int i = 0; i < list->items; i ++)
+            {
+              const void * item   = ast_list_at(list, i);
+              uint64_t     slot   = items + i * sizeof(ast_list_item);
+              uint64_t     target = 0;
+              if(item != NULL && (uintptr_t)item < AST_LIST_SCALARS)
+                {
+                  intptr_t scalar = (intptr_t)((uint64_t)INT64_MIN + (uintptr_t)item);
+                  memcpy(&image[slot], &scalar, sizeof(scalar));
+                }
+              else
+                {
+                  set(slot, target, item == NULL || !write(item, &target));
+                }
+            }
+        }
+      else
+        {
+          const char * outer_src = src;
+          uint64_t     outer_at  = at;
+          verilog_cache_fields(*this, kind, (void *)p);
+          src = outer_src;
+          at  = outer_at;
+        }
+      return true;
+    }
+  };
+
+  /*!
+@brief Checks an image before anything in it is used, see verilog_cache_fields.
+@details Blocks are visited in the order the writer placed them, so each
+pointer must aim either at the next block, which is then checked in turn,
+or back at a block listed as shared or as a file name. Every node is
+checked to lie within the image, every text to end within it, and every
+list to hold exactly its items. Nothing is written to the image.
+*/
+  struct verilog_cache_checker{
+    const char                 * base;        //!< Start of the image.
+    uint64_t                     size;        //!< Length of the image.
+    uint64_t                     at;          //!< Where the next block must be.
+    const unsigned char        * kinds;       //!< Kind of each block.
+    uint64_t                     blocks;      //!< Number of kinds.
+    uint64_t                     next_kind;   //!< Kinds used so far.
+    const uint64_t             * shared;      //!< Blocks reached again, sorted.
+    uint64_t                     shares;      //!< Number of them.
+    uint64_t                     next_share;  //!< Those placed so far.
+    const ast_symbol_entry     * entries;     //!< The symbols.
+    uint64_t                     symbols;     //!< Number of them.
+    uint64_t                     texts;       //!< Where their texts begin.
+    uint64_t                     texts_end;   //!< Where their texts end.
+    bool                         collect;     //!< Whether to list identifiers.
+    std::vector<uint64_t>        files;       //!< Where each file name is.
+    uint64_t                     last_file;   //!< File of the last node, or 0.
+    std::vector<uint64_t>        spare;       //!< Stands in for a node past the end.
+    std::vector<ast_identifier>  identifiers; //!< Every identifier checked.
+    const char                 * problem;     //!< What was wrong, or NULL.
+
+    void fail(const char * what)
+    {
+      if(problem == NULL)
+        problem = what;
+    }
+
+    //! Returns where a pointer in the image aims, as an offset in the image.
+    uint64_t target(const void * f, intptr_t offset) const
+    {
+      return (uint64_t)((const char *)f - base) + (uint64_t)offset;
+    }
+
+    //! Begins the block at the cursor, giving the kind the writer noted.
+    ast_arena_kind begin()
+    {
+      if(next_share < shares && shared[next_share] <= at)
+        {
+          if(shared[next_share] < at)
+            fail("shared");
+          next_share ++;
+        }
+
+      if(next_kind == blocks)
+        {
+          fail("kinds");
+          return ARENA_KIND_NONE;
+        }
+      return (ast_arena_kind)kinds[next_kind ++];
+    }
+
+    //! Checks that the text at the cursor ends within the image, and passes it.
+    void text()
+    {
+      const char * end = (const char *)memchr(base + at, '\0', (size_t)(size - at));
+      if(end == NULL)
+        {
+          fail("text");
+          return;
+        }
+      at = VERILOG_CACHE_ALIGN((uint64_t)(end - base) + 1);
+    }
+
+    template <class T>
+    void place(void *, T *& n)
+    {
+      uint64_t length = VERILOG_CACHE_ALIGN(sizeof(T));
+      if(length > size - at)
+        {
+          fail("size");
+          spare.assign(length / 8, 0);
+          n = (T *)spare.data();
+          return;
+        }
+      n = (T *)(base + at);
+      at += length;
+    }
+
+    void meta(ast_metadata & m)
+    {
+      // No file is ever at 0, so last_file is 0 until one is seen.
+      uint64_t t = target(&m.file, m.file.offset);
+      if(m.file.offset == 0 || (t == last_file && t != 0) || problem != NULL)
+        return;
+
+      if(t == at)
+        {
+          if(begin() != ARENA_KIND_TEXT)
+            fail("file");
+          text();
+          files.push_back(t);
+        }
+      else if(!std::binary_search(files.begin(), files.end(), t))
+        {
+          fail("file");
+        }
+      last_file = t;
+    }
+
+    //! The text need only lie among the symbols' texts, which all end there.
+    void symbol(ast_identifier id)
+    {
+      uint64_t t = target(&id->identifier, id->identifier.offset);
+      if(id->symbol == AST_SYMBOL_NONE || id->symbol > symbols ||
+         id->identifier.offset == 0 || t < texts || t >= texts_end)
+        fail("symbol");
+      else if(collect)
+        identifiers.push_back(id);
+    }
+
+    template <class T>
+    void ref(ast_ref<T> & f)
+    {
+      if(f.offset != 0)
+        visit(target(&f, f.offset));
+    }
+
+    //! Checks a pointer to t, and what it points to if not checked already.
+    void visit(uint64_t t)
+    {
+      if(problem != NULL)
+        return;
+
+      if(t < at)
+        {
+          if(!std::binary_search(shared, shared + next_share, t))
+            fail("pointer");
+          return;
+        }
+      if(t != at)
+        {
+          fail("pointer");
+          return;
+        }
+
+      ast_arena_kind kind = begin();
+      if(kind == ARENA_KIND_TEXT)
+        {
+          text();
+        }
+      else if(kind == ARENA_KIND_LIST)
+        {
+          if(sizeof(ast_list) > size - at)
+            {
+              fail("list");
+              return;
+            }
+
+          const ast_list * list = (const ast_list *)(base + at);
+          uint64_t items = at + sizeof(ast_list);
+          if(list->first != 0 || list->capacity != list->items ||
+             list->data.offset != (list->items > 0 ? (intptr_t)sizeof(ast_list) : 0) ||
+             list->items > (size - items) / sizeof(ast_list_item))
+            {
+              fail("list");
+              return;
+            }
+
+          at = items + list->items * sizeof(ast_list_item);
+          const ast_list_item * item = (const ast_list_item *)(base + items);
+          for(unsigned int i = 0; i < list->items && problem == NULL; i ++)
+            {
+              uint64_t scalar = (uint64_t)item[i].offset - (uint64_t)INT64_MIN;
+              if(item[i].offset != 0 && scalar >= AST_LIST_SCALARS)
+                visit(target(&item[i], item[i].offset));
+            }
+        }
+      else if(kind > ARENA_KIND_LIST && kind < ARENA_KIND_COUNT)
+        {
+          verilog_cache_fields(*this, kind, NULL);
+        }
+      else
+        {
+          fail("kind");
+        }
+    }
+  };
+
+  //! Mixes the bits of a hash, so sums of hashes stay well spread.
+  static inline uint64_t verilog_cache_mix(uint64_t h)
+  {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  /*!
+@brief Returns a signature of the layout of the AST.
+@details Any change to the size of a node, or to the number of kinds,
+changes the signature, and so invalidates every entry written before it.
+*/
+  static uint32_t verilog_cache_layout()
+  {
+    const size_t sizes[] = {
+      VERILOG_CACHE_VERSION,
+      ARENA_KIND_COUNT,
+      sizeof(void *),
+      sizeof(ast_list),
+      sizeof(ast_list_item),
+      sizeof(ast_metadata),
+      sizeof(ast_symbol_entry),
+      #define X(kind, type) sizeof(type),
+      AST_ARENA_NODE_KINDS(X)
+      #undef X
+    };
+
+    uint64_t h = VerilogCode::verilog_cache_hash(sizes, sizeof(sizes), 0);
+    return (uint32_t)(h ^ (h >> 32));
+  }
+
+  /*!
+@brief Hashes the text of a file.
+@returns false if the file can't be read.
+*/
+  static bool verilog_cache_hash_file(
+      const char * path,    //!< The file.
+      uint64_t   * hash,    //!< Set to the hash of its text.
+      uint64_t   * length   //!< Set to its length.
+      ){
+#ifdef _WIN32
+    (void)path;
+    (void)hash;
+    (void)length;
+    return false;
+#else
+    int fd = open(path, O_RDONLY);
+    if(fd < 0)
+      return false;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+      {
+        close(fd);
+        return false;
+      }
+
+    *length = (uint64_t)st.st_size;
+    if(*length == 0)
+      {
+        close(fd);
+        *hash = VerilogCode::verilog_cache_hash(NULL, 0, 0);
+        return true;
+      }
+
+    void * text = mmap(NULL, (size_t)*length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(text == MAP_FAILED)
+      return false;
+
+    madvise(text, (size_t)*length, MADV_SEQUENTIAL);
+    *hash = VerilogCode::verilog_cache_hash(text, (size_t)*length, 0);
+    munmap(text, (size_t)*length);
+    return true;
+#endif
+  }
+
+  //! Returns the text a macro was defined with, parameters included.
+  static std::string verilog_cache_macro_text(const verilog_macro_directive * macro)
+  {
+    std::string tr;
+
+    if(macro->params != NULL)
+      {
+        tr += '(';
+        for(const ast_list_item * p = ast_list_begin(macro->params);
+            p != ast_list_end(macro->params); p ++)
+          {
+            if(p != ast_list_begin(macro->params))
+              tr += ',';
+            tr += (const char *)p->get();
+          }
+        tr += ") ";
+      }
+
+    return tr.append(macro->macro_value, macro->macro_value_length);
+  }
+
+  /*!
+@brief Hashes bytes, eight at a time.
+@details Used to notice changed files, not to resist anyone making them
+collide on purpose.
+*/
+  uint64_t VerilogCode::verilog_cache_hash(const void * data, size_t length, uint64_t seed)
+  {
+    const unsigned char * p = (const unsigned char *)data;
+    uint64_t h = seed ^ (length * 0x9e3779b97f4a7c15ULL);
+
+    while(length >= 8)
+      {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        h = (h ^ word) * 0xff51afd7ed558ccdULL;
+        h ^= h >> 32;
+        p      += 8;
+        length -= 8;
+      }
+
+    uint64_t tail = 0;
+    if(length > 0)
+      memcpy(&tail, p, length);
+
+    return verilog_cache_mix(h ^ tail);
+  }
+
+  /*!
+@details Chunks made from now on get a kind map, which the writer needs.
+A tree pointing into a chunk made before has no kinds to go by, and is
+not cached.
+*/
+  void VerilogCode::set_cache_directory(std::string directory)
+  {
+    cache_directory = directory;
+    arena_kind_maps = !directory.empty();
+  }
+
+  std::string VerilogCode::verilog_cache_path(uint64_t key)
+  {
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx", (unsigned long long)key);
+    return cache_directory + name + VERILOG_CACHE_SUFFIX;
+  }
+
+  /*!
+@brief Hashes a file's name and text with the macros defined and the
+search directories.
+@details The macros are hashed one by one and the hashes summed, so the
+order they sit in the table does not matter.
+*/
+  uint64_t VerilogCode::verilog_cache_key(std::string filename)
+  {
+    verilog_phase_timer timer(&stats.phases[PHASE_CACHE]);
+
+    uint64_t text;
+    uint64_t length;
+    if(!verilog_cache_hash_file(filename.c_str(), &text, &length))
+      return 0;
+
+    uint64_t tr = verilog_cache_hash(filename.data(), filename.size(),
+                                     text ^ verilog_cache_layout());
+
+    uint64_t macros = 0;
+    ast_hashtable * defines = yy_preproc->macrodefines;
+    for(unsigned int i = 0; i < defines->capacity; i ++)
+      {
+        ast_hashtable_element * e = &defines->elements[i];
+        if(e->key == NULL || e->data == NULL)
+          continue;
+
+        std::string value = verilog_cache_macro_text((verilog_macro_directive *)e->data);
+        uint64_t h = verilog_cache_hash(e->key, e->key_len, 0);
+        macros += verilog_cache_mix(verilog_cache_hash(value.data(), value.size(), h));
+      }
+    tr = verilog_cache_mix(tr ^ macros);
+
+    for(unsigned int d = 0; d < yy_preproc->search_dirs->items; d ++)
+      {
+        const char * dir = (const char *)ast_list_at(yy_preproc->search_dirs, d);
+        tr = verilog_cache_hash(dir, strlen(dir) + 1, tr);
+      }
+
+    // Zero means no key.
+    return tr != 0 ? tr : 1;
+  }
+
+  /*!
+@brief Notes what has been built before a file is parsed.
+*/
+  void VerilogCode::verilog_cache_begin(verilog_cache_mark * mark, uint64_t key)
+  {
+    mark->modules     = yy_verilog_source_tree->modules->items;
+    mark->primitives  = yy_verilog_source_tree->primitives->items;
+    mark->configs     = yy_verilog_source_tree->configs->items;
+    mark->libraries   = yy_verilog_source_tree->libraries->items;
+    mark->includes    = yy_preproc->includes->items;
+    mark->key         = key;
+
+    mark->macros = ast_hashtable_new();
+    ast_hashtable_insert_all(mark->macros, yy_preproc->macrodefines);
+  }
+
+
+  /*!
+@brief Writes the tree built since a mark to the cache.
+@details The image begins with every symbol of the instance, so that
+identifiers point at their text there, then the roots, then each block
+reached from them. The entry is written under a temporary name and renamed
+into place, so a reader never sees half of one.
+*/
+  bool VerilogCode::verilog_cache_save(const verilog_cache_mark * mark)
+  {
+    verilog_phase_timer timer(&stats.phases[PHASE_CACHE]);
+
+#ifdef _WIN32
+    (void)mark;
+    return false;
+#else
+    size_t header = AST_ARENA_ALIGN(sizeof(ast_arena_chunk));
+    verilog_cache_writer w;
+    w.src     = NULL;
+    w.at      = 0;
+    w.problem = NULL;
+
+    ast_arena_chunk * chains[2] = {memory_head, memory_keep};
+    for(int c = 0; c < 2; c ++)
+      {
+        for(ast_arena_chunk * chunk = chains[c]; chunk != NULL; chunk = chunk->next)
+          {
+            if(chunk->used == 0)
+              continue;
+
+            verilog_cache_chunk range;
+            range.begin = (const char *)chunk + header;
+            range.end   = range.begin + chunk->used;
+            range.kinds = chunk->kinds;
+            w.chunks.push_back(range);
+          }
+      }
+    std::sort(w.chunks.begin(), w.chunks.end(),
+              [](const verilog_cache_chunk & a, const verilog_cache_chunk & b)
+              {
+                return a.begin < b.begin;
+              });
+
+    // The symbol entries, a list of them, then their texts.
+    uint64_t symbols = yy_symbols != NULL ? yy_symbols->entries->items : 0;
+    uint64_t list    = symbols * sizeof(ast_symbol_entry);
+    uint64_t text    = list + sizeof(ast_list) + symbols * sizeof(ast_list_item);
+    for(uint64_t s = 0; s < symbols; s ++)
+      {
+        const ast_symbol_entry * entry =
+          (const ast_symbol_entry *)ast_list_at(yy_symbols->entries, (unsigned int)s);
+        w.texts.push_back(text);
+        text += VERILOG_CACHE_ALIGN(entry->length + 1);
+      }
+
+    for(uint64_t s = 0; s < symbols; s ++)
+      {
+        const ast_symbol_entry * from =
+          (const ast_symbol_entry *)ast_list_at(yy_symbols->entries, (unsigned int)s);
+        ast_symbol_entry entry = ast_symbol_entry();
+        entry.id          = from->id;
+        entry.hash        = from->hash;
+        entry.length      = from->length;
+        entry.text.offset = (intptr_t)(w.texts[s] - (w.image.size() + offsetof(ast_symbol_entry, text)));
+        w.append(&entry, sizeof(entry));
+      }
+
+    ast_list entries = ast_list();
+    entries.data.offset = symbols > 0 ? (intptr_t)sizeof(ast_list) : 0;
+    entries.items       = (unsigned int)symbols;
+    entries.capacity    = (unsigned int)symbols;
+    w.append(&entries, sizeof(entries));
+    for(uint64_t s = 0; s < symbols; s ++)
+      {
+        ast_list_item item = ast_list_item();
+        item.offset = (intptr_t)(s * sizeof(ast_symbol_entry) - w.image.size());
+        w.append(&item, sizeof(item));
+      }
+
+    for(uint64_t s = 0; s < symbols; s ++)
+      {
+        const ast_symbol_entry * entry =
+          (const ast_symbol_entry *)ast_list_at(yy_symbols->entries, (unsigned int)s);
+        // Anything else pointing at the text points into the image.
+        w.mark(entry->text.get(), w.image.size());
+        w.append(entry->text.get(), entry->length + 1);
+      }
+
+    // The roots are what the file added to the source tree.
+    ast_list * lists[4] = {
+      yy_verilog_source_tree->modules,
+      yy_verilog_source_tree->primitives,
+      yy_verilog_source_tree->configs,
+      yy_verilog_source_tree->libraries
+    };
+    unsigned int firsts[4] = {mark->modules, mark->primitives, mark->configs,
+                              mark->libraries};
+
+    uint64_t roots = 0;
+    for(int k = 0; k < 4; k ++)
+      roots += lists[k]->items - firsts[k];
+
+    uint64_t root = w.image.size();
+    w.image.resize(root + roots * sizeof(verilog_cache_root), '\0');
+    for(int k = 0; k < 4 && w.problem == NULL; k ++)
+      {
+        for(unsigned int i = firsts[k]; i < lists[k]->items && w.problem == NULL; i ++)
+          {
+            const void * item   = ast_list_at(lists[k], i);
+            uint64_t     blocks = w.kinds.size();
+            uint64_t     target = 0;
+            if(item == NULL || !w.write(item, &target) || w.kinds.size() == blocks)
+              w.fail("root");
+
+            uint64_t kind = (uint64_t)k;
+            memcpy(&w.image[root + offsetof(verilog_cache_root, kind)], &kind, sizeof(kind));
+            w.set(root + offsetof(verilog_cache_root, item), target, false);
+            root += sizeof(verilog_cache_root);
+          }
+      }
+
+    if(w.problem != NULL)
+      {
+        VERILOG_TRACE(this, TRACE_PARSER, "not caching %s, its tree holds a bad %s",
+                      streamname.c_str(), w.problem);
+        return false;
+      }
+
+    std::sort(w.shared.begin(), w.shared.end());
+    w.shared.erase(std::unique(w.shared.begin(), w.shared.end()), w.shared.end());
+
+    // Paths and macro text go after the tables, at offsets fixed up below.
+    std::string strings;
+    std::vector<verilog_cache_depend> depends;
+    std::unordered_set<std::string> seen;
+
+    for(unsigned int i = mark->includes; i < yy_preproc->includes->items; i ++)
+      {
+        const verilog_include_directive * include =
+          (const verilog_include_directive *)ast_list_at(yy_preproc->includes, i);
+        if(include->file == NULL || !seen.insert(include->file->path).second)
+          continue;
+
+        const verilog_input * input = include->file->input;
+        if(input->data == NULL)
+          return false;
+
+        verilog_cache_depend depend;
+        depend.hash        = verilog_cache_hash(input->data, input->length, 0);
+        depend.length      = input->length;
+        depend.path_offset = strings.size();
+        depend.path_length = strlen(include->file->path);
+        strings.append(include->file->path, depend.path_length);
+        depends.push_back(depend);
+      }
+
+    std::vector<verilog_cache_macro> macros;
+    ast_hashtable * tables[2] = {yy_preproc->macrodefines, mark->macros};
+    ast_hashtable * others[2] = {mark->macros, yy_preproc->macrodefines};
+
+    for(int t = 0; t < 2; t ++)
+      {
+        for(unsigned int i = 0; i < tables[t]->capacity; i ++)
+          {
+            ast_hashtable_element * e = &tables[t]->elements[i];
+            if(e->key == NULL || e->data == NULL)
+              continue;
+
+            void * other = NULL;
+            ast_hashtable_get(others[t], e->key, e->key_len, &other);
+            if(other == e->data || (t == 1 && other != NULL))
+              continue;
+
+            // Defined or redefined by the file, or else removed by it.
+            verilog_cache_macro macro;
+            macro.name_offset = strings.size();
+            macro.name_length = e->key_len;
+            strings.append(e->key, e->key_len);
+
+            macro.removed     = t == 1;
+            macro.line        = 0;
+            macro.text_offset = 0;
+            macro.text_length = 0;
+            if(t == 0)
+              {
+                const verilog_macro_directive * d = (const verilog_macro_directive *)e->data;
+                std::string text = verilog_cache_macro_text(d);
+                macro.line        = d->line;
+                macro.text_offset = strings.size();
+                macro.text_length = text.size();
+                strings += text;
+              }
+            macros.push_back(macro);
+          }
+      }
+
+    verilog_cache_header head;
+    memset(&head, 0, sizeof(head));
+    memcpy(head.magic, VERILOG_CACHE_MAGIC, sizeof(head.magic));
+    head.version        = VERILOG_CACHE_VERSION;
+    head.layout         = verilog_cache_layout();
+    head.key            = mark->key;
+    head.depends_offset = sizeof(head);
+    head.depends        = depends.size();
+    head.macros_offset  = head.depends_offset + head.depends * sizeof(verilog_cache_depend);
+    head.macros         = macros.size();
+    head.symbols        = symbols;
+    head.roots          = roots;
+
+    uint64_t strings_offset = head.macros_offset + head.macros * sizeof(verilog_cache_macro);
+    head.image_offset  = VERILOG_CACHE_ALIGN(strings_offset + strings.size());
+    head.image_size    = w.image.size();
+    head.kinds_offset  = head.image_offset + head.image_size;
+    head.blocks        = w.kinds.size();
+    head.shared_offset = VERILOG_CACHE_ALIGN(head.kinds_offset + head.blocks);
+    head.shared        = w.shared.size();
+    head.file_size     = head.shared_offset + head.shared * sizeof(uint64_t);
+
+    for(size_t d = 0; d < depends.size(); d ++)
+      depends[d].path_offset += strings_offset;
+    for(size_t m = 0; m < macros.size(); m ++)
+      {
+        macros[m].name_offset += strings_offset;
+        macros[m].text_offset += strings_offset;
+      }
+
+    // Padding up to the image and to the shared offsets.
+    strings.resize(head.image_offset - strings_offset, '\0');
+    w.kinds.resize(head.shared_offset - head.kinds_offset, '\0');
+
+    mkdir(cache_directory.c_str(), 0777);
+
+    std::string path = verilog_cache_path(mark->key);
+    char suffix[64];
+    snprintf(suffix, sizeof(suffix), ".%ld.%p.tmp", (long)getpid(), (void *)this);
+    std::string temporary = path + suffix;
+
+    FILE * out = fopen(temporary.c_str(), "wb");
+    if(out == NULL)
+      {
+        std::cout << "ERROR: Could not write the cache entry " << temporary << std::endl;
+        return false;
+      }
+
+    bool ok = fwrite(&head, sizeof(head), 1, out) == 1 &&
+      fwrite(depends.data(), sizeof(verilog_cache_depend), depends.size(), out) == depends.size() &&
+      fwrite(macros.data(), sizeof(verilog_cache_macro), macros.size(), out) == macros.size() &&
+      fwrite(strings.data(), 1, strings.size(), out) == strings.size() &&
+      fwrite(w.image.data(), 1, w.image.size(), out) == w.image.size() &&
+      fwrite(w.kinds.data(), 1, w.kinds.size(), out) == w.kinds.size() &&
+      fwrite(w.shared.data(), sizeof(uint64_t), w.shared.size(), out) == w.shared.size();
+    ok = fclose(out) == 0 && ok;
+
+    if(!ok || rename(temporary.c_str(), path.c_str()) != 0)
+      {
+        std::cout << "ERROR: Could not write the cache entry " << path << std::endl;
+        remove(temporary.c_str());
+        return false;
+      }
+
+    VERILOG_TRACE(this, TRACE_PARSER, "cached %s as %s, %lu bytes in %lu blocks",
+                  streamname.c_str(), path.c_str(), (unsigned long)head.file_size,
+                  (unsigned long)head.blocks);
+    return true;
+#endif
+  }
+
+  //! Returns true if count items of size bytes fit in the entry at offset.
+  static inline bool verilog_cache_fits(uint64_t offset, uint64_t count, uint64_t size,
+                                        uint64_t limit)
+  {
+    return offset <= limit && count <= (limit - offset) / size;
+  }
+
+  /*!
+@brief Checks the symbols at the start of an image, and the roots after them.
+@details Each entry's text must be the next text, in order, NUL terminated
+at its length, and the list must hold each entry in turn. Leaves the
+checker at the first block after the roots.
+@returns The roots, or NULL if the image is bad.
+*/
+  static const verilog_cache_root * verilog_cache_check_symbols(
+      verilog_cache_checker       & c,      //!< Set up for the image.
+      const verilog_cache_header  * head    //!< Header of the entry.
+      ){
+    uint64_t symbols = head->symbols;
+    uint64_t list    = symbols * sizeof(ast_symbol_entry);
+    uint64_t items   = list + sizeof(ast_list);
+    if(symbols > c.size / (sizeof(ast_symbol_entry) + sizeof(ast_list_item)) ||
+       items + symbols * sizeof(ast_list_item) > c.size)
+      return NULL;
+
+    const ast_list * entries = (const ast_list *)(c.base + list);
+    if(entries->first != 0 || entries->items != symbols || entries->capacity != symbols ||
+       entries->data.offset != (symbols > 0 ? (intptr_t)sizeof(ast_list) : 0))
+      return NULL;
+
+    const ast_list_item * item = (const ast_list_item *)(c.base + items);
+    c.at    = items + symbols * sizeof(ast_list_item);
+    c.texts = c.at;
+    for(uint64_t s = 0; s < symbols; s ++)
+      {
+        const ast_symbol_entry * entry = &c.entries[s];
+        if(c.target(&item[s], item[s].offset) != s * sizeof(ast_symbol_entry) ||
+           entry->id != s + 1 || c.target(&entry->text, entry->text.offset) != c.at ||
+           entry->length >= c.size - c.at || c.base[c.at + entry->length] != '\0')
+          return NULL;
+
+        // Texts are placed before any block, so a shared one is listed first.
+        if(c.next_share < c.shares && c.shared[c.next_share] < c.at)
+          return NULL;
+        if(c.next_share < c.shares && c.shared[c.next_share] == c.at)
+          c.next_share ++;
+        c.at += VERILOG_CACHE_ALIGN(entry->length + 1);
+      }
+    c.texts_end = c.at;
+
+    if(!verilog_cache_fits(c.at, head->roots, sizeof(verilog_cache_root), c.size))
+      return NULL;
+
+    const verilog_cache_root * tr = (const verilog_cache_root *)(c.base + c.at);
+    c.at += head->roots * sizeof(verilog_cache_root);
+    return tr;
+  }
+
+  /*!
+@brief Loads the entry for a key, if there is a valid one.
+@details The entry is mapped, and the header, the tables and the files it
+includes are checked. The image is then checked once, all of it, by
+verilog_cache_checker, before anything in it is used. Only then is it made
+writable, macros applied and roots added. The nodes are used where they lie
+in the mapping, which is kept until ast_free_all.
+*/
+  bool VerilogCode::verilog_cache_load(uint64_t key)
+  {
+    verilog_phase_timer timer(&stats.phases[PHASE_CACHE]);
+
+#ifdef _WIN32
+    (void)key;
+    return false;
+#else
+    std::string path = verilog_cache_path(key);
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+      return false;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(verilog_cache_header))
+      {
+        close(fd);
+        return false;
+      }
+
+    size_t length = (size_t)st.st_size;
+    // All of it is read while checking, so have it mapped up front. It is
+    // read only until then, so that nothing is copied.
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;
+#endif
+    char * base = (char *)mmap(NULL, length, PROT_READ, flags, fd, 0);
+    close(fd);
+    if(base == (char *)MAP_FAILED)
+      return false;
+
+    const verilog_cache_header * head = (const verilog_cache_header *)base;
+    const char * problem = NULL;
+
+    if(memcmp(head->magic, VERILOG_CACHE_MAGIC, sizeof(head->magic)) != 0 ||
+       head->version != VERILOG_CACHE_VERSION || head->layout != verilog_cache_layout() ||
+       head->key != key || head->file_size != length)
+      problem = "header";
+    else if(!verilog_cache_fits(head->depends_offset, head->depends, sizeof(verilog_cache_depend), length) ||
+            !verilog_cache_fits(head->macros_offset, head->macros, sizeof(verilog_cache_macro), length) ||
+            !verilog_cache_fits(head->image_offset, head->image_size, 1, length) ||
+            !verilog_cache_fits(head->kinds_offset, head->blocks, 1, length) ||
+            !verilog_cache_fits(head->shared_offset, head->shared, sizeof(uint64_t), length) ||
+            (head->depends_offset | head->macros_offset | head->image_offset |
+             head->image_size | head->shared_offset) % sizeof(uint64_t) != 0)
+      problem = "tables";
+
+    const verilog_cache_depend * depends = (const verilog_cache_depend *)(base + head->depends_offset);
+    for(uint64_t d = 0; problem == NULL && d < head->depends; d ++)
+      {
+        uint64_t hash, bytes;
+        if(!verilog_cache_fits(depends[d].path_offset, depends[d].path_length, 1, length))
+          problem = "tables";
+        else if(!verilog_cache_hash_file(std::string(base + depends[d].path_offset,
+                                                     depends[d].path_length).c_str(),
+                                         &hash, &bytes) ||
+                hash != depends[d].hash || bytes != depends[d].length)
+          problem = "included file";
+      }
+
+    const verilog_cache_macro * macros = (const verilog_cache_macro *)(base + head->macros_offset);
+    for(uint64_t m = 0; problem == NULL && m < head->macros; m ++)
+      {
+        if(!verilog_cache_fits(macros[m].name_offset, macros[m].name_length, 1, length) ||
+           !verilog_cache_fits(macros[m].text_offset, macros[m].text_length, 1, length))
+          problem = "tables";
+      }
+
+    char * image = base + head->image_offset;
+    verilog_cache_checker c;
+    c.base       = image;
+    c.size       = head->image_size;
+    c.at         = 0;
+    c.kinds      = (const unsigned char *)base + head->kinds_offset;
+    c.blocks     = head->blocks;
+    c.next_kind  = 0;
+    c.shared     = (const uint64_t *)(base + head->shared_offset);
+    c.shares     = head->shared;
+    c.next_share = 0;
+    c.entries    = (const ast_symbol_entry *)image;
+    c.symbols    = head->symbols;
+    c.last_file  = 0;
+    c.texts      = 0;
+    c.texts_end  = 0;
+    c.problem    = problem;
+
+    // Identifiers are only needed to point them at the instance's symbols,
+    // or to list them.
+    c.collect = yy_identifiers != NULL ||
+      (yy_symbols != NULL && yy_symbols->entries->items > 0);
+
+    const verilog_cache_root * roots = NULL;
+    if(c.problem == NULL)
+      {
+        for(uint64_t s = 1; s < c.shares; s ++)
+          {
+            if(c.shared[s - 1] >= c.shared[s])
+              c.fail("shared");
+          }
+
+        roots = verilog_cache_check_symbols(c, head);
+        if(roots == NULL)
+          c.fail("symbols");
+      }
+
+    // Each root must be a block of its own, of the kind it is added as.
+    static const ast_arena_kind root_kinds[] = {
+      ARENA_KIND_MODULE_DECLARATION,
+      ARENA_KIND_UDP_DECLARATION,
+      ARENA_KIND_CONFIG_DECLARATION,
+      ARENA_KIND_LIBRARY_DESCRIPTIONS
+    };
+    for(uint64_t i = 0; c.problem == NULL && i < head->roots; i ++)
+      {
+        const ast_list_item * item = &roots[i].item;
+        if(roots[i].kind > CACHE_ROOT_LIBRARY || c.next_kind >= c.blocks ||
+           c.kinds[c.next_kind] != root_kinds[roots[i].kind] ||
+           c.target(item, item->offset) != c.at)
+          c.fail("root");
+        else
+          c.visit(c.at);
+      }
+
+    if(c.problem == NULL &&
+       (c.at != c.size || c.next_kind != c.blocks || c.next_share != c.shares))
+      c.fail("size");
+
+    if(c.problem == NULL && mprotect(base, length, PROT_READ | PROT_WRITE) != 0)
+      c.fail("memory");
+
+    if(c.problem != NULL)
+      {
+        VERILOG_TRACE(this, TRACE_PARSER, "not using %s, bad %s", path.c_str(), c.problem);
+        munmap(base, length);
+        return false;
+      }
+
+    ast_list * entries = (ast_list *)(image + head->symbols * sizeof(ast_symbol_entry));
+    {
+      // Symbols outlive a streamed module, as in ast_symbol_intern.
+      ast_arena_keep keep(this);
+
+      if(yy_symbols == NULL || yy_symbols->entries->items == 0)
+        {
+          // With no symbols of its own yet, the instance takes the entry's.
+          yy_symbols = ast_symbol_table_adopt(entries);
+        }
+      else
+        {
+          // Otherwise each identifier is pointed at the instance's own.
+          std::vector<ast_symbol_entry *> interned(head->symbols);
+          for(uint64_t s = 0; s < head->symbols; s ++)
+            interned[s] = ast_symbol_intern(yy_symbols, c.entries[s].text, c.entries[s].length);
+
+          for(size_t i = 0; i < c.identifiers.size(); i ++)
+            {
+              ast_identifier id = c.identifiers[i];
+              ast_symbol_entry * entry = interned[id->symbol - 1];
+              id->symbol     = entry->id;
+              id->identifier = entry->text.get();
+            }
+        }
+    }
+
+    if(yy_identifiers != NULL)
+      {
+        for(size_t i = 0; i < c.identifiers.size(); i ++)
+          ast_list_append(yy_identifiers, c.identifiers[i]);
+      }
+
+    for(uint64_t m = 0; m < head->macros; m ++)
+      {
+        std::string name(base + macros[m].name_offset, macros[m].name_length);
+        if(macros[m].removed)
+          verilog_preprocessor_macro_undefine(name);
+        else
+          verilog_preprocessor_macro_define((unsigned int)macros[m].line, name,
+                                            base + macros[m].text_offset,
+                                            macros[m].text_length);
+      }
+
+    for(uint64_t i = 0; i < head->roots; i ++)
+      {
+        void * item = (void *)roots[i].item.get();
+        switch(roots[i].kind)
+          {
+          case CACHE_ROOT_MODULE:
+            verilog_source_tree_add_module(yy_verilog_source_tree, (ast_module_declaration *)item);
+            break;
+          case CACHE_ROOT_PRIMITIVE:
+            ast_list_append(yy_verilog_source_tree->primitives, item);
+            break;
+          case CACHE_ROOT_CONFIG:
+            ast_list_append(yy_verilog_source_tree->configs, item);
+            break;
+          case CACHE_ROOT_LIBRARY:
+            ast_list_append(yy_verilog_source_tree->libraries, item);
+            break;
+          default:
+            break;
+          }
+      }
+
+    if(cache_images == NULL)
+      cache_images = ast_list_new();
+
+    verilog_cache_image * loaded = (verilog_cache_image *)ast_calloc(1, sizeof(verilog_cache_image));
+    loaded->base   = base;
+    loaded->length = length;
+    ast_list_append(cache_images, loaded);
+
+    stats.phases[PHASE_CACHE].count ++;
+    VERILOG_TRACE(this, TRACE_PARSER, "loaded %s, %lu roots in %lu bytes", path.c_str(),
+                  (unsigned long)head->roots, (unsigned long)head->image_size);
+    return true;
+#endif
+  }
+
+  /*!
+@brief Unmaps every entry loaded.
+@post Nothing from a loaded tree may be used again.
+*/
+  void VerilogCode::verilog_cache_release()
+  {
+#ifndef _WIN32
+    if(cache_images == NULL)
+      return;
+
+    for(unsigned int i = 0; i < cache_images->items; i ++)
+      {
+        verilog_cache_image * loaded = (verilog_cache_image *)ast_list_at(cache_images, i);
+        munmap(loaded->base, loaded->length);
+      }
+#endif
+
+    cache_images = NULL;
+  }
+}
@@ -0,0 +1,150 @@
+/*!
+@file verilog_cache.hh
+@brief Contains declarations of the on-disk cache of parsed source trees.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "verilog_ast_common.hh"
+
+#ifndef VERILOG_CACHE_H
+#define VERILOG_CACHE_H
+
+namespace yy {
+  /*!
+@defgroup verilog-cache AST Cache
+@{
+@brief Parsed trees kept on disk, so unchanged files need not be parsed again.
+@details Once parse_file has read a file, the modules, primitives, configs
+and libraries it added are written to the cache directory as an image: the
+nodes, lists and texts laid out as they are in memory, each pointer kept as
+the distance from itself to its target, see ast_ref. Since nothing in an
+image depends on where it lies, a loaded entry is used where it is mapped,
+and nothing is decoded or copied.
+
+While a cache directory is set, every block the arena hands out carries an
+ast_arena_kind, and a pointer is followed by the kind of the block it points
+at rather than by the type of the field holding it, since the grammar puts
+nodes of several types in the same list. verilog_cache_fields lists the
+pointers of each kind, and is used both to write a node and to check it, so
+the two cannot disagree. A tree holding a pointer to anything other than a
+node, list or text in the arena, such as a tree loaded from another entry,
+is not cached.
+
+An image begins with the symbol table, so identifiers point at the text of
+their symbol there, then the roots, then every block reached from them in
+the order it is first reached. Alongside it are the kind of each block and
+the offsets of blocks reached more than once. Before anything in an image
+is used, it is checked once, all of it: each pointer must aim at the next
+block or at one listed as shared, and every block must lie within the
+image. Only then is the mapping made writable and its roots added. It is
+kept until ast_free_all.
+
+An entry is named by a key hashed from the text of the file, its name, the
+macros defined and the search directories when parsing began. Each
+included file is listed with a hash of its text, and checked when the entry
+is loaded. Macros the file defines or removes are recorded, and applied
+again on loading, so later files see the same definitions.
+
+An instance with no symbols of its own yet takes the entry's table as it
+lies. Otherwise the entry's symbols are interned once each, and its
+identifiers pointed at them.
+
+Entries are only valid for the build which wrote them. The header carries a
+signature of the layout of the node types, and entries with any other are
+ignored. VERILOG_CACHE_VERSION must be raised whenever a node or its fields
+in verilog_cache_fields change without changing size.
+*/
+
+  //! First eight bytes of every cache entry.
+  #define VERILOG_CACHE_MAGIC "QTVAST\r\n"
+
+  //! Raised whenever the layout of an entry, or of any AST node, changes.
+  #define VERILOG_CACHE_VERSION 4
+
+  //! Appended to the hexadecimal key to name the file holding an entry.
+  #define VERILOG_CACHE_SUFFIX ".vast"
+
+  /*!
+@brief Starts every cache entry.
+@details All offsets are in bytes from the start of the entry, and the
+image, the kinds and the shared offsets follow the tables in that order.
+*/
+  typedef struct verilog_cache_header_t{
+    char      magic[8];             //!< VERILOG_CACHE_MAGIC.
+    uint32_t  version;              //!< VERILOG_CACHE_VERSION.
+    uint32_t  layout;               //!< Signature of the AST node layout.
+    uint64_t  key;                  //!< The key the entry was saved under.
+    uint64_t  file_size;            //!< Size of the whole entry.
+    uint64_t  depends_offset;       //!< Array of verilog_cache_depend.
+    uint64_t  depends;              //!< Number of included files.
+    uint64_t  macros_offset;        //!< Array of verilog_cache_macro.
+    uint64_t  macros;               //!< Number of macros changed.
+    uint64_t  image_offset;         //!< Where the image starts.
+    uint64_t  image_size;           //!< Length of the image.
+    uint64_t  symbols;              //!< Symbols at the start of the image.
+    uint64_t  roots;                //!< verilog_cache_root after the symbols.
+    uint64_t  kinds_offset;         //!< One ast_arena_kind byte per block.
+    uint64_t  blocks;               //!< Blocks after the roots.
+    uint64_t  shared_offset;        //!< Sorted image offsets of shared blocks.
+    uint64_t  shared;               //!< Number of them.
+  } verilog_cache_header;
+
+  //! What a root of the tree is added to the source tree as.
+  typedef enum verilog_cache_root_kind_e{
+    CACHE_ROOT_MODULE,      //!< An ast_module_declaration.
+    CACHE_ROOT_PRIMITIVE,   //!< An ast_udp_declaration.
+    CACHE_ROOT_CONFIG,      //!< An ast_config_declaration.
+    CACHE_ROOT_LIBRARY      //!< An ast_library_descriptions.
+  } verilog_cache_root_kind;
+
+  //! One root of the tree, in the image.
+  typedef struct verilog_cache_root_t{
+    uint64_t       kind;  //!< A verilog_cache_root_kind.
+    ast_list_item  item;  //!< The root.
+  } verilog_cache_root;
+
+  //! A file which was included, and must be unchanged for the entry to be used.
+  typedef struct verilog_cache_depend_t{
+    uint64_t  hash;         //!< Hash of the text, see verilog_cache_hash.
+    uint64_t  length;       //!< Length of the text in bytes.
+    uint64_t  path_offset;  //!< Where the path is in the entry.
+    uint64_t  path_length;  //!< Length of the path in bytes.
+  } verilog_cache_depend;
+
+  //! A macro the file defined or removed.
+  typedef struct verilog_cache_macro_t{
+    uint64_t  removed;      //!< 1 if the file removed the macro.
+    uint64_t  line;         //!< Line of the `define.
+    uint64_t  name_offset;  //!< Where the name is in the entry.
+    uint64_t  name_length;  //!< Length of the name in bytes.
+    uint64_t  text_offset;  //!< Where the text given to `define is.
+    uint64_t  text_length;  //!< Length of the text in bytes.
+  } verilog_cache_macro;
+
+  //! The mapping of an entry loaded, kept until ast_free_all.
+  typedef struct verilog_cache_image_t{
+    void    * base;    //!< Start of the mapping.
+    size_t    length;  //!< Length of the mapping.
+  } verilog_cache_image;
+
+  /*!
+@brief What parse_file had built before it began on a file.
+@details Anything added after this is what the file built, and is what
+goes into its cache entry.
+*/
+  typedef struct verilog_cache_mark_t{
+    unsigned int  modules;      //!< Items in the tree's modules.
+    unsigned int  primitives;   //!< Items in the tree's primitives.
+    unsigned int  configs;      //!< Items in the tree's configs.
+    unsigned int  libraries;    //!< Items in the tree's libraries.
+    unsigned int  includes;     //!< Include directives seen.
+    uint64_t      key;          //!< The key the entry will be saved under.
+    ast_hashtable * macros;     //!< Copy of the macro definitions.
+  } verilog_cache_mark;
+
+  /*! @} */
+}
+
+#endif
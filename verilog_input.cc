@@ -0,0 +1,199 @@
+/*!
+@file verilog_input.cc
+@brief Contains implementations of the input buffer functions declared in
+       verilogcode.h
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "verilogcode.h"
+
+namespace yy {
+
+  /*!
+@brief Maps a regular file into memory, ready to be scanned in place.
+@details An anonymous, zero filled region one padding larger than the file
+is reserved first, and the file is then mapped over the start of it. The
+bytes after the text are therefore always NUL, even when the file ends
+exactly on a page boundary. The mapping is private and writable because
+flex temporarily NUL terminates each token in the buffer; the file itself
+is never modified.
+@returns The mapped input, or NULL if the file is not a regular file or
+could not be mapped.
+*/
+  verilog_input * VerilogCode::verilog_input_map(std::string filename)
+  {
+    verilog_phase_timer timer(&stats.phases[PHASE_INPUT]);
+
+#ifdef _WIN32
+    (void)filename;
+    return NULL;
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+      {
+        return NULL;
+      }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+      {
+        close(fd);
+        return NULL;
+      }
+
+    size_t length  = (size_t)st.st_size;
+    size_t page    = (size_t)sysconf(_SC_PAGESIZE);
+    size_t reserve = (length + VERILOG_INPUT_PADDING + page - 1) & ~(page - 1);
+
+    void * base = mmap(NULL, reserve, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(base == MAP_FAILED)
+      {
+        close(fd);
+        return NULL;
+      }
+
+    if(length > 0 &&
+       mmap(base, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+            fd, 0) == MAP_FAILED)
+      {
+        munmap(base, reserve);
+        close(fd);
+        return NULL;
+      }
+
+    // The mapping keeps its own reference to the file.
+    close(fd);
+    madvise(base, length, MADV_SEQUENTIAL);
+
+    verilog_input * tr = (verilog_input *)ast_calloc(1, sizeof(verilog_input));
+    tr->data   = (char *)base;
+    tr->length = length;
+    tr->mapped = reserve;
+    stats.phases[PHASE_INPUT].count ++;
+    stats.input_bytes += length;
+
+    return tr;
+#endif
+  }
+
+  /*!
+@brief Reads the whole of a stream into a heap buffer.
+@details This is the fallback for inputs which cannot be mapped.
+*/
+  verilog_input * VerilogCode::verilog_input_read(std::istream & in)
+  {
+    verilog_phase_timer timer(&stats.phases[PHASE_INPUT]);
+
+    size_t capacity = 64 * 1024;
+    size_t length   = 0;
+    char * data     = (char *)malloc(capacity);
+    assert(data != NULL);
+
+    while(in.good())
+      {
+        if(capacity - length < VERILOG_INPUT_PADDING + 1)
+          {
+            capacity *= 2;
+            data = (char *)realloc(data, capacity);
+            assert(data != NULL);
+          }
+
+        in.read(data + length, capacity - length - VERILOG_INPUT_PADDING);
+        length += (size_t)in.gcount();
+      }
+
+    memset(data + length, 0, VERILOG_INPUT_PADDING);
+
+    verilog_input * tr = (verilog_input *)ast_calloc(1, sizeof(verilog_input));
+    tr->data   = data;
+    tr->length = length;
+    tr->mapped = 0;
+    stats.phases[PHASE_INPUT].count ++;
+    stats.input_bytes += length;
+
+    return tr;
+  }
+
+  /*!
+@brief Opens a file as an input buffer, mapping it if possible.
+@returns The input, or NULL if the file could not be opened at all.
+*/
+  verilog_input * VerilogCode::verilog_input_open(std::string filename)
+  {
+    verilog_input * tr = verilog_input_map(filename);
+
+    if(tr == NULL)
+      {
+        std::ifstream in(filename, std::ios::in | std::ios::binary);
+        if(!in.is_open())
+          {
+            return NULL;
+          }
+        tr = verilog_input_read(in);
+      }
+
+    VERILOG_TRACE(this, TRACE_PREPROCESSOR, "%s %s, %lu bytes",
+                  tr->mapped ? "mapped" : "read", filename.c_str(),
+                  (unsigned long)tr->length);
+
+    return tr;
+  }
+
+  /*!
+@brief Unmaps or frees the text of an input buffer.
+@details Passing NULL is allowed and does nothing, so callers can release
+whatever they popped off @ref input_stack without checking.
+@post Any token text pointing into the input is no longer valid.
+*/
+  void VerilogCode::verilog_input_release(verilog_input * input)
+  {
+    if(input == NULL || input->data == NULL)
+      {
+        return;
+      }
+
+#ifndef _WIN32
+    if(input->mapped > 0)
+      {
+        munmap(input->data, input->mapped);
+      }
+    else
+#endif
+      {
+        free(input->data);
+      }
+
+    input->data   = NULL;
+    input->length = 0;
+    input->mapped = 0;
+  }
+
+  /*!
+@brief Finishes with an input the scanner has reached the end of.
+@details Inputs from the include cache are kept for the next include of the
+same file. Anything else is released.
+*/
+  void VerilogCode::verilog_input_close(verilog_input * input)
+  {
+    if(input != NULL && input->cached)
+      {
+        input->scanning = false;
+        return;
+      }
+
+    verilog_input_release(input);
+  }
+}
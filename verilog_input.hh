@@ -0,0 +1,39 @@
+/*!
+@file verilog_input.hh
+@brief Contains declarations of the in-memory source buffers which the
+       scanner reads from.
+*/
+
+#include <stddef.h>
+
+#ifndef VERILOG_INPUT_H
+#define VERILOG_INPUT_H
+
+namespace yy {
+  /*!
+@defgroup verilog-input Input Buffers
+@{
+@brief Whole source files held in memory, so the scanner can work on them
+in place.
+@details Regular files are mapped with mmap. Anything else, such as a pipe,
+is read into a heap buffer. Either way the text is followed by two NUL
+bytes, which is what flex expects to find at the end of a buffer it must
+never refill. Token text then points straight into the buffer.
+*/
+
+  //! Number of NUL bytes which follow the text of every input buffer.
+  #define VERILOG_INPUT_PADDING 2
+
+  //! A complete source file in memory.
+  typedef struct verilog_input_t{
+    char        * data;      //!< The file text, followed by the padding.
+    size_t        length;    //!< Length of the text in bytes.
+    size_t        mapped;    //!< Bytes mapped at data, or 0 if on the heap.
+    bool          cached;    //!< Owned by the include cache, kept at its end.
+    bool          scanning;  //!< A cached input the scanner is reading now.
+  } verilog_input;
+
+  /*! @} */
+}
+
+#endif
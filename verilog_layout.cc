@@ -0,0 +1,880 @@
+/*!
+@file verilog_layout.cc
+@brief Contains implementations of the schematic layout functions declared
+       in verilogcode.h
+*/
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "verilogcode.h"
+
+namespace yy {
+
+  //! Which side of a node a net meets it on.
+  typedef enum verilog_layout_side_e{
+    LAYOUT_LEFT,    //!< Inputs, in the channel before the node's column.
+    LAYOUT_RIGHT    //!< Outputs, in the channel after it.
+  } verilog_layout_side;
+
+  //! Where a net meets a node: a pin, a port, or one side of a through row.
+  typedef struct verilog_layout_attach_t{
+    unsigned int    node;     //!< Instance, port or through row.
+    unsigned int    net;      //!< Net met.
+    unsigned int    channel;  //!< Channel the net is met in.
+    int             offset;   //!< Below the top of the node.
+    unsigned char   side;     //!< A verilog_layout_side.
+  } verilog_layout_attach;
+
+  /*!
+@brief The columns and nodes of a layout while it is being worked out.
+@details Nodes are the instances, numbered as in the netlist, then the
+ports, then the rows nets pass through columns on.
+*/
+  typedef struct verilog_layout_graph_t{
+    std::vector<unsigned int>                 column;   //!< Column of each node.
+    std::vector<int>                          x;        //!< Left of each node.
+    std::vector<int>                          y;        //!< Top of each node.
+    std::vector<int>                          width;    //!< Width of each node.
+    std::vector<int>                          height;   //!< Height of each node.
+    std::vector<unsigned int>                 pos;      //!< Place of each node in its column.
+    std::vector<std::vector<unsigned int> >   order;    //!< Nodes of each column, top to bottom.
+    std::vector<verilog_layout_attach>        attach;   //!< Where nets meet nodes, by channel.
+    std::vector<unsigned int>                 channel_start; //!< Where each channel starts in attach.
+  } verilog_layout_graph;
+
+  //! Orders the nodes of a column by a key for each node.
+  struct verilog_layout_by_key
+  {
+    const std::vector<double> & key;
+    explicit verilog_layout_by_key(const std::vector<double> & key) : key(key) {}
+    bool operator()(unsigned int a, unsigned int b) const { return key[a] < key[b]; }
+  };
+
+  /*!
+@brief Reorders one column by the places of what it meets in the next.
+@details Each net in the channel between the two columns is given the mean
+place of the nodes it meets in the column kept still, and each node of
+the other column the mean of its nets. Nodes meeting no net there keep
+their place.
+*/
+  static void verilog_layout_sweep(
+      verilog_layout_graph      * graph,
+      unsigned int                channel,
+      bool                        rightwards,
+      std::vector<double>       & net_sum,
+      std::vector<unsigned int> & net_count,
+      std::vector<double>       & key,
+      std::vector<unsigned int> & key_count
+      ){
+    unsigned int from = rightwards ? channel : channel + 1;
+    unsigned int to   = rightwards ? channel + 1 : channel;
+    const verilog_layout_attach * begin = graph->attach.data() + graph->channel_start[channel];
+    const verilog_layout_attach * end   = graph->attach.data() + graph->channel_start[channel + 1];
+    std::vector<unsigned int> & order = graph->order[to];
+
+    for(const verilog_layout_attach * a = begin; a != end; a ++)
+      if(graph->column[a->node] == from)
+        {
+          net_sum[a->net]   += graph->pos[a->node];
+          net_count[a->net] += 1;
+        }
+
+    for(size_t o = 0; o < order.size(); o ++)
+      {
+        key[order[o]]       = 0;
+        key_count[order[o]] = 0;
+      }
+
+    for(const verilog_layout_attach * a = begin; a != end; a ++)
+      if(graph->column[a->node] == to && net_count[a->net] > 0)
+        {
+          key[a->node]       += net_sum[a->net] / net_count[a->net];
+          key_count[a->node] += 1;
+        }
+
+    for(const verilog_layout_attach * a = begin; a != end; a ++)
+      {
+        net_sum[a->net]   = 0;
+        net_count[a->net] = 0;
+      }
+
+    for(size_t o = 0; o < order.size(); o ++)
+      key[order[o]] = key_count[order[o]] > 0 ? key[order[o]] / key_count[order[o]] : o;
+
+    std::stable_sort(order.begin(), order.end(), verilog_layout_by_key(key));
+    for(size_t o = 0; o < order.size(); o ++)
+      graph->pos[order[o]] = (unsigned int)o;
+  }
+
+  /*!
+@brief Places the nodes of a column as near as it can to what they meet.
+@details Each node wants its top where the nets it meets in a channel come
+from, on average, in the column beside it. The nodes have to stay in
+order, a pitch apart, so the tops nearest what they want, by least squares,
+are an isotonic regression of the wants less the space above each node.
+That is found by pooling adjacent violators, in time linear in the nodes.
+Nodes meeting nothing there only want to be close to the one above.
+*/
+  static void verilog_layout_place(
+      verilog_layout_graph      * graph,
+      unsigned int                column,
+      unsigned int                channel,
+      unsigned int                beside,
+      int                         pitch,
+      std::vector<double>       & net_sum,
+      std::vector<unsigned int> & net_count,
+      std::vector<double>       & want,
+      std::vector<unsigned int> & want_count
+      ){
+    const std::vector<unsigned int> & order = graph->order[column];
+    const verilog_layout_attach * begin = NULL;
+    const verilog_layout_attach * end   = NULL;
+    if(column != beside)
+      {
+        begin = graph->attach.data() + graph->channel_start[channel];
+        end   = graph->attach.data() + graph->channel_start[channel + 1];
+      }
+
+    for(const verilog_layout_attach * a = begin; a != end; a ++)
+      if(graph->column[a->node] == beside)
+        {
+          net_sum[a->net]   += graph->y[a->node] + a->offset;
+          net_count[a->net] += 1;
+        }
+
+    for(size_t o = 0; o < order.size(); o ++)
+      {
+        want[order[o]]       = 0;
+        want_count[order[o]] = 0;
+      }
+
+    for(const verilog_layout_attach * a = begin; a != end; a ++)
+      if(graph->column[a->node] == column && net_count[a->net] > 0)
+        {
+          want[a->node]       += net_sum[a->net] / net_count[a->net] - a->offset;
+          want_count[a->node] += 1;
+        }
+
+    for(const verilog_layout_attach * a = begin; a != end; a ++)
+      {
+        net_sum[a->net]   = 0;
+        net_count[a->net] = 0;
+      }
+
+    // Blocks of nodes which end up touching, each at its weighted mean.
+    std::vector<double>       block_sum;
+    std::vector<double>       block_weight;
+    std::vector<unsigned int> block_size;
+    std::vector<int>          above(order.size());
+    int space = 0;
+
+    for(size_t o = 0; o < order.size(); o ++)
+      {
+        unsigned int node = order[o];
+        double weight = want_count[node] > 0 ? want_count[node] : 1e-6;
+        double wanted = want_count[node] > 0 ? want[node] / want_count[node] - space : 0;
+
+        above[o] = space;
+        space += (graph->height[node] + 2 * pitch - 1) / pitch * pitch;
+
+        block_sum.push_back(wanted * weight);
+        block_weight.push_back(weight);
+        block_size.push_back(1);
+
+        while(block_size.size() > 1)
+          {
+            size_t b = block_size.size() - 1;
+            if(block_sum[b - 1] / block_weight[b - 1] < block_sum[b] / block_weight[b])
+              break;
+
+            block_sum[b - 1]    += block_sum[b];
+            block_weight[b - 1] += block_weight[b];
+            block_size[b - 1]   += block_size[b];
+            block_sum.pop_back();
+            block_weight.pop_back();
+            block_size.pop_back();
+          }
+      }
+
+    // Rounding keeps the blocks in order, and every top on a whole pitch.
+    size_t o = 0;
+    for(size_t b = 0; b < block_size.size(); b ++)
+      {
+        double mean = block_sum[b] / block_weight[b];
+        int top = (int)floor(mean / pitch + 0.5) * pitch;
+        for(unsigned int n = 0; n < block_size[b]; n ++, o ++)
+          graph->y[order[o]] = top + above[o];
+      }
+  }
+
+  /*!
+@brief Places and routes a levelized netlist as a schematic.
+@details Linear in the number of pins and of the rows nets pass through
+columns on, apart from sorting each column and each channel.
+@see verilog-layout
+*/
+  verilog_layout * VerilogCode::verilog_layout_build(
+      verilog_levels * levels
+      ){
+    assert(levels != NULL);
+    verilog_phase_timer timer(&stats.phases[PHASE_LAYOUT]);
+
+    const verilog_netlist * netlist = levels->netlist;
+    const int pitch = VERILOG_LAYOUT_PITCH;
+    unsigned int instances = netlist->instances;
+    unsigned int nets = netlist->nets;
+
+    verilog_layout * tr = (verilog_layout *)ast_calloc(1, sizeof(verilog_layout));
+    tr->levels = levels;
+
+    // Inputs, the levels, any loops, then outputs.
+    unsigned int loop_column = levels->depth + 2;
+    unsigned int last = levels->ordered < instances ? loop_column + 1 : loop_column;
+    tr->columns = last + 1;
+
+    verilog_layout_graph graph;
+    graph.order.resize(tr->columns);
+
+    /* Instances, with their inputs down the left and outputs down the right.
+       Every node's top is on a whole pitch. Nets are met on the left on
+       whole pitches, and on the right half way between, so the wires
+       leaving one column never run into those entering the next. */
+    std::vector<unsigned char> pin_side(netlist->pins);
+    std::vector<int> pin_offset(netlist->pins);
+
+    tr->instance_column = (unsigned int *)ast_calloc(instances, sizeof(unsigned int));
+    for(unsigned int i = 0; i < instances; i ++)
+      {
+        int slots[2] = {0, 0};
+        for(unsigned int p = netlist->instance_pins_start[i];
+            p < netlist->instance_pins_start[i + 1]; p ++)
+          {
+            pin_side[p] = netlist->pin_direction[p] == PORT_OUTPUT ? LAYOUT_RIGHT : LAYOUT_LEFT;
+            slots[pin_side[p]] ++;
+          }
+
+        // Outputs are centred, which takes an odd number of slots more than them.
+        int rows = std::max(std::max(slots[LAYOUT_LEFT], slots[LAYOUT_RIGHT]), 1);
+        if((rows - slots[LAYOUT_RIGHT]) % 2 == 0)
+          rows ++;
+
+        int next[2] = {pitch, (rows - slots[LAYOUT_RIGHT] + 2) * pitch / 2};
+        for(unsigned int p = netlist->instance_pins_start[i];
+            p < netlist->instance_pins_start[i + 1]; p ++)
+          {
+            pin_offset[p] = next[pin_side[p]];
+            next[pin_side[p]] += pitch;
+          }
+
+        unsigned int column = levels->level[i] == VERILOG_NETLIST_NONE ?
+                              loop_column : levels->level[i] + 1;
+        tr->instance_column[i] = column;
+        graph.column.push_back(column);
+        graph.width.push_back(8 * pitch);
+        graph.height.push_back((rows + 1) * pitch);
+      }
+
+    // Ports, with a pin in the middle of the side facing the logic.
+    // Inputs are a pitch high, so that their pin is half way between two.
+    std::vector<unsigned int> port_node(nets, VERILOG_NETLIST_NONE);
+    for(unsigned int n = 0; n < nets; n ++)
+      {
+        if(netlist->net_port[n] == PORT_NONE || netlist->net_symbol[n] == AST_SYMBOL_NONE)
+          continue;
+
+        port_node[n] = (unsigned int)graph.column.size();
+        graph.column.push_back(netlist->net_port[n] == PORT_OUTPUT ? last : 0);
+        graph.width.push_back(4 * pitch);
+        graph.height.push_back(netlist->net_port[n] == PORT_OUTPUT ? 2 * pitch : pitch);
+        tr->ports ++;
+      }
+
+    // Where each net meets a pin or port, and the channels it spans.
+    std::vector<verilog_layout_attach> meets;
+    std::vector<unsigned int> span_first(nets, VERILOG_NETLIST_NONE);
+    std::vector<unsigned int> span_last(nets, 0);
+    std::vector<unsigned int> met(nets, 0);
+
+    for(unsigned int n = 0; n < nets; n ++)
+      {
+        if(netlist->net_symbol[n] == AST_SYMBOL_NONE)
+          continue;
+
+        for(const unsigned int * p = verilog_netlist_net_begin(netlist, n);
+            p != verilog_netlist_net_end(netlist, n); p ++)
+          {
+            unsigned int node = netlist->pin_instance[*p];
+            verilog_layout_attach a = {node, n, 0, pin_offset[*p], pin_side[*p]};
+            a.channel = a.side == LAYOUT_RIGHT ? graph.column[node] : graph.column[node] - 1;
+            meets.push_back(a);
+          }
+
+        if(port_node[n] != VERILOG_NETLIST_NONE)
+          {
+            unsigned int node = port_node[n];
+            verilog_layout_attach a = {node, n, 0, graph.height[node] / 2, LAYOUT_LEFT};
+            a.side    = graph.column[node] == 0 ? LAYOUT_RIGHT : LAYOUT_LEFT;
+            a.channel = graph.column[node] == 0 ? 0 : graph.column[node] - 1;
+            meets.push_back(a);
+          }
+      }
+
+    for(size_t m = 0; m < meets.size(); m ++)
+      {
+        unsigned int n = meets[m].net;
+        span_first[n] = std::min(span_first[n], meets[m].channel);
+        span_last[n] = std::max(span_last[n], meets[m].channel);
+        met[n] ++;
+      }
+
+    // Nets which are drawn as wires pass through the columns they span.
+    tr->net_routed = (unsigned char *)ast_calloc(nets, sizeof(unsigned char));
+    for(unsigned int n = 0; n < nets; n ++)
+      tr->net_routed[n] = met[n] > 1 && span_last[n] - span_first[n] < VERILOG_LAYOUT_SPAN;
+
+    for(size_t m = 0; m < meets.size(); m ++)
+      if(tr->net_routed[meets[m].net])
+        graph.attach.push_back(meets[m]);
+
+    for(unsigned int n = 0; n < nets; n ++)
+      {
+        if(!tr->net_routed[n])
+          continue;
+
+        for(unsigned int c = span_first[n] + 1; c <= span_last[n]; c ++)
+          {
+            unsigned int node = (unsigned int)graph.column.size();
+            graph.column.push_back(c);
+            graph.width.push_back(0);
+            graph.height.push_back(pitch / 2);
+
+            verilog_layout_attach left  = {node, n, c - 1, 0, LAYOUT_LEFT};
+            verilog_layout_attach right = {node, n, c, pitch / 2, LAYOUT_RIGHT};
+            graph.attach.push_back(left);
+            graph.attach.push_back(right);
+          }
+      }
+
+    unsigned int nodes = (unsigned int)graph.column.size();
+    graph.pos.resize(nodes);
+    graph.x.resize(nodes);
+    graph.y.resize(nodes);
+    for(unsigned int node = 0; node < nodes; node ++)
+      {
+        graph.pos[node] = (unsigned int)graph.order[graph.column[node]].size();
+        graph.order[graph.column[node]].push_back(node);
+      }
+
+    // Counting sort of where nets meet nodes, by channel.
+    unsigned int channels = tr->columns - 1;
+    graph.channel_start.assign(channels + 1, 0);
+    {
+      std::vector<verilog_layout_attach> sorted(graph.attach.size());
+      for(size_t a = 0; a < graph.attach.size(); a ++)
+        graph.channel_start[graph.attach[a].channel + 1] ++;
+      for(unsigned int k = 0; k < channels; k ++)
+        graph.channel_start[k + 1] += graph.channel_start[k];
+
+      std::vector<unsigned int> next(graph.channel_start.begin(), graph.channel_start.end() - 1);
+      for(size_t a = 0; a < graph.attach.size(); a ++)
+        sorted[next[graph.attach[a].channel] ++] = graph.attach[a];
+      graph.attach.swap(sorted);
+    }
+
+    // Order each column, sweeping right then left, twice.
+    {
+      std::vector<double>       net_sum(nets, 0);
+      std::vector<unsigned int> net_count(nets, 0);
+      std::vector<double>       key(nodes, 0);
+      std::vector<unsigned int> key_count(nodes, 0);
+
+      for(int sweep = 0; sweep < 4 && channels > 0; sweep ++)
+        for(unsigned int k = 0; k < channels; k ++)
+          {
+            unsigned int channel = sweep % 2 == 0 ? k : channels - 1 - k;
+            verilog_layout_sweep(&graph, channel, sweep % 2 == 0,
+                                 net_sum, net_count, key, key_count);
+          }
+    }
+
+    /* Place each column level with what drives it, then the inputs level
+       with what they drive, then move everything down to start at 0. */
+    {
+      std::vector<double>       net_sum(nets, 0);
+      std::vector<unsigned int> net_count(nets, 0);
+      std::vector<double>       want(nodes, 0);
+      std::vector<unsigned int> want_count(nodes, 0);
+
+      verilog_layout_place(&graph, 0, 0, 0, pitch, net_sum, net_count, want, want_count);
+      for(unsigned int c = 1; c < tr->columns; c ++)
+        verilog_layout_place(&graph, c, c - 1, c - 1, pitch, net_sum, net_count, want, want_count);
+      if(tr->columns > 1)
+        verilog_layout_place(&graph, 0, 0, 1, pitch, net_sum, net_count, want, want_count);
+
+      int top = 0;
+      for(unsigned int node = 0; node < nodes; node ++)
+        top = std::min(top, graph.y[node]);
+      for(unsigned int node = 0; node < nodes; node ++)
+        {
+          graph.y[node] -= top;
+          tr->height = std::max(tr->height, graph.y[node] + graph.height[node]);
+        }
+    }
+
+    // Give each net a track in each channel it crosses, by the left edge algorithm.
+    std::vector<unsigned int> track_start(nets + 1, 0);
+    for(unsigned int n = 0; n < nets; n ++)
+      track_start[n + 1] = track_start[n] + (tr->net_routed[n] ? span_last[n] - span_first[n] + 1 : 0);
+
+    std::vector<int>          track_x(track_start[nets]);
+    std::vector<int>          track_top(track_start[nets], 0);
+    std::vector<int>          track_bottom(track_start[nets], 0);
+    std::vector<unsigned int> track(track_start[nets], 0);
+    std::vector<unsigned int> tracks(channels, 0);
+    {
+      std::vector<bool> seen(track_start[nets], false);
+      std::vector<std::pair<int, unsigned int> > spans;
+
+      for(unsigned int k = 0; k < channels; k ++)
+        {
+          spans.clear();
+          for(unsigned int a = graph.channel_start[k]; a < graph.channel_start[k + 1]; a ++)
+            {
+              const verilog_layout_attach & at = graph.attach[a];
+              unsigned int t = track_start[at.net] + k - span_first[at.net];
+              int y = graph.y[at.node] + at.offset;
+              if(!seen[t])
+                {
+                  seen[t] = true;
+                  track_top[t] = track_bottom[t] = y;
+                  spans.push_back(std::make_pair(0, at.net));
+                }
+              track_top[t]    = std::min(track_top[t], y);
+              track_bottom[t] = std::max(track_bottom[t], y);
+            }
+
+          for(size_t s = 0; s < spans.size(); s ++)
+            spans[s].first = track_top[track_start[spans[s].second] + k - span_first[spans[s].second]];
+          std::sort(spans.begin(), spans.end());
+
+          // Tracks by where they are open from, the soonest on top.
+          std::priority_queue<std::pair<int, unsigned int>,
+                              std::vector<std::pair<int, unsigned int> >,
+                              std::greater<std::pair<int, unsigned int> > > open;
+          for(size_t s = 0; s < spans.size(); s ++)
+            {
+              unsigned int t = track_start[spans[s].second] + k - span_first[spans[s].second];
+              if(!open.empty() && open.top().first < track_top[t])
+                {
+                  track[t] = open.top().second;
+                  open.pop();
+                }
+              else
+                track[t] = tracks[k] ++;
+              open.push(std::make_pair(track_bottom[t], track[t]));
+            }
+        }
+    }
+
+    // Columns are as wide as their widest node, channels as their tracks.
+    std::vector<int> column_x(tr->columns, 0);
+    std::vector<int> column_width(tr->columns, 0);
+    for(unsigned int node = 0; node < nodes; node ++)
+      column_width[graph.column[node]] = std::max(column_width[graph.column[node]],
+                                                  graph.width[node]);
+
+    for(unsigned int c = 0; c + 1 < tr->columns; c ++)
+      column_x[c + 1] = column_x[c] + column_width[c] + (tracks[c] + 1) * pitch;
+    tr->width = column_x[last] + column_width[last];
+
+    for(unsigned int node = 0; node < nodes; node ++)
+      {
+        unsigned int c = graph.column[node];
+        if(graph.width[node] == 0)
+          graph.width[node] = column_width[c];
+        graph.x[node] = column_x[c] + (column_width[c] - graph.width[node]) / 2;
+      }
+
+    for(unsigned int n = 0; n < nets; n ++)
+      for(unsigned int k = span_first[n]; tr->net_routed[n] && k <= span_last[n]; k ++)
+        {
+          unsigned int t = track_start[n] + k - span_first[n];
+          track_x[t] = column_x[k] + column_width[k] + (track[t] + 1) * pitch;
+        }
+
+    // Boxes and pins.
+    tr->instance_rect = (verilog_layout_rect *)ast_calloc(instances, sizeof(verilog_layout_rect));
+    for(unsigned int i = 0; i < instances; i ++)
+      {
+        verilog_layout_rect r = {graph.x[i], graph.y[i], graph.width[i], graph.height[i]};
+        tr->instance_rect[i] = r;
+      }
+
+    tr->port_net  = (unsigned int *)ast_calloc(tr->ports, sizeof(unsigned int));
+    tr->port_rect = (verilog_layout_rect *)ast_calloc(tr->ports, sizeof(verilog_layout_rect));
+    for(unsigned int n = 0, p = 0; n < nets; n ++)
+      {
+        unsigned int node = port_node[n];
+        if(node == VERILOG_NETLIST_NONE)
+          continue;
+
+        verilog_layout_rect r = {graph.x[node], graph.y[node], graph.width[node], graph.height[node]};
+        tr->port_net[p]    = n;
+        tr->port_rect[p ++] = r;
+      }
+
+    tr->pin_x = (int *)ast_calloc(netlist->pins, sizeof(int));
+    tr->pin_y = (int *)ast_calloc(netlist->pins, sizeof(int));
+    for(unsigned int p = 0; p < netlist->pins; p ++)
+      {
+        unsigned int node = netlist->pin_instance[p];
+        tr->pin_x[p] = graph.x[node] + (pin_side[p] == LAYOUT_RIGHT ? graph.width[node] : 0);
+        tr->pin_y[p] = graph.y[node] + pin_offset[p];
+      }
+
+    // Wires, net by net: tracks, the branches off them, and through rows.
+    std::vector<unsigned int> net_start(nets + 1, 0);
+    std::vector<unsigned int> by_net(graph.attach.size());
+    for(size_t a = 0; a < graph.attach.size(); a ++)
+      net_start[graph.attach[a].net + 1] ++;
+    for(unsigned int n = 0; n < nets; n ++)
+      net_start[n + 1] += net_start[n];
+    {
+      std::vector<unsigned int> next(net_start.begin(), net_start.end() - 1);
+      for(size_t a = 0; a < graph.attach.size(); a ++)
+        by_net[next[graph.attach[a].net] ++] = (unsigned int)a;
+    }
+
+    std::vector<verilog_layout_segment> segments;
+    tr->net_segments_start = (unsigned int *)ast_calloc(nets + 1, sizeof(unsigned int));
+
+    for(unsigned int n = 0; n < nets; n ++)
+      {
+        tr->net_segments_start[n] = (unsigned int)segments.size();
+
+        if(!tr->net_routed[n])
+          {
+            // A stub off each pin and port, pointing away from the node.
+            for(const unsigned int * p = verilog_netlist_net_begin(netlist, n);
+                p != verilog_netlist_net_end(netlist, n); p ++)
+              {
+                int x = tr->pin_x[*p];
+                verilog_layout_segment s = {x - pitch, tr->pin_y[*p], x, tr->pin_y[*p], n};
+                if(pin_side[*p] == LAYOUT_RIGHT)
+                  {
+                    s.x1 = x;
+                    s.x2 = x + pitch;
+                  }
+                segments.push_back(s);
+              }
+
+            unsigned int node = port_node[n];
+            if(node != VERILOG_NETLIST_NONE)
+              {
+                int y = graph.y[node] + graph.height[node] / 2;
+                int x = graph.column[node] == 0 ? graph.x[node] + graph.width[node] : graph.x[node] - pitch;
+                verilog_layout_segment s = {x, y, x + pitch, y, n};
+                segments.push_back(s);
+              }
+            continue;
+          }
+
+        for(unsigned int k = span_first[n]; k <= span_last[n]; k ++)
+          {
+            unsigned int t = track_start[n] + k - span_first[n];
+            if(track_top[t] < track_bottom[t])
+              {
+                verilog_layout_segment s = {track_x[t], track_top[t], track_x[t], track_bottom[t], n};
+                segments.push_back(s);
+              }
+          }
+
+        for(unsigned int b = net_start[n]; b < net_start[n + 1]; b ++)
+          {
+            const verilog_layout_attach & at = graph.attach[by_net[b]];
+            int x = graph.x[at.node] + (at.side == LAYOUT_RIGHT ? graph.width[at.node] : 0);
+            int y = graph.y[at.node] + at.offset;
+            int to = track_x[track_start[n] + at.channel - span_first[n]];
+
+            if(x != to)
+              {
+                verilog_layout_segment s = {std::min(x, to), y, std::max(x, to), y, n};
+                segments.push_back(s);
+              }
+
+            // A through row is drawn once, from its left side, with a step
+            // half way across down to where it meets the next channel.
+            if(at.node >= instances + tr->ports && at.side == LAYOUT_LEFT)
+              {
+                int middle = x + graph.width[at.node] / 2;
+                verilog_layout_segment in   = {x, y, middle, y, n};
+                verilog_layout_segment step = {middle, y, middle, y + pitch / 2, n};
+                verilog_layout_segment out  = {middle, y + pitch / 2, x + graph.width[at.node], y + pitch / 2, n};
+                segments.push_back(in);
+                segments.push_back(step);
+                segments.push_back(out);
+              }
+          }
+      }
+
+    tr->segments = (unsigned int)segments.size();
+    tr->net_segments_start[nets] = tr->segments;
+    tr->segment = (verilog_layout_segment *)ast_calloc(tr->segments, sizeof(verilog_layout_segment));
+    if(tr->segments > 0)
+      memcpy(tr->segment, segments.data(), tr->segments * sizeof(verilog_layout_segment));
+
+    stats.phases[PHASE_LAYOUT].count += tr->segments;
+    return tr;
+  }
+
+  //! Returns how far along a Hilbert curve through a 65536 square a point is.
+  static uint32_t verilog_layout_hilbert(
+      uint32_t x,
+      uint32_t y
+      ){
+    const uint32_t n = 1 << 16;
+    uint32_t tr = 0;
+
+    for(uint32_t s = n / 2; s > 0; s /= 2)
+      {
+        uint32_t rx = (x & s) > 0;
+        uint32_t ry = (y & s) > 0;
+        tr += s * s * ((3 * rx) ^ ry);
+
+        // Turn the quadrant so the curve through it starts where it should.
+        if(ry == 0)
+          {
+            if(rx == 1)
+              {
+                x = n - 1 - x;
+                y = n - 1 - y;
+              }
+            std::swap(x, y);
+          }
+      }
+
+    return tr;
+  }
+
+  //! Returns true if two boxes share any point.
+  static inline bool verilog_layout_box_meets(
+      const verilog_layout_box & a,
+      const verilog_layout_box & b
+      ){
+    return a.x1 <= b.x2 && b.x1 <= a.x2 && a.y1 <= b.y2 && b.y1 <= a.y2;
+  }
+
+  /*!
+@brief Indexes every instance, port, pin and wire segment of a layout.
+@details Sorting the items along the curve is the only part which isn't
+linear in the number of items.
+@see verilog_layout_index
+*/
+  verilog_layout_index * VerilogCode::verilog_layout_index_build(
+      verilog_layout * layout
+      ){
+    assert(layout != NULL);
+    verilog_phase_timer timer(&stats.phases[PHASE_LAYOUT]);
+
+    const verilog_netlist * netlist = layout->levels->netlist;
+    verilog_layout_index * tr = (verilog_layout_index *)ast_calloc(1, sizeof(verilog_layout_index));
+    tr->layout = layout;
+    tr->items  = netlist->pins + layout->segments + layout->ports + netlist->instances;
+
+    std::vector<verilog_layout_box> box;
+    std::vector<unsigned char>      kind;
+    std::vector<unsigned int>       index;
+    box.reserve(tr->items);
+    kind.reserve(tr->items);
+    index.reserve(tr->items);
+
+    for(unsigned int p = 0; p < netlist->pins; p ++)
+      {
+        verilog_layout_box b = {layout->pin_x[p], layout->pin_y[p], layout->pin_x[p], layout->pin_y[p]};
+        box.push_back(b);
+        kind.push_back(LAYOUT_ITEM_PIN);
+        index.push_back(p);
+      }
+
+    for(unsigned int s = 0; s < layout->segments; s ++)
+      {
+        const verilog_layout_segment & w = layout->segment[s];
+        verilog_layout_box b = {w.x1, w.y1, w.x2, w.y2};
+        box.push_back(b);
+        kind.push_back(LAYOUT_ITEM_SEGMENT);
+        index.push_back(s);
+      }
+
+    for(unsigned int p = 0; p < layout->ports; p ++)
+      {
+        const verilog_layout_rect & r = layout->port_rect[p];
+        verilog_layout_box b = {r.x, r.y, r.x + r.width, r.y + r.height};
+        box.push_back(b);
+        kind.push_back(LAYOUT_ITEM_PORT);
+        index.push_back(p);
+      }
+
+    for(unsigned int i = 0; i < netlist->instances; i ++)
+      {
+        const verilog_layout_rect & r = layout->instance_rect[i];
+        verilog_layout_box b = {r.x, r.y, r.x + r.width, r.y + r.height};
+        box.push_back(b);
+        kind.push_back(LAYOUT_ITEM_INSTANCE);
+        index.push_back(i);
+      }
+
+    // Sort along the curve, by the centre of each item scaled to fit it.
+    uint64_t width  = (uint64_t)std::max(layout->width, 1);
+    uint64_t height = (uint64_t)std::max(layout->height, 1);
+    std::vector<std::pair<uint32_t, unsigned int> > order(tr->items);
+    for(unsigned int t = 0; t < tr->items; t ++)
+      {
+        uint64_t x = (uint64_t)std::max((box[t].x1 + box[t].x2) / 2, 0);
+        uint64_t y = (uint64_t)std::max((box[t].y1 + box[t].y2) / 2, 0);
+        order[t].first  = verilog_layout_hilbert((uint32_t)std::min<uint64_t>(x * 65535 / width, 65535),
+                                                 (uint32_t)std::min<uint64_t>(y * 65535 / height, 65535));
+        order[t].second = t;
+      }
+    std::sort(order.begin(), order.end());
+
+    tr->item_kind  = (unsigned char *)ast_calloc(tr->items, sizeof(unsigned char));
+    tr->item_index = (unsigned int *)ast_calloc(tr->items, sizeof(unsigned int));
+    tr->item_box   = (verilog_layout_box *)ast_calloc(tr->items, sizeof(verilog_layout_box));
+    for(unsigned int t = 0; t < tr->items; t ++)
+      {
+        tr->item_kind[t]  = kind[order[t].second];
+        tr->item_index[t] = index[order[t].second];
+        tr->item_box[t]   = box[order[t].second];
+      }
+
+    // Each level boxes the one below it, until there is a single root.
+    std::vector<verilog_layout_box> nodes;
+    std::vector<unsigned int>       level_start(1, 0);
+    const verilog_layout_box * below = tr->item_box;
+    unsigned int count = tr->items;
+
+    while(count > 0 && (level_start.size() == 1 || count > 1))
+      {
+        unsigned int parents = (count + VERILOG_LAYOUT_FANOUT - 1) / VERILOG_LAYOUT_FANOUT;
+        for(unsigned int n = 0; n < parents; n ++)
+          {
+            unsigned int first = n * VERILOG_LAYOUT_FANOUT;
+            unsigned int end   = std::min(first + VERILOG_LAYOUT_FANOUT, count);
+            verilog_layout_box b = below[first];
+            for(unsigned int c = first + 1; c < end; c ++)
+              {
+                b.x1 = std::min(b.x1, below[c].x1);
+                b.y1 = std::min(b.y1, below[c].y1);
+                b.x2 = std::max(b.x2, below[c].x2);
+                b.y2 = std::max(b.y2, below[c].y2);
+              }
+            nodes.push_back(b);
+          }
+
+        level_start.push_back((unsigned int)nodes.size());
+        below = nodes.data() + level_start[level_start.size() - 2];
+        count = parents;
+      }
+
+    tr->levels      = (unsigned int)level_start.size() - 1;
+    tr->level_start = (unsigned int *)ast_calloc(level_start.size(), sizeof(unsigned int));
+    tr->node_box    = (verilog_layout_box *)ast_calloc(nodes.size(), sizeof(verilog_layout_box));
+    memcpy(tr->level_start, level_start.data(), level_start.size() * sizeof(unsigned int));
+    if(!nodes.empty())
+      memcpy(tr->node_box, nodes.data(), nodes.size() * sizeof(verilog_layout_box));
+
+    return tr;
+  }
+
+  /*!
+@brief Finds the items of a layout meeting an area.
+@details Appends the place of each in the index, from which item_kind and
+item_index say what it is. Nothing is allocated, but for found.
+*/
+  void VerilogCode::verilog_layout_index_query(
+      const verilog_layout_index  * index,
+      const verilog_layout_box    & area,
+      std::vector<unsigned int>   & found
+      ){
+    if(index->levels == 0)
+      return;
+
+    /* Nodes left to look in, as a level and a place in it. There are at
+       most 8 levels over 32 bit item numbers, each leaving fewer than
+       VERILOG_LAYOUT_FANOUT nodes waiting. */
+    std::pair<unsigned int, unsigned int> stack[8 * VERILOG_LAYOUT_FANOUT];
+    unsigned int depth = 0;
+    stack[depth ++] = std::make_pair(index->levels, 0u);
+
+    while(depth > 0)
+      {
+        std::pair<unsigned int, unsigned int> node = stack[-- depth];
+        unsigned int level = node.first;
+        unsigned int first = node.second * VERILOG_LAYOUT_FANOUT;
+        unsigned int count = level == 1 ? index->items :
+                             index->level_start[level - 1] - index->level_start[level - 2];
+        unsigned int end   = std::min(first + VERILOG_LAYOUT_FANOUT, count);
+
+        if(level == 1)
+          {
+            for(unsigned int c = first; c < end; c ++)
+              if(verilog_layout_box_meets(index->item_box[c], area))
+                found.push_back(c);
+            continue;
+          }
+
+        const verilog_layout_box * child = index->node_box + index->level_start[level - 2];
+        for(unsigned int c = first; c < end; c ++)
+          if(verilog_layout_box_meets(child[c], area))
+            stack[depth ++] = std::make_pair(level - 1, c);
+      }
+  }
+
+  /*!
+@brief Finds the item of a layout under a point.
+@details Of the items within a radius of the point, pins come first, then
+wires, ports and instances, so that what is on top of an instance can be
+picked out. Between items of a kind, the nearest wins.
+@returns The place of the item in the index, or VERILOG_NETLIST_NONE.
+*/
+  unsigned int VerilogCode::verilog_layout_index_hit(
+      const verilog_layout_index  * index,
+      int                           x,
+      int                           y,
+      int                           radius
+      ){
+    verilog_layout_box area = {x - radius, y - radius, x + radius, y + radius};
+    std::vector<unsigned int> found;
+    verilog_layout_index_query(index, area, found);
+
+    unsigned int tr   = VERILOG_NETLIST_NONE;
+    int64_t      best = 0;
+    for(size_t f = 0; f < found.size(); f ++)
+      {
+        const verilog_layout_box & b = index->item_box[found[f]];
+        int64_t dx = std::max(std::max(b.x1 - x, x - b.x2), 0);
+        int64_t dy = std::max(std::max(b.y1 - y, y - b.y2), 0);
+        int64_t distance = dx * dx + dy * dy;
+        if(distance > (int64_t)radius * radius)
+          continue;
+
+        if(tr == VERILOG_NETLIST_NONE ||
+           index->item_kind[found[f]] < index->item_kind[tr] ||
+           (index->item_kind[found[f]] == index->item_kind[tr] && distance < best))
+          {
+            tr   = found[f];
+            best = distance;
+          }
+      }
+
+    return tr;
+  }
+}
@@ -0,0 +1,136 @@
+/*!
+@file verilog_layout.hh
+@brief Contains declarations of the placement and routing of a module's
+       netlist as a schematic.
+*/
+
+#include "verilog_netlist.hh"
+
+#ifndef VERILOG_LAYOUT_H
+#define VERILOG_LAYOUT_H
+
+namespace yy {
+  /*!
+@defgroup verilog-layout Schematic Layout
+@{
+@brief Where each instance, port and wire of a module is drawn.
+@details The layout is layered, after Sugiyama. Each instance goes in the
+column of its level from verilog_netlist_levelize, so signals flow from
+left to right, with the input ports in the first column and the output
+ports in the last. Instances on loops go in a column of their own, after
+the deepest logic.
+
+A net joining columns which are not next to each other passes through
+each column in between on a row of its own, so no wire crosses an
+instance. The instances and rows in each column are then put in order
+by the barycenter heuristic, sweeping across the columns a few times,
+which brings together what is connected and keeps wires short and
+crossings few.
+
+Between each pair of columns is a channel, in which every net crossing it
+gets a vertical track. Tracks are shared by nets whose spans don't
+overlap, in the order of the left edge algorithm, so channels are only
+as wide as the most nets crossing any one height. All wires are
+horizontal or vertical.
+
+Nets spanning more than VERILOG_LAYOUT_SPAN channels, such as clocks and
+resets, and constants, would cross the whole schematic. They are drawn
+as a short stub at each pin instead, and net_routed says which these are.
+
+Coordinates are integers, with y growing downwards, in units where pins
+are VERILOG_LAYOUT_PITCH apart. Everything is allocated with ast_calloc,
+and is freed with the tree.
+*/
+
+  //! The distance between pins on an instance, and between tracks.
+  #define VERILOG_LAYOUT_PITCH 10
+
+  //! The most channels a net is routed across, before it is drawn as stubs.
+  #define VERILOG_LAYOUT_SPAN 8
+
+  //! A rectangle in layout coordinates.
+  typedef struct verilog_layout_rect_t{
+    int x;        //!< Left edge.
+    int y;        //!< Top edge.
+    int width;    //!< Width.
+    int height;   //!< Height.
+  } verilog_layout_rect;
+
+  //! A horizontal or vertical piece of wire.
+  typedef struct verilog_layout_segment_t{
+    int            x1;   //!< Start.
+    int            y1;   //!< Start.
+    int            x2;   //!< End, x1 <= x2.
+    int            y2;   //!< End, y1 <= y2.
+    unsigned int   net;  //!< Net the wire is part of.
+  } verilog_layout_segment;
+
+  //! A schematic of one netlist, see @ref verilog-layout.
+  typedef struct verilog_layout_t{
+    verilog_levels          * levels;         //!< Where the columns came from.
+    int                       width;          //!< Width of the whole schematic.
+    int                       height;         //!< Height of the whole schematic.
+    unsigned int              columns;        //!< Number of columns.
+
+    verilog_layout_rect     * instance_rect;  //!< Box of each instance.
+    unsigned int            * instance_column; //!< Column of each instance.
+    unsigned int              ports;          //!< Number of ports drawn.
+    unsigned int            * port_net;       //!< Net of each port.
+    verilog_layout_rect     * port_rect;      //!< Box of each port.
+    int                     * pin_x;          //!< Where each pin of the netlist is.
+    int                     * pin_y;          //!< Where each pin of the netlist is.
+
+    unsigned char           * net_routed;     //!< Non-zero for each net drawn as wires.
+    unsigned int              segments;       //!< Number of wire segments.
+    verilog_layout_segment  * segment;        //!< Wire segments, grouped by net.
+    unsigned int            * net_segments_start; //!< Where each net's segments start, and the end.
+  } verilog_layout;
+
+  //! What an item of a verilog_layout_index is.
+  typedef enum verilog_layout_item_kind_e{
+    LAYOUT_ITEM_PIN,        //!< A pin, by its index in the netlist.
+    LAYOUT_ITEM_SEGMENT,    //!< A wire segment.
+    LAYOUT_ITEM_PORT,       //!< A port, by its index in port_net.
+    LAYOUT_ITEM_INSTANCE    //!< An instance.
+  } verilog_layout_item_kind;
+
+  //! A box with its edges included, in layout coordinates.
+  typedef struct verilog_layout_box_t{
+    int x1;   //!< Left.
+    int y1;   //!< Top.
+    int x2;   //!< Right, x1 <= x2.
+    int y2;   //!< Bottom, y1 <= y2.
+  } verilog_layout_box;
+
+  //! How many children each node of a verilog_layout_index has.
+  #define VERILOG_LAYOUT_FANOUT 16
+
+  /*!
+@brief Finds what of a layout is in or near an area, without looking at the rest.
+@details A packed R-tree over every instance, port, pin and wire segment.
+The items are sorted along a Hilbert curve through their centres, which
+keeps items close on the curve close on the schematic, and every
+VERILOG_LAYOUT_FANOUT of them in that order are a node, whose box holds
+theirs. Every VERILOG_LAYOUT_FANOUT nodes are in turn a node of the level
+above, up to a single root. Since each node's children are consecutive
+in the level below, only the boxes are kept, level by level, with no
+pointers between them.
+
+A query goes down from the root only through the boxes meeting the area,
+so its cost follows what is found, and not the size of the design.
+*/
+  typedef struct verilog_layout_index_t{
+    verilog_layout          * layout;       //!< The layout indexed.
+    unsigned int              items;        //!< Number of items.
+    unsigned char           * item_kind;    //!< A verilog_layout_item_kind for each item, in curve order.
+    unsigned int            * item_index;   //!< What each item is, by kind.
+    verilog_layout_box      * item_box;     //!< Box of each item.
+    unsigned int              levels;       //!< Levels of nodes above the items.
+    unsigned int            * level_start;  //!< Where each level starts in node_box, and the end.
+    verilog_layout_box      * node_box;     //!< Box of each node, the lowest level first.
+  } verilog_layout_index;
+
+  /*! @} */
+}
+
+#endif
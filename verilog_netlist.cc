@@ -0,0 +1,885 @@
+/*!
+@file verilog_netlist.cc
+@brief Contains implementations of the netlist functions declared in
+       verilogcode.h
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "verilogcode.h"
+
+namespace yy {
+
+  //! The ports of a declaration, for finding the direction of pins.
+  typedef struct verilog_netlist_ports_t{
+    std::unordered_map<ast_symbol, unsigned char>  named;   //!< By port name.
+    std::vector<unsigned char>                     ordered; //!< By position.
+  } verilog_netlist_ports;
+
+  //! Packs a net's name and bit into the key it is indexed by.
+  static inline uint64_t verilog_netlist_key(ast_symbol symbol, int bit)
+  {
+    return ((uint64_t)symbol << 32) | (uint32_t)bit;
+  }
+
+  //! Returns the slot a key is first looked for in, of an index of capacity slots.
+  static inline unsigned int verilog_netlist_slot(uint64_t key, unsigned int capacity)
+  {
+    return (unsigned int)((key * 0x9E3779B97F4A7C15ULL) >> 32) & (capacity - 1);
+  }
+
+  //! Returns the number of slots to index count items with.
+  static unsigned int verilog_netlist_capacity(unsigned int count)
+  {
+    unsigned int tr = 16;
+    while(tr < count * 2)
+      tr *= 2;
+    return tr;
+  }
+
+  /*!
+@brief Evaluates an expression which is a plain number.
+@returns False if it is anything else, or has x or z bits.
+*/
+  static bool verilog_netlist_constant(ast_expression * expression, long * value)
+  {
+    if(expression == NULL || expression->type != PRIMARY_EXPRESSION ||
+       expression->primary == NULL ||
+       expression->primary->value_type != PRIMARY_NUMBER)
+      return false;
+
+    ast_number * number = expression->primary->value.number;
+    if(number->representation == REP_INTEGER)
+      {
+        *value = number->as_int;
+        return true;
+      }
+    if(number->representation != REP_BITS || number->as_bits == NULL)
+      return false;
+
+    int radix = number->base == BASE_BINARY ? 2 :
+                number->base == BASE_OCTAL  ? 8 :
+                number->base == BASE_HEX    ? 16 : 10;
+
+    // Digits may be broken up with underscores.
+    char digits[64];
+    size_t length = 0;
+    for(const char * c = number->as_bits; *c != '\0'; c ++)
+      {
+        if(*c == '_')
+          continue;
+        if(length + 1 >= sizeof(digits))
+          return false;
+        digits[length ++] = *c;
+      }
+    digits[length] = '\0';
+
+    char * end = NULL;
+    *value = strtol(digits, &end, radix);
+    return length > 0 && *end == '\0';
+  }
+
+  /*!
+@brief Finds the net a port connection's expression names.
+@returns False if it names something other than a net, a bit of one, or
+the constant 0 or 1.
+*/
+  static bool verilog_netlist_net_of(
+      ast_expression * expression, //!< What the port is connected to.
+      ast_symbol     * symbol,     //!< [out] Name of the net.
+      int            * bit         //!< [out] Bit of the net.
+      ){
+    long value;
+
+    if(verilog_netlist_constant(expression, &value))
+      {
+        if(value != 0 && value != 1)
+          return false;
+
+        *symbol = AST_SYMBOL_NONE;
+        *bit    = (int)value;
+        return true;
+      }
+
+    if(expression == NULL || expression->type != PRIMARY_EXPRESSION ||
+       expression->primary == NULL ||
+       expression->primary->value_type != PRIMARY_IDENTIFIER)
+      return false;
+
+    ast_identifier id = expression->primary->value.identifier;
+    if(id == NULL || id->next != NULL)
+      return false;
+
+    *symbol = id->symbol;
+
+    if(id->range_or_idx == ID_HAS_NONE)
+      {
+        *bit = VERILOG_NETLIST_WHOLE;
+        return true;
+      }
+
+    if(id->range_or_idx != ID_HAS_INDEX ||
+       !verilog_netlist_constant(id->index, &value) ||
+       value < 0 || value > 0x7fffffff)
+      return false;
+
+    *bit = (int)value;
+    return true;
+  }
+
+  /*!
+@brief Builds the connectivity of a module's instances.
+@details Makes a pass over the port connections to number instances, pins
+and nets, then a counting sort of the pins by net. Both are linear in the
+number of connections. Nets are found by name with an open addressed index,
+which is kept for verilog_netlist_find_net.
+@pre The module's instantiations should have been resolved, so the pins of
+instances of modules declared in the design get their directions.
+*/
+  verilog_netlist * VerilogCode::verilog_netlist_build(
+      ast_module_declaration * module
+      ){
+    assert(module != NULL);
+    verilog_phase_timer timer(&stats.phases[PHASE_NETLIST]);
+
+    verilog_netlist * tr = (verilog_netlist *)ast_calloc(1, sizeof(verilog_netlist));
+    tr->module = module;
+
+    ast_list * instantiations = module->module_instantiations;
+    unsigned int port_bits    = 0;
+
+    for(unsigned int i = 0; instantiations != NULL && i < instantiations->items; i ++)
+      {
+        ast_module_instantiation * of = (ast_module_instantiation *)ast_list_get(instantiations, i);
+        for(unsigned int n = 0; of->module_instances != NULL &&
+                                n < of->module_instances->items; n ++)
+          {
+            ast_module_instance * instance = (ast_module_instance *)ast_list_get(of->module_instances, n);
+            tr->instances ++;
+            if(instance->port_connections != NULL)
+              tr->pins += instance->port_connections->items;
+          }
+      }
+
+    // Bits of the module's ports which are known to be there.
+    std::unordered_map<ast_symbol, unsigned char> port_direction;
+    std::vector<long> port_low, port_high;
+    for(unsigned int p = 0; module->module_ports != NULL && p < module->module_ports->items; p ++)
+      {
+        ast_port_declaration * port = (ast_port_declaration *)ast_list_get(module->module_ports, p);
+        long high = VERILOG_NETLIST_WHOLE, low = VERILOG_NETLIST_WHOLE;
+
+        if(port->range != NULL &&
+           verilog_netlist_constant(port->range->upper, &high) &&
+           verilog_netlist_constant(port->range->lower, &low) &&
+           high >= 0 && low >= 0 && labs(high - low) < 65536)
+          {
+            if(high < low)
+              std::swap(high, low);
+          }
+        else
+          high = low = VERILOG_NETLIST_WHOLE;
+
+        port_low.push_back(low);
+        port_high.push_back(high);
+
+        for(unsigned int n = 0; port->port_names != NULL && n < port->port_names->items; n ++)
+          {
+            ast_identifier name = (ast_identifier)ast_list_get(port->port_names, n);
+            port_direction[name->symbol] = (unsigned char)port->direction;
+            port_bits += (unsigned int)(high - low + 1);
+          }
+      }
+
+    std::vector<ast_symbol>     net_symbol;
+    std::vector<int>            net_bit;
+    std::vector<unsigned char>  net_port;
+    unsigned int capacity = verilog_netlist_capacity(tr->pins + port_bits);
+    std::vector<unsigned int>   slots(capacity, 0);
+
+    // Returns the id of a net, numbering it if it is new.
+    auto net_id = [&](ast_symbol symbol, int bit) -> unsigned int
+      {
+        uint64_t key = verilog_netlist_key(symbol, bit);
+        unsigned int s = verilog_netlist_slot(key, capacity);
+        while(slots[s] != 0)
+          {
+            unsigned int net = slots[s] - 1;
+            if(net_symbol[net] == symbol && net_bit[net] == bit)
+              return net;
+            s = (s + 1) & (capacity - 1);
+          }
+
+        std::unordered_map<ast_symbol, unsigned char>::const_iterator port =
+            symbol == AST_SYMBOL_NONE ? port_direction.end() : port_direction.find(symbol);
+
+        net_symbol.push_back(symbol);
+        net_bit.push_back(bit);
+        net_port.push_back(port != port_direction.end() ? port->second :
+                                                          (unsigned char)PORT_NONE);
+        slots[s] = (unsigned int)net_symbol.size();
+        return slots[s] - 1;
+      };
+
+    for(unsigned int p = 0; module->module_ports != NULL && p < module->module_ports->items; p ++)
+      {
+        ast_port_declaration * port = (ast_port_declaration *)ast_list_get(module->module_ports, p);
+        for(unsigned int n = 0; port->port_names != NULL && n < port->port_names->items; n ++)
+          {
+            ast_identifier name = (ast_identifier)ast_list_get(port->port_names, n);
+            for(long b = port_low[p]; b <= port_high[p]; b ++)
+              net_id(name->symbol, (int)b);
+          }
+      }
+
+    tr->instance            = (ast_module_instance **)ast_calloc(tr->instances, sizeof(ast_module_instance *));
+    tr->instance_of         = (ast_module_instantiation **)ast_calloc(tr->instances, sizeof(ast_module_instantiation *));
+    tr->instance_pins_start = (unsigned int *)ast_calloc(tr->instances + 1, sizeof(unsigned int));
+    tr->pin_instance        = (unsigned int *)ast_calloc(tr->pins, sizeof(unsigned int));
+    tr->pin_net             = (unsigned int *)ast_calloc(tr->pins, sizeof(unsigned int));
+    tr->pin_port            = (ast_symbol *)ast_calloc(tr->pins, sizeof(ast_symbol));
+    tr->pin_direction       = (unsigned char *)ast_calloc(tr->pins, sizeof(unsigned char));
+
+    // Ports of each module instanced which is declared in the design.
+    std::unordered_map<ast_module_declaration *, verilog_netlist_ports> declared;
+
+    unsigned int instance = 0;
+    unsigned int pin      = 0;
+    for(unsigned int i = 0; instantiations != NULL && i < instantiations->items; i ++)
+      {
+        ast_module_instantiation * of = (ast_module_instantiation *)ast_list_get(instantiations, i);
+        verilog_netlist_ports * ports = NULL;
+
+        if(of->resolved && of->declaration != NULL)
+          {
+            bool seen = declared.count(of->declaration) > 0;
+            ports = &declared[of->declaration];
+
+            ast_list * list = of->declaration->module_ports;
+            for(unsigned int p = 0; !seen && list != NULL && p < list->items; p ++)
+              {
+                ast_port_declaration * port = (ast_port_declaration *)ast_list_get(list, p);
+                for(unsigned int n = 0; port->port_names != NULL && n < port->port_names->items; n ++)
+                  {
+                    ast_identifier name = (ast_identifier)ast_list_get(port->port_names, n);
+                    ports->named[name->symbol] = (unsigned char)port->direction;
+                    ports->ordered.push_back((unsigned char)port->direction);
+                  }
+              }
+          }
+
+        for(unsigned int n = 0; of->module_instances != NULL &&
+                                n < of->module_instances->items; n ++)
+          {
+            ast_module_instance * node = (ast_module_instance *)ast_list_get(of->module_instances, n);
+            ast_list * connections = node->port_connections;
+
+            tr->instance[instance]            = node;
+            tr->instance_of[instance]         = of;
+            tr->instance_pins_start[instance] = pin;
+
+            for(unsigned int c = 0; connections != NULL && c < connections->items; c ++, pin ++)
+              {
+                ast_port_connection * connection = (ast_port_connection *)ast_list_get(connections, c);
+                ast_symbol symbol;
+                int        bit;
+
+                tr->pin_instance[pin]  = instance;
+                tr->pin_port[pin]      = connection->port_name != NULL ?
+                                         connection->port_name->symbol : AST_SYMBOL_NONE;
+                tr->pin_direction[pin] = PORT_NONE;
+
+                if(ports != NULL && connection->port_name != NULL)
+                  {
+                    std::unordered_map<ast_symbol, unsigned char>::const_iterator port =
+                        ports->named.find(connection->port_name->symbol);
+                    if(port != ports->named.end())
+                      tr->pin_direction[pin] = port->second;
+                  }
+                else if(ports != NULL && c < ports->ordered.size())
+                  tr->pin_direction[pin] = ports->ordered[c];
+
+                if(verilog_netlist_net_of(connection->expression, &symbol, &bit))
+                  tr->pin_net[pin] = net_id(symbol, bit);
+                else
+                  {
+                    tr->pin_net[pin] = VERILOG_NETLIST_NONE;
+                    if(connection->expression != NULL)
+                      tr->skipped ++;
+                  }
+              }
+
+            instance ++;
+          }
+      }
+    tr->instance_pins_start[instance] = pin;
+
+    tr->nets       = (unsigned int)net_symbol.size();
+    tr->net_symbol = (ast_symbol *)ast_calloc(tr->nets, sizeof(ast_symbol));
+    tr->net_bit    = (int *)ast_calloc(tr->nets, sizeof(int));
+    tr->net_port   = (unsigned char *)ast_calloc(tr->nets, sizeof(unsigned char));
+    if(tr->nets > 0)
+      {
+        memcpy(tr->net_symbol, net_symbol.data(), tr->nets * sizeof(ast_symbol));
+        memcpy(tr->net_bit,    net_bit.data(),    tr->nets * sizeof(int));
+        memcpy(tr->net_port,   net_port.data(),   tr->nets * sizeof(unsigned char));
+      }
+
+    // Counting sort of the pins by net.
+    tr->net_pins_start = (unsigned int *)ast_calloc(tr->nets + 1, sizeof(unsigned int));
+    for(unsigned int p = 0; p < tr->pins; p ++)
+      if(tr->pin_net[p] != VERILOG_NETLIST_NONE)
+        tr->net_pins_start[tr->pin_net[p] + 1] ++;
+    for(unsigned int n = 0; n < tr->nets; n ++)
+      tr->net_pins_start[n + 1] += tr->net_pins_start[n];
+
+    tr->net_pins = (unsigned int *)ast_calloc(tr->net_pins_start[tr->nets], sizeof(unsigned int));
+    std::vector<unsigned int> fill(tr->net_pins_start, tr->net_pins_start + tr->nets);
+    for(unsigned int p = 0; p < tr->pins; p ++)
+      if(tr->pin_net[p] != VERILOG_NETLIST_NONE)
+        tr->net_pins[fill[tr->pin_net[p]] ++] = p;
+
+    // The indexes kept are sized for what was found.
+    tr->net_capacity = verilog_netlist_capacity(tr->nets);
+    tr->net_index    = (unsigned int *)ast_calloc(tr->net_capacity, sizeof(unsigned int));
+    for(unsigned int n = 0; n < tr->nets; n ++)
+      {
+        unsigned int s = verilog_netlist_slot(verilog_netlist_key(tr->net_symbol[n], tr->net_bit[n]),
+                                              tr->net_capacity);
+        while(tr->net_index[s] != 0)
+          s = (s + 1) & (tr->net_capacity - 1);
+        tr->net_index[s] = n + 1;
+      }
+
+    tr->instance_capacity = verilog_netlist_capacity(tr->instances);
+    tr->instance_index    = (unsigned int *)ast_calloc(tr->instance_capacity, sizeof(unsigned int));
+    for(unsigned int n = 0; n < tr->instances; n ++)
+      {
+        ast_identifier name = tr->instance[n]->instance_identifier;
+        if(name == NULL)
+          continue;
+
+        unsigned int s = verilog_netlist_slot(verilog_netlist_key(name->symbol, 0),
+                                              tr->instance_capacity);
+        while(tr->instance_index[s] != 0)
+          s = (s + 1) & (tr->instance_capacity - 1);
+        tr->instance_index[s] = n + 1;
+      }
+
+    stats.phases[PHASE_NETLIST].count += tr->pins;
+
+    return tr;
+  }
+
+  //! Returns the symbol of a name, or AST_SYMBOL_NONE if it was never seen.
+  static ast_symbol verilog_netlist_symbol(VerilogCode * code, const char * name)
+  {
+    void * entry = NULL;
+
+    if(code->yy_symbols == NULL ||
+       code->ast_hashtable_get(code->yy_symbols->index, name, strlen(name), &entry) != HASH_SUCCESS)
+      return AST_SYMBOL_NONE;
+
+    return ((ast_symbol_entry *)entry)->id;
+  }
+
+  /*!
+@brief Finds a net by name and bit.
+@details A NULL name finds the constant net whose value is bit.
+@returns The id of the net, or VERILOG_NETLIST_NONE.
+*/
+  unsigned int VerilogCode::verilog_netlist_find_net(
+      const verilog_netlist * netlist,
+      const char            * name,
+      int                     bit
+      ){
+    ast_symbol symbol = AST_SYMBOL_NONE;
+    if(name != NULL && (symbol = verilog_netlist_symbol(this, name)) == AST_SYMBOL_NONE)
+      return VERILOG_NETLIST_NONE;
+
+    unsigned int s = verilog_netlist_slot(verilog_netlist_key(symbol, bit), netlist->net_capacity);
+    while(netlist->net_index[s] != 0)
+      {
+        unsigned int net = netlist->net_index[s] - 1;
+        if(netlist->net_symbol[net] == symbol && netlist->net_bit[net] == bit)
+          return net;
+        s = (s + 1) & (netlist->net_capacity - 1);
+      }
+
+    return VERILOG_NETLIST_NONE;
+  }
+
+  //! Finds an instance by name, returning its id or VERILOG_NETLIST_NONE.
+  unsigned int VerilogCode::verilog_netlist_find_instance(
+      const verilog_netlist * netlist,
+      const char            * name
+      ){
+    ast_symbol symbol = verilog_netlist_symbol(this, name);
+    if(symbol == AST_SYMBOL_NONE)
+      return VERILOG_NETLIST_NONE;
+
+    unsigned int s = verilog_netlist_slot(verilog_netlist_key(symbol, 0), netlist->instance_capacity);
+    while(netlist->instance_index[s] != 0)
+      {
+        unsigned int instance = netlist->instance_index[s] - 1;
+        if(netlist->instance[instance]->instance_identifier->symbol == symbol)
+          return instance;
+        s = (s + 1) & (netlist->instance_capacity - 1);
+      }
+
+    return VERILOG_NETLIST_NONE;
+  }
+
+  //! Returns the name of a net as it would be written in the source.
+  std::string VerilogCode::verilog_netlist_net_name(
+      const verilog_netlist * netlist,
+      unsigned int            net
+      ){
+    assert(net < netlist->nets);
+
+    if(netlist->net_symbol[net] == AST_SYMBOL_NONE)
+      return netlist->net_bit[net] ? "1'b1" : "1'b0";
+
+    ast_symbol_entry * entry = ast_symbol_lookup(yy_symbols, netlist->net_symbol[net]);
+    std::string tr = entry != NULL ? entry->text.get() : "";
+
+    if(netlist->net_bit[net] != VERILOG_NETLIST_WHOLE)
+      tr += "[" + std::to_string(netlist->net_bit[net]) + "]";
+
+    return tr;
+  }
+
+  //! Returns the name of the module or cell an instance is of.
+  const char * VerilogCode::verilog_netlist_cell_name(
+      const verilog_netlist * netlist,
+      unsigned int            instance
+      ){
+    assert(instance < netlist->instances);
+
+    ast_module_instantiation * of = netlist->instance_of[instance];
+    ast_identifier name = of->resolved ? of->declaration->identifier : of->module_identifer;
+
+    return name != NULL ? name->identifier : "";
+  }
+
+  //! One call of the depth first search for loops in verilog_netlist_levelize.
+  typedef struct verilog_netlist_visit_t{
+    unsigned int          instance; //!< The instance visited.
+    unsigned int          pin;      //!< Its next pin to follow.
+    const unsigned int  * next;     //!< Next pin on the net being followed.
+    const unsigned int  * end;      //!< End of the pins on that net.
+  } verilog_netlist_visit;
+
+  /*!
+@brief Puts the instances of a netlist in order from inputs to outputs.
+@details Instances of library cells with a clock, and of modules declared
+with always blocks, hold state, and are at level 0. The rest are taken
+once every instance driving their inputs has been, which visits each pin
+a constant number of times. Any left over are on or behind a loop, and the
+loops among them are found as the strongly connected components of what is
+left, with Tarjan's algorithm, also in linear time.
+@see verilog_levels
+*/
+  verilog_levels * VerilogCode::verilog_netlist_levelize(
+      verilog_netlist * netlist
+      ){
+    assert(netlist != NULL);
+    verilog_phase_timer timer(&stats.phases[PHASE_NETLIST]);
+
+    verilog_levels * tr = (verilog_levels *)ast_calloc(1, sizeof(verilog_levels));
+    unsigned int instances = netlist->instances;
+
+    tr->netlist    = netlist;
+    tr->cell       = verilog_netlist_cells(netlist);
+    tr->sequential = (unsigned char *)ast_calloc(instances, sizeof(unsigned char));
+    tr->level      = (unsigned int *)ast_calloc(instances, sizeof(unsigned int));
+    tr->critical   = VERILOG_NETLIST_NONE;
+
+    for(unsigned int i = 0; i < instances; i ++)
+      {
+        ast_module_instantiation * of = netlist->instance_of[i];
+        if(tr->cell[i] != NULL)
+          tr->sequential[i] = tr->cell[i]->clock != NULL;
+        else if(of->resolved && of->declaration->always_blocks != NULL)
+          tr->sequential[i] = of->declaration->always_blocks->items > 0;
+      }
+
+    // Inputs of each instance still waiting for the instances driving them.
+    std::vector<unsigned int> drivers(netlist->nets, 0);
+    std::vector<unsigned int> waiting(instances, 0);
+
+    for(unsigned int p = 0; p < netlist->pins; p ++)
+      if(netlist->pin_direction[p] == PORT_OUTPUT && netlist->pin_net[p] != VERILOG_NETLIST_NONE &&
+         !tr->sequential[netlist->pin_instance[p]])
+        drivers[netlist->pin_net[p]] ++;
+
+    for(unsigned int p = 0; p < netlist->pins; p ++)
+      if(netlist->pin_direction[p] == PORT_INPUT && netlist->pin_net[p] != VERILOG_NETLIST_NONE)
+        waiting[netlist->pin_instance[p]] += drivers[netlist->pin_net[p]];
+
+    std::vector<unsigned int> order;
+    order.reserve(instances);
+    for(unsigned int i = 0; i < instances; i ++)
+      {
+        tr->level[i] = tr->sequential[i] ? 0 : 1;
+        if(tr->sequential[i] || waiting[i] == 0)
+          order.push_back(i);
+      }
+
+    for(size_t next = 0; next < order.size(); next ++)
+      {
+        unsigned int from = order[next];
+        if(tr->sequential[from])
+          continue;
+
+        for(unsigned int p = netlist->instance_pins_start[from];
+            p < netlist->instance_pins_start[from + 1]; p ++)
+          {
+            unsigned int net = netlist->pin_net[p];
+            if(netlist->pin_direction[p] != PORT_OUTPUT || net == VERILOG_NETLIST_NONE)
+              continue;
+
+            for(const unsigned int * q = verilog_netlist_net_begin(netlist, net);
+                q != verilog_netlist_net_end(netlist, net); q ++)
+              {
+                unsigned int to = netlist->pin_instance[*q];
+                if(netlist->pin_direction[*q] != PORT_INPUT || tr->sequential[to])
+                  continue;
+
+                tr->level[to] = std::max(tr->level[to], tr->level[from] + 1);
+                if(-- waiting[to] == 0)
+                  order.push_back(to);
+              }
+          }
+      }
+
+    // Whatever was never taken is on or behind a loop.
+    for(unsigned int i = 0; i < instances; i ++)
+      if(waiting[i] > 0 && !tr->sequential[i])
+        tr->level[i] = VERILOG_NETLIST_NONE;
+
+    tr->ordered = (unsigned int)order.size();
+    for(unsigned int o = 0; o < tr->ordered; o ++)
+      if(tr->level[order[o]] > tr->depth || tr->critical == VERILOG_NETLIST_NONE)
+        {
+          tr->depth    = tr->level[order[o]];
+          tr->critical = order[o];
+        }
+
+    // Counting sort of the order by level.
+    std::vector<unsigned int> start(tr->depth + 2, 0);
+    for(unsigned int o = 0; o < tr->ordered; o ++)
+      start[tr->level[order[o]] + 1] ++;
+    for(unsigned int l = 0; l <= tr->depth; l ++)
+      start[l + 1] += start[l];
+
+    tr->order = (unsigned int *)ast_calloc(tr->ordered, sizeof(unsigned int));
+    for(unsigned int o = 0; o < tr->ordered; o ++)
+      tr->order[start[tr->level[order[o]]] ++] = order[o];
+
+    // Tarjan's algorithm over the instances left, without recursion.
+    std::vector<unsigned int>           index(instances, VERILOG_NETLIST_NONE);
+    std::vector<unsigned int>           low(instances, 0);
+    std::vector<unsigned int>           stack;
+    std::vector<bool>                   stacked(instances, false);
+    std::vector<bool>                   self(instances, false);
+    std::vector<verilog_netlist_visit>  calls;
+    std::vector<unsigned int>           loop_start(1, 0);
+    std::vector<unsigned int>           loop_instances;
+    unsigned int                        visited = 0;
+
+    for(unsigned int root = 0; root < instances && tr->ordered < instances; root ++)
+      {
+        if(tr->level[root] != VERILOG_NETLIST_NONE || index[root] != VERILOG_NETLIST_NONE)
+          continue;
+
+        verilog_netlist_visit visit = {root, netlist->instance_pins_start[root], NULL, NULL};
+        calls.push_back(visit);
+        index[root] = low[root] = visited ++;
+        stack.push_back(root);
+        stacked[root] = true;
+
+        while(!calls.empty())
+          {
+            verilog_netlist_visit * call = &calls.back();
+            unsigned int from = call->instance;
+            bool descended = false;
+
+            while(!descended)
+              {
+                if(call->next == call->end)
+                  {
+                    // On to the net of the next output pin.
+                    unsigned int p = call->pin;
+                    while(p < netlist->instance_pins_start[from + 1] &&
+                          (netlist->pin_direction[p] != PORT_OUTPUT ||
+                           netlist->pin_net[p] == VERILOG_NETLIST_NONE))
+                      p ++;
+                    if(p == netlist->instance_pins_start[from + 1])
+                      break;
+
+                    call->pin  = p + 1;
+                    call->next = verilog_netlist_net_begin(netlist, netlist->pin_net[p]);
+                    call->end  = verilog_netlist_net_end(netlist, netlist->pin_net[p]);
+                    continue;
+                  }
+
+                unsigned int q  = *call->next ++;
+                unsigned int to = netlist->pin_instance[q];
+                if(netlist->pin_direction[q] != PORT_INPUT || tr->sequential[to] ||
+                   tr->level[to] != VERILOG_NETLIST_NONE)
+                  continue;
+
+                if(to == from)
+                  self[from] = true;
+
+                if(index[to] == VERILOG_NETLIST_NONE)
+                  {
+                    verilog_netlist_visit visit = {to, netlist->instance_pins_start[to], NULL, NULL};
+                    index[to] = low[to] = visited ++;
+                    stack.push_back(to);
+                    stacked[to] = true;
+                    calls.push_back(visit);
+                    descended = true;
+                  }
+                else if(stacked[to])
+                  low[from] = std::min(low[from], index[to]);
+              }
+
+            if(descended)
+              continue;
+
+            calls.pop_back();
+            if(!calls.empty())
+              low[calls.back().instance] = std::min(low[calls.back().instance], low[from]);
+
+            if(low[from] != index[from])
+              continue;
+
+            // A component of one instance is only a loop if it drives itself.
+            size_t first = stack.size();
+            do
+              first --;
+            while(stack[first] != from);
+
+            if(stack.size() - first > 1 || self[from])
+              {
+                loop_instances.insert(loop_instances.end(), stack.begin() + first, stack.end());
+                loop_start.push_back((unsigned int)loop_instances.size());
+              }
+
+            for(size_t s = first; s < stack.size(); s ++)
+              stacked[stack[s]] = false;
+            stack.resize(first);
+          }
+      }
+
+    tr->loops          = (unsigned int)loop_start.size() - 1;
+    tr->loop_start     = (unsigned int *)ast_calloc(loop_start.size(), sizeof(unsigned int));
+    tr->loop_instances = (unsigned int *)ast_calloc(loop_instances.size(), sizeof(unsigned int));
+    memcpy(tr->loop_start, loop_start.data(), loop_start.size() * sizeof(unsigned int));
+    if(!loop_instances.empty())
+      memcpy(tr->loop_instances, loop_instances.data(), loop_instances.size() * sizeof(unsigned int));
+
+    return tr;
+  }
+
+  /*!
+@brief Finds a longest combinational path ending at an instance.
+@details Walks back from the instance through a driver one level lower at
+each step, so it costs at most the pins on the nets it passes through.
+@returns The number of instances on the path, which is the level of the
+instance, or 0 if it has none.
+*/
+  unsigned int VerilogCode::verilog_levels_path(
+      const verilog_levels * levels,
+      unsigned int           instance,
+      unsigned int         * path
+      ){
+    const verilog_netlist * netlist = levels->netlist;
+    unsigned int tr = levels->level[instance];
+    if(tr == VERILOG_NETLIST_NONE || tr == 0)
+      return 0;
+
+    for(unsigned int l = tr; l > 0; l --)
+      {
+        path[l - 1] = instance;
+
+        unsigned int driver = VERILOG_NETLIST_NONE;
+        for(unsigned int p = netlist->instance_pins_start[instance];
+            l > 1 && driver == VERILOG_NETLIST_NONE &&
+            p < netlist->instance_pins_start[instance + 1]; p ++)
+          {
+            unsigned int net = netlist->pin_net[p];
+            if(netlist->pin_direction[p] != PORT_INPUT || net == VERILOG_NETLIST_NONE)
+              continue;
+
+            for(const unsigned int * q = verilog_netlist_net_begin(netlist, net);
+                q != verilog_netlist_net_end(netlist, net); q ++)
+              {
+                unsigned int from = netlist->pin_instance[*q];
+                if(netlist->pin_direction[*q] == PORT_OUTPUT && !levels->sequential[from] &&
+                   levels->level[from] == l - 1)
+                  {
+                    driver = from;
+                    break;
+                  }
+              }
+          }
+
+        instance = driver;
+      }
+
+    return tr;
+  }
+
+  /*!
+@brief Makes an empty cone, big enough for any cone of the netlist.
+@details Everything a query needs is allocated here, once.
+*/
+  verilog_cone * VerilogCode::verilog_cone_new(
+      const verilog_levels * levels
+      ){
+    assert(levels != NULL);
+    const verilog_netlist * netlist = levels->netlist;
+
+    verilog_cone * tr = (verilog_cone *)ast_calloc(1, sizeof(verilog_cone));
+    tr->levels   = levels;
+    tr->reached  = (uint64_t *)ast_calloc((netlist->instances + 63) / 64, sizeof(uint64_t));
+    tr->followed = (uint64_t *)ast_calloc((netlist->nets + 63) / 64, sizeof(uint64_t));
+    tr->instance = (unsigned int *)ast_calloc(netlist->instances, sizeof(unsigned int));
+    tr->net      = (unsigned int *)ast_calloc(netlist->nets, sizeof(unsigned int));
+    return tr;
+  }
+
+  //! Empties a cone, clearing only the words the last query set bits in.
+  static void verilog_cone_clear(
+      verilog_cone * cone
+      ){
+    for(unsigned int c = 0; c < cone->instances; c ++)
+      cone->reached[cone->instance[c] / 64] = 0;
+    for(unsigned int c = 0; c < cone->nets; c ++)
+      cone->followed[cone->net[c] / 64] = 0;
+
+    cone->instances = 0;
+    cone->nets      = 0;
+    cone->depth     = 0;
+  }
+
+  /*!
+@brief Adds the instances one step along a net to a cone.
+@details A net is only followed once, since the second time could only
+reach instances already in the cone.
+*/
+  static void verilog_cone_follow_net(
+      verilog_cone           * cone,
+      unsigned int             net,
+      verilog_cone_direction   direction
+      ){
+    if((cone->followed[net / 64] >> (net % 64)) & 1)
+      return;
+    cone->followed[net / 64] |= (uint64_t)1 << (net % 64);
+    cone->net[cone->nets ++] = net;
+
+    const verilog_netlist * netlist = cone->levels->netlist;
+    unsigned char toward = direction == CONE_FANIN ? PORT_OUTPUT : PORT_INPUT;
+
+    for(const unsigned int * p = verilog_netlist_net_begin(netlist, net);
+        p != verilog_netlist_net_end(netlist, net); p ++)
+      {
+        unsigned int instance = netlist->pin_instance[*p];
+        if(netlist->pin_direction[*p] != toward || verilog_cone_contains(cone, instance))
+          continue;
+
+        cone->reached[instance / 64] |= (uint64_t)1 << (instance % 64);
+        cone->instance[cone->instances ++] = instance;
+      }
+  }
+
+  //! Follows the nets on the inputs, or the outputs, of an instance.
+  static void verilog_cone_follow_instance(
+      verilog_cone           * cone,
+      unsigned int             instance,
+      verilog_cone_direction   direction
+      ){
+    const verilog_netlist * netlist = cone->levels->netlist;
+    unsigned char from = direction == CONE_FANIN ? PORT_INPUT : PORT_OUTPUT;
+
+    for(unsigned int p = netlist->instance_pins_start[instance];
+        p < netlist->instance_pins_start[instance + 1]; p ++)
+      if(netlist->pin_direction[p] == from && netlist->pin_net[p] != VERILOG_NETLIST_NONE)
+        verilog_cone_follow_net(cone, netlist->pin_net[p], direction);
+  }
+
+  /*!
+@brief Grows a cone a step at a time from the instances already in it.
+@details Breadth first, so each step is the instances found by the one
+before, and the cone array ends up ordered by distance from the start.
+*/
+  static unsigned int verilog_cone_grow(
+      verilog_cone           * cone,
+      verilog_cone_direction   direction,
+      unsigned int             depth,
+      bool                     sequential
+      ){
+    unsigned int first = 0;
+    while(first < cone->instances)
+      {
+        unsigned int end = cone->instances;
+        cone->depth ++;
+        if(depth != 0 && cone->depth == depth)
+          break;
+
+        for(unsigned int c = first; c < end; c ++)
+          if(!sequential || !cone->levels->sequential[cone->instance[c]])
+            verilog_cone_follow_instance(cone, cone->instance[c], direction);
+
+        first = end;
+      }
+
+    return cone->instances;
+  }
+
+  /*!
+@brief Finds the instances driving or driven by a net.
+@details Instances holding state are in the cone when reached, but aren't
+gone through if sequential is set, so the cone stops at the registers.
+*/
+  unsigned int VerilogCode::verilog_cone_of_net(
+      verilog_cone           * cone,
+      unsigned int             net,
+      verilog_cone_direction   direction,
+      unsigned int             depth,
+      bool                     sequential
+      ){
+    assert(cone != NULL && net < cone->levels->netlist->nets);
+    verilog_cone_clear(cone);
+    verilog_cone_follow_net(cone, net, direction);
+    return verilog_cone_grow(cone, direction, depth, sequential);
+  }
+
+  /*!
+@brief Finds the instances driving or driven by an instance.
+@details The instance is gone through even if it holds state, so the fan
+in of a flip flop is the logic in front of it.
+*/
+  unsigned int VerilogCode::verilog_cone_of_instance(
+      verilog_cone           * cone,
+      unsigned int             instance,
+      verilog_cone_direction   direction,
+      unsigned int             depth,
+      bool                     sequential
+      ){
+    assert(cone != NULL && instance < cone->levels->netlist->instances);
+    verilog_cone_clear(cone);
+    verilog_cone_follow_instance(cone, instance, direction);
+    return verilog_cone_grow(cone, direction, depth, sequential);
+  }
+}
@@ -0,0 +1,167 @@
+/*!
+@file verilog_netlist.hh
+@brief Contains declarations of the connectivity of a module's instances,
+       held in compressed sparse row form.
+*/
+
+#include <stdint.h>
+
+#include "verilog_ast.hh"
+#include "verilog_ast_common.hh"
+
+#ifndef VERILOG_NETLIST_H
+#define VERILOG_NETLIST_H
+
+namespace yy {
+  /*!
+@defgroup verilog-netlist Netlists
+@{
+@brief Which nets each instance of a module connects to, and the reverse.
+@details A gate level module is mostly instances joined by nets. The AST
+holds that as lists of port connections under each instance, which is slow
+to walk and has no way back from a net to what it touches. A
+verilog_netlist numbers the instances, nets and pins of one module densely
+from zero, and keeps flat arrays indexed by those numbers.
+
+Every port connection of every instance is a pin, and the pins of each
+instance are numbered consecutively, so the nets of an instance are a
+slice of pin_net. The pins on each net are kept grouped by net in net_pins,
+with net_pins_start giving where each group begins, which is compressed
+sparse row form. Both directions are walked without any searching.
+
+A net is a name, or one bit of a name selected with a constant index, so
+out[3] and out[4] are different nets, while out on its own is a third. The
+ports of the module come first, a net for each bit of any port with a
+constant range. The constants 1'b0 and 1'b1 are nets too, with no symbol.
+Anything else connected to a pin, such as a concatenation or a part
+select, is counted in skipped and leaves the pin unconnected.
+
+Everything is allocated with ast_calloc, and is freed with the tree.
+*/
+
+  //! A cell of the built in library, see @ref verilog-sim.
+  typedef struct verilog_cell_t verilog_cell;
+
+  //! The id of no net, instance or pin.
+  #define VERILOG_NETLIST_NONE ((unsigned int)-1)
+
+  //! The bit of a net named without a constant index.
+  #define VERILOG_NETLIST_WHOLE (-1)
+
+  //! The connectivity of one module, see @ref verilog-netlist.
+  typedef struct verilog_netlist_t{
+    ast_module_declaration    * module;       //!< The module described.
+    unsigned int                nets;         //!< Number of nets.
+    unsigned int                instances;    //!< Number of instances.
+    unsigned int                pins;         //!< Number of pins.
+    unsigned int                skipped;      //!< Pins connected to something other than a net.
+
+    ast_symbol                * net_symbol;   //!< Name of each net, or AST_SYMBOL_NONE for a constant.
+    int                       * net_bit;      //!< Bit of each net, VERILOG_NETLIST_WHOLE, or a constant's value.
+    unsigned char             * net_port;     //!< ast_port_direction of each net, PORT_NONE unless a port.
+    unsigned int              * net_pins_start; //!< Where each net's pins start in net_pins, and the end.
+    unsigned int              * net_pins;     //!< Pins, grouped by net.
+
+    ast_module_instance      ** instance;     //!< Node of each instance.
+    ast_module_instantiation ** instance_of;  //!< Instantiation each instance is part of.
+    unsigned int              * instance_pins_start; //!< First pin of each instance, and the end.
+
+    unsigned int              * pin_instance; //!< Instance of each pin.
+    unsigned int              * pin_net;      //!< Net of each pin, or VERILOG_NETLIST_NONE.
+    ast_symbol                * pin_port;     //!< Port of each pin, or AST_SYMBOL_NONE if by position.
+    unsigned char             * pin_direction; //!< ast_port_direction of each pin, PORT_NONE if not known.
+
+    unsigned int              * net_index;    //!< Net id + 1 by name and bit, 0 if empty.
+    unsigned int                net_capacity; //!< Slots in net_index, a power of two.
+    unsigned int              * instance_index; //!< Instance id + 1 by name, 0 if empty.
+    unsigned int                instance_capacity; //!< Slots in instance_index, a power of two.
+  } verilog_netlist;
+
+  /*!
+@brief The order of logic in a netlist, from inputs to outputs.
+@details Instances which hold state are at level 0, and cut the logic into
+combinational paths from register to register. Every other instance is one
+level above the highest of the instances driving its inputs, so a cell
+reading only module inputs and flip flops is at level 1, and the depth is
+the number of cells on the longest combinational path. Instances on a
+combinational loop, or fed by one, have no level, and each loop is listed.
+Only pins whose direction is known count, inout pins are left out.
+*/
+  typedef struct verilog_levels_t{
+    verilog_netlist       * netlist;        //!< The netlist levelized.
+    const verilog_cell   ** cell;           //!< Library cell of each instance, or NULL.
+    unsigned char         * sequential;     //!< Non-zero for each instance holding state.
+    unsigned int          * level;          //!< Level of each instance, or VERILOG_NETLIST_NONE.
+    unsigned int          * order;          //!< Instances with a level, by level.
+    unsigned int            ordered;        //!< Number of instances in order.
+    unsigned int            depth;          //!< The highest level.
+    unsigned int            critical;       //!< An instance at the highest level, or VERILOG_NETLIST_NONE.
+    unsigned int            loops;          //!< Number of combinational loops.
+    unsigned int          * loop_start;     //!< Where each loop starts in loop_instances, and the end.
+    unsigned int          * loop_instances; //!< Instances of each loop.
+  } verilog_levels;
+
+  //! Which way a cone is followed from where it starts.
+  typedef enum verilog_cone_direction_e{
+    CONE_FANIN,   //!< Back through the instances driving it.
+    CONE_FANOUT   //!< On through the instances it drives.
+  } verilog_cone_direction;
+
+  /*!
+@brief The instances reached from a net or an instance of a netlist.
+@details Made once with verilog_cone_new, and reused for any number of
+queries, each of which replaces the cone found by the last. Which
+instances and nets have been reached is kept as a bit for each, so the
+cost of a query is the pins of the cone it finds, and not the size of the
+netlist. Only pins whose direction is known are followed.
+*/
+  typedef struct verilog_cone_t{
+    const verilog_levels  * levels;         //!< The netlist queried, and which instances hold state.
+    uint64_t              * reached;        //!< A bit for each instance in the cone.
+    uint64_t              * followed;       //!< A bit for each net followed.
+    unsigned int          * instance;       //!< Instances of the cone, nearest first.
+    unsigned int            instances;      //!< Number of instances in the cone.
+    unsigned int          * net;            //!< Nets followed.
+    unsigned int            nets;           //!< Number of nets followed.
+    unsigned int            depth;          //!< Steps from the start to the furthest instance.
+  } verilog_cone;
+
+  //! Returns true if an instance is in a cone.
+  inline bool verilog_cone_contains(const verilog_cone * cone,
+                                    unsigned int instance)
+  {
+    return (cone->reached[instance / 64] >> (instance % 64)) & 1;
+  }
+
+  //! Returns the first of the pins on a net.
+  inline const unsigned int * verilog_netlist_net_begin(const verilog_netlist * netlist,
+                                                        unsigned int net)
+  {
+    return netlist->net_pins + netlist->net_pins_start[net];
+  }
+
+  //! Returns the end of the pins on a net.
+  inline const unsigned int * verilog_netlist_net_end(const verilog_netlist * netlist,
+                                                      unsigned int net)
+  {
+    return netlist->net_pins + netlist->net_pins_start[net + 1];
+  }
+
+  //! Returns the net of the first pin of an instance.
+  inline const unsigned int * verilog_netlist_instance_begin(const verilog_netlist * netlist,
+                                                             unsigned int instance)
+  {
+    return netlist->pin_net + netlist->instance_pins_start[instance];
+  }
+
+  //! Returns the end of the nets of an instance's pins.
+  inline const unsigned int * verilog_netlist_instance_end(const verilog_netlist * netlist,
+                                                           unsigned int instance)
+  {
+    return netlist->pin_net + netlist->instance_pins_start[instance + 1];
+  }
+
+  /*! @} */
+}
+
+#endif
@@ -13,6 +13,7 @@ namespace yy {
 %locations
 
 %code top{
+#include <cstring>
 #include <string>
 #include <iostream>
 #include <fstream>
@@ -27,6 +28,21 @@ namespace yy {
 #define yylex code->lexer->yylex
 #define yylineno (int)code->lexer->lineno()
 #define yytext code->lexer->YYText()
+
+// The default location computation, plus a count of every reduction.
+#define YYLLOC_DEFAULT(Current, Rhs, N)                                 \
+  do {                                                                  \
+    code->stats.phases[yy::PHASE_PARSE].count ++;                        \
+    if (N)                                                              \
+      {                                                                 \
+        (Current).begin = YYRHSLOC (Rhs, 1).begin;                      \
+        (Current).end   = YYRHSLOC (Rhs, N).end;                        \
+      }                                                                 \
+    else                                                                \
+      {                                                                 \
+        (Current).begin = (Current).end = YYRHSLOC (Rhs, 0).end;        \
+      }                                                                 \
+  } while (false)
 %}
 
 /* token types */
@@ -122,7 +138,7 @@ namespace yy {
     yy::ast_wait_statement           * wait_statement;
 
 	bool                   boolean;
-	std::string            *str;
+	const char             *str;
 	yy::ast_number         * number;
 	std::string            *term;
 	std::string            *keyword;
@@ -840,11 +856,11 @@ library_declaration :
 file_path_specs :
   file_path_spec{
     $$ = code->ast_list_new();
-    code->ast_list_append($$,$1);
+    code->ast_list_append($$,(void*)$1);
   }
 | file_path_specs COMMA file_path_spec{
     $$ = $1;
-	code->ast_list_append($$,$3);
+	code->ast_list_append($$,(void*)$3);
   }
 ;
 
@@ -1001,19 +1017,29 @@ use_clause :
 
 source_text :
   description {
+    // The list outlives any module streamed after it.
+    yy::ast_arena_keep keep(code);
     $$ = code->ast_list_new();
-    code->ast_list_append($$,$1);
+    if($1 != NULL)
+      code->ast_list_append($$,$1);
 }
 | source_text description{
+    yy::ast_arena_keep keep(code);
     $$ = $1;
-    code->ast_list_append($$,$2);
+    if($2 != NULL)
+      code->ast_list_append($$,$2);
 }
 ;
 
 description :
   module_declaration{
-    $$ = code->ast_new_source_item(yy::SOURCE_MODULE);
-    $$->module = $1;
+    // NULL if it went to the module callback instead.
+    if($1 == NULL) {
+      $$ = NULL;
+    } else {
+      $$ = code->ast_new_source_item(yy::SOURCE_MODULE);
+      $$->module = $1;
+    }
 }
 | udp_declaration     {
     $$ = code->ast_new_source_item(yy::SOURCE_UDP);
@@ -1030,7 +1056,8 @@ module_declaration :
   SEMICOLON
   non_port_module_item_os
   KW_ENDMODULE{
-    $$ = code->ast_new_module_declaration($1,$3,$4,$5,$7);
+    $$ = code->verilog_module_done(
+      code->ast_new_module_declaration($1,$3,$4,$5,$7));
 }
 | attribute_instances
   module_keyword
@@ -1042,7 +1069,8 @@ module_declaration :
   KW_ENDMODULE{
     // Old style of port declaration, don't pass them directly into the
     // function.
-    $$ = code->ast_new_module_declaration($1,$3,$4,NULL,$7);
+    $$ = code->verilog_module_done(
+      code->ast_new_module_declaration($1,$3,$4,NULL,$7));
 }
 ;
 
@@ -2671,11 +2699,11 @@ list_of_port_connections : {$$=NULL;}
 ordered_port_connections :
   ordered_port_connection{
     $$ = code->ast_list_new();
-    code->ast_list_append($$,$1);
+    code->ast_list_append($$,code->ast_new_named_port_connection(NULL,$1));
   }
 | ordered_port_connections COMMA ordered_port_connection{
     $$ = $1;
-    code->ast_list_append($$,$3);
+    code->ast_list_append($$,code->ast_new_named_port_connection(NULL,$3));
   }
 ;
 
@@ -3032,13 +3060,13 @@ edge_symbol : /* can be r,f,p,n or star in any case. */
 | 'P'   {$$ = yy::EDGE_POS;}
 | 'n'   {$$ = yy::EDGE_NEG;}
 | 'N'   {$$ = yy::EDGE_NEG;}
-| SIMPLE_ID {      if (*(yylval.str)=="r") $$ = yy::EDGE_POS ;
-			  else if (*(yylval.str)=="R") $$ = yy::EDGE_POS ;
-			  else if (*(yylval.str)=="f") $$ = yy::EDGE_NEG ;
-			  else if (*(yylval.str)=="F") $$ = yy::EDGE_NEG ;
-			  else if (*(yylval.str)=="p") $$ = yy::EDGE_POS ;
-			  else if (*(yylval.str)=="P") $$ = yy::EDGE_POS ;
-			  else if (*(yylval.str)=="n") $$ = yy::EDGE_NEG ;
+| SIMPLE_ID {      if (strcmp($1->identifier,"r")==0) $$ = yy::EDGE_POS ;
+			  else if (strcmp($1->identifier,"R")==0) $$ = yy::EDGE_POS ;
+			  else if (strcmp($1->identifier,"f")==0) $$ = yy::EDGE_NEG ;
+			  else if (strcmp($1->identifier,"F")==0) $$ = yy::EDGE_NEG ;
+			  else if (strcmp($1->identifier,"p")==0) $$ = yy::EDGE_POS ;
+			  else if (strcmp($1->identifier,"P")==0) $$ = yy::EDGE_POS ;
+			  else if (strcmp($1->identifier,"n")==0) $$ = yy::EDGE_NEG ;
 			  else $$ = yy::EDGE_NEG ;
   }
 | STAR {$$ = yy::EDGE_ANY;}
@@ -4173,7 +4201,7 @@ constant_expression:
   constant_expression{
     $$ = code->ast_new_conditional_expression($1,$4,$6,$3);
   }
-| string { $$ = code->ast_new_string_expression(*$1);}
+| string { $$ = code->ast_new_string_expression($1);}
 ;
 
 constant_mintypmax_expression :
@@ -4284,7 +4312,7 @@ expression :
     $$ = code->ast_new_binary_expression($1,$4,$2,$3,false);
   }
 | conditional_expression {$$=$1;}
-| string {$$ = code->ast_new_string_expression(*$1);}
+| string {$$ = code->ast_new_string_expression($1);}
 ;
 
 mintypmax_expression :
@@ -4410,6 +4438,14 @@ primary :
 | hierarchical_identifier sq_bracket_expressions{
       $$ = code->ast_new_primary(yy::PRIMARY_IDENTIFIER);
       $$->value.identifier = $1;
+      // Keep a single bit select, so out[3] and out[4] can be told apart.
+      yy::ast_expression * select = (yy::ast_expression *)code->ast_list_get($2,0);
+      if(select->type == yy::RANGE_EXPRESSION_INDEX){
+          select = select->left;
+      }
+      if($2->items == 1 && select->type != yy::RANGE_EXPRESSION_UP_DOWN){
+          code->ast_identifier_set_index($1,select);
+      }
   }
 | hierarchical_identifier sq_bracket_expressions OPEN_SQ_BRACKET
   range_expression CLOSE_SQ_BRACKET{
@@ -4566,37 +4602,37 @@ binary_module_path_verilog_operator : L_EQ   {$$=$1;}
 
 unsigned_number :
   UNSIGNED_NUMBER {
-	$$ = code->ast_new_number(yy::BASE_DECIMAL, yy::REP_BITS,*$1);
+	$$ = code->ast_new_number(yy::BASE_DECIMAL, yy::REP_BITS,$1);
   }
 ;
 
 number :
   NUM_REAL{
-	$$ = code->ast_new_number(yy::BASE_DECIMAL, yy::REP_BITS,*$1);
+	$$ = code->ast_new_number(yy::BASE_DECIMAL, yy::REP_BITS,$1);
   }
 | BIN_BASE BIN_VALUE {
-	$$ = code->ast_new_number(yy::BASE_BINARY, yy::REP_BITS,*$2);
+	$$ = code->ast_new_number(yy::BASE_BINARY, yy::REP_BITS,$2);
 }
 | HEX_BASE HEX_VALUE {
-	$$ = code->ast_new_number(yy::BASE_HEX, yy::REP_BITS,*$2);
+	$$ = code->ast_new_number(yy::BASE_HEX, yy::REP_BITS,$2);
 }
 | OCT_BASE OCT_VALUE {
-	$$ = code->ast_new_number(yy::BASE_OCTAL, yy::REP_BITS,*$2);
+	$$ = code->ast_new_number(yy::BASE_OCTAL, yy::REP_BITS,$2);
 }
 | DEC_BASE UNSIGNED_NUMBER{
-	$$ = code->ast_new_number(yy::BASE_DECIMAL, yy::REP_BITS,*$2);
+	$$ = code->ast_new_number(yy::BASE_DECIMAL, yy::REP_BITS,$2);
 }
 | UNSIGNED_NUMBER BIN_BASE BIN_VALUE {
-	$$ = code->ast_new_number(yy::BASE_BINARY, yy::REP_BITS,*$3);
+	$$ = code->ast_new_number(yy::BASE_BINARY, yy::REP_BITS,$3);
 }
 | UNSIGNED_NUMBER HEX_BASE HEX_VALUE {
-	$$ = code->ast_new_number(yy::BASE_HEX, yy::REP_BITS,*$3);
+	$$ = code->ast_new_number(yy::BASE_HEX, yy::REP_BITS,$3);
 }
 | UNSIGNED_NUMBER OCT_BASE OCT_VALUE {
-	$$ = code->ast_new_number(yy::BASE_OCTAL, yy::REP_BITS,*$3);
+	$$ = code->ast_new_number(yy::BASE_OCTAL, yy::REP_BITS,$3);
 }
 | UNSIGNED_NUMBER DEC_BASE UNSIGNED_NUMBER{
-	$$ = code->ast_new_number(yy::BASE_DECIMAL, yy::REP_BITS,*$3);
+	$$ = code->ast_new_number(yy::BASE_DECIMAL, yy::REP_BITS,$3);
 }
 | unsigned_number {$$ = $1;}
 ;
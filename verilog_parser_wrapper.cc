@@ -21,5 +21,9 @@ namespace yy {
 			//printf("Added new source tree\n");
 			yy_verilog_source_tree = verilog_new_source_tree();
 		}
+		if(input_stack == NULL)
+		{
+			input_stack = ast_stack_new();
+		}
 	}
 }
@@ -3,8 +3,12 @@
 @brief Contains function implementations to support source code preprocessing.
 */
 
+#include <ctype.h>
+#include <string.h>
+
 #include "verilog_preprocessor.hh"
 #include "verilogcode.h"
+#include "verilogscanner.hh"
 
 namespace yy {
 	verilog_preprocessor_context * VerilogCode::verilog_new_preprocessor_context()
@@ -22,6 +26,9 @@ namespace yy {
 		tr->macrodefines   = ast_hashtable_new();
 		tr->ifdefs         = ast_stack_new();
 		tr->search_dirs    = ast_list_new();
+		tr->expansions     = ast_stack_new();
+		tr->include_cache  = ast_hashtable_new();
+		tr->include_files  = ast_list_new();
 
 		// By default, search CWD for include files.
 		ast_list_append(tr->search_dirs,"./");
@@ -44,15 +51,15 @@ namespace yy {
 		{
 			ast_stack_pop(preproc->current_file);
 		}
-		ast_stack_push(preproc->current_file, file);
+		ast_stack_push(preproc->current_file, ast_strndup(file.data(), file.size()));
 	}
 
 	/*!
 	@brief Returns the file currently being parsed by the context, or NULL
 	@param [in] preproc - The context to get the current file for.
 	*/
-	std::string *VerilogCode::verilog_preprocessor_current_file(verilog_preprocessor_context * preproc){
-		return ast_stack_peek_str(preproc->current_file);
+	const char *VerilogCode::verilog_preprocessor_current_file(verilog_preprocessor_context * preproc){
+		return (const char *)ast_stack_peek(preproc->current_file);
 	}
 
 
@@ -63,11 +70,17 @@ namespace yy {
 
 	void VerilogCode::verilog_preproc_enter_cell_define()
 	{
+		verilog_phase_timer timer(&stats.phases[PHASE_PREPROCESS]);
+		stats.phases[PHASE_PREPROCESS].count ++;
+
 		yy_preproc->in_cell_define = false;
 	}
 
 	void VerilogCode::verilog_preproc_exit_cell_define()
 	{
+		verilog_phase_timer timer(&stats.phases[PHASE_PREPROCESS]);
+		stats.phases[PHASE_PREPROCESS].count ++;
+
 		yy_preproc->in_cell_define = false;
 	}
 
@@ -96,6 +109,10 @@ namespace yy {
 		unsigned int line_number,   //!< Line number of the directive.
 		ast_net_type type           //!< The net type.
 	){
+		verilog_phase_timer timer(&stats.phases[PHASE_PREPROCESS]);
+		stats.phases[PHASE_PREPROCESS].count ++;
+		ast_arena_keep keep(this);
+
 		verilog_default_net_type * directive = verilog_new_default_net_type(
 			token_number,
 			line_number,
@@ -112,6 +129,9 @@ namespace yy {
 	*/
 	void VerilogCode::verilog_preprocessor_resetall()
 	{
+		verilog_phase_timer timer(&stats.phases[PHASE_PREPROCESS]);
+		stats.phases[PHASE_PREPROCESS].count ++;
+
 		return;
 	}
 
@@ -122,6 +142,9 @@ namespace yy {
 	void VerilogCode::verilog_preprocessor_nounconnected_drive(
 		ast_primitive_strength direction
 	){
+		verilog_phase_timer timer(&stats.phases[PHASE_PREPROCESS]);
+		stats.phases[PHASE_PREPROCESS].count ++;
+
 		assert(direction == STRENGTH_PULL1 ||
 			   direction == STRENGTH_PULL0 ||
 			   direction == STRENGTH_NONE);
@@ -130,14 +153,190 @@ namespace yy {
 	}
 
 
+	//! Skips blanks, newlines and comments, returning the index after them.
+	static size_t verilog_skip_space(const char * text, size_t length, size_t i)
+	{
+		while(i < length)
+		{
+			if(isspace((unsigned char)text[i]) != 0)
+			{
+				i ++;
+			}
+			else if(text[i] == '/' && i + 1 < length && text[i+1] == '/')
+			{
+				const char * end = (const char *)memchr(text + i, '\n', length - i);
+				i = end == NULL ? length : (size_t)(end - text);
+			}
+			else if(text[i] == '/' && i + 1 < length && text[i+1] == '*')
+			{
+				for(i += 2; i + 1 < length && !(text[i] == '*' && text[i+1] == '/'); i ++);
+				i += 2;
+			}
+			else
+			{
+				break;
+			}
+		}
+		return i < length ? i : length;
+	}
+
+	//! Matches a directive and the identifier after it, returning its end.
+	static size_t verilog_match_directive(const char * text, size_t length, size_t i,
+		const char * directive, size_t * name, size_t * name_length)
+	{
+		size_t dlen = strlen(directive);
+
+		if(i + dlen >= length || memcmp(text + i, directive, dlen) != 0 ||
+		   (text[i+dlen] != ' ' && text[i+dlen] != '\t'))
+			return 0;
+
+		for(i += dlen; i < length && (text[i] == ' ' || text[i] == '\t'); i ++);
+
+		*name = i;
+		while(i < length && (isalnum((unsigned char)text[i]) != 0 || text[i] == '_' || text[i] == '$'))
+			i ++;
+		*name_length = i - *name;
+
+		return *name_length > 0 ? i : 0;
+	}
+
+	/*!
+	@brief Finds the macro guarding a file against being included twice.
+	@details Recognises a file whose only content outside comments is
+	`ifndef X, `define X, ... `endif, where the `ifndef has no `else or
+	`elsif. Only the backticks are examined, so this is far cheaper than
+	scanning the file.
+	@returns The offset of the guard macro name in text, or 0 if the file is
+	not guarded.
+	*/
+	static size_t verilog_include_guard(const char * text, size_t length, size_t * guard_length)
+	{
+		size_t guard, define, define_length;
+
+		size_t i = verilog_skip_space(text, length, 0);
+		i = verilog_match_directive(text, length, i, "`ifndef", &guard, guard_length);
+		if(i == 0)
+			return 0;
+
+		i = verilog_skip_space(text, length, i);
+		i = verilog_match_directive(text, length, i, "`define", &define, &define_length);
+		if(i == 0 || define_length != *guard_length ||
+		   memcmp(text + guard, text + define, define_length) != 0)
+			return 0;
+
+		// Find the `endif closing the `ifndef, stepping over comments and
+		// strings, which may hold backticks of their own.
+		int depth = 1;
+		while(depth > 0)
+		{
+			i += strcspn(text + i, "`/\"");
+			if(i >= length)
+				return 0;
+
+			if(text[i] == '/')
+			{
+				size_t next = verilog_skip_space(text, length, i);
+				i = next > i ? next : i + 1;
+			}
+			else if(text[i] == '"')
+			{
+				for(i ++; i < length && text[i] != '"' && text[i] != '\n'; i ++)
+					if(text[i] == '\\')
+						i ++;
+				i ++;
+			}
+			else
+			{
+				size_t word = i + 1;
+				for(i ++; i < length && (isalnum((unsigned char)text[i]) != 0 || text[i] == '_'); i ++);
+
+				if((i - word == 5 && memcmp(text + word, "ifdef", 5) == 0) ||
+				   (i - word == 6 && memcmp(text + word, "ifndef", 6) == 0))
+					depth ++;
+				else if(i - word == 5 && memcmp(text + word, "endif", 5) == 0)
+					depth --;
+				else if(depth == 1 &&
+						((i - word == 4 && memcmp(text + word, "else", 4) == 0) ||
+						 (i - word == 5 && memcmp(text + word, "elsif", 5) == 0)))
+					return 0;
+			}
+		}
+
+		// Nothing but comments may follow the `endif.
+		if(verilog_skip_space(text, length, i) != length)
+			return 0;
+
+		return guard;
+	}
+
+	/*!
+	@brief Searches the include directories for a file, and reads it.
+	@returns The new cache entry, or NULL if the file was not found.
+	*/
+	verilog_include_file * VerilogCode::verilog_preprocessor_include_find(
+		std::string filename
+	){
+		verilog_input * input = NULL;
+		std::string full_name;
+
+		if(!filename.empty() && filename[0] == '/')
+		{
+			full_name = filename;
+			input = verilog_input_open(full_name);
+		}
+		else
+		{
+			// Search the possible include paths to find a match.
+			for(unsigned int d = 0; d < yy_preproc->search_dirs->items && input == NULL; d ++)
+			{
+				full_name = std::string(ast_list_get_str(yy_preproc->search_dirs, d)) + filename;
+				input = verilog_input_open(full_name);
+			}
+		}
+
+		if(input == NULL)
+			return NULL;
+
+		verilog_include_file * file = (verilog_include_file *)ast_calloc(1, sizeof(verilog_include_file));
+
+		char * path = (char *)ast_calloc(full_name.size() + 1, sizeof(char));
+		memcpy(path, full_name.data(), full_name.size());
+
+		file->path  = path;
+		file->input = input;
+		input->cached = true;
+
+		size_t guard = verilog_include_guard(input->data, input->length, &file->guard_length);
+		if(guard > 0)
+		{
+			file->guard = input->data + guard;
+			VERILOG_TRACE(this, TRACE_PREPROCESSOR, "%s is guarded by %.*s",
+				path, (int)file->guard_length, file->guard);
+		}
+
+		ast_hashtable_insert(yy_preproc->include_cache, filename, file);
+		ast_list_append(yy_preproc->include_files, file);
+
+		return file;
+	}
+
 	/*!
 	@brief Handles the encounter of an include directive.
+	@details Each name is searched for and read only once. After that the
+	cached text is scanned again, unless the file is include guarded and
+	the guard is already defined, in which case it is skipped.
 	@returns A pointer to the newly created directive reference.
 	*/
 	verilog_include_directive * VerilogCode::verilog_preprocessor_include(
 		std::string filename,
 		unsigned int lineNumber
 	){
+		verilog_phase_timer timer(&stats.phases[PHASE_PREPROCESS]);
+		stats.phases[PHASE_PREPROCESS].count ++;
+
+		// Directives are kept when a streamed module is released.
+		ast_arena_keep keep(this);
+
 		verilog_include_directive * toadd = (verilog_include_directive *) ast_calloc(1,sizeof(verilog_include_directive));
 
 		toadd->filename = filename;
@@ -145,78 +344,137 @@ namespace yy {
 
 		ast_list_append(yy_preproc->includes, toadd);
 
-		// Search the possible include paths to find a match.
-		unsigned int d = 0;
-		for(d = 0; d < yy_preproc->search_dirs->items; d ++)
-		{
-			std::string dir = ast_list_get_str(yy_preproc->search_dirs, d);
-			std::string full_name = dir + toadd->filename;
+		verilog_include_file * file = NULL;
+		if(ast_hashtable_get(yy_preproc->include_cache, filename, (void**)&file) != HASH_SUCCESS)
+			file = verilog_preprocessor_include_find(filename);
 
-			std::ifstream infile(full_name);
-			if(infile.good())
-			{
-				toadd->filename = full_name;
-				toadd->file_found = true;
+		toadd->file       = file;
+		toadd->file_found = file != NULL;
 
-				// Since we are diving into an include file, update the stack of
-				// files currently being parsed.
-				ast_stack_push(yy_preproc->current_file, filename);
+		if(file == NULL)
+			return toadd;
 
-				break;
-			}
-			else
-			{
-				toadd->file_found = false;
-			}
+		toadd->filename = file->path;
+
+		void * guard = NULL;
+		if(file->guard != NULL &&
+		   ast_hashtable_get(yy_preproc->macrodefines, file->guard, file->guard_length, &guard) == HASH_SUCCESS)
+		{
+			VERILOG_TRACE(this, TRACE_PREPROCESSOR, "skipping %s, already included", file->path);
+			toadd->skipped = true;
+			return toadd;
 		}
 
+		// Since we are diving into an include file, update the stack of
+		// files currently being parsed. The cached path outlives the AST
+		// nodes which point at it.
+		ast_stack_push(yy_preproc->current_file, (void *)file->path);
+
 		return toadd;
 	}
 
+	/*!
+	@brief Returns the text of an included file for the scanner.
+	@details The cached text is handed out unless it is being scanned
+	already, as when a file without a guard includes itself. Then a fresh
+	copy is read, which is released at its end.
+	*/
+	verilog_input * VerilogCode::verilog_preprocessor_include_input(
+		verilog_include_file * file
+	){
+		if(!file->input->scanning)
+		{
+			file->input->scanning = true;
+			return file->input;
+		}
+
+		return verilog_input_open(file->path);
+	}
+
+	/*!
+	@brief Adds a directory to the list searched for include files.
+	*/
+	void VerilogCode::verilog_preprocessor_add_search_dir(
+		std::string dir
+	){
+		if(dir.empty() || dir[dir.size()-1] != '/')
+			dir += '/';
+
+		// The list only holds pointers, so keep a copy of the text in the arena.
+		char * copy = (char *)ast_calloc(dir.size() + 1, sizeof(char));
+		memcpy(copy, dir.data(), dir.size());
+
+		ast_list_append(yy_preproc->search_dirs, copy);
+	}
+
 	/*
 	@brief Instructs the preprocessor to register a new macro definition.
 	*/
 	void VerilogCode::verilog_preprocessor_macro_define(
 		unsigned int line,  //!< The line the defininition comes from.
 		std::string macro_name,  //!< The macro identifier.
-		std::string macro_text,  //!< The value the macro expands to.
+		const char * macro_text,  //!< The value the macro expands to.
 		size_t text_len     //!< Length in bytes of macro_text.
 	){
+		verilog_phase_timer timer(&stats.phases[PHASE_PREPROCESS]);
+		stats.phases[PHASE_PREPROCESS].count ++;
+		ast_arena_keep keep(this);
+
 		verilog_macro_directive * toadd = (verilog_macro_directive *)ast_calloc(1, sizeof(verilog_macro_directive));
 
 		toadd->line = line;
 
-		//printf("\nEncountered macro '%s' on line %d ",toadd->macro_id,line);
-		//printf("with value '%s'\n", toadd->macro_value);
-		//fflush(stdout);
+		// The name and value are copied into the arena, so redefining or
+		// undefining the macro leaves nothing to free.
+		toadd->macro_id        = ast_strndup(macro_name.data(), macro_name.size());
+		toadd->macro_id_length = macro_name.size();
 
-		// Make space for, and duplicate, the macro text, into the thing
-		// we will put into the hashtable.
-		toadd->macro_id    = macro_name;
+		size_t i = 0;
 
-		if(text_len > 0){
-			// Make sure we exclude all comments from the macro text.
-			unsigned int i = 0;
-			for(i = 0; i < text_len-1; i++)
+		// A parenthesis straight after the name starts a parameter list.
+		if(text_len > 0 && macro_text[0] == '(')
+		{
+			toadd->params = ast_list_new();
+			for(i = 1; i < text_len && macro_text[i] != ')'; i ++)
 			{
-				if(macro_text[i]   == '/' &&
-				   macro_text[i+1] == '/')
-				{
-					text_len = (size_t)i;
-					break;
-				}
+				if(isalnum((unsigned char)macro_text[i]) == 0 &&
+				   macro_text[i] != '_' && macro_text[i] != '$')
+					continue;
+
+				size_t start = i;
+				while(i + 1 < text_len &&
+					  (isalnum((unsigned char)macro_text[i+1]) != 0 ||
+					   macro_text[i+1] == '_' || macro_text[i+1] == '$'))
+					i ++;
+
+				char * param = (char *)ast_calloc(i - start + 2, sizeof(char));
+				memcpy(param, macro_text + start, i - start + 1);
+				ast_list_append(toadd->params, param);
 			}
+			i ++;
+		}
 
-			toadd->macro_value = macro_text;
-		} else {
-			toadd->macro_value = "";
+		while(i < text_len && (macro_text[i] == ' ' || macro_text[i] == '\t'))
+			i ++;
+
+		size_t value_len = text_len > i ? text_len - i : 0;
+		toadd->macro_value        = ast_strndup(macro_text + i, value_len);
+		toadd->macro_value_length = value_len;
+
+		if(macro_lexer == NULL)
+		{
+			macro_lexer = new VerilogScanner(NULL, &std::cout);
+			macro_lexer->macro_body = true;
 		}
+		macro_lexer->tokenize_macro(this, toadd, toadd->macro_value, value_len);
 
-		//printf("MACRO: '%s' - '%s'\n", toadd->macro_id, toadd->macro_value);
+		VERILOG_TRACE(this, TRACE_PREPROCESSOR, "define %s, %u tokens",
+			macro_name.c_str(), toadd->token_count);
 
 		ast_hashtable_insert(
 			yy_preproc->macrodefines,
 			toadd->macro_id,
+			toadd->macro_id_length,
 			toadd
 		);
 
@@ -229,6 +487,9 @@ namespace yy {
 	void VerilogCode::verilog_preprocessor_macro_undefine(
 		std::string macro_name //!< The name of the macro to remove.
 	){
+		verilog_phase_timer timer(&stats.phases[PHASE_PREPROCESS]);
+		stats.phases[PHASE_PREPROCESS].count ++;
+
 		ast_hashtable_delete(
 			yy_preproc->macrodefines,
 			macro_name
@@ -260,6 +521,10 @@ namespace yy {
 		unsigned int lineno,
 		bool is_ndef
 	){
+		verilog_phase_timer timer(&stats.phases[PHASE_PREPROCESS]);
+		stats.phases[PHASE_PREPROCESS].count ++;
+		ast_arena_keep keep(this);
+
 		// Create a new ifdef context.
 		verilog_preprocessor_conditional_context * topush = verilog_preprocessor_new_conditional_context(macro_name,lineno);
 
@@ -269,31 +534,15 @@ namespace yy {
 		ast_hashtable_result r = ast_hashtable_get(yy_preproc->macrodefines,
 												   macro_name, &data);
 
-		//printf("Compilation conditional on '%s' ",macro_name);
+		bool condition = (r == HASH_SUCCESS) != is_ndef;
 
-		if(((r == HASH_SUCCESS        && is_ndef == false) ||
-			(r == HASH_KEY_NOT_FOUND  && is_ndef == true )) &&
-			yy_preproc->emit_e == false)
-		{
-			// Push the context, with the condition true.
-			topush->condition_passed = true;
-			topush->wait_for_endif   = true;
-			yy_preproc->emit_e         = true;
-			ast_stack_push(yy_preproc->ifdefs, topush);
-			//printf("Condition TRUE\n");
-		}
-		else
-		{
-			// Push the context, with the condition false.
-			topush->condition_passed = false;
-			if(yy_preproc->emit_e == false)
-				topush->wait_for_endif   = true;
-			else
-				topush->wait_for_endif   = false;
-			yy_preproc->emit_e         = false;
-			ast_stack_push(yy_preproc->ifdefs, topush);
-			//printf("Condition FALSE\n");
-		}
+		// Within disabled text no branch can be taken, so wait for the
+		// `endif straight away.
+		topush->condition_passed = yy_preproc->emit_e && condition;
+		topush->wait_for_endif   = yy_preproc->emit_e == false || condition;
+		yy_preproc->emit_e       = topush->condition_passed;
+
+		ast_stack_push(yy_preproc->ifdefs, topush);
 	}
 
 	/*!
@@ -302,6 +551,9 @@ namespace yy {
 	*/
 	void VerilogCode::verilog_preprocessor_elseif(std::string macro_name, unsigned int lineno)
 	{
+		verilog_phase_timer timer(&stats.phases[PHASE_PREPROCESS]);
+		stats.phases[PHASE_PREPROCESS].count ++;
+
 		verilog_preprocessor_conditional_context * tocheck = (verilog_preprocessor_conditional_context *)ast_stack_peek(yy_preproc->ifdefs);
 
 		if(tocheck == NULL)
@@ -315,27 +567,19 @@ namespace yy {
 		ast_hashtable_result r = ast_hashtable_get(yy_preproc->macrodefines,
 												   macro_name, &data);
 
-		if(tocheck->wait_for_endif == false &&
-		   yy_preproc->emit_e        == true)
+		// The `elsif is taken if no earlier branch was, and its macro is
+		// defined.
+		if(tocheck->wait_for_endif == false && r == HASH_SUCCESS)
 		{
-			if((tocheck->is_ndef == true  && r == HASH_KEY_NOT_FOUND) ||
-			   (tocheck->is_ndef == false && r == HASH_SUCCESS      ))
-			{
-				tocheck->condition_passed = true;
-				tocheck->wait_for_endif   = true;
-				yy_preproc->emit_e          = true;
-			}
-			else
-			{
-				yy_preproc->emit_e = false;
-				tocheck   ->condition_passed = false;
-			}
+			tocheck->condition_passed = true;
+			tocheck->wait_for_endif   = true;
 		}
 		else
 		{
-			yy_preproc->emit_e = false;
-			tocheck   ->condition_passed = false;
+			tocheck->condition_passed = false;
 		}
+
+		yy_preproc->emit_e = tocheck->condition_passed;
 	}
 
 	/*!
@@ -343,8 +587,10 @@ namespace yy {
 	*/
 	void VerilogCode::verilog_preprocessor_else  (unsigned int lineno)
 	{
+		verilog_phase_timer timer(&stats.phases[PHASE_PREPROCESS]);
+		stats.phases[PHASE_PREPROCESS].count ++;
+
 		verilog_preprocessor_conditional_context * tocheck = (verilog_preprocessor_conditional_context *) ast_stack_peek(yy_preproc->ifdefs);
-		verilog_preprocessor_conditional_context * parent = (verilog_preprocessor_conditional_context *) ast_stack_peek2(yy_preproc->ifdefs);
 
 		if(tocheck == NULL)
 		{
@@ -353,35 +599,10 @@ namespace yy {
 			return;
 		}
 
-		if(yy_preproc->emit_e           == true &&
-			tocheck  ->wait_for_endif == false)
-		{
-			yy_preproc->emit_e              = false;
-			tocheck   ->condition_passed  = false;
-		}
-		else
-		{
-			if(parent != NULL)
-			{
-				if(parent->condition_passed == true)
-				{
-					yy_preproc->emit_e              = true;
-					tocheck   ->condition_passed  = true;
-				}
-				else
-				{
-					yy_preproc->emit_e              = false;
-					tocheck   ->condition_passed  = false;
-				}
-			}
-			else
-			{
-				yy_preproc->emit_e              = true;
-				tocheck   ->condition_passed  = true;
-			}
-		}
-
-		tocheck->wait_for_endif = true;
+		// The `else is taken if no earlier branch was.
+		tocheck->condition_passed = tocheck->wait_for_endif == false;
+		tocheck->wait_for_endif   = true;
+		yy_preproc->emit_e        = tocheck->condition_passed;
 	}
 
 	/*!
@@ -389,6 +610,9 @@ namespace yy {
 	*/
 	void VerilogCode::verilog_preprocessor_endif (unsigned int lineno)
 	{
+		verilog_phase_timer timer(&stats.phases[PHASE_PREPROCESS]);
+		stats.phases[PHASE_PREPROCESS].count ++;
+
 		verilog_preprocessor_conditional_context * tocheck = (verilog_preprocessor_conditional_context *) ast_stack_pop(yy_preproc->ifdefs);
 
 		if(tocheck == NULL)
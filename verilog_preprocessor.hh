@@ -10,6 +10,7 @@
 
 #include "verilog_ast.hh"
 #include "verilog_ast_common.hh"
+#include "verilog_input.hh"
 
 #ifndef VERILOG_PREPROCESSOR_H
 #define VERILOG_PREPROCESSOR_H
@@ -64,24 +65,83 @@ encountered.
 
   // ----------------------- Include Directives ---------------------------
 
+  /*!
+@brief A file found by an include directive, kept for the whole session.
+@details Later includes of the same name reuse the path and the text
+rather than searching and reading again. A file wrapped in an include
+guard is not scanned at all once its guard macro is defined.
+*/
+  typedef struct verilog_include_file_t{
+    const char    * path;          //!< Where the file was found.
+    verilog_input * input;         //!< The file text.
+    const char    * guard;         //!< The guard macro, or NULL if none.
+    size_t          guard_length;  //!< Length of the guard macro name.
+  } verilog_include_file;
+
   //! Stores information on an include directive.
   typedef struct verilog_include_directive_t{
 	std::string filename;      //!< The file to include.
     unsigned int lineNumber;    //!< The line number of the directive.
     bool  file_found;    //!< Can we find the file?
+    bool  skipped;       //!< Left out, as its include guard is defined.
+    verilog_include_file * file; //!< The cached file, if it was found.
   } verilog_include_directive;
 
   // ----------------------- `define Directives ---------------------------
 
+  //! Returned by the scanner for a macro usage. Never reaches the parser.
+  #define VERILOG_TOKEN_MACRO -1
+
+  //! How deeply macro expansions may nest before one is taken as recursive.
+  #define VERILOG_MACRO_MAX_DEPTH 64
+
+  /*!
+@brief One token of a macro value.
+@details Macro values are tokenized once, when they are defined, and
+replayed from these on every use. Tokens with a semantic value keep their
+text, so a fresh value can be made each time.
+*/
+  typedef struct verilog_macro_token_t{
+    int           token;     //!< Parser token, or VERILOG_TOKEN_MACRO.
+    int           param;     //!< Index of the formal parameter, or -1.
+    ast_operator  op;        //!< The operator, for operator tokens.
+    const char  * text;      //!< The token text.
+    unsigned int  length;    //!< Length of text in bytes.
+  } verilog_macro_token;
+
+  //! The tokens of one actual argument to a macro.
+  typedef struct verilog_macro_argument_t{
+    verilog_macro_token * tokens;  //!< The argument tokens.
+    unsigned int          count;   //!< Number of tokens.
+  } verilog_macro_argument;
+
   /*!
 @brief A simple container for macro directives
 */
   typedef struct verilog_macro_directive_t{
     unsigned int line;      //!< Line number of the directive.
-	std::string macro_id;        //!< The name of the macro.
-	std::string macro_value;     //!< The value it expands to.
+    const char          * macro_id;          //!< The name of the macro.
+    unsigned int          macro_id_length;   //!< Length of macro_id in bytes.
+    const char          * macro_value;       //!< The value it expands to.
+    unsigned int          macro_value_length; //!< Length of macro_value in bytes.
+    ast_list            * params;      //!< Formal parameter names, or NULL.
+    verilog_macro_token * tokens;      //!< The value, tokenized.
+    unsigned int          token_count; //!< Number of tokens in the value.
   } verilog_macro_directive;
 
+  /*!
+@brief A macro value, or macro argument, part way through being replayed.
+@details A stack of these is kept while expanding, so macros may use
+other macros and their own arguments.
+*/
+  typedef struct verilog_macro_expansion_t{
+    verilog_macro_token    * tokens;    //!< The tokens being replayed.
+    unsigned int             count;     //!< Number of tokens.
+    unsigned int             next;      //!< Index of the next token.
+    verilog_macro_argument * args;      //!< Actual arguments, or NULL.
+    unsigned int             arg_count; //!< Number of actual arguments.
+  } verilog_macro_expansion;
+
   // ----------------------- Conditional Compilation Directives -----------
 
   /*!
@@ -95,7 +155,7 @@ level of nested `ifdef or `ifndef statements.
     int           line_number;         //!< Where the `ifdef came from.
     bool   condition_passed;    //!< Did the condition pass?
     bool   is_ndef;             //!< True if directive was `ifndef
-    bool   wait_for_endif;      //!< Emit nothing more until `endif
+    bool   wait_for_endif;      //!< No later branch may be taken.
   } verilog_preprocessor_conditional_context;
 
   // ----------------------- Preprocessor Context -------------------------
@@ -124,6 +184,9 @@ level of nested `ifdef or `ifndef statements.
     ast_primitive_strength unconnected_drive_pull; //!< nounconnectedrive
     ast_stack     * ifdefs;         //!< Storage for conditional compile stack.
     ast_list      * search_dirs;    //!< Where to look for include files.
+    ast_hashtable * include_cache;  //!< Include names to verilog_include_file.
+    ast_list      * include_files;  //!< Every verilog_include_file, to release.
+    ast_stack     * expansions;     //!< Macro expansions being replayed.
   } verilog_preprocessor_context;
 
   /*! @} */
@@ -0,0 +1,452 @@
+/*!
+@file verilog_project.cc
+@brief Contains implementations of the filelist reading and parallel parsing
+       functions declared in verilogcode.h
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "verilogscanner.hh"
+#include "verilogcode.h"
+#include "verilog.yy.hh"
+
+namespace yy {
+
+  //! How deeply filelists may include each other, to stop include loops.
+  #define VERILOG_FILELIST_MAX_DEPTH 16
+
+  //! What the workers of parse_files share.
+  typedef struct verilog_project_job_t{
+    VerilogCode            ** units;  //!< One instance per file.
+    const std::string       * paths;  //!< The file each instance parses.
+    char                    * ok;     //!< Set for each file which parsed.
+    unsigned int              count;  //!< Number of files.
+    std::atomic<unsigned int> next;   //!< The next file nobody has taken.
+  } verilog_project_job;
+
+  //! Parses files until there are none left to take.
+  static void verilog_project_worker(verilog_project_job * job)
+  {
+    for(;;)
+      {
+        unsigned int i = job->next ++;
+        if(i >= job->count)
+          return;
+        job->ok[i] = job->units[i]->parse_file(job->paths[i]);
+      }
+  }
+
+  //! Expands $NAME, ${NAME} and $(NAME) from the environment.
+  static std::string verilog_filelist_expand(const std::string & text)
+  {
+    std::string tr;
+
+    for(size_t i = 0; i < text.size(); i ++)
+      {
+        if(text[i] != '$' || i + 1 == text.size())
+          {
+            tr += text[i];
+            continue;
+          }
+
+        size_t start = i + 1;
+        char   close = 0;
+        if(text[start] == '{')
+          close = '}';
+        else if(text[start] == '(')
+          close = ')';
+
+        size_t end;
+        if(close != 0)
+          {
+            start ++;
+            end = text.find(close, start);
+            if(end == std::string::npos)
+              {
+                tr += text[i];
+                continue;
+              }
+          }
+        else
+          {
+            for(end = start; end < text.size() &&
+                (isalnum((unsigned char)text[end]) || text[end] == '_'); end ++);
+            if(end == start)
+              {
+                tr += text[i];
+                continue;
+              }
+          }
+
+        const char * value = getenv(text.substr(start, end - start).c_str());
+        if(value != NULL)
+          tr += value;
+        i = close != 0 ? end : end - 1;
+      }
+
+    return tr;
+  }
+
+  //! Returns the directory part of a path, with its trailing '/'.
+  static std::string verilog_filelist_dir(const std::string & path)
+  {
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+  }
+
+  //! Prefixes a relative path with base.
+  static std::string verilog_filelist_path(const std::string & base, const std::string & path)
+  {
+    if(path.empty() || path[0] == '/')
+      return path;
+    return base + path;
+  }
+
+  //! Splits "+option+a+b" after the option, appending a and b to list.
+  static void verilog_filelist_split(VerilogCode * code, ast_list * list,
+    const std::string & text, size_t start, const std::string * base)
+  {
+    while(start < text.size())
+      {
+        size_t end = text.find('+', start);
+        if(end == std::string::npos)
+          end = text.size();
+
+        if(end > start)
+          {
+            std::string item = text.substr(start, end - start);
+            if(base != NULL)
+              item = verilog_filelist_path(*base, item);
+            code->ast_list_append(list, code->ast_strndup(item.data(), item.size()));
+          }
+        start = end + 1;
+      }
+  }
+
+  /*!
+@brief Reads one filelist into list, following -f and -F.
+@details Tokens are separated by white space, and // and block comments are
+ignored. Options other than -f, -F, +incdir+ and +define+ are reported and
+skipped.
+@param [in] base - Prefixed to relative paths in this filelist.
+*/
+  bool VerilogCode::verilog_filelist_read_file(
+    verilog_filelist * list,
+    std::string filename,
+    std::string base,
+    unsigned int depth
+  ){
+    if(depth > VERILOG_FILELIST_MAX_DEPTH)
+      {
+        std::cout << "ERROR: Filelists nested too deeply at " << filename << std::endl;
+        return false;
+      }
+
+    std::ifstream in(filename.c_str());
+    if(!in)
+      {
+        std::cout << "ERROR: Could not read filelist " << filename << std::endl;
+        return false;
+      }
+
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string text = buffer.str();
+
+    // Split into tokens first, so options can take the next one.
+    std::vector<std::string> tokens;
+    for(size_t i = 0; i < text.size(); )
+      {
+        if(isspace((unsigned char)text[i]))
+          {
+            i ++;
+          }
+        else if(text.compare(i, 2, "//") == 0)
+          {
+            i = text.find('\n', i);
+            if(i == std::string::npos)
+              i = text.size();
+          }
+        else if(text.compare(i, 2, "/*") == 0)
+          {
+            i = text.find("*/", i + 2);
+            i = i == std::string::npos ? text.size() : i + 2;
+          }
+        else
+          {
+            size_t start = i;
+            while(i < text.size() && !isspace((unsigned char)text[i]))
+              i ++;
+            tokens.push_back(verilog_filelist_expand(text.substr(start, i - start)));
+          }
+      }
+
+    bool tr = true;
+    for(size_t t = 0; t < tokens.size(); t ++)
+      {
+        const std::string & token = tokens[t];
+
+        if(token == "-f" || token == "-F")
+          {
+            if(t + 1 == tokens.size())
+              {
+                std::cout << "ERROR: " << token << " without a filelist in " << filename << std::endl;
+                tr = false;
+                break;
+              }
+            std::string nested = verilog_filelist_path(base, tokens[++ t]);
+            std::string nested_base = token == "-F" ? verilog_filelist_dir(nested) : base;
+            tr = verilog_filelist_read_file(list, nested, nested_base, depth + 1) && tr;
+          }
+        else if(token.compare(0, 8, "+incdir+") == 0)
+          {
+            verilog_filelist_split(this, list->incdirs, token, 8, &base);
+          }
+        else if(token.compare(0, 8, "+define+") == 0)
+          {
+            verilog_filelist_split(this, list->defines, token, 8, NULL);
+          }
+        else if(token[0] == '-' || token[0] == '+')
+          {
+            // Library options name a file or directory to go with them.
+            if(token == "-v" || token == "-y")
+              t ++;
+            std::cout << "WARNING: Ignoring " << token << " in filelist " << filename << std::endl;
+          }
+        else
+          {
+            std::string path = verilog_filelist_path(base, token);
+            ast_list_append(list->files, ast_strndup(path.data(), path.size()));
+          }
+      }
+
+    return tr;
+  }
+
+  /*!
+@brief Reads a filelist, and any filelists it includes.
+@returns The files and options found, or NULL if the filelist, or one it
+includes, could not be read.
+*/
+  verilog_filelist * VerilogCode::verilog_filelist_read(std::string filename)
+  {
+    verilog_filelist * tr = (verilog_filelist *)ast_calloc(1, sizeof(verilog_filelist));
+    tr->files   = ast_list_new();
+    tr->incdirs = ast_list_new();
+    tr->defines = ast_list_new();
+
+    if(!verilog_filelist_read_file(tr, filename, std::string(), 0))
+      return NULL;
+    return tr;
+  }
+
+  /*!
+@brief Reads a filelist and parses every file it names.
+@details +incdir+ directories and +define+ macros are added to this instance,
+so every file starts from them.
+*/
+  bool VerilogCode::parse_filelist(std::string filename, unsigned int jobs)
+  {
+    verilog_parser_init();
+
+    verilog_filelist * list = verilog_filelist_read(filename);
+    if(list == NULL)
+      return false;
+
+    for(unsigned int d = 0; d < list->incdirs->items; d ++)
+      verilog_preprocessor_add_search_dir(ast_list_get_str(list->incdirs, d));
+
+    for(unsigned int m = 0; m < list->defines->items; m ++)
+      {
+        const char * define = (const char *)ast_list_get(list->defines, m);
+        const char * equals = strchr(define, '=');
+
+        if(equals == NULL)
+          verilog_preprocessor_macro_define(0, define, "", 0);
+        else
+          verilog_preprocessor_macro_define(0, std::string(define, equals - define),
+                                            equals + 1, strlen(equals + 1));
+      }
+
+    return parse_files(list->files, jobs);
+  }
+
+  /*!
+@brief Creates an instance to parse one file of a project.
+@details It starts with the search directories of this instance, and shares
+its macro definitions. The definitions are only read while parsing, so any
+number of instances may share them.
+*/
+  VerilogCode * VerilogCode::verilog_project_unit()
+  {
+    VerilogCode * unit = new VerilogCode();
+
+    // The parser's debug level is process wide, see parse_file.
+    unit->trace_scanning   = trace_scanning;
+    unit->trace_categories = trace_categories;
+    unit->yy_identifiers   = unit->ast_list_new();
+    unit->set_cache_directory(cache_directory);
+
+    for(unsigned int d = 0; d < yy_preproc->search_dirs->items; d ++)
+      unit->verilog_preprocessor_add_search_dir(ast_list_get_str(yy_preproc->search_dirs, d));
+
+    unit->ast_hashtable_insert_all(unit->yy_preproc->macrodefines, yy_preproc->macrodefines);
+
+    return unit;
+  }
+
+  /*!
+@brief Parses files on a pool of worker threads, then merges their trees.
+@details Each file gets its own VerilogCode, so the workers share nothing
+but the macro definitions, which they only read. The trees are merged once
+every worker has finished, in the order the files were given, so the result
+does not depend on which worker finished first.
+*/
+  bool VerilogCode::parse_files(ast_list * files, unsigned int jobs)
+  {
+    verilog_parser_init();
+
+    unsigned int count = files->items;
+    if(count == 0)
+      return true;
+
+    if(jobs == 0)
+      jobs = std::thread::hardware_concurrency();
+    if(jobs == 0)
+      jobs = 1;
+    if(jobs > count)
+      jobs = count;
+
+    if(yy_units == NULL)
+      yy_units = ast_list_new();
+
+    std::vector<std::string>   paths(count);
+    std::vector<VerilogCode *> units(count);
+    std::vector<char>          ok(count, 0);
+
+    for(unsigned int f = 0; f < count; f ++)
+      {
+        paths[f] = ast_list_get_str(files, f);
+        units[f] = verilog_project_unit();
+        ast_list_append(yy_units, units[f]);
+      }
+
+    verilog_project_job job;
+    job.units = units.data();
+    job.paths = paths.data();
+    job.ok    = ok.data();
+    job.count = count;
+    job.next  = 0;
+
+    VERILOG_TRACE(this, TRACE_PARSER, "parsing %u files with %u workers", count, jobs);
+
+    // This thread is one of the workers.
+    std::vector<std::thread> workers;
+    for(unsigned int w = 1; w < jobs; w ++)
+      workers.push_back(std::thread(verilog_project_worker, &job));
+    verilog_project_worker(&job);
+    for(unsigned int w = 0; w < workers.size(); w ++)
+      workers[w].join();
+
+    bool tr = true;
+    for(unsigned int f = 0; f < count; f ++)
+      {
+        if(!ok[f])
+          {
+            std::cout << "ERROR: " << paths[f] << " failed to parse" << std::endl;
+            tr = false;
+          }
+        verilog_source_tree_merge(units[f]);
+      }
+
+    if(!stats_json_path.empty())
+      stats_write_json(stats_json_path);
+
+    return tr;
+  }
+
+  /*!
+@brief Merges the tree of a project's instance into this one.
+@details Each instance interned its identifiers into its own symbol table.
+Every symbol is interned again here, once, and the identifiers are pointed
+at the results, so identifiers from any file of the project compare by
+symbol id as usual. Modules with a name already in the tree are kept in the
+list, but the index keeps the first, as verilog_source_tree_add_module does.
+*/
+  void VerilogCode::verilog_source_tree_merge(VerilogCode * unit)
+  {
+    assert(unit->yy_identifiers != NULL);
+
+    if(unit->yy_symbols != NULL)
+      {
+        if(yy_symbols == NULL)
+          yy_symbols = ast_symbol_table_new();
+
+        ast_list * entries = unit->yy_symbols->entries;
+        std::vector<ast_symbol_entry *> remap(entries->items + 1, (ast_symbol_entry *)NULL);
+
+        for(unsigned int s = 0; s < entries->items; s ++)
+          {
+            const ast_symbol_entry * e = (const ast_symbol_entry *)ast_list_at(entries, s);
+            remap[e->id] = ast_symbol_intern(yy_symbols, e->text, e->length);
+          }
+
+        const ast_list_item * end = ast_list_end(unit->yy_identifiers);
+        for(const ast_list_item * i = ast_list_begin(unit->yy_identifiers); i != end; i ++)
+          {
+            ast_identifier id = (ast_identifier)*i;
+            ast_symbol_entry * e = remap[id->symbol];
+            id->symbol     = e->id;
+            id->identifier = e->text;
+          }
+      }
+
+    verilog_source_tree * from = unit->yy_verilog_source_tree;
+    verilog_source_tree * to   = yy_verilog_source_tree;
+
+    for(unsigned int m = 0; m < from->modules->items; m ++)
+      verilog_source_tree_add_module(to, (ast_module_declaration *)ast_list_get(from->modules, m));
+    for(unsigned int p = 0; p < from->primitives->items; p ++)
+      ast_list_append(to->primitives, ast_list_get(from->primitives, p));
+    for(unsigned int c = 0; c < from->configs->items; c ++)
+      ast_list_append(to->configs, ast_list_get(from->configs, c));
+    for(unsigned int l = 0; l < from->libraries->items; l ++)
+      ast_list_append(to->libraries, ast_list_get(from->libraries, l));
+
+    stats_add(&unit->stats);
+  }
+
+  /*!
+@brief Releases the instances which parsed the files of a project.
+@post Nodes merged in from them are gone, like the rest of the tree.
+*/
+  void VerilogCode::verilog_project_release()
+  {
+    if(yy_units == NULL)
+      return;
+
+    for(unsigned int u = 0; u < yy_units->items; u ++)
+      {
+        VerilogCode * unit = (VerilogCode *)ast_list_get(yy_units, u);
+        unit->ast_free_all();
+
+        delete unit->parser;
+        delete unit->lexer;
+        delete unit->macro_lexer;
+        delete unit;
+      }
+
+    yy_units = NULL;
+  }
+}
@@ -0,0 +1,33 @@
+/*!
+@file verilog_project.hh
+@brief Contains declarations of the filelist a multi-file design is read
+       from.
+*/
+
+#include "verilog_ast_common.hh"
+
+#ifndef VERILOG_PROJECT_H
+#define VERILOG_PROJECT_H
+
+namespace yy {
+  /*!
+@defgroup verilog-project Projects
+@{
+@brief Designs spread over many files, named in a .f filelist.
+@details Every file of a project is parsed by its own VerilogCode, on a pool
+of worker threads. Each one starts with the search directories and macros
+of the VerilogCode reading the project, and their trees are then merged
+into its tree, in filelist order, ready to be resolved.
+*/
+
+  //! The contents of a filelist, and of any filelists it includes.
+  typedef struct verilog_filelist_t{
+    ast_list * files;    //!< Source files, as NUL terminated paths.
+    ast_list * incdirs;  //!< Directories given with +incdir+.
+    ast_list * defines;  //!< Macros given with +define+, as NAME or NAME=value.
+  } verilog_filelist;
+
+  /*! @} */
+}
+
+#endif
@@ -1,15 +1,28 @@
 %{
+#include <climits>
+#include <cctype>
+#include <cstring>
 #include <string>
 #include <iostream>
 #include <fstream>
 
 #include "verilog_ast.hh"
 #include "verilog_preprocessor.hh"
+#include "verilog_trace.hh"
 
 #include "verilogscanner.hh"
 
-#define EMIT_TOKEN(x) return x;
-#define YY_DECL int yy::VerilogScanner::yylex(YYSTYPE* yylval, YYLTYPE* yylloc, yy::VerilogCode* code)
+#define EMIT_TOKEN(x) {code->stats.tokens ++; return x;}
+
+// Enters the skip mode if the last conditional directive disabled the text.
+#define SKIP_IF_INACTIVE() {                \
+    if(code->yy_preproc->emit_e == false) { \
+        skip_depth = 0;                     \
+        BEGIN(in_skip);                     \
+        skip_inactive();                    \
+    }                                       \
+}
+#define YY_DECL int yy::VerilogScanner::yylex_raw(YYSTYPE* yylval, YYLTYPE* yylloc, yy::VerilogCode* code)
 %}
 
 %option c++
@@ -45,6 +58,7 @@ CD_IFNDEF              "`ifndef"
 %x in_ifdef
 %x in_ifndef
 %x in_elseif
+%x in_skip
 
 CD_UNDEF               "`undef"
 
@@ -250,7 +264,7 @@ SIMPLE_ID           [a-zA-Z_][a-zA-Z0-9_$]*
 ESCAPED_ID          \\{SIMPLE_ID}
 MACRO_IDENTIFIER    `{SIMPLE_ID}
 
-MACRO_TEXT          .*\n
+MACRO_TEXT          ([^\\\n]|\\(.|\n))*\n
 
 %x in_define
 %x in_define_t
@@ -269,7 +283,7 @@ COMMENT_END         "*/"
 %x in_comment
 
 /* Strings */
-BLANKS          [ \t]+
+BLANKS          [ \t\r]+
 STRING          [a-zA-Z0-9_<>\[\]:.?$/!]*[a-zA-Z_][a-zA-Z0-9_<>\[\]:.?$/!]*
 
 /* Single character tokens */
@@ -312,10 +326,11 @@ TERNARY             "?"
 {ATTRIBUTE_START}      {EMIT_TOKEN(yy::VerilogParser::token::ATTRIBUTE_START);}
 {ATTRIBUTE_END}        {EMIT_TOKEN(yy::VerilogParser::token::ATTRIBUTE_END);}
 
-{COMMENT_LINE}         {/*EMIT_TOKEN(yy::VerilogParser::token::COMMENT_LINE); IGNORE */}
+{COMMENT_LINE}         {yylineno ++; /*EMIT_TOKEN(yy::VerilogParser::token::COMMENT_LINE); IGNORE */}
 {COMMENT_BEGIN}        {BEGIN(in_comment);}
 
-<in_comment>.|\n       {/* IGNORE                            */}
+<in_comment>\n         {yylineno ++;                          }
+<in_comment>.          {/* IGNORE                            */}
 <in_comment>{COMMENT_END} {BEGIN(INITIAL);                     }
 
 {CD_CELLDEFINE}          {code->verilog_preproc_enter_cell_define();}
@@ -362,7 +377,7 @@ TERNARY             "?"
     BEGIN(in_ts_2);
 }
 <in_ts_1>{NUM_UNSIGNED}      {
-		code->yy_preproc->timescale.scale = *(yylval->str);
+		code->yy_preproc->timescale.scale = std::string(yytext, yyleng);
 }
 <in_ts_2>{DIV}               {
     BEGIN(in_ts_3);
@@ -371,18 +386,21 @@ TERNARY             "?"
     BEGIN(INITIAL);
 }
 <in_ts_3>{NUM_UNSIGNED}      {
-		code->yy_preproc->timescale.precision = *(yylval->str);
+		code->yy_preproc->timescale.precision = std::string(yytext, yyleng);
 }
 {CD_RESETALL}            {
     code->verilog_preprocessor_resetall();
 }
 
+<in_ifdef,in_ifndef,in_elseif>{BLANKS} {}
+
 {CD_IFDEF}               {
     BEGIN(in_ifdef);
 }
 <in_ifdef>{SIMPLE_ID}    {
         code->verilog_preprocessor_ifdef(yytext,yylineno,false);
     BEGIN(INITIAL);
+    SKIP_IF_INACTIVE();
 }
 
 {CD_IFNDEF}              {
@@ -391,6 +409,7 @@ TERNARY             "?"
 <in_ifndef>{SIMPLE_ID}   {
         code->verilog_preprocessor_ifdef(yytext,yylineno,true);
     BEGIN(INITIAL);
+    SKIP_IF_INACTIVE();
 }
 
 {CD_ELSIF}               {
@@ -399,40 +418,100 @@ TERNARY             "?"
 <in_elseif>{SIMPLE_ID}   {
     code->verilog_preprocessor_elseif(yytext, yylineno);
     BEGIN(INITIAL);
+    SKIP_IF_INACTIVE();
 }
 
 {CD_ELSE}                {
     code->verilog_preprocessor_else(yylineno);
+    SKIP_IF_INACTIVE();
 }
 
 {CD_ENDIF}               {
     code->verilog_preprocessor_endif(yylineno);
 }
 
+    /* Disabled text. skip_inactive jumps from one conditional directive to
+       the next, so these rules only see those, and whatever is left at the
+       end of the input. Conditionals nested in the disabled text are
+       counted, not evaluated. */
+<in_skip>{CD_IFDEF}      |
+<in_skip>{CD_IFNDEF}     {
+    skip_depth ++;
+    skip_inactive();
+}
+<in_skip>{CD_ELSIF}      {
+    if(skip_depth > 0)
+        skip_inactive();
+    else
+        BEGIN(in_elseif);
+}
+<in_skip>{CD_ELSE}       {
+    if(skip_depth > 0)
+    {
+        skip_inactive();
+    }
+    else
+    {
+        BEGIN(INITIAL);
+        code->verilog_preprocessor_else(yylineno);
+        SKIP_IF_INACTIVE();
+    }
+}
+<in_skip>{CD_ENDIF}      {
+    if(skip_depth > 0)
+    {
+        skip_depth --;
+        skip_inactive();
+    }
+    else
+    {
+        BEGIN(INITIAL);
+        code->verilog_preprocessor_endif(yylineno);
+        SKIP_IF_INACTIVE();
+    }
+}
+<in_skip>{NEWLINE}       {yylineno += yyleng;}
+<in_skip>[^`\n]+|`       {}
+
 {CD_INCLUDE}             {
     BEGIN(in_include);
 }
+<in_include>{BLANKS}     {}
+
+<in_include>\"[^\"\n]*\"  |
 <in_include>{STRING}     {
     YY_BUFFER_STATE cur = YY_CURRENT_BUFFER;
 
-    yy::verilog_include_directive * id = code->verilog_preprocessor_include(yytext,yylineno);
+    // The include outlives any module being streamed.
+    yy::ast_arena_keep keep(code);
 
-    // Now, we need to look for the file, open it as a buffer, and then
-    // switch to it.
+    // The name may or may not be quoted.
+    std::string name = yytext[0] == '"' ? std::string(yytext + 1, yyleng - 2) :
+                                          std::string(yytext, yyleng);
 
-        if(id->file_found == true)
+    yy::verilog_include_directive * id = code->verilog_preprocessor_include(name,yylineno);
+
+    // Now, we need to take the file from the include cache, and then
+    // switch to it. A guarded file already included is skipped.
+    yy::verilog_input * input = NULL;
+
+    if(id->file_found == true && id->skipped == false)
     {
-        std::ifstream file;
-        file.open (id->filename, std::ifstream::in);
-        YY_BUFFER_STATE n = this->yy_create_buffer(file, YY_BUF_SIZE);
+        input = code->verilog_preprocessor_include_input(id->file);
+    }
 
+    if(input != NULL)
+    {
 	cur->yy_bs_lineno = yylineno;
-	yy_switch_to_buffer(cur);
-	yypush_buffer_state(n);
-	BEGIN(INITIAL);
+	scan_input(input);
+	yylineno = 1;
+	code->ast_stack_push(code->input_stack, input);
     }
-    else
+    else if(id->skipped == false)
     {
+        if(id->file_found == true)
+            code->ast_stack_pop(code->yy_preproc->current_file);
+
 		std::cout << "ERROR - Could not find include file "<<id->filename<<" on line " << id-> lineNumber << std::endl;
 		std::cout << "\tExpect stuff to break now." << std::endl;
     }
@@ -466,22 +545,20 @@ TERNARY             "?"
     BEGIN(in_define);
 }
 
+<in_define>{BLANKS}      {}
+
 <in_define>{SIMPLE_ID}   {
 		code->yy_preproc->scratch = yytext;
     BEGIN(in_define_t);
 }
 
 <in_define_t>{MACRO_TEXT} {
-    if(yyleng == 1)
-    {
-        // Macro has no value, and is just a newline character.
-		code->verilog_preprocessor_macro_define(yylineno-1, code->yy_preproc->scratch, NULL, 0); // -1 to avoid including the newline.
-    }
-    else
-    {
-        // Macro has a proper value.
-		code->verilog_preprocessor_macro_define(yylineno-1, code->yy_preproc->scratch, yytext+1, yyleng-2); // -1 to avoid including the newline.
-    }
+    // Pass everything after the name, less the newline. The preprocessor
+    // splits off any parameter list.
+		code->verilog_preprocessor_macro_define(yylineno, code->yy_preproc->scratch, yytext, yyleng-1); // -1 to avoid including the newline.
+    for(int i = 0; i < yyleng; i ++)
+        if(yytext[i] == '\n')
+            yylineno ++;
     BEGIN(INITIAL);
 }
 
@@ -495,29 +572,8 @@ TERNARY             "?"
 }
 
 {MACRO_IDENTIFIER}     {
-	// Look for the macro entry.
-	yy::verilog_macro_directive * macro = NULL;
-    char * macroName = (yytext)+1;
-	yy::ast_hashtable_result r = code->ast_hashtable_get(code->yy_preproc->macrodefines, macroName, (void**)&macro);
-
-    if(r == HASH_SUCCESS)
-    {
-		// Switch buffers to expand the macro.
-		//YY_BUFFER_STATE cur = YY_CURRENT_BUFFER;
-		//YY_BUFFER_STATE n   = code->lexer->yy_scan_string(macro->macro_value);
-		//code->lexer->yy_switch_to_buffer(cur);
-		//code->lexer->yypush_buffer_state(n);
-		//yy_buffer_state* new_buffer = code->lexer->yy_create_buffer(std::string(macro->macro_value),strlen(macro->macro_value));
-		//code->lexer->yy_switch_to_buffer( new_buffer );
-		// TODO: Fix this!
-		std::cout << "MACRO_IDENTIFIER: " << macro->macro_value << std::endl;
-    }
-    else
-    {
-        // Undefined macro - PANIC!
-		std::cout << "ERROR: Undefined macro '" << yytext << "' on line " << yylineno << std::endl;
-		std::cout << "\tIt's probably all going to fall apart now...\n\n" << std::endl;
-    }
+	// Expanded by VerilogScanner::yylex, which replays the macro's tokens.
+	return VERILOG_TOKEN_MACRO;
 }
 
 EQ                   {yylval->verilog_operator = yy::OPERATOR_L_EQ; EMIT_TOKEN(yy::VerilogParser::token::EQ)}
@@ -565,12 +621,12 @@ COLON                {EMIT_TOKEN(yy::VerilogParser::token::COLON)}
 {BASE_OCTAL}           {BEGIN(in_oct_val); EMIT_TOKEN(yy::VerilogParser::token::OCT_BASE);}
 {BASE_BINARY}          {BEGIN(in_bin_val); EMIT_TOKEN(yy::VerilogParser::token::BIN_BASE);}
 
-<in_bin_val>{BIN_VALUE} {BEGIN(INITIAL); yylval->str = new std::string(yytext); EMIT_TOKEN(yy::VerilogParser::token::BIN_VALUE);}
-<in_oct_val>{OCT_VALUE} {BEGIN(INITIAL); yylval->str = new std::string(yytext); EMIT_TOKEN(yy::VerilogParser::token::OCT_VALUE);}
-<in_hex_val>{HEX_VALUE} {BEGIN(INITIAL); yylval->str = new std::string(yytext); EMIT_TOKEN(yy::VerilogParser::token::HEX_VALUE);}
+<in_bin_val>{BIN_VALUE} {BEGIN(INITIAL); EMIT_TOKEN(yy::VerilogParser::token::BIN_VALUE);}
+<in_oct_val>{OCT_VALUE} {BEGIN(INITIAL); EMIT_TOKEN(yy::VerilogParser::token::OCT_VALUE);}
+<in_hex_val>{HEX_VALUE} {BEGIN(INITIAL); EMIT_TOKEN(yy::VerilogParser::token::HEX_VALUE);}
 
-{NUM_REAL}             {yylval->str = new std::string(yytext); EMIT_TOKEN(yy::VerilogParser::token::NUM_REAL);}
-{NUM_UNSIGNED}         {yylval->str = new std::string(yytext); EMIT_TOKEN(yy::VerilogParser::token::UNSIGNED_NUMBER);}
+{NUM_REAL}             {EMIT_TOKEN(yy::VerilogParser::token::NUM_REAL);}
+{NUM_UNSIGNED}         {EMIT_TOKEN(yy::VerilogParser::token::UNSIGNED_NUMBER);}
 
 {ALWAYS}               {EMIT_TOKEN(yy::VerilogParser::token::KW_ALWAYS);}
 {AND}                  {EMIT_TOKEN(yy::VerilogParser::token::KW_AND);}
@@ -697,34 +753,30 @@ COLON                {EMIT_TOKEN(yy::VerilogParser::token::COLON)}
 {XOR}                  {EMIT_TOKEN(yy::VerilogParser::token::KW_XOR);}
 
 {SYSTEM_ID}+ {
-	std::string id_name = std::string(yytext);
-	std::cout << "SYSTEM_ID: " << id_name << std::endl;
-	yylval->identifier = code->ast_new_identifier(id_name,yylineno);
+	VERILOG_TRACE(code, yy::TRACE_LEXER, "SYSTEM_ID: %s", yytext);
+	yylval->identifier = code->ast_new_identifier(yytext,yyleng,yylineno);
 	EMIT_TOKEN(yy::VerilogParser::token::SYSTEM_ID);
 }
 
 {ESCAPED_ID}+ {
-	std::string id_name = std::string(yytext);
-	std::cout << "ESCAPED_ID: " <<id_name << std::endl;
-	yylval->identifier = code->ast_new_identifier(id_name,yylineno);
+	VERILOG_TRACE(code, yy::TRACE_LEXER, "ESCAPED_ID: %s", yytext);
+	yylval->identifier = code->ast_new_identifier(yytext,yyleng,yylineno);
 	EMIT_TOKEN(yy::VerilogParser::token::ESCAPED_ID);
 }
 
 {SIMPLE_ID}+ {
-	std::string id_name = std::string(yytext);
-	std::cout << "SIMPLE_ID: " <<id_name << std::endl;
-	yylval->identifier = code->ast_new_identifier(id_name,yylineno);
+	VERILOG_TRACE(code, yy::TRACE_LEXER, "SIMPLE_ID: %s", yytext);
+	yylval->identifier = code->ast_new_identifier(yytext,yyleng,yylineno);
 	EMIT_TOKEN(yy::VerilogParser::token::SIMPLE_ID);
 }
 
 {STRING}+ {
-	std::string *id_name = new std::string(yytext);
-	yylval->str = id_name;
-	std::cout << "STRING: " << *(id_name) << std::endl;
+	VERILOG_TRACE(code, yy::TRACE_LEXER, "STRING: %s", yytext);
 	EMIT_TOKEN(yy::VerilogParser::token::STRING);
 }
 
 {BLANKS}+		{};
+{NEWLINE}		{yylineno += yyleng;}
 {COMMA}+		EMIT_TOKEN(yy::VerilogParser::token::COMMA)
 {AT}+			EMIT_TOKEN(yy::VerilogParser::token::AT)
 {HASH}+			EMIT_TOKEN(yy::VerilogParser::token::HASH)
@@ -732,8 +784,19 @@ COLON                {EMIT_TOKEN(yy::VerilogParser::token::COLON)}
 
 <<EOF>> {
 
+	if(macro_body)
+	{
+		// The end of a macro value, which is not a file.
+		yypop_buffer_state();
+		BEGIN(INITIAL);
+		yyterminate();
+	}
+
 	yypop_buffer_state();
 
+	// The buffer is gone, so the text it was scanning can go too.
+	code->verilog_input_close((yy::verilog_input*)code->ast_stack_pop(code->input_stack));
+
 	// We are exiting a file, so pop from the the preprocessor stack of files
 	// being parsed.
 	code->ast_stack_pop(code->yy_preproc->current_file);
@@ -753,3 +816,117 @@ COLON                {EMIT_TOKEN(yy::VerilogParser::token::COLON)}
 %%
 
 //. EMIT_TOKEN(yy::VerilogParser::token::ANY)
+
+/*!
+@brief Scans an in-memory input in place.
+@details Builds the buffer by hand, as the C scanner's yy_scan_buffer would.
+Because yy_fill_buffer is zero, flex stops at the two NUL bytes after the
+text instead of trying to refill, and yytext points into input->data.
+yy_delete_buffer frees only the buffer state, since the text is not ours.
+*/
+void yy::VerilogScanner::scan_input(yy::verilog_input* input)
+{
+	// flex keeps buffer sizes in an int.
+	if(input->length > (size_t)INT_MAX - VERILOG_INPUT_PADDING)
+		YY_FATAL_ERROR("input too large in scan_input()");
+
+	yy_buffer_state * b = (yy_buffer_state *)yyalloc(sizeof(struct yy_buffer_state));
+	if(b == NULL)
+		YY_FATAL_ERROR("out of dynamic memory in scan_input()");
+
+	b->yy_buf_size       = (int)input->length;
+	b->yy_buf_pos        = b->yy_ch_buf = input->data;
+	b->yy_is_our_buffer  = 0;
+	b->yy_input_file     = NULL;
+	b->yy_n_chars        = b->yy_buf_size;
+	b->yy_is_interactive = 0;
+	b->yy_at_bol         = 1;
+	b->yy_bs_lineno      = 1;
+	b->yy_bs_column      = 0;
+	b->yy_fill_buffer    = 0;
+	b->yy_buffer_status  = YY_BUFFER_NEW;
+
+	yypush_buffer_state(b);
+}
+
+/*!
+@brief Moves the scanner past text disabled by a conditional directive.
+@details Looks only for backticks, slashes and quotes, with strcspn, and
+counts the newlines passed on the way. Comments and strings are stepped
+over as verilog_include_guard does, so a directive inside one does not end
+the region, and neither does // inside a string hide the rest of its line.
+Stops at the next `ifdef, `ifndef, `elsif, `else or `endif, or at the end
+of the buffer, and leaves the in_skip rules to act on what is there. Every
+buffer holds a whole file or macro value, see open_scanner, so there is no
+refill to resume from.
+*/
+void yy::VerilogScanner::skip_inactive()
+{
+	char * end = YY_CURRENT_BUFFER_LVALUE->yy_ch_buf + yy_n_chars;
+	char * p   = yy_c_buf_p;
+
+	// Undo flex's NUL termination of the directive just matched. The
+	// buffer itself always ends in NULs, so strcspn stops at its end.
+	*p = yy_hold_char;
+
+	while(p < end)
+	{
+		char * stop = p + strcspn(p, "`/\"");
+		if(stop > end)
+			stop = end;
+
+		for(char * nl = p; (nl = (char *)memchr(nl, '\n', stop - nl)) != NULL; nl ++)
+			yylineno ++;
+
+		p = stop;
+		if(p == end)
+			break;
+
+		if(*p == '/' && p[1] == '/')
+		{
+			// The newline ending the comment is counted on the next pass.
+			char * nl = (char *)memchr(p, '\n', end - p);
+			p = nl != NULL ? nl : end;
+		}
+		else if(*p == '/' && p[1] == '*')
+		{
+			for(p += 2; p < end && !(p[0] == '*' && p[1] == '/'); p ++)
+				if(*p == '\n')
+					yylineno ++;
+			p = p < end ? p + 2 : end;
+		}
+		else if(*p == '"')
+		{
+			// An unterminated string ends at its line, as in verilog_include_guard.
+			for(p ++; p < end && *p != '"' && *p != '\n'; p ++)
+				if(*p == '\\' && p + 1 < end && *++p == '\n')
+					yylineno ++;
+			if(p < end && *p == '"')
+				p ++;
+		}
+		else if(*p == '`')
+		{
+			// Only conditional directives matter here.
+			static const char * const names[] = {"ifdef", "ifndef", "elsif", "else", "endif"};
+			bool conditional = false;
+			for(unsigned int i = 0; i < sizeof(names) / sizeof(names[0]) && !conditional; i ++)
+			{
+				size_t n = strlen(names[i]);
+				conditional = (size_t)(end - p) > n && memcmp(p + 1, names[i], n) == 0 &&
+					!(isalnum((unsigned char)p[n+1]) || p[n+1] == '_' || p[n+1] == '$');
+			}
+
+			if(conditional)
+				break;
+			p ++;
+		}
+		else
+		{
+			// A lone slash, or a NUL inside the text.
+			p ++;
+		}
+	}
+
+	yy_c_buf_p   = p;
+	yy_hold_char = *p;
+}
@@ -0,0 +1,274 @@
+/*!
+@file verilog_sim.cc
+@brief Contains implementations of the simulation functions declared in
+       verilogcode.h
+*/
+
+#include <assert.h>
+#include <string.h>
+
+#include <unordered_map>
+#include <vector>
+
+#include "verilogcode.h"
+
+namespace yy {
+
+  //! The built in cell library, named as in the OSU standard cells.
+  static const verilog_cell verilog_cells[] = {
+    {"BUFX2",    CELL_BUF,     1, {"A"},                "Y", NULL},
+    {"BUFX4",    CELL_BUF,     1, {"A"},                "Y", NULL},
+    {"INVX1",    CELL_INV,     1, {"A"},                "Y", NULL},
+    {"INVX2",    CELL_INV,     1, {"A"},                "Y", NULL},
+    {"INVX4",    CELL_INV,     1, {"A"},                "Y", NULL},
+    {"INVX8",    CELL_INV,     1, {"A"},                "Y", NULL},
+    {"AND2X1",   CELL_AND,     2, {"A", "B"},           "Y", NULL},
+    {"AND2X2",   CELL_AND,     2, {"A", "B"},           "Y", NULL},
+    {"NAND2X1",  CELL_NAND,    2, {"A", "B"},           "Y", NULL},
+    {"NAND3X1",  CELL_NAND,    3, {"A", "B", "C"},      "Y", NULL},
+    {"OR2X1",    CELL_OR,      2, {"A", "B"},           "Y", NULL},
+    {"OR2X2",    CELL_OR,      2, {"A", "B"},           "Y", NULL},
+    {"NOR2X1",   CELL_NOR,     2, {"A", "B"},           "Y", NULL},
+    {"NOR3X1",   CELL_NOR,     3, {"A", "B", "C"},      "Y", NULL},
+    {"XOR2X1",   CELL_XOR,     2, {"A", "B"},           "Y", NULL},
+    {"XNOR2X1",  CELL_XNOR,    2, {"A", "B"},           "Y", NULL},
+    {"AOI21X1",  CELL_AOI21,   3, {"A", "B", "C"},      "Y", NULL},
+    {"OAI21X1",  CELL_OAI21,   3, {"A", "B", "C"},      "Y", NULL},
+    {"AOI22X1",  CELL_AOI22,   4, {"A", "B", "C", "D"}, "Y", NULL},
+    {"OAI22X1",  CELL_OAI22,   4, {"A", "B", "C", "D"}, "Y", NULL},
+    {"DFFPOSX1", CELL_DFF_POS, 1, {"D"},                "Q", "CLK"},
+    {"DFFNEGX1", CELL_DFF_NEG, 1, {"D"},                "Q", "CLK"}
+  };
+
+  /*!
+@brief Finds a cell of the built in library by name.
+@returns The cell, or NULL if there is none of that name.
+*/
+  const verilog_cell * VerilogCode::verilog_cell_find(const char * name)
+  {
+    for(size_t c = 0; c < sizeof(verilog_cells) / sizeof(verilog_cells[0]); c ++)
+      if(strcmp(verilog_cells[c].name, name) == 0)
+        return &verilog_cells[c];
+
+    return NULL;
+  }
+
+  /*!
+@brief Matches each instance of a netlist to its cell in the library.
+@details Also fills in the direction of the named pins of library cells
+whose module is not declared in the design: the output is PORT_OUTPUT, and
+every other pin, supplies included, PORT_INPUT.
+@returns The cell of each instance, or NULL where there is none.
+*/
+  const verilog_cell ** VerilogCode::verilog_netlist_cells(
+      verilog_netlist * netlist
+      ){
+    const verilog_cell ** tr = (const verilog_cell **)ast_calloc(netlist->instances,
+                                                                  sizeof(const verilog_cell *));
+
+    // Interned names are compared by address, so each name is looked up once.
+    std::unordered_map<const char *, const verilog_cell *> cells;
+
+    for(unsigned int i = 0; i < netlist->instances; i ++)
+      {
+        const char * name = verilog_netlist_cell_name(netlist, i);
+        std::unordered_map<const char *, const verilog_cell *>::iterator found = cells.find(name);
+        if(found == cells.end())
+          found = cells.insert(std::make_pair(name, verilog_cell_find(name))).first;
+
+        const verilog_cell * cell = found->second;
+        tr[i] = cell;
+        if(cell == NULL)
+          continue;
+
+        for(unsigned int p = netlist->instance_pins_start[i];
+            p < netlist->instance_pins_start[i + 1]; p ++)
+          {
+            ast_symbol_entry * port = ast_symbol_lookup(yy_symbols, netlist->pin_port[p]);
+            if(port == NULL || netlist->pin_direction[p] != PORT_NONE)
+              continue;
+
+            netlist->pin_direction[p] = strcmp(port->text, cell->output) == 0 ?
+                                        PORT_OUTPUT : PORT_INPUT;
+          }
+      }
+
+    return tr;
+  }
+
+  /*!
+@brief Prepares a netlist for simulation.
+@details Levelizes the netlist, then matches every pin of each library cell
+to the cell's pins by port name. The combinational cells are evaluated by
+level, and within a level, cells computing the same function are put
+together, so the switch in verilog_sim_eval mostly takes the branch it took
+last. All nets start at 0, except the constant 1'b1.
+*/
+  verilog_sim * VerilogCode::verilog_sim_new(
+      verilog_netlist * netlist
+      ){
+    assert(netlist != NULL);
+
+    verilog_sim * tr = (verilog_sim *)ast_calloc(1, sizeof(verilog_sim));
+    tr->netlist = netlist;
+    tr->levels  = verilog_netlist_levelize(netlist);
+    tr->values  = (uint64_t *)ast_calloc(netlist->nets, sizeof(uint64_t));
+
+    for(unsigned int n = 0; n < netlist->nets; n ++)
+      if(netlist->net_symbol[n] == AST_SYMBOL_NONE && netlist->net_bit[n] != 0)
+        tr->values[n] = ~(uint64_t)0;
+
+    const verilog_levels * levels = tr->levels;
+    for(unsigned int i = 0; i < netlist->instances; i ++)
+      {
+        if(levels->cell[i] == NULL)
+          tr->unknown ++;
+        else if(levels->level[i] == VERILOG_NETLIST_NONE)
+          tr->looped ++;
+      }
+
+    std::vector<verilog_sim_gate>  gates;
+    std::vector<unsigned int>      level;
+    std::vector<verilog_sim_flop>  flops;
+
+    for(unsigned int o = 0; o < levels->ordered; o ++)
+      {
+        unsigned int i = levels->order[o];
+        const verilog_cell * cell = levels->cell[i];
+        if(cell == NULL)
+          continue;
+
+        verilog_sim_gate gate;
+        memset(&gate, 0, sizeof(gate));
+        gate.function = (unsigned char)cell->function;
+        gate.inputs   = (unsigned char)cell->inputs;
+        gate.output   = VERILOG_NETLIST_NONE;
+        for(unsigned int c = 0; c < VERILOG_CELL_INPUTS; c ++)
+          gate.input[c] = VERILOG_NETLIST_NONE;
+
+        for(unsigned int p = netlist->instance_pins_start[i];
+            p < netlist->instance_pins_start[i + 1]; p ++)
+          {
+            ast_symbol_entry * port = ast_symbol_lookup(yy_symbols, netlist->pin_port[p]);
+            if(port == NULL)
+              continue;
+
+            if(strcmp(port->text, cell->output) == 0)
+              gate.output = netlist->pin_net[p];
+
+            for(unsigned int c = 0; c < cell->inputs; c ++)
+              if(strcmp(port->text, cell->input[c]) == 0)
+                gate.input[c] = netlist->pin_net[p];
+          }
+
+        // A cell with a pin left unconnected can't be evaluated.
+        bool connected = gate.output != VERILOG_NETLIST_NONE;
+        for(unsigned int c = 0; c < cell->inputs; c ++)
+          connected = connected && gate.input[c] != VERILOG_NETLIST_NONE;
+        if(!connected)
+          {
+            tr->unknown ++;
+            continue;
+          }
+
+        if(cell->clock != NULL)
+          {
+            verilog_sim_flop flop;
+            flop.d = gate.input[0];
+            flop.q = gate.output;
+            flops.push_back(flop);
+          }
+        else
+          {
+            gates.push_back(gate);
+            level.push_back(levels->level[i]);
+          }
+      }
+
+    // Counting sort by level, then function.
+    std::vector<unsigned int> start((size_t)(levels->depth + 1) * (CELL_DFF_POS + 1) + 1, 0);
+    for(size_t g = 0; g < gates.size(); g ++)
+      start[level[g] * (CELL_DFF_POS + 1) + gates[g].function + 1] ++;
+    for(size_t b = 1; b < start.size(); b ++)
+      start[b] += start[b - 1];
+
+    tr->gates = (unsigned int)gates.size();
+    tr->gate  = (verilog_sim_gate *)ast_calloc(tr->gates, sizeof(verilog_sim_gate));
+    for(size_t g = 0; g < gates.size(); g ++)
+      tr->gate[start[level[g] * (CELL_DFF_POS + 1) + gates[g].function] ++] = gates[g];
+
+    tr->flops   = (unsigned int)flops.size();
+    tr->flop    = (verilog_sim_flop *)ast_calloc(tr->flops, sizeof(verilog_sim_flop));
+    tr->sampled = (uint64_t *)ast_calloc(tr->flops, sizeof(uint64_t));
+    if(tr->flops > 0)
+      memcpy(tr->flop, flops.data(), tr->flops * sizeof(verilog_sim_flop));
+
+    return tr;
+  }
+
+  /*!
+@brief Settles every net driven by combinational cells.
+@details One pass over the cells in order, each computing 64 patterns with
+a few word operations.
+*/
+  void VerilogCode::verilog_sim_eval(
+      verilog_sim * sim
+      ){
+    uint64_t               * v    = sim->values;
+    const verilog_sim_gate * gate = sim->gate;
+    const verilog_sim_gate * end  = sim->gate + sim->gates;
+
+    for(; gate != end; gate ++)
+      {
+        const unsigned int * in = gate->input;
+        uint64_t y;
+
+        switch(gate->function)
+          {
+          case CELL_BUF:   y =  v[in[0]]; break;
+          case CELL_INV:   y = ~v[in[0]]; break;
+          case CELL_AND:
+          case CELL_NAND:
+            y = v[in[0]] & v[in[1]];
+            if(gate->inputs > 2) y &= v[in[2]];
+            if(gate->inputs > 3) y &= v[in[3]];
+            if(gate->function == CELL_NAND) y = ~y;
+            break;
+          case CELL_OR:
+          case CELL_NOR:
+            y = v[in[0]] | v[in[1]];
+            if(gate->inputs > 2) y |= v[in[2]];
+            if(gate->inputs > 3) y |= v[in[3]];
+            if(gate->function == CELL_NOR) y = ~y;
+            break;
+          case CELL_XOR:   y =   v[in[0]] ^ v[in[1]];  break;
+          case CELL_XNOR:  y = ~(v[in[0]] ^ v[in[1]]); break;
+          case CELL_AOI21: y = ~((v[in[0]] & v[in[1]]) | v[in[2]]); break;
+          case CELL_OAI21: y = ~((v[in[0]] | v[in[1]]) & v[in[2]]); break;
+          case CELL_AOI22: y = ~((v[in[0]] & v[in[1]]) | (v[in[2]] & v[in[3]])); break;
+          case CELL_OAI22: y = ~((v[in[0]] | v[in[1]]) & (v[in[2]] | v[in[3]])); break;
+          default:         y = 0; break;
+          }
+
+        v[gate->output] = y;
+      }
+  }
+
+  /*!
+@brief Runs one clock cycle.
+@details Every flip flop samples its input, then all of them change their
+outputs together, and the combinational logic settles again. Falling edge
+flip flops are clocked along with the rest, once a cycle.
+*/
+  void VerilogCode::verilog_sim_clock(
+      verilog_sim * sim
+      ){
+    for(unsigned int f = 0; f < sim->flops; f ++)
+      sim->sampled[f] = sim->values[sim->flop[f].d];
+
+    for(unsigned int f = 0; f < sim->flops; f ++)
+      sim->values[sim->flop[f].q] = sim->sampled[f];
+
+    verilog_sim_eval(sim);
+  }
+}
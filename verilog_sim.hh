@@ -0,0 +1,95 @@
+/*!
+@file verilog_sim.hh
+@brief Contains declarations of the cell library and the bit parallel
+       simulator of gate level netlists.
+*/
+
+#include <stdint.h>
+
+#include "verilog_netlist.hh"
+
+#ifndef VERILOG_SIM_H
+#define VERILOG_SIM_H
+
+namespace yy {
+  /*!
+@defgroup verilog-sim Simulation
+@{
+@brief Cycle based, two valued simulation of a gate level module.
+@details Each instance is matched by name to a cell of a small built in
+library, which says what its pins are and what it computes. The
+combinational cells are evaluated in the order verilog_netlist_levelize
+puts them in, so that every cell comes after the cells driving its inputs,
+with flip flops cutting the design into combinational logic between
+registers. One pass over that order settles every net.
+
+Each net holds a uint64_t, and each bit of it is an independent pattern,
+so every pass simulates 64 stimuli at once with one machine operation per
+cell. Instances of cells which are not in the library, and cells on a
+combinational loop, are counted and left out; the nets they drive keep
+whatever they were set to.
+*/
+
+  //! The most inputs any cell in the library has.
+  #define VERILOG_CELL_INPUTS 4
+
+  //! What a cell computes from its inputs.
+  typedef enum verilog_cell_function_e{
+    CELL_BUF,       //!< Y = A
+    CELL_INV,       //!< Y = !A
+    CELL_AND,       //!< Y = A & B ...
+    CELL_NAND,      //!< Y = !(A & B ...)
+    CELL_OR,        //!< Y = A | B ...
+    CELL_NOR,       //!< Y = !(A | B ...)
+    CELL_XOR,       //!< Y = A ^ B
+    CELL_XNOR,      //!< Y = !(A ^ B)
+    CELL_AOI21,     //!< Y = !((A & B) | C)
+    CELL_OAI21,     //!< Y = !((A | B) & C)
+    CELL_AOI22,     //!< Y = !((A & B) | (C & D))
+    CELL_OAI22,     //!< Y = !((A | B) & (C | D))
+    CELL_DFF_POS,   //!< Q = D on the rising edge of CLK.
+    CELL_DFF_NEG    //!< Q = D on the falling edge of CLK.
+  } verilog_cell_function;
+
+  //! One cell of the built in library.
+  typedef struct verilog_cell_t{
+    const char            * name;      //!< Name it is instanced by.
+    verilog_cell_function   function;  //!< What it computes.
+    unsigned int            inputs;    //!< Number of data inputs.
+    const char            * input[VERILOG_CELL_INPUTS]; //!< Names of the data inputs.
+    const char            * output;    //!< Name of the output.
+    const char            * clock;     //!< Name of the clock, or NULL.
+  } verilog_cell;
+
+  //! A combinational cell as the simulator evaluates it.
+  typedef struct verilog_sim_gate_t{
+    unsigned char  function;  //!< A verilog_cell_function.
+    unsigned char  inputs;    //!< Number of inputs.
+    unsigned int   input[VERILOG_CELL_INPUTS]; //!< Nets read.
+    unsigned int   output;    //!< Net driven.
+  } verilog_sim_gate;
+
+  //! A flip flop as the simulator evaluates it.
+  typedef struct verilog_sim_flop_t{
+    unsigned int   d;         //!< Net sampled.
+    unsigned int   q;         //!< Net driven.
+  } verilog_sim_flop;
+
+  //! The state of a simulation of one netlist.
+  typedef struct verilog_sim_t{
+    verilog_netlist  * netlist;   //!< What is simulated.
+    verilog_levels   * levels;    //!< The order cells are evaluated in.
+    uint64_t         * values;    //!< 64 patterns for each net.
+    unsigned int       gates;     //!< Combinational cells, in evaluation order.
+    verilog_sim_gate * gate;      //!< The combinational cells.
+    unsigned int       flops;     //!< Flip flops.
+    verilog_sim_flop * flop;      //!< The flip flops.
+    uint64_t         * sampled;   //!< What each flip flop saw at the last edge.
+    unsigned int       unknown;   //!< Instances of cells not in the library.
+    unsigned int       looped;    //!< Cells left out for being on a loop.
+  } verilog_sim;
+
+  /*! @} */
+}
+
+#endif
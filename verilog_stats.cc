@@ -0,0 +1,160 @@
+/*!
+@file verilog_stats.cc
+@brief Contains implementations of the statistics functions declared in
+       verilogcode.h
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "verilogcode.h"
+
+namespace yy {
+
+  //! Zeroes every phase time and counter.
+  void VerilogCode::stats_reset()
+  {
+    memset(&stats, 0, sizeof(stats));
+  }
+
+  /*!
+@brief Adds the statistics of another VerilogCode to these.
+@details Used to fold in the instances which parsed the files of a project.
+Their phase times are summed, so they add up to more than the wall time
+when the files were parsed in parallel.
+*/
+  void VerilogCode::stats_add(const verilog_stats * other)
+  {
+    for(int p = 0; p < PHASE_COUNT; p ++)
+      {
+        stats.phases[p].seconds += other->phases[p].seconds;
+        stats.phases[p].count   += other->phases[p].count;
+      }
+    for(int k = 0; k < NODE_KIND_COUNT; k ++)
+      stats.nodes[k] += other->nodes[k];
+    stats.input_bytes += other->input_bytes;
+    stats.tokens      += other->tokens;
+  }
+
+  //! Returns the wall time spent in a phase, in seconds.
+  double VerilogCode::stats_phase_seconds(verilog_phase phase)
+  {
+    return stats.phases[phase].seconds;
+  }
+
+  //! Returns the phase specific count of a phase.
+  unsigned long VerilogCode::stats_phase_count(verilog_phase phase)
+  {
+    return stats.phases[phase].count;
+  }
+
+  //! Returns the number of AST nodes of one kind built so far.
+  unsigned long VerilogCode::stats_node_count(verilog_node_kind kind)
+  {
+    return stats.nodes[kind];
+  }
+
+  //! Returns the name of a phase, as used in the JSON dump.
+  const char * VerilogCode::stats_phase_name(verilog_phase phase)
+  {
+    switch(phase)
+      {
+      case PHASE_INPUT:      return "input";
+      case PHASE_PREPROCESS: return "preprocess";
+      case PHASE_PARSE:      return "parse";
+      case PHASE_RESOLVE:    return "resolve";
+      case PHASE_RELEASE:    return "release";
+      case PHASE_CACHE:      return "cache";
+      case PHASE_NETLIST:    return "netlist";
+      case PHASE_LAYOUT:     return "layout";
+      default:               return "unknown";
+      }
+  }
+
+  //! Returns the name of a node kind, as used in the JSON dump.
+  const char * VerilogCode::stats_node_kind_name(verilog_node_kind kind)
+  {
+    switch(kind)
+      {
+      case NODE_KIND_ATTRIBUTE:            return "attribute";
+      case NODE_KIND_IDENTIFIER:           return "identifier";
+      case NODE_KIND_NUMBER:               return "number";
+      case NODE_KIND_PRIMARY:              return "primary";
+      case NODE_KIND_EXPRESSION:           return "expression";
+      case NODE_KIND_CONCATENATION:        return "concatenation";
+      case NODE_KIND_LVALUE:               return "lvalue";
+      case NODE_KIND_RANGE:                return "range";
+      case NODE_KIND_STATEMENT:            return "statement";
+      case NODE_KIND_TIMING:               return "timing";
+      case NODE_KIND_DECLARATION:          return "declaration";
+      case NODE_KIND_PATH:                 return "path";
+      case NODE_KIND_GATE:                 return "gate";
+      case NODE_KIND_UDP:                  return "udp";
+      case NODE_KIND_GENERATE:             return "generate";
+      case NODE_KIND_MODULE:               return "module";
+      case NODE_KIND_MODULE_ITEM:          return "module_item";
+      case NODE_KIND_MODULE_INSTANTIATION: return "module_instantiation";
+      case NODE_KIND_MODULE_INSTANCE:      return "module_instance";
+      case NODE_KIND_PORT_CONNECTION:      return "port_connection";
+      case NODE_KIND_SOURCE_ITEM:          return "source_item";
+      case NODE_KIND_CONFIG:               return "config";
+      default:                             return "unknown";
+      }
+  }
+
+  /*!
+@brief Writes every phase time and counter as a JSON object.
+@param [in] filename - Where to write. "-" means standard output.
+@returns true if the file could be written.
+*/
+  bool VerilogCode::stats_write_json(std::string filename)
+  {
+    FILE * out = filename == "-" ? stdout : fopen(filename.c_str(), "w");
+    if(out == NULL)
+      {
+        return false;
+      }
+
+    fprintf(out, "{\n  \"phases\": {\n");
+    for(int p = 0; p < PHASE_COUNT; p ++)
+      {
+        fprintf(out, "    \"%s\": {\"seconds\": %.9f, \"count\": %lu}%s\n",
+                stats_phase_name((verilog_phase)p),
+                stats.phases[p].seconds, stats.phases[p].count,
+                p + 1 < PHASE_COUNT ? "," : "");
+      }
+    fprintf(out, "  },\n");
+
+    fprintf(out, "  \"input_bytes\": %lu,\n", stats.input_bytes);
+    fprintf(out, "  \"tokens\": %lu,\n", stats.tokens);
+    fprintf(out, "  \"reductions\": %lu,\n", stats.phases[PHASE_PARSE].count);
+
+    fprintf(out, "  \"nodes\": {\n");
+    for(int k = 0; k < NODE_KIND_COUNT; k ++)
+      {
+        fprintf(out, "    \"%s\": %lu%s\n",
+                stats_node_kind_name((verilog_node_kind)k), stats.nodes[k],
+                k + 1 < NODE_KIND_COUNT ? "," : "");
+      }
+    fprintf(out, "  },\n");
+
+    fprintf(out, "  \"memory\": {\n");
+    fprintf(out, "    \"allocations\": %u,\n", memory_allocations);
+    fprintf(out, "    \"bytes_allocated\": %lu,\n", (unsigned long)total_allocated);
+    fprintf(out, "    \"arena_in_use\": %lu,\n", (unsigned long)arena_in_use);
+    fprintf(out, "    \"arena_high_water\": %lu,\n", (unsigned long)arena_high_water);
+    fprintf(out, "    \"arena_reserved\": %lu\n", (unsigned long)arena_reserved);
+    fprintf(out, "  }\n}\n");
+
+    if(out != stdout)
+      {
+        fclose(out);
+      }
+    else
+      {
+        fflush(out);
+      }
+
+    return true;
+  }
+}
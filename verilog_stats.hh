@@ -0,0 +1,108 @@
+/*!
+@file verilog_stats.hh
+@brief Contains declarations of the per-phase timing and counters which a
+       VerilogCode instance keeps while it works.
+*/
+
+#include <chrono>
+
+#ifndef VERILOG_STATS_H
+#define VERILOG_STATS_H
+
+namespace yy {
+  /*!
+@defgroup verilog-stats Statistics
+@{
+@brief Wall time and counts for each phase of reading a design.
+@details Every VerilogCode keeps a verilog_stats, which accumulates across
+calls to parse_file until reset with VerilogCode::stats_reset. Counting is
+always on; it costs an increment per token, reduction and node.
+*/
+
+  //! The phases which time is attributed to.
+  typedef enum verilog_phase_e{
+    PHASE_INPUT,      //!< Opening, mapping and reading source files.
+    PHASE_PREPROCESS, //!< Handling compiler directives.
+    PHASE_PARSE,      //!< Scanning, parsing and building the AST.
+    PHASE_RESOLVE,    //!< Resolving module instantiations.
+    PHASE_RELEASE,    //!< Handing AST memory back to the system.
+    PHASE_CACHE,      //!< Looking up, loading and saving cached trees.
+    PHASE_NETLIST,    //!< Building the connectivity of modules.
+    PHASE_LAYOUT,     //!< Placing and routing schematics.
+    PHASE_COUNT       //!< Number of phases. Not a phase.
+  } verilog_phase;
+
+  //! Coarse kinds of AST node, for counting what the parser built.
+  typedef enum verilog_node_kind_e{
+    NODE_KIND_ATTRIBUTE,
+    NODE_KIND_IDENTIFIER,
+    NODE_KIND_NUMBER,
+    NODE_KIND_PRIMARY,
+    NODE_KIND_EXPRESSION,
+    NODE_KIND_CONCATENATION,
+    NODE_KIND_LVALUE,
+    NODE_KIND_RANGE,
+    NODE_KIND_STATEMENT,
+    NODE_KIND_TIMING,
+    NODE_KIND_DECLARATION,
+    NODE_KIND_PATH,
+    NODE_KIND_GATE,
+    NODE_KIND_UDP,
+    NODE_KIND_GENERATE,
+    NODE_KIND_MODULE,
+    NODE_KIND_MODULE_ITEM,
+    NODE_KIND_MODULE_INSTANTIATION,
+    NODE_KIND_MODULE_INSTANCE,
+    NODE_KIND_PORT_CONNECTION,
+    NODE_KIND_SOURCE_ITEM,
+    NODE_KIND_CONFIG,
+    NODE_KIND_COUNT     //!< Number of kinds. Not a kind.
+  } verilog_node_kind;
+
+  /*!
+@brief Time spent in, and the number of things done by, one phase.
+@details What count measures depends on the phase: files opened for
+PHASE_INPUT, directives for PHASE_PREPROCESS, grammar reductions for
+PHASE_PARSE, instantiations looked up for PHASE_RESOLVE, bytes released
+for PHASE_RELEASE, cache entries loaded for PHASE_CACHE, pins for
+PHASE_NETLIST and wire segments for PHASE_LAYOUT.
+*/
+  typedef struct verilog_phase_stats_t{
+    double          seconds;  //!< Wall time, exclusive of nested phases.
+    unsigned long   count;    //!< Phase specific count, see above.
+  } verilog_phase_stats;
+
+  //! Everything a VerilogCode instance measures.
+  typedef struct verilog_stats_t{
+    verilog_phase_stats phases[PHASE_COUNT];    //!< Indexed by verilog_phase.
+    unsigned long       input_bytes;            //!< Bytes of source read.
+    unsigned long       tokens;                 //!< Tokens handed to the parser.
+    unsigned long       nodes[NODE_KIND_COUNT]; //!< By verilog_node_kind.
+  } verilog_stats;
+
+  /*!
+@brief Adds the wall time of a scope to a phase.
+@details Declare one at the top of a function and the time until it
+returns, by whatever path, is added to the phase.
+*/
+  class verilog_phase_timer
+  {
+  public:
+    explicit verilog_phase_timer(verilog_phase_stats * phase) :
+      phase(phase), start(std::chrono::steady_clock::now()) {}
+
+    ~verilog_phase_timer()
+    {
+      phase->seconds += std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - start).count();
+    }
+
+  private:
+    verilog_phase_stats * phase;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  /*! @} */
+}
+
+#endif
@@ -0,0 +1,88 @@
+/*!
+@file verilog_trace.cc
+@brief Contains implementations of the trace functions declared in
+       verilogcode.h
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "verilogcode.h"
+
+namespace yy {
+
+  /*!
+@brief Selects which categories of trace message are written.
+@details Also sets trace_scanning and trace_parsing from the lexer and parser
+categories, so flex and bison's own debug output follow the same switches.
+Without VERILOG_TRACE_ENABLED every category stays off.
+*/
+  void VerilogCode::set_trace_categories(unsigned int categories)
+  {
+#ifdef VERILOG_TRACE_ENABLED
+    trace_categories = categories;
+#else
+    (void)categories;
+    trace_categories = TRACE_NONE;
+#endif
+    trace_scanning = (trace_categories & TRACE_LEXER) != 0;
+    trace_parsing  = (trace_categories & TRACE_PARSER) != 0;
+  }
+
+  /*!
+@brief Turns a comma separated list of category names into a category mask.
+@details Accepts "lexer", "parser", "preprocessor", "memory", "all" and
+"none". Unknown names are ignored.
+*/
+  unsigned int VerilogCode::verilog_trace_parse_categories(const char * names)
+  {
+    unsigned int tr = TRACE_NONE;
+
+    while(names != NULL && *names != '\0')
+      {
+        const char * end = strchr(names, ',');
+        size_t len = end == NULL ? strlen(names) : (size_t)(end - names);
+
+        if(len == 5 && strncmp(names, "lexer", len) == 0)
+          tr |= TRACE_LEXER;
+        else if(len == 6 && strncmp(names, "parser", len) == 0)
+          tr |= TRACE_PARSER;
+        else if(len == 12 && strncmp(names, "preprocessor", len) == 0)
+          tr |= TRACE_PREPROCESSOR;
+        else if(len == 6 && strncmp(names, "memory", len) == 0)
+          tr |= TRACE_MEMORY;
+        else if(len == 3 && strncmp(names, "all", len) == 0)
+          tr |= TRACE_ALL;
+
+        names = end == NULL ? NULL : end + 1;
+      }
+
+    return tr;
+  }
+
+  /*!
+@brief Writes one trace message, prefixed by its category, to stderr.
+@note Use the VERILOG_TRACE macro rather than calling this directly, so the
+call disappears from release builds.
+*/
+  void VerilogCode::trace(verilog_trace_category category, const char * format, ...)
+  {
+    const char * name;
+    switch(category)
+      {
+      case TRACE_LEXER:        name = "lexer";        break;
+      case TRACE_PARSER:       name = "parser";       break;
+      case TRACE_PREPROCESSOR: name = "preprocessor"; break;
+      case TRACE_MEMORY:       name = "memory";       break;
+      default:                 name = "trace";        break;
+      }
+
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "[%s] ", name);
+    vfprintf(stderr, format, args);
+    fputc('\n', stderr);
+    va_end(args);
+  }
+}
@@ -0,0 +1,50 @@
+/*!
+@file verilog_trace.hh
+@brief Contains the category based trace facility used by the scanner,
+       parser, preprocessor and memory manager.
+@details Tracing is compiled in only when VERILOG_TRACE_ENABLED is
+defined, which the library project does for debug builds. Otherwise every
+VERILOG_TRACE statement compiles to nothing, and its arguments are never
+evaluated. When compiled in, categories are switched on at run time with
+VerilogCode::set_trace_categories.
+*/
+
+#ifndef VERILOG_TRACE_H
+#define VERILOG_TRACE_H
+
+namespace yy {
+
+  /*!
+@brief The things which can be traced. Values may be or'd together.
+*/
+  typedef enum verilog_trace_category_e{
+    TRACE_NONE          = 0,      //!< Trace nothing.
+    TRACE_LEXER         = 1 << 0, //!< Tokens, and flex's own debug output.
+    TRACE_PARSER        = 1 << 1, //!< Grammar actions and bison's debug output.
+    TRACE_PREPROCESSOR  = 1 << 2, //!< Files, includes, macros and conditionals.
+    TRACE_MEMORY        = 1 << 3, //!< Arena allocation and release.
+    TRACE_ALL           = 0xF     //!< Trace everything.
+  } verilog_trace_category;
+
+}
+
+#ifdef VERILOG_TRACE_ENABLED
+
+/*!
+@brief Writes a printf style trace message if the category is enabled.
+@param [in] code - The VerilogCode instance doing the tracing.
+@param [in] category - The verilog_trace_category of the message.
+*/
+#define VERILOG_TRACE(code, category, ...)                                   \
+  do{                                                                        \
+    if((code)->trace_categories & (category))                                \
+      (code)->trace((category), __VA_ARGS__);                                \
+  }while(0)
+
+#else
+
+#define VERILOG_TRACE(code, category, ...) do{}while(0)
+
+#endif
+
+#endif
@@ -1,6 +1,7 @@
 #include <string>
-#include <fstream>
 #include <istream>
+#include <sstream>
+#include <chrono>
 
 #include "verilogscanner.hh"
 #include "verilogcode.h"
@@ -13,32 +14,132 @@ namespace yy {
 	VerilogCode::VerilogCode() {
 		yy_verilog_source_tree = NULL;
 		yy_preproc = NULL;
+		lexer = NULL;
+		parser = NULL;
 		verilog_parser_init();
 	}
 
-	bool VerilogCode::parse_file(QString filename)
+	/*!
+	@brief Creates a scanner reading from the named file.
+	@details Regular files are scanned in place. Pipes and stdin ("-") can't
+	be mapped, so they are read whole first, and scanned in place the same
+	way: the scanner only ever sees a single buffer holding all of a file.
+	*/
+	void VerilogCode::open_scanner(std::string filename)
 	{
-		std::ifstream input;
-		std::string stdfilename = filename.toStdString();
-		int stat;
+		verilog_input * input = NULL;
 
-		trace_scanning = false;
-		trace_parsing = false;
+		// Recreates the context if ast_free_all has released it.
+		verilog_parser_init();
 
 		streamname = filename;
-		std::cout << "opening file " << stdfilename << std::endl;
-		input.open(stdfilename,std::ios::in);
-		std::cout << "opened file" << stdfilename << std::endl;
+		VERILOG_TRACE(this, TRACE_PREPROCESSOR, "opening file %s", filename.c_str());
 
-		lexer = new VerilogScanner(&input,&std::cout);
+		if(filename == "-")
+			input = verilog_input_read(std::cin);
+		else
+			input = verilog_input_open(filename);
+
+		// A file which can't be opened scans as empty.
+		if(input == NULL) {
+			std::istringstream empty;
+			input = verilog_input_read(empty);
+		}
+
+		lexer = new VerilogScanner(NULL,&std::cout);
+		lexer->scan_input(input);
+		ast_stack_push(input_stack, input);
+		verilog_preprocessor_set_file(yy_preproc, filename);
 		lexer->set_debug(trace_scanning);
+	}
+
+	/*!
+	@brief Releases the inputs of a finished scan.
+	@details A parse error leaves files unfinished, so anything still on
+	input_stack is released here.
+	*/
+	void VerilogCode::close_scanner()
+	{
+		while(input_stack->depth > 0)
+			verilog_input_close((verilog_input *)ast_stack_pop(input_stack));
+
+		// Nor is a macro expansion finished.
+		while(yy_preproc->expansions->depth > 0)
+			ast_stack_pop(yy_preproc->expansions);
+	}
+
+	bool VerilogCode::parse_file(std::string filename)
+	{
+		int stat;
+
+		// A streamed tree is gone by the time it could be saved.
+		bool caching = !cache_directory.empty() && module_callback == NULL &&
+			filename != "-";
+		verilog_cache_mark mark;
+
+		if(caching) {
+			verilog_parser_init();
+			uint64_t key = verilog_cache_key(filename);
+
+			if(key != 0 && verilog_cache_load(key)) {
+				if(!stats_json_path.empty())
+					stats_write_json(stats_json_path);
+				return true;
+			}
+
+			caching = key != 0;
+			if(caching)
+				verilog_cache_begin(&mark, key);
+		}
+
+		open_scanner(filename);
 
 		parser = new VerilogParser(this);
-		parser->set_debug_level(trace_parsing);
+
+		// The GLR parser keeps its debug level in a process wide variable.
+		// Leave it alone unless asked, so parsers on other threads can run.
+		if(trace_parsing)
+			parser->set_debug_level(trace_parsing);
+
+		// Includes and directives are handled while parsing. Their time is
+		// booked to their own phases, so take it back out of the parse.
+		double nested = stats.phases[PHASE_INPUT].seconds +
+			stats.phases[PHASE_PREPROCESS].seconds;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
 		stat=parser->parse();
-		input.close();
 
-		return stat;
+		nested = stats.phases[PHASE_INPUT].seconds +
+			stats.phases[PHASE_PREPROCESS].seconds - nested;
+		stats.phases[PHASE_PARSE].seconds += std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - start).count() - nested;
+
+		close_scanner();
+
+		if(caching && stat == 0)
+			verilog_cache_save(&mark);
+
+		if(!stats_json_path.empty())
+			stats_write_json(stats_json_path);
+
+		// The parser returns zero on success.
+		return stat == 0;
+	}
+
+	unsigned long VerilogCode::scan_file(std::string filename)
+	{
+		unsigned long tokens = 0;
+		YYSTYPE yylval;
+		YYLTYPE yylloc;
+
+		open_scanner(filename);
+
+		while(lexer->yylex(&yylval, &yylloc, this) != 0)
+			tokens ++;
+
+		close_scanner();
+
+		return tokens;
 	}
 
 	void VerilogCode::error(const std::string& m)
@@ -60,9 +161,13 @@ namespace yy {
 	{
 		for(unsigned int i = 0; i < t->items; i ++) {
 			ast_source_item* toadd = (ast_source_item*)ast_list_get(t, i);
-			if(toadd->type == SOURCE_MODULE) {
-				std::cout << "adding module" << std::endl;
-				ast_list_append(this->yy_verilog_source_tree->modules, toadd->module);
+			if(toadd == NULL) {
+				// Streamed to module_callback, and added there if kept.
+				continue;
+			} else if(toadd->type == SOURCE_MODULE) {
+				VERILOG_TRACE(this, TRACE_PARSER, "adding module %s",
+					toadd->module->identifier->identifier);
+				verilog_source_tree_add_module(yy_verilog_source_tree, toadd->module);
 			} else if (toadd -> type == SOURCE_UDP) {
 				ast_list_append(this->yy_verilog_source_tree->primitives, toadd->udp);
 			} else {
@@ -72,6 +177,56 @@ namespace yy {
 		}
 	}
 
+	void VerilogCode::set_module_callback(verilog_module_callback callback, void * data)
+	{
+		module_callback      = callback;
+		module_callback_data = data;
+	}
+
+	/*!
+	@brief Marks where the module whose keyword was just scanned begins.
+	@details The parser may look one token ahead, so the next module can be
+	begun before the last one is done. Its mark is then taken once the last
+	one is done, see verilog_module_done.
+	*/
+	void VerilogCode::verilog_module_begin()
+	{
+		if(module_callback == NULL)
+			return;
+
+		if(modules_open ++ == 0)
+			module_mark = ast_arena_get_mark();
+	}
+
+	/*!
+	@brief Hands a module to module_callback as soon as it is reduced.
+	@details A released module is cut out of the arena with everything else
+	allocated since its keyword was scanned. Symbols, macros and anything
+	else the rest of the file may need were allocated under an
+	ast_arena_keep, so they stay.
+	@returns The module if nothing is streaming, or else NULL, so the rule
+	that called this leaves the module out of its source list.
+	*/
+	ast_module_declaration * VerilogCode::verilog_module_done(ast_module_declaration * module)
+	{
+		if(module_callback == NULL || modules_open == 0)
+			return module;
+
+		verilog_module_action action = module_callback(this, module, module_callback_data);
+
+		if(action == MODULE_RELEASE) {
+			ast_arena_release(&module_mark);
+		} else {
+			ast_arena_keep keep(this);
+			verilog_source_tree_add_module(yy_verilog_source_tree, module);
+		}
+
+		if(-- modules_open > 0)
+			module_mark = ast_arena_get_mark();
+
+		return NULL;
+	}
+
 	void VerilogCode::showData()
 	{
 		ast_module_declaration * module;
@@ -80,8 +235,8 @@ namespace yy {
 		std::cout << "Primitives: " << st->primitives->items << std::endl;
 		std::cout << "Libraries: " << st->libraries->items << std::endl;
 
-		for(ast_list_element * m = st->modules->head; m; m=m->next) {
-			module = (ast_module_declaration *)m->data;
+		for(unsigned int m = 0; m < st->modules->items; m ++) {
+			module = (ast_module_declaration *)ast_list_get(st->modules, m);
 			std::cout << module->identifier->identifier << std::endl;
 		}
 	}
@@ -4,13 +4,49 @@
 #include <fstream>
 #include <sstream>
 #include <ostream>
+#include <vector>
 
 #include "verilog_ast.hh"
+#include "verilog_ast_util.hh"
 #include "verilog_preprocessor.hh"
 #include "verilog_ast_common.hh"
+#include "verilog_trace.hh"
+#include "verilog_input.hh"
+#include "verilog_stats.hh"
+#include "verilog_project.hh"
+#include "verilog_cache.hh"
+#include "verilog_netlist.hh"
+#include "verilog_sim.hh"
+#include "verilog_layout.hh"
 
 namespace yy {
 	class VerilogScanner;
+	class VerilogCode;
+
+	//! What the parser does with a module once the callback has seen it.
+	typedef enum verilog_module_action_e{
+		MODULE_KEEP,    //!< Add it to yy_verilog_source_tree as usual.
+		MODULE_RELEASE  //!< Free it. It must not be used again.
+	} verilog_module_action;
+
+	/*!
+	  @brief Called as soon as each endmodule is reduced, when streaming.
+	  @see VerilogCode::set_module_callback
+	*/
+	typedef verilog_module_action (*verilog_module_callback)(
+		VerilogCode            * code,   //!< The parser the module came from.
+		ast_module_declaration * module, //!< The module just parsed.
+		void                   * data    //!< As given to set_module_callback.
+		);
+
+	/*!
+	  @brief A parser, with the scanners, arena and trees it owns.
+	  @details Instances share no mutable state, so each may parse on its own
+	  thread. A single instance is not thread safe, every call may allocate
+	  from its arena. Once parsing and resolution are done, the tree may be
+	  read from many threads through the cursor free accessors, such as
+	  ast_list_begin, which do not need the instance.
+	*/
 	class VerilogCode
 	{
 	public:
@@ -22,41 +58,218 @@ namespace yy {
 		  wanted to add my own "__IS_MY_SIMULATOR__" pre-defined macro, it can be
 		  done by accessing this variable, and using the
 		  verilog_preprocessor_macro_define function.
-		  @note This is a global variable. Treat it with care!
+		  @note Each instance has its own.
 		*/
 		verilog_preprocessor_context * yy_preproc;
 
 		/*!
 		  @brief Global source tree object, used to store parsed constructs.
-		  @details This is a global variable, initialised prior to calling
-		  the verilog_parse function, into which all objects the parser finds are
-		  stored.
+		  @details Initialised prior to calling the verilog_parse function,
+		  into which all objects the parser finds are stored.
 		*/
 		verilog_source_tree * yy_verilog_source_tree;
 
+		/*!
+		  @brief Interned text of every identifier seen by this parser.
+		  @details Identifier nodes point into this table rather than owning
+		  their own copies, so repeated names are stored only once and can be
+		  compared by symbol id.
+		*/
+		ast_symbol_table * yy_symbols = NULL;
+
+		/*!
+		  @brief Every identifier node built, or NULL if they are not kept.
+		  @details Kept by the instances parsing the files of a project, so
+		  their identifiers can be moved over to the project's symbols when
+		  their trees are merged.
+		*/
+		ast_list * yy_identifiers = NULL;
+
+		/*!
+		  @brief The instances which parsed the files of a project.
+		  @details Their trees have been merged into this one, but the nodes
+		  still live in their arenas, so they are only released by
+		  ast_free_all.
+		*/
+		ast_list * yy_units = NULL;
+
+		/*!
+		  @brief The verilog_input behind each buffer on the scanner's stack.
+		  @details Pushed when a file is opened and popped at its end of file,
+		  so the mapping lives exactly as long as the scanner reads from it.
+		*/
+		ast_stack * input_stack = NULL;
+
 		//! The total number of memory allocations made.
 		unsigned int memory_allocations = 0;
 
 		//! The total number of bytes ever allocated using ast_alloc
 		size_t       total_allocated = 0;
 
-		//! Head of the linked list of allocated memory.
-		ast_memory * memory_head = NULL;
+		//! The arena chunk currently being allocated from.
+		ast_arena_chunk * memory_head = NULL;
+
+		//! Chunks which memory allocated under an ast_arena_keep comes from.
+		ast_arena_chunk * memory_keep = NULL;
+
+		//! Number of ast_arena_keep objects in scope.
+		unsigned int arena_keep = 0;
+
+		//! Number of arena chunks ever made, to number them.
+		unsigned long arena_chunks = 0;
+
+		//! Number of bytes currently handed out by the arena, with padding.
+		size_t       arena_in_use = 0;
+
+		//! The largest value arena_in_use has reached since construction.
+		size_t       arena_high_water = 0;
+
+		//! Number of bytes requested from the system for arena chunks.
+		size_t       arena_reserved = 0;
+
+		//! True if new arena chunks get a kind map, which is only while
+		//! a cache directory is set, see ast_arena_chunk.
+		bool         arena_kind_maps = false;
+
+		/// Phase timings and counters, accumulated across parse_file calls.
+		verilog_stats stats = verilog_stats();
+
+		/// If not empty, parse_file writes stats here as JSON when it
+		/// finishes. "-" means standard output.
+		std::string stats_json_path;
+
+		/// Zeroes every phase time and counter.
+		void stats_reset();
+
+		/// Adds another instance's times and counters to these.
+		void stats_add(const verilog_stats * other);
+
+		/// Wall time spent in a phase, in seconds, exclusive of nested phases.
+		double stats_phase_seconds(verilog_phase phase);
+
+		/// The phase specific count of a phase. See verilog_phase_stats.
+		unsigned long stats_phase_count(verilog_phase phase);
+
+		/// Number of AST nodes of one kind built so far.
+		unsigned long stats_node_count(verilog_node_kind kind);
+
+		/// Name of a phase, as used in the JSON dump.
+		static const char * stats_phase_name(verilog_phase phase);
+
+		/// Name of a node kind, as used in the JSON dump.
+		static const char * stats_node_kind_name(verilog_node_kind kind);
+
+		/** Writes all statistics as a JSON object.
+		 * @param filename	where to write, or "-" for standard output
+		 * @return		true if the file could be written
+		 */
+		bool stats_write_json(std::string filename);
+
+		/// Receives each module as it is parsed, or NULL. See set_module_callback.
+		verilog_module_callback module_callback = NULL;
+
+		/// Passed on to module_callback.
+		void * module_callback_data = NULL;
+
+		/// Modules whose keyword has been scanned but which are not yet done.
+		unsigned int modules_open = 0;
+
+		/// Where the arena stood when the module being parsed began.
+		ast_arena_mark module_mark = ast_arena_mark();
+
+		/** Streams modules to a callback while parsing. Each module is
+		 * handed over as soon as its endmodule is reduced. If the callback
+		 * returns MODULE_RELEASE, the module's memory is handed back there
+		 * and then, so a file needs no more memory than its largest module.
+		 * Kept modules are added to yy_verilog_source_tree. Released ones
+		 * are not, and nothing from them may be used afterwards.
+		 * @param callback	the callback, or NULL to stop streaming
+		 * @param data		passed on to the callback
+		 */
+		void set_module_callback(verilog_module_callback callback, void * data);
+
+		/** Marks the arena as a module keyword is scanned. */
+		void verilog_module_begin();
+
+		/** Hands a module to module_callback.
+		 * @return		the module, or NULL if it was streamed
+		 */
+		ast_module_declaration * verilog_module_done(ast_module_declaration * module);
+
+		/// Directory cache entries are kept in, or empty to parse every
+		/// file. See set_cache_directory.
+		std::string cache_directory;
+
+		/// The verilog_cache_image of each entry loaded, or NULL.
+		ast_list * cache_images = NULL;
+
+		/** Keeps the tree of each file parse_file reads in a directory,
+		 * and loads it from there instead of parsing the file again, for
+		 * as long as the file, the files it includes, the macros defined
+		 * and the search directories are unchanged. Not used while
+		 * modules are streamed, nor for standard input. The instances
+		 * parsing the files of a project use the same directory.
+		 * @param directory	where to keep entries, or empty to stop
+		 */
+		void set_cache_directory(std::string directory);
+
+		/** Hashes a file's name and text with everything else its tree
+		 * depends on, to name its cache entry.
+		 * @return		the key, or 0 if the file can't be read
+		 */
+		uint64_t verilog_cache_key(std::string filename);
+
+		/** Returns the path of the entry saved under a key. */
+		std::string verilog_cache_path(uint64_t key);
+
+		/** Adds the tree in the entry for a key to yy_verilog_source_tree.
+		 * @return		false, changing nothing, if there is no valid entry
+		 */
+		bool verilog_cache_load(uint64_t key);
+
+		/** Notes what has been built before a file is parsed. */
+		void verilog_cache_begin(verilog_cache_mark * mark, uint64_t key);
+
+		/** Writes what was built since the mark to the cache.
+		 * @return		true if an entry was written
+		 */
+		bool verilog_cache_save(const verilog_cache_mark * mark);
+
+		/** Unmaps every entry loaded. */
+		void verilog_cache_release();
 
-		//! Walker for the linked list of allocated memory.
-		ast_memory * walker = NULL;
+		/** Hashes bytes, eight at a time. Fast, but not cryptographic. */
+		static uint64_t verilog_cache_hash(const void * data, size_t length, uint64_t seed);
 
 		/// enable debug output in the flex scanner
-		bool trace_scanning = true;
+		bool trace_scanning = false;
 
 		/// enable debug output in the bison parser
-		bool trace_parsing = true;
+		bool trace_parsing = false;
+
+		/// verilog_trace_category bits currently enabled. See verilog_trace.hh
+		unsigned int trace_categories = TRACE_NONE;
+
+		/** Selects the trace categories to write. Has no effect unless the
+		 * library was built with VERILOG_TRACE_ENABLED.
+		 * @param categories	verilog_trace_category values or'd together
+		 */
+		void set_trace_categories(unsigned int categories);
+
+		/** Parses a comma separated list of category names, such as
+		 * "lexer,preprocessor", into verilog_trace_category bits.
+		 */
+		static unsigned int verilog_trace_parse_categories(const char * names);
+
+		/** Writes a trace message. Use the VERILOG_TRACE macro instead. */
+		void trace(verilog_trace_category category, const char * format, ...)
+			__attribute__((format(printf, 3, 4)));
 
 		/// construct a new parser driver context
 		VerilogCode();
 
 		/// stream name (file or input stream) used for error messages.
-		QString streamname;
+		std::string streamname;
 
 		void showData();
 
@@ -65,7 +278,64 @@ namespace yy {
 		 * @param filename	input file name
 		 * @return		true if successfully parsed
 		 */
-		bool parse_file(QString filename);
+		bool parse_file(std::string filename);
+
+		/** Runs only the scanner over a file, discarding the tokens. The
+		 * preprocessor still acts on directives. Used to time lexing apart
+		 * from parsing.
+		 * @param filename	input file name
+		 * @return		the number of tokens scanned
+		 */
+		unsigned long scan_file(std::string filename);
+
+		/** Reads a .f filelist, applies its +incdir+ and +define+ options to
+		 * this instance, and parses its files with parse_files.
+		 * @param filename	the filelist
+		 * @param jobs		worker threads, 0 for one per core
+		 * @return		true if every file parsed
+		 */
+		bool parse_filelist(std::string filename, unsigned int jobs = 0);
+
+		/** Parses several files at once, each with its own VerilogCode
+		 * starting from this one's search directories and macros, then
+		 * merges their trees into yy_verilog_source_tree in list order.
+		 * Macros defined by one file are not seen by the others.
+		 * @param files		paths, as NUL terminated strings
+		 * @param jobs		worker threads, 0 for one per core
+		 * @return		true if every file parsed
+		 */
+		bool parse_files(ast_list * files, unsigned int jobs = 0);
+
+		/** Reads a filelist. Paths are relative to the working directory,
+		 * or to the filelist for those in a filelist included with -F.
+		 * @param filename	the filelist
+		 * @return		its contents, or NULL if it could not be read
+		 */
+		verilog_filelist * verilog_filelist_read(std::string filename);
+
+		/** Moves the modules, primitives, configs and libraries parsed by a
+		 * project's instance into yy_verilog_source_tree, and its
+		 * identifiers over to yy_symbols. */
+		void verilog_source_tree_merge(VerilogCode * unit);
+
+		/** Adds one filelist, and those it includes, to list. */
+		bool verilog_filelist_read_file(verilog_filelist * list,
+			std::string filename, std::string base, unsigned int depth);
+
+		/** Creates an instance to parse one file of a project. */
+		VerilogCode * verilog_project_unit();
+
+		/** Releases the instances in yy_units. */
+		void verilog_project_release();
+
+		/** Creates the scanner for a file, mapping it where possible and
+		 * reading it whole otherwise.
+		 * @param filename	input file name, or "-" for stdin
+		 */
+		void open_scanner(std::string filename);
+
+		/** Releases any inputs the scanner did not finish. */
+		void close_scanner();
 
 		// To demonstrate pure handling of parse errors, instead of
 		// simply dumping them on the standard error output, we will pass
@@ -80,6 +350,9 @@ namespace yy {
 		void error(const std::string& m);
 
 		class VerilogScanner* lexer;
+
+		//! Tokenizes macro values as they are defined. Created on first use.
+		class VerilogScanner* macro_lexer = NULL;
 		class VerilogParser *parser;
 
 		void add_library(ast_list *t);
@@ -197,7 +470,7 @@ namespace yy {
 	  @brief Creates a new string expression.
 	  @param [in] string - The string. Duh.
 	  */
-		ast_expression * ast_new_string_expression(std::string string);
+		ast_expression * ast_new_string_expression(const char * string);
 
 
 		/*!
@@ -1205,7 +1478,11 @@ namespace yy {
 		std::string ast_identifier_tostring(ast_identifier id);
 
 		/*!
-	  @brief Acts like strcmp but works on ast identifiers.
+	  @brief Compares two identifiers, returning zero when they are equal.
+	  @details Each level of a hierarchical identifier is compared by symbol
+	  id, so no strings are built or scanned. Unequal identifiers are ordered
+	  by symbol id, which is stable for one VerilogCode but is not
+	  alphabetical.
 	  */
 		int ast_identifier_cmp(
 			ast_identifier a,
@@ -1223,6 +1500,17 @@ namespace yy {
 		ast_identifier ast_new_identifier(std::string identifier,  //!< String text of the identifier.
 			unsigned int   from_line    //!< THe line the idenifier came from.
 			);
+		ast_identifier ast_new_identifier(
+			const char   * identifier,  //!< Text of the identifier.
+			size_t         length,      //!< Length of the text.
+			unsigned int   from_line    //!< THe line the idenifier came from.
+			);
+
+		/*!
+	  @brief Returns a hash of an identifier, taken from its interned symbols.
+	  @details Equal identifiers always hash equally.
+	  */
+		unsigned int ast_identifier_hash(ast_identifier id);
 
 
 		/*!
@@ -1327,7 +1615,7 @@ namespace yy {
 		ast_number * ast_new_number(
 			ast_number_base base,   //!< What is the base of the number.
 			ast_number_representation representation,   //!< How to interepret digits.
-			std::string digits  //!< The string token representing the number.
+			const char * digits  //!< The string token representing the number.
 			);
 
 		/*!
@@ -1357,25 +1645,54 @@ namespace yy {
 
 		ast_node * ast_node_new();
 
-		//! Duplicates the supplied null terminated string.
-		//std::string ast_strdup(std::string in);
-		//std::string ast_strdup(QString in);
+		/*!
+	  @brief Copies length bytes of text into the arena, NUL terminated.
+	  @details Used to keep token text once the scanner buffer it points
+	  into may be refilled or released. Costs no heap allocation of its own.
+	  */
+		char * ast_strndup(const char * text, size_t length);
 
-		//! Iterates over all allocated memory and frees it.
+		//! Releases every arena chunk in one go.
 		void ast_free_all();
 
 		/*!
-	  @brief A simple wrapper around calloc.
-	  @details This function is identical to calloc, but uses the head and
-	  walker variables above to keep a linked list of all heap memory that the
-	  AST construction allocates. This makes it very easy to clean up afterward
-	  using the @ref ast_free_all function.
+	  @brief A replacement for calloc which bump allocates from an arena.
+	  @details Memory is carved out of large zeroed chunks hanging off
+	  memory_head, so a node costs a pointer increment rather than a call to
+	  malloc. Individual blocks cannot be free'd; everything is released at
+	  once using the @ref ast_free_all function.
 	  @param [in] num - Number of elements to allocate space for.
 	  @param [in] size - The size of each element being allocated.
 	  @returns A pointer to the start of the block of memory allocated.
 	  */
 		void * ast_calloc(size_t num, size_t size);
 
+		/*!
+	  @brief Allocates a zeroed T from the arena, as ast_calloc does.
+	  @details Notes the kind of the block, see ast_arena_kind_of, if its
+	  chunk has a kind map.
+	  */
+		template <class T>
+		T * ast_new()
+		{
+			return (T *)ast_arena_alloc(sizeof(T), ast_arena_kind_of<T>::kind);
+		}
+
+		//! Allocates bytes from the arena, noting kind if kept, see ast_calloc.
+		void * ast_arena_alloc(size_t bytes, ast_arena_kind kind);
+
+		//! Returns the largest number of bytes the arena has had in use.
+		size_t ast_arena_high_water();
+
+		//! Returns the current position of the arena.
+		ast_arena_mark ast_arena_get_mark();
+
+		/*!
+	  @brief Frees everything allocated since a mark.
+	  @details Memory allocated under an ast_arena_keep is not affected.
+	  */
+		void ast_arena_release(const ast_arena_mark * mark);
+
 		/*!
 	  @brief Creates and returns a pointer to a new linked list.
 	  */
@@ -1388,6 +1705,13 @@ namespace yy {
 	  */
 		void       ast_list_free(ast_list * list);
 
+		/*!
+	  @brief Moves the items of a list into a larger block of storage.
+	  @param [inout] list - The list to grow.
+	  @param [in] at_front - Put the new room before the first item.
+	  */
+		void       ast_list_grow(ast_list * list, bool at_front);
+
 		/*!
 	  @brief Adds a new item to the end of a linked list.
 	  */
@@ -1417,7 +1741,7 @@ namespace yy {
 	  @param head - This will form the "front" of the new list.
 	  @param tail - This will form the "end" of the new list.
 	  @details This function takes all the elements in tail and appends them
-	  to those in head. The tail argument is then released from memory, and the
+	  to those in head. The tail argument is then left empty, and the
 	  original head pointer is returned, with all data items still in tact.
 	  */
 		ast_list *    ast_list_concat(ast_list * head, ast_list * tail);
@@ -1454,10 +1778,6 @@ namespace yy {
 			ast_stack * stack,
 			void      * item
 			);
-		void ast_stack_push(
-			ast_stack * stack,
-			std::string item
-			);
 
 		/*!
 	  @brief Pop the top item from the top of the stack.
@@ -1474,9 +1794,6 @@ namespace yy {
 		void * ast_stack_peek(
 			ast_stack * stack
 			);
-		std::string* ast_stack_peek_str(
-			ast_stack * stack
-			);
 
 		/*!
 	  @brief Peek at the item *below* the top item on the top of the stack.
@@ -1486,9 +1803,32 @@ namespace yy {
 			ast_stack * stack
 			);
 
+		//! Hashes a string key using 32-bit FNV-1a.
+		static unsigned int ast_hashtable_hash(const char * key, size_t len);
+
+		//! Finds the slot holding a key, or the slot it should go into.
+		ast_hashtable_element * ast_hashtable_find(
+			ast_hashtable * table, //!< The table to search.
+			const char    * key,   //!< The key to look for.
+			size_t          len,   //!< Length of the key.
+			unsigned int    hash   //!< Hash of the key.
+			);
+
+		//! Re-inserts every live element into a fresh set of slots.
+		void ast_hashtable_resize(
+			ast_hashtable * table,    //!< The table to resize.
+			unsigned int    capacity  //!< New number of slots, a power of two.
+			);
+
 		//! Creates and returns a new hashtable.
 		ast_hashtable * ast_hashtable_new();
 
+		//! Inserts every item of from into table, sharing the items.
+		void ast_hashtable_insert_all(
+			ast_hashtable * table, //!< The table to insert into.
+			ast_hashtable * from   //!< The table to read from.
+			);
+
 		//! Frees an existing hashtable, but not it's contents, only the structure.
 		void  ast_hashtable_free(
 			ast_hashtable * table  //!< The table to free.
@@ -1499,6 +1839,12 @@ namespace yy {
 			std::string key,   //!< The key to insert with.
 			void          * value  //!< The data being added.
 			);
+		ast_hashtable_result ast_hashtable_insert(
+			ast_hashtable * table, //!< The table to insert into.
+			const char    * key,   //!< The key to insert with.
+			size_t          len,   //!< Length of the key.
+			void          * value  //!< The data being added.
+			);
 
 		//! Returns an item from the hashtable.
 		ast_hashtable_result ast_hashtable_get(
@@ -1506,6 +1852,12 @@ namespace yy {
 			std::string key,   //!< The key of the data to fetch.
 			void         ** value  //!< [out] The data being returned.
 			);
+		ast_hashtable_result ast_hashtable_get(
+			ast_hashtable * table, //!< The table to fetch from.
+			const char    * key,   //!< The key of the data to fetch.
+			size_t          len,   //!< Length of the key.
+			void         ** value  //!< [out] The data being returned.
+			);
 
 		//! Removes a key value pair from the hashtable.
 		ast_hashtable_result ast_hashtable_delete(
@@ -1520,6 +1872,34 @@ namespace yy {
 			void          * value  //!< The new data item to update.
 			);
 
+		//! Creates and returns a new, empty symbol table.
+		ast_symbol_table * ast_symbol_table_new();
+
+		//! Creates a symbol table around entries which carry their own hashes.
+		ast_symbol_table * ast_symbol_table_adopt(
+			ast_list * entries  //!< Entry for symbol N at position N-1.
+			);
+
+		//! Builds the index of an adopted table, if it has none yet.
+		void ast_symbol_table_index(ast_symbol_table * table);
+
+		/*!
+	  @brief Returns the entry for a string, interning it if it is new.
+	  @details The text need not be NUL terminated and is copied on first
+	  sight, so the caller's buffer may be reused afterwards.
+	  */
+		ast_symbol_entry * ast_symbol_intern(
+			ast_symbol_table * table, //!< The table to intern into.
+			const char       * text,  //!< The text to intern.
+			size_t             len    //!< Length of the text.
+			);
+
+		//! Returns the entry for a symbol id, or NULL if the id is not known.
+		ast_symbol_entry * ast_symbol_lookup(
+			ast_symbol_table * table, //!< The table the symbol came from.
+			ast_symbol         symbol //!< The symbol to look up.
+			);
+
 			/*!
 		@defgroup ast-utility-modules Module Resoloution & Searching
 		@{
@@ -1530,14 +1910,27 @@ namespace yy {
 			/*!
 		@brief searches across an entire verilog source tree, resolving module
 		identifiers to their declarations.
+		@details Each unresolved instantiation costs one probe of the
+		source tree's module index.
+		@returns Counts of what was resolved, and how long it took.
 		*/
-			void verilog_resolve_modules(
+			verilog_resolution_stats verilog_resolve_modules(
 					verilog_source_tree * source
 					);
 
 			/*!
-		@brief Searches the list of modules in the parsed source tree, returning the
-		one that matches the passed identifer.
+		@brief Adds a module to a source tree, and to its module name index.
+		@details Where two modules share a name, the first one added is the one
+		found by @ref verilog_find_module_declaration.
+		*/
+			void verilog_source_tree_add_module(
+					verilog_source_tree    * source,
+					ast_module_declaration * module
+					);
+
+			/*!
+		@brief Looks up the module in the parsed source tree that matches the
+		passed identifer.
 		@returns The matching module declaration, or NULL if no such declaration
 		exists.
 		*/
@@ -1579,6 +1972,156 @@ namespace yy {
 
 	/*! @} */
 
+			/*!
+		@brief Builds the connectivity of a module's instances.
+		@details Linear in the number of port connections.
+		@see verilog-netlist
+		*/
+			verilog_netlist * verilog_netlist_build(
+					ast_module_declaration * module //!< The module to describe.
+					);
+
+			//! Finds a net by name and bit, or a constant if name is NULL.
+			unsigned int verilog_netlist_find_net(
+					const verilog_netlist * netlist, //!< The netlist to look in.
+					const char            * name,    //!< Name of the net.
+					int                     bit      //!< Bit, or VERILOG_NETLIST_WHOLE.
+					);
+
+			//! Finds an instance by name.
+			unsigned int verilog_netlist_find_instance(
+					const verilog_netlist * netlist, //!< The netlist to look in.
+					const char            * name     //!< Name of the instance.
+					);
+
+			//! Returns the name of a net, with its bit if it has one.
+			std::string verilog_netlist_net_name(
+					const verilog_netlist * netlist, //!< The netlist of the net.
+					unsigned int            net      //!< The net.
+					);
+
+			//! Returns the name of the module or cell an instance is of.
+			const char * verilog_netlist_cell_name(
+					const verilog_netlist * netlist, //!< The netlist of the instance.
+					unsigned int            instance //!< The instance.
+					);
+
+			//! Finds a cell of the built in library by name, or returns NULL.
+			static const verilog_cell * verilog_cell_find(
+					const char * name //!< Name the cell is instanced by.
+					);
+
+			//! Matches each instance to its library cell, NULL where there is none.
+			const verilog_cell ** verilog_netlist_cells(
+					verilog_netlist * netlist //!< The netlist of the instances.
+					);
+
+			/*!
+		@brief Orders the instances of a netlist from inputs to outputs.
+		@details Finds the level of each instance, the depth of the logic and
+		its combinational loops, in time linear in the number of pins.
+		@see verilog_levels
+		*/
+			verilog_levels * verilog_netlist_levelize(
+					verilog_netlist * netlist //!< The netlist to order.
+					);
+
+			/*!
+		@brief Finds a longest combinational path ending at an instance.
+		@details Writes the instances of the path, from the first to the given
+		one, to path, which needs room for the instance's level.
+		@returns The number of instances written.
+		*/
+			unsigned int verilog_levels_path(
+					const verilog_levels * levels,   //!< The levelized netlist.
+					unsigned int           instance, //!< Where the path ends.
+					unsigned int         * path      //!< Instances of the path.
+					);
+
+			//! Makes an empty cone, to find the cones of a levelized netlist in.
+			verilog_cone * verilog_cone_new(
+					const verilog_levels * levels //!< The levelized netlist.
+					);
+
+			/*!
+		@brief Finds the instances driving or driven by a net.
+		@details Those one step away are the instances with an output on the
+		net, for a fan in cone, or with an input on it, for a fan out cone.
+		@returns The number of instances in the cone.
+		@see verilog_cone
+		*/
+			unsigned int verilog_cone_of_net(
+					verilog_cone           * cone,      //!< Where to put the cone.
+					unsigned int             net,       //!< Where the cone starts.
+					verilog_cone_direction   direction, //!< Fan in or fan out.
+					unsigned int             depth,     //!< Most steps to take, 0 for any number.
+					bool                     sequential //!< Stop at instances holding state.
+					);
+
+			/*!
+		@brief Finds the instances driving or driven by an instance.
+		@details The instance itself is only in the cone if it is on a loop.
+		@returns The number of instances in the cone.
+		@see verilog_cone
+		*/
+			unsigned int verilog_cone_of_instance(
+					verilog_cone           * cone,      //!< Where to put the cone.
+					unsigned int             instance,  //!< Where the cone starts.
+					verilog_cone_direction   direction, //!< Fan in or fan out.
+					unsigned int             depth,     //!< Most steps to take, 0 for any number.
+					bool                     sequential //!< Stop at instances holding state.
+					);
+
+			/*!
+		@brief Prepares a netlist for simulation, with every net at 0.
+		@details Set the nets of the module's inputs in values, then call
+		verilog_sim_eval and verilog_sim_clock.
+		@see verilog-sim
+		*/
+			verilog_sim * verilog_sim_new(
+					verilog_netlist * netlist //!< The netlist to simulate.
+					);
+
+			//! Settles the combinational logic, for 64 patterns at once.
+			void verilog_sim_eval(
+					verilog_sim * sim //!< The simulation.
+					);
+
+			//! Clocks every flip flop once, then settles the logic again.
+			void verilog_sim_clock(
+					verilog_sim * sim //!< The simulation.
+					);
+
+			/*!
+		@brief Places and routes a levelized netlist as a schematic.
+		@details Allocates from this VerilogCode, so it may run on a thread of
+		its own only while nothing else uses the VerilogCode.
+		@see verilog-layout
+		*/
+			verilog_layout * verilog_layout_build(
+					verilog_levels * levels //!< The netlist to lay out.
+					);
+
+			//! Indexes where everything of a layout is, see verilog_layout_index.
+			verilog_layout_index * verilog_layout_index_build(
+					verilog_layout * layout //!< The layout to index.
+					);
+
+			//! Appends the place in the index of each item meeting an area.
+			void verilog_layout_index_query(
+					const verilog_layout_index * index, //!< The index to look in.
+					const verilog_layout_box   & area,  //!< Where to look.
+					std::vector<unsigned int>  & found  //!< What meets it.
+					);
+
+			//! Returns the place in the index of the item under a point, or VERILOG_NETLIST_NONE.
+			unsigned int verilog_layout_index_hit(
+					const verilog_layout_index * index,  //!< The index to look in.
+					int                          x,      //!< Where to look.
+					int                          y,      //!< Where to look.
+					int                          radius  //!< How far from the point an item may be.
+					);
+
 	//! Creates and returns a new default net type directive.
 		verilog_default_net_type * verilog_new_default_net_type(
 			unsigned int token_number,  //!< Token number of the directive.
@@ -1588,11 +2131,13 @@ namespace yy {
 
 		/*!
 	  @brief Instructs the preprocessor to register a new macro definition.
+	  @details macro_text is everything after the name, so a function like
+	  macro starts with its parameter list. The value is tokenized here, once.
 	  */
 		void verilog_preprocessor_macro_define(
 			unsigned int line,  //!< The line the defininition comes from.
 			std::string macro_name,  //!< The macro identifier.
-			std::string macro_text,  //!< The value the macro expands to.
+			const char * macro_text,  //!< The value the macro expands to.
 			size_t text_len     //!< Length in bytes of macro_text.
 			);
 
@@ -1663,7 +2208,7 @@ namespace yy {
 	  @brief Returns the file currently being parsed by the context, or NULL
 	  @param [in] preproc - The context to get the current file for.
 	  */
-		std::string *verilog_preprocessor_current_file(
+		const char *verilog_preprocessor_current_file(
 			verilog_preprocessor_context * preproc
 			);
 
@@ -1719,6 +2264,40 @@ namespace yy {
 			unsigned int lineNumber //!< The line number of the directive.
 			);
 
+		//! Searches for and reads an include file into the include cache.
+		verilog_include_file * verilog_preprocessor_include_find(
+			std::string filename  //!< The name given to `include.
+			);
+
+		//! Returns the text of a cached include file, ready to scan.
+		verilog_input * verilog_preprocessor_include_input(
+			verilog_include_file * file
+			);
+
+		//! Maps a regular file for scanning in place. NULL if it can't be mapped.
+		verilog_input * verilog_input_map(std::string filename);
+
+		//! Reads a whole stream into a heap buffer for scanning in place.
+		verilog_input * verilog_input_read(std::istream & in);
+
+		//! Maps a file, or failing that reads it. NULL if it can't be opened.
+		verilog_input * verilog_input_open(std::string filename);
+
+		//! Unmaps or frees the text of an input. Does nothing given NULL.
+		void verilog_input_release(verilog_input * input);
+
+		//! Releases an input at its end, unless the include cache owns it.
+		void verilog_input_close(verilog_input * input);
+
+		/*!
+	  @brief Adds a directory to the list searched for include files.
+	  @details Directories are searched in the order they were added, after
+	  the current working directory.
+	  */
+		void verilog_preprocessor_add_search_dir(
+			std::string dir  //!< The directory, with or without a trailing '/'.
+			);
+
 
 	};
 }
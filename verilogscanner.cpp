@@ -1,8 +1,341 @@
+#include <cstring>
+#include <iostream>
+
 #include "verilogscanner.hh"
+#include "verilogcode.h"
 
 namespace yy {
+	typedef VerilogParser::token token;
+
 	VerilogScanner::VerilogScanner(std::istream* in = 0, std::ostream* out = &std::cout) : yyFlexLexer(in, 0)
 	{
+		macro_body = false;
+		skip_depth = 0;
+	}
+
+	//! True for the tokens whose text the parser needs, as VerilogParser's str.
+	static bool token_has_text(int t)
+	{
+		switch(t)
+		{
+			case token::STRING:
+			case token::BIN_VALUE:
+			case token::OCT_VALUE:
+			case token::HEX_VALUE:
+			case token::NUM_REAL:
+			case token::UNSIGNED_NUMBER:
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	/*!
+	@details Tokens only carry a view of their text, in the scanner buffer or
+	a macro value, until they reach the parser. Only then is the text of
+	those the grammar keeps copied, into the arena rather than the heap. A
+	GLR parser may hold a token after the buffer is refilled or its file
+	released, so the view can not be handed over as it is.
+	*/
+	int VerilogScanner::yylex(YYSTYPE* yylval, YYLTYPE* yylloc, VerilogCode* code)
+	{
+		verilog_macro_token record;
+		int t = next_token(&record, yylval, yylloc, code);
+
+		// Replayed macro tokens are in the arena already, see make_value.
+		if(token_has_text(t) && code->yy_preproc->expansions->depth == 0)
+			yylval->str = code->ast_strndup(record.text, record.length);
+
+		if(t == token::KW_MODULE || t == token::KW_MACROMODULE)
+			code->verilog_module_begin();
+		return t;
+	}
+
+	/*!
+	@brief Returns the next token, from the innermost macro expansion if there
+	is one, or else from the source text.
+	@details record is filled in to describe the token. Its text is only valid
+	until the next call.
+	*/
+	int VerilogScanner::next_token(verilog_macro_token* record, YYSTYPE* yylval,
+		YYLTYPE* yylloc, VerilogCode* code)
+	{
+		ast_stack * expansions = code->yy_preproc->expansions;
+
+		for(;;)
+		{
+			if(expansions->depth == 0)
+			{
+				int t = yylex_raw(yylval, yylloc, code);
+				if(t == VERILOG_TOKEN_MACRO)
+				{
+					expand_macro(YYText() + 1, YYLeng() - 1, yylval, yylloc, code);
+					continue;
+				}
+
+				record->token  = t;
+				record->param  = -1;
+				record->op     = yylval->verilog_operator;
+				record->text   = YYText();
+				record->length = YYLeng();
+				return t;
+			}
+
+			verilog_macro_expansion * e = (verilog_macro_expansion *)code->ast_stack_peek(expansions);
+			if(e->next == e->count)
+			{
+				code->ast_stack_pop(expansions);
+				continue;
+			}
+
+			verilog_macro_token * t = &e->tokens[e->next ++];
+			if(t->param >= 0)
+			{
+				// Replay the actual argument in place of the formal one.
+				if((unsigned int)t->param < e->arg_count && e->args[t->param].count > 0)
+				{
+					ast_arena_keep keep(code);
+					verilog_macro_expansion * arg = (verilog_macro_expansion *)code->ast_calloc(1, sizeof(verilog_macro_expansion));
+					arg->tokens = e->args[t->param].tokens;
+					arg->count  = e->args[t->param].count;
+					code->ast_stack_push(expansions, arg);
+				}
+				continue;
+			}
+
+			if(t->token == VERILOG_TOKEN_MACRO)
+			{
+				// Macros used by a macro are looked up when it is used.
+				expand_macro(t->text, t->length, yylval, yylloc, code);
+				continue;
+			}
+
+			*record = *t;
+			make_value(t, yylval, code);
+			code->stats.tokens ++;
+			return t->token;
+		}
+	}
+
+	//! Copies a token into the arena, so it outlives the scanner buffer.
+	static verilog_macro_token * copy_token(VerilogCode * code, const verilog_macro_token * record)
+	{
+		verilog_macro_token * copy = (verilog_macro_token *)code->ast_calloc(1, sizeof(verilog_macro_token));
+		char * text = (char *)code->ast_calloc(record->length + 1, sizeof(char));
+
+		memcpy(text, record->text, record->length);
+		*copy = *record;
+		copy->text = text;
+		return copy;
+	}
+
+	//! Moves a list of tokens into an array.
+	static verilog_macro_token * flatten_tokens(VerilogCode * code, ast_list * list)
+	{
+		verilog_macro_token * tokens = (verilog_macro_token *)code->ast_calloc(list->items + 1, sizeof(verilog_macro_token));
+
+		for(unsigned int i = 0; i < list->items; i ++)
+			tokens[i] = *(verilog_macro_token *)code->ast_list_get(list, i);
+		return tokens;
+	}
+
+	/*!
+	@brief Starts replaying a macro.
+	@details The actual arguments of a function like macro are read first,
+	from whatever the macro was used in, and split on commas which are not
+	inside brackets.
+	*/
+	void VerilogScanner::expand_macro(const char* name, size_t length, YYSTYPE* yylval,
+		YYLTYPE* yylloc, VerilogCode* code)
+	{
+		ast_stack * expansions = code->yy_preproc->expansions;
+		verilog_macro_directive * macro = NULL;
+
+		// An expansion may run on past the end of a streamed module.
+		ast_arena_keep keep(code);
+
+		if(code->ast_hashtable_get(code->yy_preproc->macrodefines, name, length, (void**)&macro) != HASH_SUCCESS)
+		{
+			// Undefined macro - PANIC!
+			std::cout << "ERROR: Undefined macro '`" << std::string(name, length) << "' on line " << lineno() << std::endl;
+			std::cout << "\tIt's probably all going to fall apart now...\n\n" << std::endl;
+			return;
+		}
+
+		if(expansions->depth >= VERILOG_MACRO_MAX_DEPTH)
+		{
+			std::cout << "ERROR: Macro '`" << macro->macro_id << "' nested too deeply on line " << lineno() << ", is it recursive?" << std::endl;
+			return;
+		}
+
+		code->stats.phases[PHASE_PREPROCESS].count ++;
+		VERILOG_TRACE(code, TRACE_PREPROCESSOR, "expanding %s", macro->macro_id);
+
+		verilog_macro_expansion * e = (verilog_macro_expansion *)code->ast_calloc(1, sizeof(verilog_macro_expansion));
+		e->tokens = macro->tokens;
+		e->count  = macro->token_count;
+
+		if(macro->params != NULL)
+		{
+			verilog_macro_token record;
+			int t = next_token(&record, yylval, yylloc, code);
+
+			if(t != token::OPEN_BRACKET)
+			{
+				std::cout << "ERROR: Macro '`" << macro->macro_id << "' used without arguments on line " << lineno() << std::endl;
+
+				// Put the token back, rather than lose it.
+				verilog_macro_expansion * back = (verilog_macro_expansion *)code->ast_calloc(1, sizeof(verilog_macro_expansion));
+				back->tokens = copy_token(code, &record);
+				back->count  = 1;
+				code->ast_stack_push(expansions, back);
+				return;
+			}
+
+			ast_list * args  = code->ast_list_new();
+			ast_list * arg   = code->ast_list_new();
+			int        depth = 0;
+
+			for(;;)
+			{
+				t = next_token(&record, yylval, yylloc, code);
+
+				if(t == 0)
+				{
+					std::cout << "ERROR: Unterminated arguments to macro '`" << macro->macro_id << "'" << std::endl;
+					code->ast_list_append(args, arg);
+
+					// Hand the end of input on to the parser after the expansion.
+					verilog_macro_expansion * end = (verilog_macro_expansion *)code->ast_calloc(1, sizeof(verilog_macro_expansion));
+					end->tokens = copy_token(code, &record);
+					end->count  = 1;
+					code->ast_stack_push(expansions, end);
+					break;
+				}
+
+				if(depth == 0 && (t == token::COMMA || t == token::CLOSE_BRACKET))
+				{
+					code->ast_list_append(args, arg);
+					if(t == token::CLOSE_BRACKET)
+						break;
+					arg = code->ast_list_new();
+					continue;
+				}
+
+				if(t == token::OPEN_BRACKET || t == token::OPEN_SQ_BRACKET || t == token::OPEN_SQ_BRACE)
+					depth ++;
+				else if(t == token::CLOSE_BRACKET || t == token::CLOSE_SQ_BRACKET || t == token::CLOSE_SQ_BRACE)
+					depth --;
+
+				code->ast_list_append(arg, copy_token(code, &record));
+			}
+
+			e->arg_count = args->items;
+			e->args = (verilog_macro_argument *)code->ast_calloc(args->items, sizeof(verilog_macro_argument));
+			for(unsigned int i = 0; i < args->items; i ++)
+			{
+				ast_list * tokens = (ast_list *)code->ast_list_get(args, i);
+				e->args[i].tokens = flatten_tokens(code, tokens);
+				e->args[i].count  = tokens->items;
+			}
+		}
+
+		if(e->count > 0)
+			code->ast_stack_push(expansions, e);
+	}
+
+	/*!
+	@brief Gives a replayed token a semantic value of its own, as the scanner
+	would have made it.
+	*/
+	void VerilogScanner::make_value(const verilog_macro_token* record, YYSTYPE* yylval, VerilogCode* code)
+	{
+		switch(record->token)
+		{
+			case token::SIMPLE_ID:
+			case token::ESCAPED_ID:
+			case token::SYSTEM_ID:
+				yylval->identifier = code->ast_new_identifier(record->text, record->length, lineno());
+				break;
+			case token::STRING:
+			case token::BIN_VALUE:
+			case token::OCT_VALUE:
+			case token::HEX_VALUE:
+			case token::NUM_REAL:
+			case token::UNSIGNED_NUMBER:
+				yylval->str = record->text;
+				break;
+			default:
+				yylval->verilog_operator = record->op;
+				break;
+		}
+	}
+
+	/*!
+	@brief Tokenizes a macro value once, when it is defined.
+	@details Line continuations become blanks, and a newline is added so a
+	trailing // comment ends. Identifiers naming a formal parameter are
+	marked, so the actual argument can be replayed in their place.
+	*/
+	void VerilogScanner::tokenize_macro(VerilogCode* code, verilog_macro_directive* macro,
+		const char* text, size_t length)
+	{
+		verilog_input input;
+		input.data   = (char *)code->ast_calloc(length + 1 + VERILOG_INPUT_PADDING, sizeof(char));
+		input.length = 0;
+		input.mapped = 0;
+
+		for(size_t i = 0; i < length; i ++)
+		{
+			if(text[i] == '\\' && i + 1 < length && text[i+1] == '\n')
+				input.data[input.length ++] = ' ';
+			else
+				input.data[input.length ++] = text[i];
+		}
+		input.data[input.length ++] = '\n';
+
+		// Tokens are counted as they reach the parser, not here.
+		unsigned long tokens = code->stats.tokens;
+		ast_list * list = code->ast_list_new();
+		YYSTYPE value;
+		YYLTYPE location;
+		int t;
+
+		scan_input(&input);
+		while((t = yylex_raw(&value, &location, code)) != 0)
+		{
+			verilog_macro_token record;
+			record.token  = t;
+			record.param  = -1;
+			record.op     = value.verilog_operator;
+			record.text   = YYText();
+			record.length = YYLeng();
+
+			if(t == VERILOG_TOKEN_MACRO)
+			{
+				// Drop the backtick, leaving the name to look up.
+				record.text ++;
+				record.length --;
+			}
+			else if(t == token::SIMPLE_ID && macro->params != NULL)
+			{
+				for(unsigned int p = 0; p < macro->params->items; p ++)
+				{
+					const char * param = (const char *)code->ast_list_get(macro->params, p);
+					if(strlen(param) == record.length && memcmp(param, record.text, record.length) == 0)
+					{
+						record.param = (int)p;
+						break;
+					}
+				}
+			}
+
+			code->ast_list_append(list, copy_token(code, &record));
+		}
+		code->stats.tokens = tokens;
+
+		macro->tokens      = flatten_tokens(code, list);
+		macro->token_count = list->items;
 	}
 }
 
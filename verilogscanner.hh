@@ -9,6 +9,7 @@
 
 #include "verilog_ast.hh"
 #include "verilog_preprocessor.hh"
+#include "verilog_input.hh"
 #include "verilog.yy.hh"
 
 namespace yy {
@@ -16,7 +17,42 @@ class VerilogScanner : public yyFlexLexer
 {
 public:
 	explicit VerilogScanner(std::istream* in, std::ostream* out);
+
+	/** Returns the next token for the parser. Macro usages are expanded
+	 * here, by replaying the tokens cached when the macro was defined. */
 	int yylex(YYSTYPE* yylval, YYLTYPE* yylloc, yy::VerilogCode* code);
+
+	/** The flex scanner itself. Returns VERILOG_TOKEN_MACRO for a macro
+	 * usage, leaving the name in YYText(). */
+	int yylex_raw(YYSTYPE* yylval, YYLTYPE* yylloc, yy::VerilogCode* code);
+
+	/** Pushes an in-memory input onto the buffer stack and scans it in
+	 * place, without copying it into refill buffers. The input must stay
+	 * valid until the scanner reaches its end. */
+	void scan_input(verilog_input* input);
+
+	/** Tokenizes the value of a macro into macro->tokens. Only called on
+	 * a scanner with macro_body set. */
+	void tokenize_macro(yy::VerilogCode* code, verilog_macro_directive* macro,
+		const char* text, size_t length);
+
+	/** True for the scanner which tokenizes macro values. Its buffers are
+	 * not files, so reaching their end touches no file state. */
+	bool macro_body;
+
+	/** Skips disabled text up to the next conditional directive. */
+	void skip_inactive();
+
+	/** Conditionals opened within the disabled text being skipped. */
+	int skip_depth;
+
+private:
+	int next_token(verilog_macro_token* record, YYSTYPE* yylval,
+		YYLTYPE* yylloc, yy::VerilogCode* code);
+	void expand_macro(const char* name, size_t length, YYSTYPE* yylval,
+		YYLTYPE* yylloc, yy::VerilogCode* code);
+	void make_value(const verilog_macro_token* record, YYSTYPE* yylval,
+		yy::VerilogCode* code);
 };
 }
 